@@ -0,0 +1,106 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// AdaptiveTimeout.cpp : implementation of the CAdaptiveTimeout class
+//
+
+#include "pch.h"
+#include "AdaptiveTimeout.h"
+#include <cmath>
+
+/**
+ * @brief Default constructor for CAdaptiveTimeout; timeouts between 200 ms and 5 seconds
+ */
+CAdaptiveTimeout::CAdaptiveTimeout() noexcept :
+	m_dwFloor{ 200 },
+	m_dwCeiling{ 5000 }
+{
+	Reset();
+}
+
+/**
+ * @brief Forgets the round trip time estimate and the losses accounted for so far
+ */
+void CAdaptiveTimeout::Reset() noexcept
+{
+	m_fSRTT = 0.0;
+	m_fRTTVar = 0.0;
+	m_nBackoff = 0;
+	m_bEstimate = false;
+	m_nLosses = 0;
+	m_nLossWait = 0;
+}
+
+/**
+ * @brief Sets the range the timeout is kept in
+ * @param dwFloor The smallest timeout in milliseconds; replies slower than this are never declared lost early
+ * @param dwCeiling The largest timeout in milliseconds, normally the configured timeout
+ */
+void CAdaptiveTimeout::SetBounds(DWORD dwFloor, DWORD dwCeiling) noexcept
+{
+	m_dwCeiling = (dwCeiling > 0) ? dwCeiling : 1;
+	m_dwFloor = (dwFloor < m_dwCeiling) ? dwFloor : m_dwCeiling;
+}
+
+/**
+ * @brief Accounts for an answered probe (RFC 6298 2.2 and 2.3)
+ * @param nRTT Round trip time in microseconds
+ */
+void CAdaptiveTimeout::AddSample(ULONGLONG nRTT) noexcept
+{
+	const double fRTT{ static_cast<double>(nRTT) };
+	if (!m_bEstimate)
+	{
+		m_fSRTT = fRTT;
+		m_fRTTVar = fRTT / 2.0;
+		m_bEstimate = true;
+	}
+	else
+	{
+		m_fRTTVar = (0.75 * m_fRTTVar) + (0.25 * std::fabs(m_fSRTT - fRTT));
+		m_fSRTT = (0.875 * m_fSRTT) + (0.125 * fRTT);
+	}
+	m_nBackoff = 0;
+}
+
+/**
+ * @brief Accounts for a probe which was not answered in time, and backs the timeout off (RFC 6298 5.5)
+ * @param dwTimeout How long the probe was waited for in milliseconds
+ */
+void CAdaptiveTimeout::AddLoss(DWORD dwTimeout) noexcept
+{
+	++m_nLosses;
+	m_nLossWait += dwTimeout;
+	if (m_nBackoff < MAX_BACKOFF)
+		++m_nBackoff;
+}
+
+/**
+ * @brief Gets the timeout of the next probe
+ * @return SRTT + max(G, 4 * RTTVAR) rounded up to milliseconds, raised to the floor, doubled for every loss since
+ * the last answer and capped at the ceiling; the ceiling while there is no estimate
+ */
+DWORD CAdaptiveTimeout::GetTimeout() const noexcept
+{
+	if (!m_bEstimate)
+		return m_dwCeiling;
+	const double fVariation{ 4.0 * m_fRTTVar };
+	const double fRTO{ m_fSRTT + ((fVariation > static_cast<double>(CLOCK_GRANULARITY)) ? fVariation : static_cast<double>(CLOCK_GRANULARITY)) };
+	ULONGLONG nTimeout{ static_cast<ULONGLONG>(std::ceil(fRTO / 1000.0)) };
+	if (nTimeout < m_dwFloor)
+		nTimeout = m_dwFloor;
+	nTimeout <<= m_nBackoff;
+	return (nTimeout < m_dwCeiling) ? static_cast<DWORD>(nTimeout) : m_dwCeiling;
+}
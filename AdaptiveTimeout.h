@@ -0,0 +1,58 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// AdaptiveTimeout.h : interface of the CAdaptiveTimeout class, a probe timeout which follows the round trip
+// times observed so far instead of always waiting the full configured timeout.
+//
+
+#pragma once
+
+// CAdaptiveTimeout: the retransmission timeout estimator of RFC 6298 applied to probes of one target or one hop.
+// - every answered probe updates the smoothed round trip time SRTT and its variation RTTVAR (alpha 1/8, beta 1/4)
+// - the timeout is SRTT + max(G, 4 * RTTVAR), kept between a floor and a ceiling (the configured timeout)
+// - until the first answer the timeout is the ceiling
+// - every lost probe doubles the timeout until the next answer (RFC 6298 5.5), so a path which slows down is
+//   not declared lost probe after probe
+class CAdaptiveTimeout
+{
+public:
+	CAdaptiveTimeout() noexcept;
+
+	void Reset() noexcept;                                   // Forgets the estimate and the losses; keeps the bounds
+	void SetBounds(DWORD dwFloor, DWORD dwCeiling) noexcept; // Milliseconds
+	void AddSample(ULONGLONG nRTT) noexcept;                 // Accounts for an answered probe; nRTT in microseconds
+	void AddLoss(DWORD dwTimeout) noexcept;                  // Accounts for a probe given up after dwTimeout milliseconds
+
+	DWORD GetTimeout() const noexcept;                       // The timeout of the next probe in milliseconds
+	bool HasEstimate() const noexcept { return m_bEstimate; }
+	double GetSRTT() const noexcept { return m_fSRTT; }      // Microseconds
+	double GetRTTVar() const noexcept { return m_fRTTVar; }  // Microseconds
+	ULONGLONG GetLosses() const noexcept { return m_nLosses; }
+	ULONGLONG GetLossWait() const noexcept { return m_nLossWait; } // Milliseconds spent waiting for the lost probes
+	ULONGLONG GetFixedLossWait() const noexcept { return m_nLosses * m_dwCeiling; } // The same with the ceiling as a fixed timeout
+
+protected:
+	static const UINT MAX_BACKOFF{ 6 };                // Doublings after which the timeout stops growing
+	static const ULONGLONG CLOCK_GRANULARITY{ 1000 };  // G of RFC 6298 in microseconds
+
+	double m_fSRTT;                                    // Smoothed round trip time in microseconds
+	double m_fRTTVar;                                  // Round trip time variation in microseconds
+	DWORD m_dwFloor;                                   // Smallest timeout in milliseconds
+	DWORD m_dwCeiling;                                 // Largest timeout in milliseconds, and the one used without an estimate
+	UINT m_nBackoff;                                   // Losses since the last answer, up to MAX_BACKOFF
+	bool m_bEstimate;                                  // Whether SRTT and RTTVAR hold an estimate
+	ULONGLONG m_nLosses;                               // Probes given up
+	ULONGLONG m_nLossWait;                             // Milliseconds spent waiting for them
+};
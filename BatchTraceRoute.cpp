@@ -0,0 +1,302 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// BatchTraceRoute.cpp : implementation of the CBatchTraceRoute class
+//
+
+#include "pch.h"
+#include "BatchTraceRoute.h"
+#include "ping.h"
+
+namespace
+{
+	/**
+	 * @brief Gets the host order IPv4 address of a hop
+	 * @param htrr The hop
+	 * @return The address, 0 if the hop did not answer
+	 */
+	ULONG HopAddress(const CHostTraceMultiReplyv4& htrr) noexcept
+	{
+		return (htrr.nStatus == IP_REQ_TIMED_OUT) ? 0 : ntohl(htrr.Address.sin_addr.s_addr);
+	}
+
+	/**
+	 * @brief Makes the key of a stop set
+	 * @param nAddress The host order address of the hop
+	 * @param nQualifier The TTL of the hop (local stop set) or the destination prefix (global stop set)
+	 * @return The key
+	 */
+	ULONGLONG StopSetKey(ULONG nAddress, ULONG nQualifier) noexcept
+	{
+		return (static_cast<ULONGLONG>(nAddress) << 32) | nQualifier;
+	}
+}
+
+/**
+ * @brief Default constructor for CBatchTraceRoute; automatic start hop and /24 destination prefixes
+ */
+CBatchTraceRoute::CBatchTraceRoute() noexcept :
+	m_nPathHops{ 0 },
+	m_nPaths{ 0 },
+	m_pLocalAddress{ nullptr },
+	m_dwTimeout{ 5000 },
+	m_dwPingsPerHost{ 3 },
+	m_wDataSize{ 32 },
+	m_nTOS{ 0 },
+	m_nHopCount{ 30 },
+	m_nStartHop{ 0 },
+	m_nPrefixMask{ 0xFFFFFF00 }
+{
+}
+
+/**
+ * @brief Adds a destination to trace
+ * @param address The destination
+ */
+void CBatchTraceRoute::AddTarget(const SOCKADDR_IN& address)
+{
+	CBatchTraceTarget target;
+	target.Address = address;
+	m_Targets.push_back(std::move(target));
+}
+
+/**
+ * @brief Sets how much of a destination address the global stop set looks at
+ * @param nPrefixLength Prefix length in bits, 0 to 32; hops seen on the way to one destination of a prefix are
+ * assumed to lead to every other destination of the prefix as well
+ */
+void CBatchTraceRoute::SetPrefixLength(UCHAR nPrefixLength) noexcept
+{
+	if (nPrefixLength > 32)
+		nPrefixLength = 32;
+	m_nPrefixMask = (nPrefixLength == 0) ? 0 : (0xFFFFFFFFUL << (32 - nPrefixLength));
+}
+
+/**
+ * @brief Forgets every hop learned so far
+ */
+void CBatchTraceRoute::ClearStopSets()
+{
+	m_LocalStopSet.clear();
+	m_GlobalStopSet.clear();
+	m_nPathHops = 0;
+	m_nPaths = 0;
+}
+
+/**
+ * @brief Traces the route to every destination, one after the other
+ * @param nHopCount The largest TTL probed
+ * @param dwTimeout Timeout of each probe in milliseconds; the ceiling when adaptive timeouts are on
+ * @param dwPingsPerHost Probes sent to each hop
+ * @param wDataSize Payload size of each probe in bytes
+ * @param nTOS Type of service of each probe
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true if every destination was traced, false if the run was cancelled or the parameters are invalid
+ * @details The stop sets are kept from one run to the next; call ClearStopSets to start from scratch. A Cancel
+ * which comes before Run stops it before its first probe.
+ */
+bool CBatchTraceRoute::Run(UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN* pLocalAddress)
+{
+	m_Summary = CBatchTraceSummary{};
+	if ((nHopCount == 0) || (dwPingsPerHost == 0))
+	{
+		m_bCancelled = false;
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return false;
+	}
+	m_nHopCount = nHopCount;
+	m_dwTimeout = dwTimeout;
+	m_dwPingsPerHost = dwPingsPerHost;
+	m_wDataSize = wDataSize;
+	m_nTOS = nTOS;
+	m_pLocalAddress = pLocalAddress;
+	m_nProbesSent = 0;
+
+	const ULONGLONG nStart{ CPingClock::NowMicroseconds() };
+	bool bCompleted{ true };
+	for (size_t i = 0; i < m_Targets.size(); i++)
+	{
+		if (m_bCancelled)
+		{
+			bCompleted = false;
+			break;
+		}
+		const bool bTraced{ TraceTarget(i) };
+		const CBatchTraceTarget& target{ m_Targets[i] };
+		m_Summary.nTargets++;
+		m_Summary.nProbedHops += target.nProbedHops;
+		m_Summary.nCopiedHops += target.nCopiedHops;
+		if (target.HasReachedDestination())
+			m_Summary.nReached++;
+		if (!bTraced || !OnTargetComplete(i, target))
+		{
+			bCompleted = false;
+			break;
+		}
+	}
+	m_Summary.nProbesSent = m_nProbesSent;
+	m_Summary.nElapsed = CPingClock::NowMicroseconds() - nStart;
+	m_pLocalAddress = nullptr;
+	m_bCancelled = false;
+	if (!bCompleted)
+		SetLastError(ERROR_CANCELLED);
+	return bCompleted;
+}
+
+/**
+ * @brief Gets the TTL the next destination is first probed at
+ * @return The configured start hop, or half the mean length of the paths traced so far; at most the hop count
+ */
+UCHAR CBatchTraceRoute::GetStartHop() const noexcept
+{
+	ULONGLONG nStartHop{ m_nStartHop };
+	if (nStartHop == 0)
+		nStartHop = (m_nPaths > 0) ? (m_nPathHops / m_nPaths / 2) : 1;
+	if (nStartHop < 1)
+		nStartHop = 1;
+	return (nStartHop < m_nHopCount) ? static_cast<UCHAR>(nStartHop) : m_nHopCount;
+}
+
+/**
+ * @brief Checks whether a hop is the destination
+ * @param htrr The hop
+ * @param destAddress The destination
+ * @return true if the destination answered, or an echo reply came back from anywhere
+ */
+bool CBatchTraceRoute::IsDestinationReply(const CHostTraceMultiReplyv4& htrr, const SOCKADDR_IN& destAddress) noexcept
+{
+	if (htrr.nStatus == IP_REQ_TIMED_OUT)
+		return false;
+	return (htrr.nStatus == IP_SUCCESS) || (htrr.Address.sin_addr.s_addr == destAddress.sin_addr.s_addr);
+}
+
+/**
+ * @brief Probes one hop of a destination
+ * @param target The destination
+ * @param nTTL The hop
+ * @param htrr Receives the outcome
+ * @return false if the run was cancelled
+ */
+bool CBatchTraceRoute::ProbeTargetHop(CBatchTraceTarget& target, UCHAR nTTL, CHostTraceMultiReplyv4& htrr)
+{
+	ProbeHopv4(target.Address, nTTL, htrr, m_Replies, false, m_dwTimeout, m_dwPingsPerHost, m_wDataSize, m_nTOS, false, false, m_pLocalAddress);
+	target.nProbedHops++;
+	return !m_bCancelled;
+}
+
+/**
+ * @brief Traces the route to one destination, forwards and backwards from the start hop
+ * @param nTarget Index of the destination
+ * @return false if the run was cancelled
+ */
+bool CBatchTraceRoute::TraceTarget(size_t nTarget)
+{
+	CBatchTraceTarget& target{ m_Targets[nTarget] };
+	target.trr.clear();
+	target.nProbedHops = 0;
+	target.nCopiedHops = 0;
+	target.nStartHop = GetStartHop();
+	ResetHopTimeouts(m_nHopCount, m_dwTimeout);
+	std::vector<CHostTraceMultiReplyv4> hops(m_nHopCount);
+	const ULONG nPrefix{ ntohl(target.Address.sin_addr.s_addr) & m_nPrefixMask };
+
+	// Forwards from the start hop, just like Tracev4 would from hop 1
+	m_StopReason = StopReason::HopCount;
+	UCHAR nSilentHops{ 0 };
+	UCHAR nPathHops{ 0 };
+	for (UCHAR nTTL = target.nStartHop; nTTL <= m_nHopCount; nTTL++)
+	{
+		CHostTraceMultiReplyv4& htrr{ hops[nTTL - 1] };
+		if (!ProbeTargetHop(target, nTTL, htrr))
+			return false;
+		nPathHops = nTTL;
+		if (CheckStopPolicies(IsDestinationReply(htrr, target.Address), htrr.nStatus, htrr.dwError, nSilentHops))
+			break;
+
+		// A hop already seen on the way to this prefix leads where it led before, up to the destination itself
+		const ULONG nAddress{ HopAddress(htrr) };
+		if (nAddress == 0)
+			continue;
+		const auto it{ m_GlobalStopSet.find(StopSetKey(nAddress, nPrefix)) };
+		if (it == m_GlobalStopSet.end())
+			continue;
+		const CBatchTraceTarget& known{ m_Targets[it->second.nTarget] };
+		if (!known.HasReachedDestination())
+			continue;
+		for (size_t i = it->second.nTTL; ((i + 1) < known.trr.size()) && (nTTL < m_nHopCount); i++)
+		{
+			hops[nTTL] = known.trr[i];
+			nSilentHops = (known.trr[i].nStatus == IP_REQ_TIMED_OUT) ? static_cast<UCHAR>(nSilentHops + 1) : 0;
+			target.nCopiedHops++;
+			nTTL++;
+		}
+		nPathHops = nTTL;
+	}
+	target.Reason = m_StopReason;
+
+	// Backwards from the start hop. When the start hop already was the destination, the path may be shorter still
+	bool bFindDestination{ (target.Reason == StopReason::DestinationReached) && (nPathHops == target.nStartHop) };
+	for (UCHAR nTTL = static_cast<UCHAR>(target.nStartHop - 1); nTTL >= 1; nTTL--)
+	{
+		CHostTraceMultiReplyv4& htrr{ hops[nTTL - 1] };
+		if (!ProbeTargetHop(target, nTTL, htrr))
+			return false;
+		if (bFindDestination && IsDestinationReply(htrr, target.Address))
+		{
+			nPathHops = nTTL;
+			continue;
+		}
+		bFindDestination = false;
+
+		// A hop already seen at this TTL is reached the way it was reached before
+		const ULONG nAddress{ HopAddress(htrr) };
+		if (nAddress == 0)
+			continue;
+		const auto it{ m_LocalStopSet.find(StopSetKey(nAddress, nTTL)) };
+		if (it == m_LocalStopSet.end())
+			continue;
+		const CBatchTraceTarget& known{ m_Targets[it->second.nTarget] };
+		for (size_t i = 0; (i + 1) < nTTL; i++)
+			hops[i] = known.trr[i];
+		target.nCopiedHops = static_cast<UCHAR>(target.nCopiedHops + nTTL - 1);
+		break;
+	}
+
+	target.trr.assign(hops.begin(), hops.begin() + nPathHops);
+	LearnPath(nTarget);
+	return true;
+}
+
+/**
+ * @brief Adds the hops of a traced path to the stop sets
+ * @param nTarget Index of the destination whose path was traced
+ */
+void CBatchTraceRoute::LearnPath(size_t nTarget)
+{
+	const CBatchTraceTarget& target{ m_Targets[nTarget] };
+	const ULONG nPrefix{ ntohl(target.Address.sin_addr.s_addr) & m_nPrefixMask };
+	for (size_t i = 0; i < target.trr.size(); i++)
+	{
+		const CHostTraceMultiReplyv4& htrr{ target.trr[i] };
+		const ULONG nAddress{ HopAddress(htrr) };
+		if ((nAddress == 0) || IsDestinationReply(htrr, target.Address))
+			continue;
+		const CHopLocation location{ nTarget, static_cast<UCHAR>(i + 1) };
+		m_LocalStopSet.emplace(StopSetKey(nAddress, static_cast<ULONG>(i + 1)), location);
+		m_GlobalStopSet.emplace(StopSetKey(nAddress, nPrefix), location);
+	}
+	m_nPathHops += target.trr.size();
+	m_nPaths++;
+}
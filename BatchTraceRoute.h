@@ -0,0 +1,117 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// BatchTraceRoute.h : interface of the CBatchTraceRoute class, which traces the routes to many IPv4 destinations
+// without probing the hops they share over and over (Doubletree).
+//
+
+#pragma once
+
+#include "tracer.h"
+#include <unordered_map>
+
+// The per destination state and result of a batch traceroute
+struct CBatchTraceTarget
+{
+	SOCKADDR_IN Address{};                // The destination
+	CTraceRoute::CReplyv4 trr;            // Its hops, as CTraceRoute::Tracev4 would give them
+	CTraceRoute::StopReason Reason{ CTraceRoute::StopReason::HopCount }; // Why the trace stopped
+	UCHAR nStartHop{ 0 };                 // The TTL probing started at
+	UCHAR nProbedHops{ 0 };               // Hops which were probed
+	UCHAR nCopiedHops{ 0 };               // Hops taken from the stop sets instead of being probed
+
+	bool HasReachedDestination() const noexcept { return Reason == CTraceRoute::StopReason::DestinationReached; }
+};
+
+// The totals of a batch traceroute
+struct CBatchTraceSummary
+{
+	size_t nTargets{ 0 };                 // Destinations traced
+	size_t nReached{ 0 };                 // Destinations which answered
+	ULONGLONG nProbesSent{ 0 };           // Echo requests sent
+	ULONGLONG nProbedHops{ 0 };           // Hops probed
+	ULONGLONG nCopiedHops{ 0 };           // Hops taken from the stop sets
+	ULONGLONG nElapsed{ 0 };              // Duration of the run in microseconds
+};
+
+// CBatchTraceRoute: the Doubletree algorithm of Donnet et al. for a single vantage point. Every destination is
+// first probed mid-path, at the start hop, and from there
+// - forwards, until the destination answers, a termination policy of CTraceRoute ends the trace, or a hop turns
+//   up which the global stop set knows on the way to the same destination prefix. The hops after it are then
+//   taken from the path which put it there, and probing resumes at the hop where that path reached its own
+//   destination;
+// - backwards, until a hop turns up which the local stop set knows at the same TTL. The hops before it are then
+//   taken from the path which put it there.
+// Destinations behind a shared upstream thus cost a few probes each instead of a probe for every hop. The
+// destinations are traced one after the other, as every trace feeds the stop sets of the next ones. The
+// probes themselves are those of CTraceRoute, with its per hop adaptive timeouts and termination policies.
+class CBatchTraceRoute : public CTraceRoute
+{
+public:
+	CBatchTraceRoute() noexcept;
+	CBatchTraceRoute(const CBatchTraceRoute&) = delete;
+	CBatchTraceRoute(CBatchTraceRoute&&) = delete;
+	virtual ~CBatchTraceRoute() = default;
+
+	CBatchTraceRoute& operator=(const CBatchTraceRoute&) = delete;
+	CBatchTraceRoute& operator=(CBatchTraceRoute&&) = delete;
+
+	// Targets
+	void AddTarget(const SOCKADDR_IN& address);
+	void ClearTargets() noexcept { m_Targets.clear(); }
+	const std::vector<CBatchTraceTarget>& GetTargets() const noexcept { return m_Targets; }
+
+	// Options
+	void SetStartHop(UCHAR nStartHop) noexcept { m_nStartHop = nStartHop; }           // 0 = half the mean length of the paths traced so far
+	void SetPrefixLength(UCHAR nPrefixLength) noexcept;                               // Destination prefix of the global stop set, 24 by default
+
+	bool Run(UCHAR nHopCount = 30, DWORD dwTimeout = 5000, DWORD dwPingsPerHost = 3, WORD wDataSize = 32, UCHAR nTOS = 0, const SOCKADDR_IN* pLocalAddress = nullptr);
+	void Cancel() noexcept { m_bCancelled = true; }     // Stops after the current probe; safe to call from any thread
+	void ClearStopSets();                               // Forgets every hop learned, so the next run starts from scratch
+	const CBatchTraceSummary& GetSummary() const noexcept { return m_Summary; }
+
+protected:
+	// Where a hop was seen: the target whose path it is on and its TTL there
+	struct CHopLocation
+	{
+		size_t nTarget;
+		UCHAR nTTL;
+	};
+
+	// Called on the thread which called Run once a destination has been traced; return false to stop
+	virtual bool OnTargetComplete(size_t /*nTarget*/, const CBatchTraceTarget& /*target*/) { return true; }
+
+	bool TraceTarget(size_t nTarget);
+	bool ProbeTargetHop(CBatchTraceTarget& target, UCHAR nTTL, CHostTraceMultiReplyv4& htrr);
+	void LearnPath(size_t nTarget);
+	UCHAR GetStartHop() const noexcept;
+	static bool IsDestinationReply(const CHostTraceMultiReplyv4& htrr, const SOCKADDR_IN& destAddress) noexcept;
+
+	std::vector<CBatchTraceTarget> m_Targets;                     // The destinations and their paths
+	std::unordered_map<ULONGLONG, CHopLocation> m_LocalStopSet;   // (hop address, TTL) pairs seen so far
+	std::unordered_map<ULONGLONG, CHopLocation> m_GlobalStopSet;  // (hop address, destination prefix) pairs seen so far
+	std::vector<CHostTraceSingleReplyv4> m_Replies;               // Scratch space of ProbeHopv4
+	CBatchTraceSummary m_Summary;                                 // The totals of the last run
+	ULONGLONG m_nPathHops;                                        // Hops of all the paths traced so far, for the automatic start hop
+	size_t m_nPaths;                                              // Paths traced so far
+	const SOCKADDR_IN* m_pLocalAddress;                           // The options of the run in progress
+	DWORD m_dwTimeout;
+	DWORD m_dwPingsPerHost;
+	WORD m_wDataSize;
+	UCHAR m_nTOS;
+	UCHAR m_nHopCount;
+	UCHAR m_nStartHop;                                            // 0 = automatic
+	ULONG m_nPrefixMask;                                          // Host order mask of the destination prefix
+};
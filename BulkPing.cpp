@@ -0,0 +1,411 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// BulkPing.cpp : implementation of the CBulkPing class
+//
+
+#include "pch.h"
+#include "BulkPing.h"
+#include <fstream>
+
+/**
+ * @brief Default constructor for CBulkPing; one request per target, two retries and 1000 requests per second
+ */
+CBulkPing::CBulkPing() noexcept :
+	m_bCancelled{ false },
+	m_nMaxResolvers{ 16 },
+	m_dwInterval{ 1000 },
+	m_nRetries{ 2 },
+	m_nCount{ 1 },
+	m_dwTimeout{ 1000 },
+	m_wDataSize{ 32 },
+	m_nTTL{ 128 }
+{
+}
+
+/**
+ * @brief Adds a target to the target list
+ * @param pszTarget A host name, an address literal or a CIDR block such as 192.0.2.0/24 or 2001:db8::/120
+ * @param nFamily The address family used to resolve host names (AF_INET or AF_INET6)
+ * @return true if the target was added; a host name which cannot be resolved is still added (with nFamily
+ * set to AF_UNSPEC) so that it shows up in the summary
+ */
+bool CBulkPing::AddTarget(LPCTSTR pszTarget, int nFamily)
+{
+	const std::basic_string<TCHAR> sTarget{ pszTarget };
+	const size_t nSlash{ sTarget.find(_T('/')) };
+	if (nSlash == std::basic_string<TCHAR>::npos)
+	{
+		CBulkPingTarget target;
+		target.sName = sTarget;
+		target.nFamily = nFamily;
+		const int nError{ ResolveTarget(target) };
+		m_Targets.push_back(std::move(target));
+		SetLastError(static_cast<DWORD>(nError));
+		return nError == 0;
+	}
+
+	// A CIDR block: the family comes from the literal itself
+	const std::basic_string<TCHAR> sAddress{ sTarget.substr(0, nSlash) };
+	const int nRangeFamily{ (sAddress.find(_T(':')) != std::basic_string<TCHAR>::npos) ? AF_INET6 : AF_INET };
+	UINT nPrefixLength{ 0 };
+	size_t nDigits{ 0 };
+	for (size_t i = nSlash + 1; (i < sTarget.size()) && (sTarget[i] >= _T('0')) && (sTarget[i] <= _T('9')) && (nDigits < 3); i++, nDigits++)
+		nPrefixLength = (nPrefixLength * 10) + static_cast<UINT>(sTarget[i] - _T('0'));
+	if ((nDigits == 0) || ((nSlash + 1 + nDigits) != sTarget.size()))
+	{
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return false;
+	}
+	SOCKADDR_STORAGE address{};
+#pragma warning(suppress: 26490)
+	const int nError{ CPingSession::ResolveAddress(sAddress.c_str(), AI_NUMERICHOST, nRangeFamily, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) };
+	if (nError != 0)
+	{
+		SetLastError(static_cast<DWORD>(nError));
+		return false;
+	}
+	return AddRange(address, nRangeFamily, nPrefixLength);
+}
+
+/**
+ * @brief Adds many targets to the target list
+ * @param targets Host names, address literals or CIDR blocks
+ * @param nFamily The address family used to resolve host names (AF_INET or AF_INET6)
+ * @return The number of targets which were added and resolved
+ * @details Unlike calling AddTarget for each of them, the host names are looked up in parallel by up to
+ * m_nMaxResolvers threads, so a long list of names costs roughly the slowest lookups rather than the sum of
+ * all of them. Every answer also lands in CHostNameCache, so pinging the same names again later is free.
+ */
+size_t CBulkPing::AddTargets(const std::vector<std::basic_string<TCHAR>>& targets, int nFamily)
+{
+	const size_t nFirstTarget{ m_Targets.size() };
+	std::vector<size_t> hostIndexes;
+	for (const auto& sTarget : targets)
+	{
+		// CIDR blocks are literals, so AddTarget adds them without a lookup
+		if (sTarget.find(_T('/')) != std::basic_string<TCHAR>::npos)
+		{
+			AddTarget(sTarget.c_str(), nFamily);
+			continue;
+		}
+		CBulkPingTarget target;
+		target.sName = sTarget;
+		target.nFamily = nFamily;
+		hostIndexes.push_back(m_Targets.size());
+		m_Targets.push_back(std::move(target));
+	}
+	ResolveTargets(hostIndexes);
+
+	size_t nAdded{ 0 };
+	for (size_t i = nFirstTarget; i < m_Targets.size(); i++)
+	{
+		if (m_Targets[i].nFamily != AF_UNSPEC)
+			++nAdded;
+	}
+	return nAdded;
+}
+
+/**
+ * @brief Resolves the addresses of the given targets using at most m_nMaxResolvers threads
+ * @param indexes The indexes in m_Targets of the targets to resolve
+ * @details Each thread claims the next unresolved target from a shared counter and only ever writes to the
+ * target it claimed, so no further locking is needed
+ */
+void CBulkPing::ResolveTargets(const std::vector<size_t>& indexes)
+{
+	const size_t nThreads{ (std::min)(m_nMaxResolvers, indexes.size()) };
+	if (nThreads <= 1)
+	{
+		for (const size_t nIndex : indexes)
+			ResolveTarget(m_Targets[nIndex]);
+		return;
+	}
+
+	std::atomic<size_t> nNext{ 0 };
+	const auto Resolver{ [&]()
+	{
+		for (size_t i = nNext++; i < indexes.size(); i = nNext++)
+			ResolveTarget(m_Targets[indexes[i]]);
+	} };
+	std::vector<std::thread> threads;
+	threads.reserve(nThreads - 1);
+	for (size_t i = 1; i < nThreads; i++)
+		threads.emplace_back(Resolver);
+	Resolver();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+/**
+ * @brief Resolves the address of a target from its name and family
+ * @param target The target; on failure its family is set to AF_UNSPEC and the error kept in dwLastError
+ * @return 0 on success, otherwise the resolver error
+ */
+int CBulkPing::ResolveTarget(CBulkPingTarget& target)
+{
+#pragma warning(suppress: 26490)
+	const int nError{ CPingSession::ResolveAddress(target.sName.c_str(), 0, target.nFamily, reinterpret_cast<SOCKADDR*>(&target.Address), sizeof(target.Address)) };
+	if (nError != 0)
+	{
+		target.nFamily = AF_UNSPEC;
+		target.dwLastError = static_cast<DWORD>(nError);
+	}
+	return nError;
+}
+
+/**
+ * @brief Adds every address of a CIDR block to the target list
+ * @param address Any address inside the block
+ * @param nFamily AF_INET or AF_INET6
+ * @param nPrefixLength The prefix length of the block
+ * @return true if the block was added, false if the prefix is invalid or the block is too large
+ * @details For IPv4 blocks with at least 4 addresses the network and broadcast addresses are skipped
+ */
+bool CBulkPing::AddRange(const SOCKADDR_STORAGE& address, int nFamily, UINT nPrefixLength)
+{
+	const UINT nAddressBits{ (nFamily == AF_INET6) ? 128U : 32U };
+	if ((nPrefixLength > nAddressBits) || ((nAddressBits - nPrefixLength) > MAX_RANGE_BITS))
+	{
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return false;
+	}
+	const UINT nHostBits{ nAddressBits - nPrefixLength };
+	const DWORD nCount{ DWORD{ 1 } << nHostBits };
+	const DWORD nHostMask{ nCount - 1 };
+	DWORD nFirst{ 0 };
+	DWORD nLast{ nHostMask };
+	if ((nFamily == AF_INET) && (nHostBits >= 2))
+	{
+		nFirst = 1;
+		nLast = nHostMask - 1;
+	}
+	m_Targets.reserve(m_Targets.size() + (nLast - nFirst) + 1);
+
+	CBulkPingTarget target;
+	target.nFamily = nFamily;
+	target.Address = address;
+	for (DWORD nHost = nFirst; nHost <= nLast; nHost++)
+	{
+		// The host part never exceeds MAX_RANGE_BITS, so it always lives in the last 32 bits of the address
+#pragma warning(suppress: 26490)
+		BYTE* pLast32{ (nFamily == AF_INET6) ? (reinterpret_cast<SOCKADDR_IN6*>(&target.Address)->sin6_addr.s6_addr + 12) : reinterpret_cast<BYTE*>(&reinterpret_cast<SOCKADDR_IN*>(&target.Address)->sin_addr) };
+		DWORD nLast32{ 0 };
+		memcpy(&nLast32, pLast32, sizeof(nLast32));
+		nLast32 = htonl((ntohl(nLast32) & ~nHostMask) | nHost);
+		memcpy(pLast32, &nLast32, sizeof(nLast32));
+		m_Targets.push_back(target);
+	}
+	return true;
+}
+
+/**
+ * @brief Adds the targets listed in a text file
+ * @param pszFileName The file to read; targets are separated by white space, commas or new lines and
+ * anything following a '#' is a comment
+ * @param nFamily The address family used to resolve host names
+ * @return true if the file was read; targets which could not be added do not fail the load
+ * @details The whole file is read first so that AddTargets can resolve the host names in parallel
+ */
+bool CBulkPing::LoadTargets(LPCTSTR pszFileName, int nFamily)
+{
+	std::ifstream file{ pszFileName };
+	if (!file.is_open())
+	{
+		SetLastError(ERROR_OPEN_FAILED);
+		return false;
+	}
+
+	std::string sLine;
+	std::vector<std::basic_string<TCHAR>> targets;
+	while (std::getline(file, sLine))
+	{
+		const size_t nComment{ sLine.find('#') };
+		if (nComment != std::string::npos)
+			sLine.resize(nComment);
+		size_t nPos{ 0 };
+		while (nPos < sLine.size())
+		{
+			const size_t nStart{ sLine.find_first_not_of(" \t\r,;", nPos) };
+			if (nStart == std::string::npos)
+				break;
+			size_t nEnd{ sLine.find_first_of(" \t\r,;", nStart) };
+			if (nEnd == std::string::npos)
+				nEnd = sLine.size();
+			// Targets are plain ASCII host names and literals, so widening char by char is enough
+			targets.emplace_back(sLine.begin() + static_cast<std::ptrdiff_t>(nStart), sLine.begin() + static_cast<std::ptrdiff_t>(nEnd));
+			nPos = nEnd;
+		}
+	}
+	AddTargets(targets, nFamily);
+	return true;
+}
+
+/**
+ * @brief Pings every target and blocks until all the requests have completed or the run was cancelled
+ * @return true if the run completed, false if the probe engine could not be started or the run was cancelled
+ * @details Requests are issued round robin over the targets, retries first, with consecutive sends spaced
+ * m_dwInterval microseconds apart on absolute deadlines so that the rate does not drift with the time spent
+ * processing completions. A Cancel which comes before Run stops it before its first request.
+ */
+bool CBulkPing::Run()
+{
+	m_Summary = CBulkPingSummary{};
+	m_Summary.nTargets = m_Targets.size();
+	if (!m_Engine.Start())
+	{
+		m_bCancelled = false;
+		return false;
+	}
+
+	// Reset the per target state, reporting the unresolved targets straight away
+	for (auto& target : m_Targets)
+	{
+		target.nSent = 0;
+		target.nReceived = 0;
+		target.minRTT = 0;
+		target.maxRTT = 0;
+		target.totalRTT = 0;
+		target.nLastStatus = IP_REQ_TIMED_OUT;
+		if (target.nFamily == AF_UNSPEC)
+		{
+			target.nPending = 0;
+			OnTargetComplete(target);
+		}
+		else
+		{
+			target.dwLastError = ERROR_TIMEOUT;
+			target.nPending = m_nCount;
+		}
+	}
+
+	CProbeRequest request;
+	request.nTTL = m_nTTL;
+	request.wDataSize = m_wDataSize;
+	request.dwTimeout = m_dwTimeout;
+	std::deque<ULONG_PTR> retries;
+	size_t nNextTarget{ 0 };
+	DWORD nRound{ 0 };
+	const auto HaveWork{ [&]() noexcept { return !retries.empty() || ((nRound < m_nCount) && !m_Targets.empty()); } };
+
+	const ULONGLONG nStart{ CPingClock::NowMicroseconds() };
+	ULONGLONG nNextSend{ nStart };
+	while (!m_bCancelled && (HaveWork() || (m_Engine.GetOutstanding() > 0)))
+	{
+		// Send everything which is due
+		const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+		while (!m_bCancelled && HaveWork() && (nNow >= nNextSend))
+		{
+			ULONG_PTR nCookie{ 0 };
+			if (!retries.empty())
+			{
+				nCookie = retries.front();
+				retries.pop_front();
+			}
+			else
+			{
+				nCookie = static_cast<ULONG_PTR>(nNextTarget) << 8;
+				if (++nNextTarget == m_Targets.size())
+				{
+					nNextTarget = 0;
+					++nRound;
+				}
+			}
+			CBulkPingTarget& target{ m_Targets[nCookie >> 8] };
+			if (target.nFamily == AF_UNSPEC)
+				continue;
+			request.nFamily = target.nFamily;
+			request.Address = target.Address;
+			request.nCookie = nCookie;
+			if (m_Engine.Submit(request))
+			{
+				++target.nSent;
+				++m_Summary.nProbesSent;
+			}
+			else
+			{
+				// The request could not be sent; it counts as failed so that the target still completes
+				target.dwLastError = GetLastError();
+				if ((target.nPending > 0) && (--target.nPending == 0))
+					OnTargetComplete(target);
+			}
+			nNextSend += m_dwInterval;
+		}
+
+		// Service completions until the next send is due
+		DWORD dwWait{ 100 };
+		if (HaveWork())
+			dwWait = (nNextSend > nNow) ? static_cast<DWORD>((nNextSend - nNow + 999) / 1000) : 0;
+		CProbeCompletion completion;
+		if (m_Engine.GetCompletion(completion, dwWait))
+		{
+			OnCompletion(completion, retries);
+			while (m_Engine.GetCompletion(completion, 0))
+				OnCompletion(completion, retries);
+		}
+	}
+
+	// Flush out whatever is still in flight after a cancel
+	m_Engine.Stop();
+	CProbeCompletion completion;
+	while (m_Engine.GetCompletion(completion, 0))
+		OnCompletion(completion, retries);
+
+	m_Summary.nElapsed = CPingClock::NowMicroseconds() - nStart;
+	for (const auto& target : m_Targets)
+	{
+		m_Summary.nRepliesReceived += target.nReceived;
+		if (target.IsAlive())
+			++m_Summary.nAlive;
+	}
+	const bool bCompleted{ !m_bCancelled };
+	m_bCancelled = false;
+	if (!bCompleted)
+		SetLastError(ERROR_CANCELLED);
+	return bCompleted;
+}
+
+/**
+ * @brief Accounts for one completed request, queueing a retry if it timed out
+ * @param completion The completion from the probe engine
+ * @param retries The queue of requests to retry
+ */
+void CBulkPing::OnCompletion(const CProbeCompletion& completion, std::deque<ULONG_PTR>& retries)
+{
+	const size_t nIndex{ static_cast<size_t>(completion.nCookie >> 8) };
+	const DWORD nAttempt{ static_cast<DWORD>(completion.nCookie & 0xFF) };
+	CBulkPingTarget& target{ m_Targets[nIndex] };
+	if (completion.dwError == ERROR_SUCCESS)
+	{
+		if ((target.nReceived == 0) || (completion.RTT < target.minRTT))
+			target.minRTT = completion.RTT;
+		if (completion.RTT > target.maxRTT)
+			target.maxRTT = completion.RTT;
+		target.totalRTT += completion.RTT;
+		++target.nReceived;
+		target.nLastStatus = completion.nStatus;
+		target.dwLastError = ERROR_SUCCESS;
+	}
+	else if ((nAttempt < m_nRetries) && !m_bCancelled)
+	{
+		retries.push_back(completion.nCookie + 1);
+		return;
+	}
+	else
+		target.dwLastError = completion.dwError;
+
+	if ((target.nPending > 0) && (--target.nPending == 0))
+		OnTargetComplete(target);
+}
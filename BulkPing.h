@@ -0,0 +1,117 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// BulkPing.h : interface of the CBulkPing class, an fping style reachability check of
+// thousands of targets multiplexed over the CProbeEngine.
+//
+
+#pragma once
+
+#include "ProbeEngine.h"
+#include <string>
+
+// The per target state and summary of a bulk ping run
+struct CBulkPingTarget
+{
+	std::basic_string<TCHAR> sName;       // The target as written in the target list, empty if expanded from a CIDR block
+	int nFamily{ AF_INET };               // AF_INET or AF_INET6, AF_UNSPEC if the target could not be resolved
+	SOCKADDR_STORAGE Address{};           // The resolved address of the target
+	DWORD nSent{ 0 };                     // Echo requests sent, including retries
+	DWORD nReceived{ 0 };                 // Replies received (echo replies and ICMP errors)
+	ULONGLONG minRTT{ 0 };                // Minimum round trip time in microseconds
+	ULONGLONG maxRTT{ 0 };                // Maximum round trip time in microseconds
+	ULONGLONG totalRTT{ 0 };              // Sum of the round trip times in microseconds
+	ULONG nLastStatus{ IP_REQ_TIMED_OUT }; // The IP_STATUS of the last reply
+	DWORD dwLastError{ ERROR_TIMEOUT };   // ERROR_SUCCESS if the last reply arrived, otherwise the error
+	DWORD nPending{ 0 };                  // Rounds whose outcome is not known yet
+
+	bool IsAlive() const noexcept { return (nReceived > 0) && (nLastStatus == IP_SUCCESS); }
+	ULONGLONG GetAvgRTT() const noexcept { return (nReceived > 0) ? (totalRTT / nReceived) : 0; }
+};
+
+// The totals of a bulk ping run
+struct CBulkPingSummary
+{
+	size_t nTargets{ 0 };                 // Number of targets pinged
+	size_t nAlive{ 0 };                   // Number of targets which answered with an echo reply
+	ULONGLONG nProbesSent{ 0 };           // Echo requests sent, including retries
+	ULONGLONG nRepliesReceived{ 0 };      // Replies received
+	ULONGLONG nElapsed{ 0 };              // Duration of the run in microseconds
+
+	double GetProbesPerSecond() const noexcept { return (nElapsed > 0) ? ((static_cast<double>(nProbesSent) * 1000000.0) / static_cast<double>(nElapsed)) : 0.0; }
+};
+
+// CBulkPing: pings every target of a target list (host names, address literals or CIDR blocks) through a
+// single CProbeEngine, so that all the targets share one ICMP handle / socket per address family and the
+// replies are matched back to their target by identifier and sequence number. Sends are paced on absolute
+// deadlines, timed out requests are retried and a per target summary is produced.
+class CBulkPing
+{
+public:
+	CBulkPing() noexcept;
+	CBulkPing(const CBulkPing&) = delete;
+	CBulkPing(CBulkPing&&) = delete;
+	virtual ~CBulkPing() = default;
+
+	CBulkPing& operator=(const CBulkPing&) = delete;
+	CBulkPing& operator=(CBulkPing&&) = delete;
+
+	// Target list
+	bool AddTarget(LPCTSTR pszTarget, int nFamily);     // Adds a host name, address literal or CIDR block (e.g. 192.0.2.0/24)
+	bool LoadTargets(LPCTSTR pszFileName, int nFamily); // Adds one target per line; blank lines and '#' comments are skipped
+	size_t AddTargets(const std::vector<std::basic_string<TCHAR>>& targets, int nFamily); // Adds many targets, resolving the host names in parallel
+	void ClearTargets() noexcept { m_Targets.clear(); }
+	const std::vector<CBulkPingTarget>& GetTargets() const noexcept { return m_Targets; }
+
+	// Options
+	void SetInterval(DWORD dwInterval) noexcept { m_dwInterval = dwInterval; } // Time between consecutive sends in microseconds, 0 = no pacing
+	void SetRetries(DWORD nRetries) noexcept { m_nRetries = (nRetries > MAX_RETRIES) ? MAX_RETRIES : nRetries; } // Retries of a timed out request
+	void SetCount(DWORD nCount) noexcept { m_nCount = nCount; }                 // Rounds of requests sent to every target
+	void SetTimeout(DWORD dwTimeout) noexcept { m_dwTimeout = dwTimeout; }      // Timeout of each request in milliseconds
+	void SetDataSize(WORD wDataSize) noexcept { m_wDataSize = wDataSize; }
+	void SetTTL(UCHAR nTTL) noexcept { m_nTTL = nTTL; }
+	void SetMaxResolvers(size_t nMaxResolvers) noexcept { m_nMaxResolvers = (nMaxResolvers > 0) ? nMaxResolvers : 1; } // Host names looked up at the same time
+	DWORD GetInterval() const noexcept { return m_dwInterval; }
+	DWORD GetRetries() const noexcept { return m_nRetries; }
+	DWORD GetCount() const noexcept { return m_nCount; }
+
+	bool Run();                                         // Pings every target and blocks until all the requests completed
+	void Cancel() noexcept { m_bCancelled = true; }     // Stops sending new requests; safe to call from any thread
+	const CBulkPingSummary& GetSummary() const noexcept { return m_Summary; }
+
+protected:
+	// Called on the thread which called Run once the outcome of every round of a target is known
+	virtual void OnTargetComplete(const CBulkPingTarget& /*target*/) {}
+
+	bool AddRange(const SOCKADDR_STORAGE& address, int nFamily, UINT nPrefixLength);
+	void ResolveTargets(const std::vector<size_t>& indexes);
+	static int ResolveTarget(CBulkPingTarget& target);
+	void OnCompletion(const CProbeCompletion& completion, std::deque<ULONG_PTR>& retries);
+
+	static const UINT MAX_RANGE_BITS{ 20 };  // The largest CIDR block accepted is 2^20 addresses
+	static const DWORD MAX_RETRIES{ 0xFF };  // The request cookie holds the target index and the attempt in its low byte
+
+	std::vector<CBulkPingTarget> m_Targets; // The targets and their summary
+	CBulkPingSummary m_Summary;             // The totals of the last run
+	CProbeEngine m_Engine;                  // Multiplexes all the requests
+	std::atomic<bool> m_bCancelled;         // Set by Cancel
+	size_t m_nMaxResolvers;                 // Host names looked up at the same time by AddTargets
+	DWORD m_dwInterval;                     // Time between consecutive sends in microseconds
+	DWORD m_nRetries;                       // Retries of a timed out request
+	DWORD m_nCount;                         // Rounds of requests sent to every target
+	DWORD m_dwTimeout;                      // Timeout of each request in milliseconds
+	WORD m_wDataSize;                       // Payload size of each request in bytes
+	UCHAR m_nTTL;                           // TTL of each request
+};
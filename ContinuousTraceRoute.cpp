@@ -0,0 +1,235 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ContinuousTraceRoute.cpp : implementation of the CContinuousTraceRoute class
+//
+
+#include "pch.h"
+#include "ContinuousTraceRoute.h"
+
+/**
+ * @brief Discards everything known about the hop
+ */
+void CTraceHopStatistics::Reset() noexcept
+{
+	Address = SOCKADDR_STORAGE{};
+	nLastStatus = IP_REQ_TIMED_OUT;
+	nLastRTT = 0;
+	nAddressChanges = 0;
+	Stats.Reset();
+	Window.reset();
+	nWindowNext = 0;
+	nWindowCount = 0;
+}
+
+/**
+ * @brief Accounts for a probe of the hop which was answered
+ * @param pAddress The address which answered
+ * @param nStatus The IP_STATUS of the answer, IP_TTL_EXPIRED_TRANSIT for the hops before the destination
+ * @param nRTT Round trip time in microseconds
+ */
+void CTraceHopStatistics::AddReply(const SOCKADDR* pAddress, ULONG nStatus, ULONGLONG nRTT) noexcept
+{
+	SOCKADDR_STORAGE address{};
+	if (pAddress != nullptr)
+		memcpy(&address, pAddress, (pAddress->sa_family == AF_INET6) ? sizeof(SOCKADDR_IN6) : sizeof(SOCKADDR_IN));
+	if (HasAnswered() && (memcmp(&address, &Address, sizeof(address)) != 0))
+		++nAddressChanges;
+	Address = address;
+	nLastStatus = nStatus;
+	nLastRTT = nRTT;
+	Stats.AddReply(nRTT);
+	Window.reset(nWindowNext);
+	nWindowNext = (nWindowNext + 1) % LOSS_WINDOW;
+	if (nWindowCount < LOSS_WINDOW)
+		++nWindowCount;
+}
+
+/**
+ * @brief Accounts for a probe of the hop which was not answered
+ */
+void CTraceHopStatistics::AddLoss() noexcept
+{
+	nLastStatus = IP_REQ_TIMED_OUT;
+	Stats.AddLoss();
+	Window.set(nWindowNext);
+	nWindowNext = (nWindowNext + 1) % LOSS_WINDOW;
+	if (nWindowCount < LOSS_WINDOW)
+		++nWindowCount;
+}
+
+/**
+ * @brief Gets the loss ratio of the hop over the last LOSS_WINDOW probes
+ * @return The ratio of lost probes, 0 before the first probe
+ */
+double CTraceHopStatistics::GetRollingLoss() const noexcept
+{
+	return (nWindowCount > 0) ? (static_cast<double>(Window.count()) / static_cast<double>(nWindowCount)) : 0.0;
+}
+
+/**
+ * @brief Default constructor for CContinuousTraceRoute; 30 hops, one cycle per second and a snapshot every 10 cycles
+ */
+CContinuousTraceRoute::CContinuousTraceRoute() noexcept :
+	m_DestAddress{},
+	m_bCancelled{ false },
+	m_nCycles{ 0 },
+	m_nMaxCycles{ 0 },
+	m_dwTimeout{ 1000 },
+	m_dwCycleInterval{ 1000 },
+	m_nSnapshotInterval{ 10 },
+	m_wDataSize{ 32 },
+	m_nHopCount{ 30 },
+	m_nDestinationHop{ 0 }
+{
+}
+
+/**
+ * @brief Stops the run once the current cycle is complete
+ */
+void CContinuousTraceRoute::Cancel() noexcept
+{
+	m_bCancelled = true;
+	m_Scheduler.Cancel();
+}
+
+/**
+ * @brief Gets the length of the path
+ * @return The TTL at which the destination answered in the last cycle; while it does not answer, the largest TTL
+ * which ever got an answer
+ */
+size_t CContinuousTraceRoute::GetPathLength() const noexcept
+{
+	if (m_nDestinationHop > 0)
+		return m_nDestinationHop;
+	for (size_t i = m_Hops.size(); i > 0; i--)
+	{
+		if (m_Hops[i - 1].HasAnswered())
+			return i;
+	}
+	return 0;
+}
+
+/**
+ * @brief Cycles through the path until the run is cancelled, OnSnapshot returns false or m_nMaxCycles cycles ran
+ * @param destAddress The already resolved destination, AF_INET or AF_INET6
+ * @return true if the run completed or was stopped, false if the probe engine or the scheduler could not be started
+ * @details A Cancel which comes before Run stops it before its first cycle; the next Run starts afresh.
+ */
+bool CContinuousTraceRoute::Run(const SOCKADDR_STORAGE& destAddress)
+{
+	m_DestAddress = destAddress;
+	m_nCycles = 0;
+	m_nDestinationHop = 0;
+
+	// Everything a cycle touches is sized here, once
+	m_Hops.resize(m_nHopCount);
+	for (auto& hop : m_Hops)
+		hop.Reset();
+	m_Cycle.resize(m_nHopCount);
+	if (!m_Engine.Start())
+	{
+		m_bCancelled = false;
+		return false;
+	}
+	if (!m_Scheduler.Start(static_cast<ULONGLONG>(m_dwCycleInterval) * 1000ULL))
+	{
+		m_Engine.Stop();
+		m_bCancelled = false;
+		return false;
+	}
+
+	bool bContinue{ true };
+	while (bContinue && !m_bCancelled && ((m_nMaxCycles == 0) || (m_nCycles < m_nMaxCycles)) && m_Scheduler.WaitForNextDeadline())
+	{
+		if (!RunCycle())
+			break;
+		++m_nCycles;
+		if ((m_nSnapshotInterval > 0) && ((m_nCycles % m_nSnapshotInterval) == 0))
+			bContinue = OnSnapshot(m_nCycles);
+	}
+	m_Engine.Stop();
+	m_bCancelled = false;
+
+	// The final snapshot, unless the last cycle just produced one
+	if ((m_nCycles > 0) && ((m_nSnapshotInterval == 0) || ((m_nCycles % m_nSnapshotInterval) != 0)))
+		OnSnapshot(m_nCycles);
+	return true;
+}
+
+/**
+ * @brief Probes every TTL of the path once, all at the same time, and folds the outcomes into the hop statistics
+ * @return false if the probes could not be sent
+ * @details The outcomes are only accounted for once the whole cycle is in, because the hops beyond the TTL at
+ * which the destination answered are the destination again and must not be counted as hops of the path.
+ */
+bool CContinuousTraceRoute::RunCycle()
+{
+	const UCHAR nProbeHops{ (m_nDestinationHop > 0) ? m_nDestinationHop : m_nHopCount };
+	CProbeRequest request;
+	request.nFamily = m_DestAddress.ss_family;
+	request.Address = m_DestAddress;
+	request.wDataSize = m_wDataSize;
+	request.dwTimeout = m_dwTimeout;
+	for (UCHAR i = 0; i < nProbeHops; i++)
+	{
+		request.nTTL = static_cast<UCHAR>(i + 1);
+		request.nCookie = (static_cast<ULONG_PTR>(m_nCycles) << 8) | i;
+		m_Cycle[i] = CProbeCompletion{};
+		m_Cycle[i].dwError = ERROR_TIMEOUT;
+		if (!m_Engine.Submit(request))
+			return false;
+	}
+
+	// Every probe completes within its timeout; the margin covers a busy worker thread. The cookie also holds the
+	// cycle, so a straggler of an earlier cycle is never mistaken for a probe of this one
+	CProbeCompletion completion;
+	for (UCHAR nCompleted = 0; nCompleted < nProbeHops; )
+	{
+		if (!m_Engine.GetCompletion(completion, m_dwTimeout + 1000))
+			break;
+		const size_t nHop{ static_cast<size_t>(completion.nCookie & 0xFF) };
+		if (((completion.nCookie >> 8) != (static_cast<ULONG_PTR>(m_nCycles) & (~ULONG_PTR{ 0 } >> 8))) || (nHop >= nProbeHops))
+			continue;
+		m_Cycle[nHop] = completion;
+		++nCompleted;
+	}
+
+	// Find where the destination answered: an echo reply, or any answer from the destination address itself
+	const size_t nAddressLen{ (m_DestAddress.ss_family == AF_INET6) ? sizeof(SOCKADDR_IN6) : sizeof(SOCKADDR_IN) };
+	UCHAR nDestinationHop{ 0 };
+	for (UCHAR i = 0; (i < nProbeHops) && (nDestinationHop == 0); i++)
+	{
+		const CProbeCompletion& outcome{ m_Cycle[i] };
+		if (outcome.dwError != ERROR_SUCCESS)
+			continue;
+		const bool bFromDestination{ (outcome.Replier.ss_family == m_DestAddress.ss_family) && (memcmp(&outcome.Replier, &m_DestAddress, nAddressLen) == 0) };
+		if ((outcome.nStatus == IP_SUCCESS) || bFromDestination)
+			nDestinationHop = static_cast<UCHAR>(i + 1);
+	}
+
+	const UCHAR nPathHops{ (nDestinationHop > 0) ? nDestinationHop : nProbeHops };
+	for (UCHAR i = 0; i < nPathHops; i++)
+	{
+		const CProbeCompletion& outcome{ m_Cycle[i] };
+		if (outcome.dwError == ERROR_SUCCESS)
+#pragma warning(suppress: 26490)
+			m_Hops[i].AddReply(reinterpret_cast<const SOCKADDR*>(&outcome.Replier), outcome.nStatus, outcome.RTT);
+		else
+			m_Hops[i].AddLoss();
+	}
+	m_nDestinationHop = nDestinationHop;
+	return true;
+}
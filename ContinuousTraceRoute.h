@@ -0,0 +1,97 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ContinuousTraceRoute.h : interface of the CContinuousTraceRoute class, an MTR style traceroute which keeps
+// cycling through the path and maintains rolling statistics for every hop.
+//
+
+#pragma once
+
+#include "ProbeEngine.h"
+#include "ProbeStatistics.h"
+#include "IntervalScheduler.h"
+#include <bitset>
+
+// The statistics of one hop of a continuously traced path; their size does not depend on the number of cycles
+struct CTraceHopStatistics
+{
+	static const size_t LOSS_WINDOW{ 100 };   // Cycles over which the rolling loss is computed
+
+	SOCKADDR_STORAGE Address{};           // The address which answered last, its family AF_UNSPEC until one did
+	ULONG nLastStatus{ IP_REQ_TIMED_OUT }; // The IP_STATUS of the last probe
+	ULONGLONG nLastRTT{ 0 };              // Round trip time of the last reply in microseconds
+	DWORD nAddressChanges{ 0 };           // How often a different address answered than the time before
+	CProbeStatistics Stats;               // Sent / received, best / worst / avg / stddev and the latency histogram
+	std::bitset<LOSS_WINDOW> Window;      // The outcome of the last LOSS_WINDOW probes, a set bit is a loss
+	size_t nWindowNext{ 0 };              // The slot of Window the next probe goes into
+	size_t nWindowCount{ 0 };             // Probes in Window so far
+
+	void Reset() noexcept;
+	void AddReply(const SOCKADDR* pAddress, ULONG nStatus, ULONGLONG nRTT) noexcept;
+	void AddLoss() noexcept;
+	double GetRollingLoss() const noexcept; // Loss ratio over the last LOSS_WINDOW probes
+	bool HasAnswered() const noexcept { return Address.ss_family != AF_UNSPEC; }
+};
+
+// CContinuousTraceRoute: every cycle sends one probe per TTL, all of them at the same time through a single
+// CProbeEngine, and folds the replies into the per hop statistics. Once the destination has answered only the
+// TTLs up to it are probed; when it stops answering the next cycle probes the full hop count again. The hop
+// table is sized once when the run starts, so a cycle costs the same however long the run lasts.
+class CContinuousTraceRoute
+{
+public:
+	CContinuousTraceRoute() noexcept;
+	CContinuousTraceRoute(const CContinuousTraceRoute&) = delete;
+	CContinuousTraceRoute(CContinuousTraceRoute&&) = delete;
+	virtual ~CContinuousTraceRoute() = default;
+
+	CContinuousTraceRoute& operator=(const CContinuousTraceRoute&) = delete;
+	CContinuousTraceRoute& operator=(CContinuousTraceRoute&&) = delete;
+
+	// Options
+	void SetHopCount(UCHAR nHopCount) noexcept { m_nHopCount = (nHopCount > 0) ? nHopCount : 1; }
+	void SetTimeout(DWORD dwTimeout) noexcept { m_dwTimeout = dwTimeout; }           // Timeout of each probe in milliseconds
+	void SetCycleInterval(DWORD dwInterval) noexcept { m_dwCycleInterval = dwInterval; } // Time between the start of consecutive cycles in milliseconds
+	void SetDataSize(WORD wDataSize) noexcept { m_wDataSize = wDataSize; }
+	void SetSnapshotInterval(DWORD nCycles) noexcept { m_nSnapshotInterval = nCycles; } // OnSnapshot every this many cycles, 0 = only at the end
+	void SetMaxCycles(ULONGLONG nCycles) noexcept { m_nMaxCycles = nCycles; }        // Cycles to run, 0 = until cancelled
+
+	bool Run(const SOCKADDR_STORAGE& destAddress);      // Cycles through the path until cancelled or m_nMaxCycles is reached
+	void Cancel() noexcept;                             // Stops after the current cycle; safe to call from any thread
+	const std::vector<CTraceHopStatistics>& GetHops() const noexcept { return m_Hops; }
+	size_t GetPathLength() const noexcept;              // Hops up to the destination, or up to the last hop which ever answered
+	ULONGLONG GetCycles() const noexcept { return m_nCycles; }
+
+protected:
+	// Called on the thread which called Run every m_nSnapshotInterval cycles and once at the end; return false to stop
+	virtual bool OnSnapshot(ULONGLONG /*nCycle*/) { return true; }
+
+	bool RunCycle();
+
+	std::vector<CTraceHopStatistics> m_Hops;  // The statistics of every TTL, sized once per run
+	std::vector<CProbeCompletion> m_Cycle;    // The completions of the current cycle indexed by TTL - 1, sized once per run
+	CProbeEngine m_Engine;                    // Sends the probes of a cycle concurrently
+	CIntervalScheduler m_Scheduler;           // Paces the cycles
+	SOCKADDR_STORAGE m_DestAddress;           // The destination being traced
+	std::atomic<bool> m_bCancelled;           // Set by Cancel
+	ULONGLONG m_nCycles;                      // Cycles completed
+	ULONGLONG m_nMaxCycles;                   // Cycles to run, 0 = until cancelled
+	DWORD m_dwTimeout;                        // Timeout of each probe in milliseconds
+	DWORD m_dwCycleInterval;                  // Time between the start of consecutive cycles in milliseconds
+	DWORD m_nSnapshotInterval;                // OnSnapshot every this many cycles
+	WORD m_wDataSize;                         // Payload size of each probe in bytes
+	UCHAR m_nHopCount;                        // The largest TTL probed
+	UCHAR m_nDestinationHop;                  // The TTL at which the destination answered in the last cycle, 0 if it did not
+};
@@ -926,6 +926,22 @@ void CWebBrowser::ExecuteScript(CString const& code)
 	}
 }
 
+/**
+ * @brief Posts a JSON message to the current page, which receives it through window.chrome.webview.
+ * @param json JSON document to post.
+ */
+void CWebBrowser::PostWebMessageAsJson(CString const& json)
+{
+	if (m_pImpl->m_webView != nullptr)
+	{
+		HRESULT hr = m_pImpl->m_webView->PostWebMessageAsJson(CT2W(json).m_psz);
+		if (FAILED(hr))
+		{
+			ShowFailure(hr, L"PostWebMessageAsJson failed");
+		}
+	}
+}
+
 /**
  * @brief Shows the print UI for the current document.
  * @param systemDialog If true, shows the system print dialog; otherwise, shows the browser print dialog.
@@ -213,6 +213,12 @@ public:
 	 */
 	void ExecuteScript(CString const& code);
 
+	/**
+	 * @brief Posts a JSON message to the current page, which receives it through window.chrome.webview.
+	 * @param json JSON document to post.
+	 */
+	void PostWebMessageAsJson(CString const& json);
+
 	/**
 	 * @brief Shows the print UI for the current document.
 	 * @param systemDialog If true, shows the system print dialog; otherwise, shows the browser print dialog.
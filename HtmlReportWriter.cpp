@@ -0,0 +1,119 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// HtmlReportWriter.cpp : implementation of the CHtmlReportWriter class
+//
+
+#include "pch.h"
+#include "HtmlReportWriter.h"
+
+/**
+ * @brief Default constructor for CHtmlReportWriter
+ */
+CHtmlReportWriter::CHtmlReportWriter() noexcept :
+	m_nTailOffset{ 0 }
+{
+}
+
+/**
+ * @brief Destructor for CHtmlReportWriter; closes the file
+ */
+CHtmlReportWriter::~CHtmlReportWriter()
+{
+	Close();
+}
+
+/**
+ * @brief Creates (or truncates) the results file and writes the header and the footer
+ * @param pszFileName Full path of the results file
+ * @param strHeader Everything up to where the result lines go
+ * @param strFooter The closing tags which follow the result lines
+ * @return true if the file was written
+ */
+bool CHtmlReportWriter::Open(LPCTSTR pszFileName, const std::string& strHeader, const std::string& strFooter)
+{
+	Close();
+	m_File.open(pszFileName, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+	if (!m_File.is_open())
+		return false;
+
+	m_strFooter = strFooter;
+	m_File.write(strHeader.data(), static_cast<std::streamsize>(strHeader.size()));
+	m_nTailOffset = strHeader.size();
+	m_File.write(m_strFooter.data(), static_cast<std::streamsize>(m_strFooter.size()));
+	m_File.flush();
+	return m_File.good();
+}
+
+/**
+ * @brief Appends one result line, overwriting the footer and writing it again after the new line
+ * @param pszText The UTF-8 text of the line
+ * @param nLength The length of the text in bytes
+ * @return true if the line was written
+ * @details The line is followed by a line break tag; only the new line and the footer are written, so the
+ * cost does not depend on how many lines the file already holds.
+ */
+bool CHtmlReportWriter::Append(const char* pszText, size_t nLength)
+{
+	return Write(pszText, nLength, true);
+}
+
+/**
+ * @brief Appends markup which is not a result line, such as a script, in front of the footer
+ * @param pszText The UTF-8 markup
+ * @param nLength The length of the markup in bytes
+ * @return true if the markup was written
+ */
+bool CHtmlReportWriter::AppendFragment(const char* pszText, size_t nLength)
+{
+	return Write(pszText, nLength, false);
+}
+
+/**
+ * @brief Writes text over the footer and the footer again after it
+ * @param pszText The UTF-8 text
+ * @param nLength The length of the text in bytes
+ * @param bLineBreak Whether a line break tag follows the text
+ * @return true if the text was written
+ */
+bool CHtmlReportWriter::Write(const char* pszText, size_t nLength, bool bLineBreak)
+{
+	if (!m_File.is_open())
+		return false;
+
+	static const char szLineBreak[]{ "<br>\n" };
+	m_File.seekp(static_cast<std::streamoff>(m_nTailOffset));
+	m_File.write(pszText, static_cast<std::streamsize>(nLength));
+	m_nTailOffset += nLength;
+	if (bLineBreak)
+	{
+		m_File.write(szLineBreak, static_cast<std::streamsize>(sizeof(szLineBreak) - 1));
+		m_nTailOffset += sizeof(szLineBreak) - 1;
+	}
+	m_File.write(m_strFooter.data(), static_cast<std::streamsize>(m_strFooter.size()));
+	m_File.flush();
+	return m_File.good();
+}
+
+/**
+ * @brief Closes the results file
+ */
+void CHtmlReportWriter::Close()
+{
+	if (m_File.is_open())
+		m_File.close();
+	m_File.clear();
+	m_nTailOffset = 0;
+}
@@ -0,0 +1,53 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// HtmlReportWriter.h : interface of the CHtmlReportWriter class, an append-only writer of the
+// HTML results file.
+//
+
+#pragma once
+
+#include <fstream>
+#include <string>
+
+// CHtmlReportWriter: keeps the results file open and appends each line in place. The closing tags live in a
+// fixed tail at the end of the file, which is simply written again after every appended fragment, so the file
+// is a complete document after every line while each line costs the same I/O however long the report is.
+class CHtmlReportWriter
+{
+public:
+	CHtmlReportWriter() noexcept;
+	CHtmlReportWriter(const CHtmlReportWriter&) = delete;
+	CHtmlReportWriter(CHtmlReportWriter&&) = delete;
+	virtual ~CHtmlReportWriter();
+
+	CHtmlReportWriter& operator=(const CHtmlReportWriter&) = delete;
+	CHtmlReportWriter& operator=(CHtmlReportWriter&&) = delete;
+
+	bool Open(LPCTSTR pszFileName, const std::string& strHeader, const std::string& strFooter); // Truncates the file and writes header and footer
+	bool Append(const char* pszText, size_t nLength);  // Appends one UTF-8 line in front of the footer
+	bool Append(const std::string& strText) { return Append(strText.data(), strText.size()); }
+	bool AppendFragment(const char* pszText, size_t nLength); // Appends UTF-8 markup which is not a line of its own, e.g. a script
+	void Close();
+	bool IsOpen() const noexcept { return m_File.is_open(); }
+	unsigned long long GetSize() const noexcept { return m_nTailOffset + m_strFooter.size(); } // Current size of the file in bytes
+
+protected:
+	bool Write(const char* pszText, size_t nLength, bool bLineBreak);
+
+	std::ofstream m_File;                               // The results file
+	std::string m_strFooter;                            // The closing tags which are kept at the end of the file
+	unsigned long long m_nTailOffset;                   // File offset where the footer starts
+};
@@ -0,0 +1,395 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IncrementalTraceRoute.cpp : implementation of the CIncrementalTraceRoute class
+//
+
+#include "pch.h"
+#include "IncrementalTraceRoute.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	/**
+	 * @brief Compares the IPv4 addresses of two socket addresses
+	 * @return true if they are the same address
+	 */
+	bool SameAddress(const SOCKADDR_IN& address1, const SOCKADDR_IN& address2) noexcept
+	{
+		return address1.sin_addr.s_addr == address2.sin_addr.s_addr;
+	}
+
+	/**
+	 * @brief Compares the IPv6 addresses of two socket addresses
+	 * @return true if they are the same address
+	 */
+	bool SameAddress(const SOCKADDR_IN6& address1, const SOCKADDR_IN6& address2) noexcept
+	{
+		return memcmp(&address1.sin6_addr, &address2.sin6_addr, sizeof(address1.sin6_addr)) == 0;
+	}
+
+	/**
+	 * @brief Makes the cache key of an IPv4 destination
+	 * @param address The destination
+	 * @return The key
+	 */
+	CAddressKey MakeKey(const SOCKADDR_IN& address) noexcept
+	{
+		CAddressKey key{};
+		key.nFamily = AF_INET;
+		memcpy(key.Address, &address.sin_addr, sizeof(address.sin_addr));
+		return key;
+	}
+
+	/**
+	 * @brief Makes the cache key of an IPv6 destination
+	 * @param address The destination
+	 * @return The key
+	 */
+	CAddressKey MakeKey(const SOCKADDR_IN6& address) noexcept
+	{
+		CAddressKey key{};
+		key.nFamily = AF_INET6;
+		memcpy(key.Address, &address.sin6_addr, sizeof(address.sin6_addr));
+		return key;
+	}
+
+	/**
+	 * @brief Checks whether a hop answered any of its probes
+	 * @param htrr The hop
+	 * @return true if an address is known for it
+	 */
+	template <typename Hop>
+	bool HasAnswered(const Hop& htrr) noexcept
+	{
+		return htrr.nStatus != IP_REQ_TIMED_OUT;
+	}
+
+	/**
+	 * @brief Checks whether a fresh probe of a hop confirms the cached hop
+	 * @param cached The hop of the cached path
+	 * @param fresh The hop as it answers now
+	 * @return true if both are silent, or both answered from the same address
+	 */
+	template <typename Hop>
+	bool ConfirmsHop(const Hop& cached, const Hop& fresh) noexcept
+	{
+		if (HasAnswered(cached) != HasAnswered(fresh))
+			return false;
+		return !HasAnswered(cached) || SameAddress(cached.Address, fresh.Address);
+	}
+}
+
+/**
+ * @brief Default constructor for CIncrementalTraceRoute; no paths are cached yet
+ */
+CIncrementalTraceRoute::CIncrementalTraceRoute() noexcept :
+	m_LastKind{ RetraceKind::Full }
+{
+}
+
+/**
+ * @brief Forgets every cached path and the totals, so the next trace to every destination is a full one
+ */
+void CIncrementalTraceRoute::ClearRoutes()
+{
+	m_Routesv4.clear();
+	m_Routesv6.clear();
+	m_Summary = CRetraceSummary{};
+}
+
+/**
+ * @brief Traces the path to an IPv4 destination, from its cached path when there is one
+ * @param destAddress The destination
+ * @param trr Receives the hops, as Tracev4 would give them
+ * @param nHopCount The largest TTL probed
+ * @param dwTimeout Timeout of each probe in milliseconds; the ceiling when adaptive timeouts are on
+ * @param dwPingsPerHost Probes sent to each hop which is probed in full
+ * @param wDataSize Payload size of each probe in bytes
+ * @param nTOS Type of service of each probe
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true if the path was traced, false if the trace was cancelled or failed; GetLastError tells why
+ */
+bool CIncrementalTraceRoute::Retrace(const SOCKADDR_IN& destAddress, CReplyv4& trr, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN* pLocalAddress)
+{
+	return RetraceT(destAddress, trr, m_Routesv4, nHopCount, dwTimeout, dwPingsPerHost, wDataSize, nTOS, pLocalAddress);
+}
+
+/**
+ * @brief Traces the path to an IPv6 destination, from its cached path when there is one
+ * @param destAddress The destination
+ * @param trr Receives the hops, as Tracev6 would give them
+ * @param nHopCount The largest hop limit probed
+ * @param dwTimeout Timeout of each probe in milliseconds; the ceiling when adaptive timeouts are on
+ * @param dwPingsPerHost Probes sent to each hop which is probed in full
+ * @param wDataSize Payload size of each probe in bytes
+ * @param nTOS Traffic class of each probe
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true if the path was traced, false if the trace was cancelled or failed; GetLastError tells why
+ */
+bool CIncrementalTraceRoute::Retrace(const SOCKADDR_IN6& destAddress, CReplyv6& trr, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN6* pLocalAddress)
+{
+	return RetraceT(destAddress, trr, m_Routesv6, nHopCount, dwTimeout, dwPingsPerHost, wDataSize, nTOS, pLocalAddress);
+}
+
+/**
+ * @brief Probes one hop of an IPv4 destination without notifications
+ * @return false if the trace was cancelled
+ */
+bool CIncrementalTraceRoute::ProbeHop(const SOCKADDR_IN& destAddress, UCHAR nTTL, CHostTraceMultiReplyv4& htrr, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN* pLocalAddress)
+{
+	ProbeHopv4(destAddress, nTTL, htrr, m_Repliesv4, false, dwTimeout, dwPingsPerHost, wDataSize, nTOS, false, false, pLocalAddress);
+	return !m_bCancelled;
+}
+
+/**
+ * @brief Probes one hop of an IPv6 destination without notifications
+ * @return false if the trace was cancelled
+ */
+bool CIncrementalTraceRoute::ProbeHop(const SOCKADDR_IN6& destAddress, UCHAR nTTL, CHostTraceMultiReplyv6& htrr, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN6* pLocalAddress)
+{
+	ProbeHopv6(destAddress, nTTL, htrr, m_Repliesv6, false, dwTimeout, dwPingsPerHost, wDataSize, nTOS, false, false, pLocalAddress);
+	return !m_bCancelled;
+}
+
+/**
+ * @brief Traces every hop of the path to an IPv4 destination
+ * @return true if the path was traced
+ */
+bool CIncrementalTraceRoute::Sweep(const SOCKADDR_IN& destAddress, CReplyv4& trr, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN* pLocalAddress)
+{
+	return Tracev4(destAddress, trr, nHopCount, dwTimeout, dwPingsPerHost, wDataSize, nTOS, false, false, pLocalAddress);
+}
+
+/**
+ * @brief Traces every hop of the path to an IPv6 destination
+ * @return true if the path was traced
+ */
+bool CIncrementalTraceRoute::Sweep(const SOCKADDR_IN6& destAddress, CReplyv6& trr, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN6* pLocalAddress)
+{
+	return Tracev6(destAddress, trr, nHopCount, dwTimeout, dwPingsPerHost, wDataSize, nTOS, false, false, pLocalAddress);
+}
+
+/**
+ * @brief Probes a hop one probe at a time until it answers
+ * @param destAddress The destination
+ * @param nTTL The hop
+ * @param htrr Receives the outcome
+ * @param dwAttempts The most probes sent
+ * @details Used to verify a hop: a single answer tells its address, and a single lost probe should not be taken
+ * for a route change.
+ */
+template <typename Address, typename Hop>
+void CIncrementalTraceRoute::ProbeUntilAnswered(const Address& destAddress, UCHAR nTTL, Hop& htrr, DWORD dwAttempts, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress)
+{
+	for (DWORD i = 0; i < dwAttempts; i++)
+	{
+		if (!ProbeHop(destAddress, nTTL, htrr, dwTimeout, 1, wDataSize, nTOS, pLocalAddress) || HasAnswered(htrr))
+			return;
+	}
+}
+
+/**
+ * @brief Traces the path to a destination, verifying and repairing its cached path
+ * @param destAddress The destination
+ * @param trr Receives the hops
+ * @param routes The cached paths of the address family
+ * @return true if the path was traced
+ * @details The hops are walked from the first one on, just like Tracev4 / Tracev6 would, so the termination
+ * policies end the path where a full trace would end it. A hop before the TTL the probing resumes at is taken
+ * from the cached path unless it was probed to verify it; every later hop is probed.
+ */
+template <typename Address, typename Reply>
+bool CIncrementalTraceRoute::RetraceT(const Address& destAddress, Reply& trr, std::unordered_map<CAddressKey, CCachedRoute<Reply>, CAddressKeyHash>& routes, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress)
+{
+	trr.clear();
+	if ((nHopCount == 0) || (dwPingsPerHost == 0))
+	{
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return false;
+	}
+
+	// Without a cached path that fits the hop count this is a plain trace
+	const CAddressKey key{ MakeKey(destAddress) };
+	auto it{ routes.find(key) };
+	if ((it == routes.end()) || it->second.trr.empty() || (it->second.trr.size() > nHopCount))
+	{
+		if (!Sweep(destAddress, trr, nHopCount, dwTimeout, dwPingsPerHost, wDataSize, nTOS, pLocalAddress))
+			return false;
+		CCachedRoute<Reply> route;
+		if (it != routes.end())
+			route = std::move(it->second);
+		const Reply oldPath{ std::move(route.trr) };
+		const StopReason oldReason{ route.Reason };
+		route.trr = trr;
+		route.Reason = m_StopReason;
+		route.arrTimeouts = m_arrHopTimeouts;
+		routes[key] = std::move(route);
+		m_LastKind = RetraceKind::Full;
+		m_Summary.nRetraces++;
+		m_Summary.nFull++;
+		m_Summary.nProbesSent += m_nProbesSent;
+		m_Summary.nSweepProbes += trr.size() * dwPingsPerHost;
+		if (!oldPath.empty())
+			ReportRouteChange(destAddress, oldPath, oldReason, trr);
+		return true;
+	}
+	CCachedRoute<Reply>& route{ it->second };
+
+	// The hops keep their timeout estimates from one trace to the next, so verification probes wait just long enough
+	m_bCancelled = false;
+	m_nProbesSent = 0;
+	if (route.arrTimeouts.size() == nHopCount)
+	{
+		m_arrHopTimeouts = route.arrTimeouts;
+		for (auto& hopTimeout : m_arrHopTimeouts)
+			hopTimeout.SetBounds(m_dwTimeoutFloor, dwTimeout);
+	}
+	else
+		ResetHopTimeouts(nHopCount, dwTimeout);
+	const UCHAR nCachedHops{ static_cast<UCHAR>(route.trr.size()) };
+	Reply hops{ route.trr };
+	hops.resize(nHopCount);
+	std::vector<bool> arrFresh(nHopCount, false);
+
+	// Verify the last hop and the last responsive hop before it
+	UCHAR nLastResponsive{ 0 };
+	for (UCHAR nTTL = static_cast<UCHAR>(nCachedHops - 1); (nTTL >= 1) && (nLastResponsive == 0); nTTL--)
+	{
+		if (HasAnswered(route.trr[nTTL - 1]))
+			nLastResponsive = nTTL;
+	}
+	const auto& cachedLast{ route.trr[nCachedHops - 1] };
+	ProbeUntilAnswered(destAddress, nCachedHops, hops[nCachedHops - 1], HasAnswered(cachedLast) ? dwPingsPerHost : 1, dwTimeout, wDataSize, nTOS, pLocalAddress);
+	arrFresh[nCachedHops - 1] = true;
+	const bool bLastConfirmed{ ConfirmsHop(cachedLast, hops[nCachedHops - 1]) };
+	bool bResponsiveConfirmed{ true };
+	if (!m_bCancelled && (nLastResponsive > 0))
+	{
+		ProbeUntilAnswered(destAddress, nLastResponsive, hops[nLastResponsive - 1], dwPingsPerHost, dwTimeout, wDataSize, nTOS, pLocalAddress);
+		arrFresh[nLastResponsive - 1] = true;
+		bResponsiveConfirmed = ConfirmsHop(route.trr[nLastResponsive - 1], hops[nLastResponsive - 1]);
+	}
+
+	// Work out where the path has to be probed again from: nowhere, after the last responsive hop, or after the
+	// last hop before it which still answers as it did
+	UCHAR nResume{ static_cast<UCHAR>(nHopCount + 1) };
+	if (!bResponsiveConfirmed)
+	{
+		nResume = 1;
+		for (UCHAR nTTL = static_cast<UCHAR>(nLastResponsive - 1); (nTTL >= 1) && !m_bCancelled; nTTL--)
+		{
+			const auto& cached{ route.trr[nTTL - 1] };
+			ProbeUntilAnswered(destAddress, nTTL, hops[nTTL - 1], HasAnswered(cached) ? dwPingsPerHost : 1, dwTimeout, wDataSize, nTOS, pLocalAddress);
+			arrFresh[nTTL - 1] = true;
+			if (HasAnswered(cached) && ConfirmsHop(cached, hops[nTTL - 1]))
+			{
+				nResume = static_cast<UCHAR>(nTTL + 1);
+				break;
+			}
+		}
+	}
+	else if (!bLastConfirmed)
+		nResume = static_cast<UCHAR>(nLastResponsive + 1);
+
+	// Walk the path from the first hop on, probing where the cached path cannot be relied on
+	m_StopReason = StopReason::HopCount;
+	UCHAR nSilentHops{ 0 };
+	UCHAR nPathHops{ 0 };
+	bool bProbed{ false };
+	for (UCHAR nTTL = 1; (nTTL <= nHopCount) && !m_bCancelled; nTTL++)
+	{
+		auto& htrr{ hops[nTTL - 1] };
+		if (((nTTL >= nResume) || (nTTL > nCachedHops)) && !arrFresh[nTTL - 1])
+		{
+			ProbeHop(destAddress, nTTL, htrr, dwTimeout, dwPingsPerHost, wDataSize, nTOS, pLocalAddress);
+			arrFresh[nTTL - 1] = true;
+			bProbed = true;
+		}
+		nPathHops = nTTL;
+		if (CheckStopPolicies(HasAnswered(htrr) && SameAddress(htrr.Address, destAddress), htrr.nStatus, htrr.dwError, nSilentHops))
+			break;
+	}
+	if (m_bCancelled)
+	{
+		m_StopReason = StopReason::Cancelled;
+		SetLastError(ERROR_CANCELLED);
+		return false;
+	}
+	trr.assign(hops.begin(), hops.begin() + nPathHops);
+
+	if (nResume == 1)
+		m_LastKind = RetraceKind::Full;
+	else
+		m_LastKind = (bProbed || (nResume <= nHopCount)) ? RetraceKind::Partial : RetraceKind::Verified;
+	m_Summary.nRetraces++;
+	if (m_LastKind == RetraceKind::Full)
+		m_Summary.nFull++;
+	else if (m_LastKind == RetraceKind::Partial)
+		m_Summary.nPartial++;
+	else
+		m_Summary.nVerified++;
+	m_Summary.nProbesSent += m_nProbesSent;
+	m_Summary.nSweepProbes += trr.size() * dwPingsPerHost;
+
+	// Report the change before the new path replaces the cached one
+	ReportRouteChange(destAddress, route.trr, route.Reason, trr);
+	route.trr = trr;
+	route.Reason = m_StopReason;
+	route.arrTimeouts = m_arrHopTimeouts;
+	return true;
+}
+
+/**
+ * @brief Compares a new path with the cached one and calls OnRouteChange if they differ
+ * @param destAddress The destination
+ * @param oldPath The cached path
+ * @param oldReason Why the trace of the cached path stopped
+ * @param newPath The new path
+ * @details Two hops differ if both answered from different addresses; a hop which did not answer in one of the
+ * paths is taken to be the same router. Paths also differ in their length and in why they ended.
+ */
+template <typename Address, typename Reply>
+void CIncrementalTraceRoute::ReportRouteChange(const Address& destAddress, const Reply& oldPath, StopReason oldReason, const Reply& newPath)
+{
+	size_t nChanged{ 0 };
+	const size_t nCommon{ (std::min)(oldPath.size(), newPath.size()) };
+	for (size_t i = 0; (i < nCommon) && (nChanged == 0); i++)
+	{
+		if (HasAnswered(oldPath[i]) && HasAnswered(newPath[i]) && !SameAddress(oldPath[i].Address, newPath[i].Address))
+			nChanged = i + 1;
+	}
+	if ((nChanged == 0) && (oldPath.size() != newPath.size()))
+		nChanged = nCommon + 1;
+	if ((nChanged == 0) && (oldReason != m_StopReason))
+		nChanged = nCommon;
+	if (nChanged == 0)
+		return;
+
+	CRouteChange change;
+	memcpy(&change.Destination, &destAddress, sizeof(destAddress));
+	change.nFirstChangedHop = static_cast<UCHAR>(nChanged);
+	if ((nChanged <= oldPath.size()) && HasAnswered(oldPath[nChanged - 1]))
+		memcpy(&change.OldAddress, &oldPath[nChanged - 1].Address, sizeof(oldPath[nChanged - 1].Address));
+	if ((nChanged <= newPath.size()) && HasAnswered(newPath[nChanged - 1]))
+		memcpy(&change.NewAddress, &newPath[nChanged - 1].Address, sizeof(newPath[nChanged - 1].Address));
+	change.nOldHops = oldPath.size();
+	change.nNewHops = newPath.size();
+	change.OldReason = oldReason;
+	change.NewReason = m_StopReason;
+	m_Summary.nRouteChanges++;
+	OnRouteChange(change);
+}
@@ -0,0 +1,116 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IncrementalTraceRoute.h : interface of the CIncrementalTraceRoute class, a traceroute which remembers the
+// path to every destination and on the next trace only probes what is needed to confirm or repair it.
+//
+
+#pragma once
+
+#include "tracer.h"
+#include "NameResolver.h"
+#include <unordered_map>
+
+// How a path was obtained by CIncrementalTraceRoute::Retrace
+enum class RetraceKind
+{
+	Full,                                 // Every hop was probed: the first trace, or nothing of the cached path held
+	Verified,                             // The last responsive hop and the last hop answered as before; the cached path was kept
+	Partial                               // A part of the cached path held; only the hops after it were probed again
+};
+
+// A route change found by CIncrementalTraceRoute::Retrace
+struct CRouteChange
+{
+	SOCKADDR_STORAGE Destination{};       // The destination
+	UCHAR nFirstChangedHop{ 0 };          // The TTL of the first hop which differs
+	SOCKADDR_STORAGE OldAddress{};        // That hop before and now; family AF_UNSPEC if it did not answer or was not on the path
+	SOCKADDR_STORAGE NewAddress{};
+	size_t nOldHops{ 0 };                 // Length of the path before and now
+	size_t nNewHops{ 0 };
+	CTraceRoute::StopReason OldReason{ CTraceRoute::StopReason::HopCount }; // Why the trace stopped before and now
+	CTraceRoute::StopReason NewReason{ CTraceRoute::StopReason::HopCount };
+};
+
+// The totals of the retraces since the last ClearRoutes
+struct CRetraceSummary
+{
+	ULONGLONG nRetraces{ 0 };             // Calls of Retrace which completed
+	ULONGLONG nFull{ 0 };                 // ... by probing every hop
+	ULONGLONG nVerified{ 0 };             // ... by confirming the cached path
+	ULONGLONG nPartial{ 0 };              // ... by probing a part of the path again
+	ULONGLONG nRouteChanges{ 0 };         // Route changes reported
+	ULONGLONG nProbesSent{ 0 };           // Echo requests sent
+	ULONGLONG nSweepProbes{ 0 };          // Echo requests full sweeps of the same paths would have sent
+};
+
+// CIncrementalTraceRoute: the first trace to a destination is a normal CTraceRoute trace. Its path and the
+// adaptive timeouts of its hops are cached, and the next trace probes just two hops: the last hop which
+// answered before the end of the path, and the last hop of the path, normally the destination. If both answer
+// as before the cached path stands. If only the last hop differs, the hops after the last responsive hop are
+// probed again; if the last responsive hop differs too, the hops before it are probed backwards until one
+// answers as before, and the path is probed again from there. A silent hop matches whatever the other path had
+// at its TTL, so a router which rate limits its answers does not look like a route change. Whenever the new
+// path differs from the cached one, OnRouteChange is called.
+class CIncrementalTraceRoute : public CTraceRoute
+{
+public:
+	CIncrementalTraceRoute() noexcept;
+	CIncrementalTraceRoute(const CIncrementalTraceRoute&) = delete;
+	CIncrementalTraceRoute(CIncrementalTraceRoute&&) = delete;
+	virtual ~CIncrementalTraceRoute() = default;
+
+	CIncrementalTraceRoute& operator=(const CIncrementalTraceRoute&) = delete;
+	CIncrementalTraceRoute& operator=(CIncrementalTraceRoute&&) = delete;
+
+	// Trace the path to a destination, from the cached path when there is one. The parameters are those of Tracev4 / Tracev6
+	bool Retrace(const SOCKADDR_IN& destAddress, CReplyv4& trr, UCHAR nHopCount = 30, DWORD dwTimeout = 5000, DWORD dwPingsPerHost = 3, WORD wDataSize = 32, UCHAR nTOS = 0, const SOCKADDR_IN* pLocalAddress = nullptr);
+	bool Retrace(const SOCKADDR_IN6& destAddress, CReplyv6& trr, UCHAR nHopCount = 30, DWORD dwTimeout = 5000, DWORD dwPingsPerHost = 3, WORD wDataSize = 32, UCHAR nTOS = 0, const SOCKADDR_IN6* pLocalAddress = nullptr);
+	void Cancel() noexcept { m_bCancelled = true; }     // Stops after the current probe; safe to call from any thread
+	void ClearRoutes();                                 // Forgets every cached path and the totals
+	RetraceKind GetLastKind() const noexcept { return m_LastKind; }
+	const CRetraceSummary& GetSummary() const noexcept { return m_Summary; }
+
+protected:
+	// The cached path to a destination
+	template <typename Reply>
+	struct CCachedRoute
+	{
+		Reply trr;                                     // The hops, as Tracev4 / Tracev6 gave them
+		StopReason Reason{ StopReason::HopCount };     // Why the trace stopped
+		std::vector<CAdaptiveTimeout> arrTimeouts;     // The timeout estimators of the hops
+	};
+
+	// Called on the thread which called Retrace when the path to a destination differs from the cached one
+	virtual void OnRouteChange(const CRouteChange& /*change*/) {}
+
+	template <typename Address, typename Reply>
+	bool RetraceT(const Address& destAddress, Reply& trr, std::unordered_map<CAddressKey, CCachedRoute<Reply>, CAddressKeyHash>& routes, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress);
+	template <typename Address, typename Hop>
+	void ProbeUntilAnswered(const Address& destAddress, UCHAR nTTL, Hop& htrr, DWORD dwAttempts, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress);
+	template <typename Address, typename Reply>
+	void ReportRouteChange(const Address& destAddress, const Reply& oldPath, StopReason oldReason, const Reply& newPath);
+	bool ProbeHop(const SOCKADDR_IN& destAddress, UCHAR nTTL, CHostTraceMultiReplyv4& htrr, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN* pLocalAddress);
+	bool ProbeHop(const SOCKADDR_IN6& destAddress, UCHAR nTTL, CHostTraceMultiReplyv6& htrr, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN6* pLocalAddress);
+	bool Sweep(const SOCKADDR_IN& destAddress, CReplyv4& trr, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN* pLocalAddress);
+	bool Sweep(const SOCKADDR_IN6& destAddress, CReplyv6& trr, UCHAR nHopCount, DWORD dwTimeout, DWORD dwPingsPerHost, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN6* pLocalAddress);
+
+	std::unordered_map<CAddressKey, CCachedRoute<CReplyv4>, CAddressKeyHash> m_Routesv4; // The cached IPv4 paths
+	std::unordered_map<CAddressKey, CCachedRoute<CReplyv6>, CAddressKeyHash> m_Routesv6; // The cached IPv6 paths
+	std::vector<CHostTraceSingleReplyv4> m_Repliesv4;  // Scratch space of ProbeHopv4
+	std::vector<CHostTraceSingleReplyv6> m_Repliesv6;  // Scratch space of ProbeHopv6
+	CRetraceSummary m_Summary;                         // The totals since the last ClearRoutes
+	RetraceKind m_LastKind;                            // How the last path was obtained
+};
@@ -0,0 +1,217 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IntervalScheduler.cpp : implementation of the CIntervalScheduler class
+//
+
+#include "pch.h"
+#include "IntervalScheduler.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif //#ifndef _WIN32
+
+/**
+ * @brief Default constructor for CIntervalScheduler
+ */
+CIntervalScheduler::CIntervalScheduler() noexcept :
+	m_nInterval{ 0 },
+	m_nStart{ 0 },
+	m_nNext{ 0 },
+	m_nMissed{ 0 },
+	m_nLastLateness{ 0 },
+	m_bCancelled{ false },
+#ifdef _WIN32
+	m_hTimer{ nullptr },
+	m_hCancelEvent{ nullptr }
+#else
+	m_nTimerFd{ -1 },
+	m_nCancelFd{ -1 }
+#endif //#ifdef _WIN32
+{
+}
+
+/**
+ * @brief Destructor for CIntervalScheduler; releases the timer
+ */
+CIntervalScheduler::~CIntervalScheduler()
+{
+	Close();
+}
+
+/**
+ * @brief Releases the timer and the cancel event
+ */
+void CIntervalScheduler::Close() noexcept
+{
+#ifdef _WIN32
+	if (m_hTimer != nullptr)
+		CloseHandle(m_hTimer);
+	if (m_hCancelEvent != nullptr)
+		CloseHandle(m_hCancelEvent);
+	m_hTimer = nullptr;
+	m_hCancelEvent = nullptr;
+#else
+	if (m_nTimerFd != -1)
+		close(m_nTimerFd);
+	if (m_nCancelFd != -1)
+		close(m_nCancelFd);
+	m_nTimerFd = -1;
+	m_nCancelFd = -1;
+#endif //#ifdef _WIN32
+}
+
+/**
+ * @brief Starts a new schedule whose first deadline is now
+ * @param nInterval Time between deadlines in microseconds, 0 for flood mode
+ * @return true if the timer could be created
+ */
+bool CIntervalScheduler::Start(ULONGLONG nInterval)
+{
+	Close();
+	m_nInterval = nInterval;
+	m_nNext = 0;
+	m_nMissed = 0;
+	m_nLastLateness = 0;
+	m_bCancelled = false;
+
+#ifdef _WIN32
+	// A high resolution timer (Windows 10 1803 and later) is not tied to the system timer tick, so fall back
+	// to a normal waitable timer on older versions
+	m_hTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (m_hTimer == nullptr)
+		m_hTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	m_hCancelEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	if ((m_hTimer == nullptr) || (m_hCancelEvent == nullptr))
+	{
+		Close();
+		return false;
+	}
+#else
+	m_nTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	m_nCancelFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if ((m_nTimerFd == -1) || (m_nCancelFd == -1))
+	{
+		SetLastError(static_cast<DWORD>(errno));
+		Close();
+		return false;
+	}
+#endif //#ifdef _WIN32
+
+	m_nStart = CPingClock::NowMicroseconds();
+	return true;
+}
+
+/**
+ * @brief Blocks until the next deadline of the schedule
+ * @return true when the deadline has been reached, false if the schedule was cancelled
+ * @details If the caller overran one or more deadlines they are skipped (and counted) rather than fired back
+ * to back, so a slow reply never causes a burst of requests.
+ */
+bool CIntervalScheduler::WaitForNextDeadline()
+{
+	if (m_bCancelled)
+		return false;
+	if (m_nInterval == 0)
+	{
+		m_nLastLateness = 0;
+		return true;
+	}
+
+	// Skip the deadlines which have already passed, but always honour the first one
+	const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+	ULONGLONG nDeadline{ m_nStart + (m_nNext * m_nInterval) };
+	if ((m_nNext > 0) && (nNow > nDeadline))
+	{
+		const ULONGLONG nSkip{ (nNow - nDeadline) / m_nInterval + 1 };
+		m_nMissed += nSkip;
+		m_nNext += nSkip;
+		nDeadline = m_nStart + (m_nNext * m_nInterval);
+	}
+	++m_nNext;
+
+	if (!WaitUntil(nDeadline))
+		return false;
+	const ULONGLONG nWoken{ CPingClock::NowMicroseconds() };
+	m_nLastLateness = (nWoken > nDeadline) ? (nWoken - nDeadline) : 0;
+	return true;
+}
+
+/**
+ * @brief Waits on the timer until an absolute CPingClock time
+ * @param nDeadline The deadline in microseconds
+ * @return true when the deadline has been reached, false if cancelled
+ */
+bool CIntervalScheduler::WaitUntil(ULONGLONG nDeadline)
+{
+#ifdef _WIN32
+	// Waitable timers take an absolute time on the system clock, which can jump, so arm it relative to now
+	const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+	if (nDeadline > nNow)
+	{
+		LARGE_INTEGER dueTime{};
+		dueTime.QuadPart = -static_cast<LONGLONG>((nDeadline - nNow) * 10ULL);
+		if (!SetWaitableTimerEx(m_hTimer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+			return false;
+		const HANDLE handles[2]{ m_hCancelEvent, m_hTimer };
+		const DWORD dwWait{ WaitForMultipleObjects(2, handles, FALSE, INFINITE) };
+		if (dwWait != (WAIT_OBJECT_0 + 1))
+			return false;
+	}
+#else
+	itimerspec expiry{};
+	expiry.it_value.tv_sec = static_cast<time_t>(nDeadline / 1000000ULL);
+	expiry.it_value.tv_nsec = static_cast<long>((nDeadline % 1000000ULL) * 1000ULL);
+	if ((expiry.it_value.tv_sec == 0) && (expiry.it_value.tv_nsec == 0))
+		expiry.it_value.tv_nsec = 1; //A zero expiry would disarm the timer
+	if (timerfd_settime(m_nTimerFd, TFD_TIMER_ABSTIME, &expiry, nullptr) == -1)
+		return false;
+	pollfd fds[2]{ { m_nTimerFd, POLLIN, 0 }, { m_nCancelFd, POLLIN, 0 } };
+	for (;;)
+	{
+		const int nReady{ poll(fds, 2, -1) };
+		if ((nReady == -1) && (errno == EINTR))
+			continue;
+		if ((nReady <= 0) || (fds[1].revents & POLLIN))
+			return false;
+		uint64_t nExpirations{ 0 };
+		const ssize_t nRead{ read(m_nTimerFd, &nExpirations, sizeof(nExpirations)) };
+		(void)nRead;
+		break;
+	}
+#endif //#ifdef _WIN32
+	return !m_bCancelled;
+}
+
+/**
+ * @brief Cancels the schedule, waking up a pending wait
+ */
+void CIntervalScheduler::Cancel() noexcept
+{
+	m_bCancelled = true;
+#ifdef _WIN32
+	if (m_hCancelEvent != nullptr)
+		SetEvent(m_hCancelEvent);
+#else
+	if (m_nCancelFd != -1)
+	{
+		const uint64_t nValue{ 1 };
+		const ssize_t nWritten{ write(m_nCancelFd, &nValue, sizeof(nValue)) };
+		(void)nWritten;
+	}
+#endif //#ifdef _WIN32
+}
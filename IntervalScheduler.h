@@ -0,0 +1,65 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IntervalScheduler.h : interface of the CIntervalScheduler class, which paces periodic probes
+// on absolute deadlines so that the send times do not drift.
+//
+
+#pragma once
+
+#include "ping.h"
+#include <atomic>
+
+// CIntervalScheduler: hands out send times at a fixed cadence. Deadline n is always start + n * interval on the
+// monotonic CPingClock, so time spent waiting for replies or formatting output never accumulates as drift. The
+// waits use a high resolution waitable timer on Windows and a timerfd armed with an absolute expiry elsewhere.
+// An interval of zero is flood mode: every wait returns immediately.
+class CIntervalScheduler
+{
+public:
+	CIntervalScheduler() noexcept;
+	CIntervalScheduler(const CIntervalScheduler&) = delete;
+	CIntervalScheduler(CIntervalScheduler&&) = delete;
+	virtual ~CIntervalScheduler();
+
+	CIntervalScheduler& operator=(const CIntervalScheduler&) = delete;
+	CIntervalScheduler& operator=(CIntervalScheduler&&) = delete;
+
+	bool Start(ULONGLONG nInterval);                    // Starts the schedule now; nInterval in microseconds, 0 = flood mode
+	bool WaitForNextDeadline();                         // Blocks until the next deadline; false if cancelled
+	void Cancel() noexcept;                             // Wakes up a pending wait; safe to call from any thread
+	bool IsFlood() const noexcept { return m_nInterval == 0; }
+	ULONGLONG GetInterval() const noexcept { return m_nInterval; }
+	ULONGLONG GetMissedDeadlines() const noexcept { return m_nMissed; } // Deadlines skipped because the caller overran them
+	ULONGLONG GetLastLateness() const noexcept { return m_nLastLateness; } // How late (in microseconds) the last wait returned
+
+protected:
+	bool WaitUntil(ULONGLONG nDeadline);
+	void Close() noexcept;
+
+	ULONGLONG m_nInterval;                              // Time between deadlines in microseconds
+	ULONGLONG m_nStart;                                 // Monotonic time in microseconds of deadline zero
+	ULONGLONG m_nNext;                                  // Index of the next deadline
+	ULONGLONG m_nMissed;                                // Deadlines skipped so far
+	ULONGLONG m_nLastLateness;                          // Lateness of the last wait in microseconds
+	std::atomic<bool> m_bCancelled;                     // Set by Cancel
+#ifdef _WIN32
+	HANDLE m_hTimer;                                    // High resolution waitable timer
+	HANDLE m_hCancelEvent;                              // Signalled by Cancel
+#else
+	int m_nTimerFd;                                     // timerfd on CLOCK_MONOTONIC
+	int m_nCancelFd;                                    // eventfd signalled by Cancel
+#endif //#ifdef _WIN32
+};
@@ -0,0 +1,503 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IpAddressText.cpp : implementation of the CIpAddressText class
+//
+
+#include "pch.h"
+#include "IpAddressText.h"
+#include <array>
+#include <cstring>
+
+namespace
+{
+	// The decimal text of every octet value, written as three characters of which the first nLength count
+	struct COctetText
+	{
+		char szText[3];
+		BYTE nLength;
+	};
+
+	constexpr std::array<COctetText, 256> MakeOctetTable() noexcept
+	{
+		std::array<COctetText, 256> table{};
+		for (UINT i = 0; i < 256; i++)
+		{
+			COctetText& octet{ table[i] };
+			if (i >= 100)
+			{
+				octet.szText[0] = static_cast<char>('0' + (i / 100));
+				octet.szText[1] = static_cast<char>('0' + ((i / 10) % 10));
+				octet.szText[2] = static_cast<char>('0' + (i % 10));
+				octet.nLength = 3;
+			}
+			else if (i >= 10)
+			{
+				octet.szText[0] = static_cast<char>('0' + (i / 10));
+				octet.szText[1] = static_cast<char>('0' + (i % 10));
+				octet.nLength = 2;
+			}
+			else
+			{
+				octet.szText[0] = static_cast<char>('0' + i);
+				octet.nLength = 1;
+			}
+		}
+		return table;
+	}
+
+	// The value of every hexadecimal digit character, 0xFF for the other characters
+	constexpr std::array<BYTE, 256> MakeDigitTable() noexcept
+	{
+		std::array<BYTE, 256> table{};
+		for (UINT i = 0; i < 256; i++)
+			table[i] = 0xFF;
+		for (UINT i = 0; i < 10; i++)
+			table['0' + i] = static_cast<BYTE>(i);
+		for (UINT i = 0; i < 6; i++)
+		{
+			table['a' + i] = static_cast<BYTE>(10 + i);
+			table['A' + i] = static_cast<BYTE>(10 + i);
+		}
+		return table;
+	}
+
+	constexpr std::array<COctetText, 256> s_OctetText{ MakeOctetTable() };
+	constexpr std::array<BYTE, 256> s_DigitValue{ MakeDigitTable() };
+	constexpr char s_szHexDigits[]{ "0123456789abcdef" };
+
+	/**
+	 * @brief Writes the dotted decimal form of an IPv4 address
+	 * @param pBytes The 4 address bytes
+	 * @param pszText Receives the text; needs room for 16 characters as every octet is written as 3 characters
+	 * @return The end of the text
+	 */
+	char* WriteIPv4(const BYTE* pBytes, char* pszText) noexcept
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			const COctetText& octet{ s_OctetText[pBytes[i]] };
+			pszText[0] = octet.szText[0];
+			pszText[1] = octet.szText[1];
+			pszText[2] = octet.szText[2];
+			pszText += octet.nLength;
+			*pszText++ = '.';
+		}
+		return pszText - 1;
+	}
+
+	/**
+	 * @brief Writes one IPv6 group in hex, without leading zeros
+	 * @param nGroup The group value
+	 * @param pszText Receives the text
+	 * @return The end of the text
+	 */
+	char* WriteGroup(UINT nGroup, char* pszText) noexcept
+	{
+		const UINT nDigits{ 1U + (nGroup > 0xF) + (nGroup > 0xFF) + (nGroup > 0xFFF) };
+		for (UINT nShift = (nDigits - 1) * 4; ; nShift -= 4)
+		{
+			*pszText++ = s_szHexDigits[(nGroup >> nShift) & 0xF];
+			if (nShift == 0)
+				break;
+		}
+		return pszText;
+	}
+
+	/**
+	 * @brief Writes the RFC 5952 form of an IPv6 address
+	 * @param pBytes The 16 address bytes
+	 * @param pszText Receives the text; needs room for 46 characters
+	 * @return The end of the text
+	 * @details Lower case hex without leading zeros, the longest run of two or more zero groups (the first one of
+	 * equally long runs) shortened to "::". Like inet_ntop, IPv4-mapped addresses and IPv4-compatible ones whose IPv4
+	 * part has a non-zero upper half are written with that part in dotted decimal, "::ffff:a.b.c.d" and "::a.b.c.d"
+	 */
+	char* WriteIPv6(const BYTE* pBytes, char* pszText) noexcept
+	{
+		UINT arrGroups[8];
+		for (int i = 0; i < 8; i++)
+			arrGroups[i] = (static_cast<UINT>(pBytes[2 * i]) << 8) | pBytes[(2 * i) + 1];
+
+		// ::ffff:a.b.c.d and ::a.b.c.d
+		if ((arrGroups[0] | arrGroups[1] | arrGroups[2] | arrGroups[3] | arrGroups[4]) == 0)
+		{
+			if (arrGroups[5] == 0xFFFF)
+			{
+				memcpy(pszText, "::ffff:", 7);
+				return WriteIPv4(pBytes + 12, pszText + 7);
+			}
+			if ((arrGroups[5] == 0) && (arrGroups[6] != 0))
+			{
+				memcpy(pszText, "::", 2);
+				return WriteIPv4(pBytes + 12, pszText + 2);
+			}
+		}
+
+		// Find the longest run of zero groups
+		int nBestStart{ -1 };
+		int nBestLength{ 1 };
+		int nRunStart{ -1 };
+		for (int i = 0; i <= 8; i++)
+		{
+			if ((i < 8) && (arrGroups[i] == 0))
+			{
+				if (nRunStart < 0)
+					nRunStart = i;
+			}
+			else if (nRunStart >= 0)
+			{
+				if ((i - nRunStart) > nBestLength)
+				{
+					nBestStart = nRunStart;
+					nBestLength = i - nRunStart;
+				}
+				nRunStart = -1;
+			}
+		}
+
+		for (int i = 0; i < 8; i++)
+		{
+			if (i == nBestStart)
+			{
+				*pszText++ = ':';
+				if (i == 0)
+					*pszText++ = ':';
+				i += nBestLength - 1;
+				continue;
+			}
+			pszText = WriteGroup(arrGroups[i], pszText);
+			if (i < 7)
+				*pszText++ = ':';
+		}
+		return pszText;
+	}
+
+	/**
+	 * @brief Writes the text of an address
+	 * @param nFamily AF_INET or AF_INET6
+	 * @param pAddress The in_addr / in6_addr bytes
+	 * @param pszText Receives the text, not null terminated; CIpAddressText::MAX_LENGTH characters
+	 * @return The end of the text, pszText for an unknown family
+	 */
+	char* WriteAddress(int nFamily, const void* pAddress, char* pszText) noexcept
+	{
+		if (nFamily == AF_INET)
+			return WriteIPv4(static_cast<const BYTE*>(pAddress), pszText);
+		if (nFamily == AF_INET6)
+			return WriteIPv6(static_cast<const BYTE*>(pAddress), pszText);
+		return pszText;
+	}
+
+	/**
+	 * @brief Writes the text of a socket address, including the scope id of a scoped IPv6 address
+	 * @param pSockAddr The socket address
+	 * @param nSockAddrLen The size of the socket address
+	 * @param pszText Receives the text, not null terminated; CIpAddressText::MAX_LENGTH characters
+	 * @return The end of the text, pszText if the address is not an IPv4 / IPv6 one
+	 */
+	char* WriteSockAddr(const SOCKADDR* pSockAddr, int nSockAddrLen, char* pszText) noexcept
+	{
+		if (pSockAddr == nullptr)
+			return pszText;
+		if ((pSockAddr->sa_family == AF_INET) && (nSockAddrLen >= static_cast<int>(sizeof(SOCKADDR_IN))))
+		{
+#pragma warning(suppress: 26490)
+			return WriteIPv4(reinterpret_cast<const BYTE*>(&reinterpret_cast<const SOCKADDR_IN*>(pSockAddr)->sin_addr), pszText);
+		}
+		if ((pSockAddr->sa_family == AF_INET6) && (nSockAddrLen >= static_cast<int>(sizeof(SOCKADDR_IN6))))
+		{
+#pragma warning(suppress: 26490)
+			const SOCKADDR_IN6* pAddress{ reinterpret_cast<const SOCKADDR_IN6*>(pSockAddr) };
+			pszText = WriteIPv6(reinterpret_cast<const BYTE*>(&pAddress->sin6_addr), pszText);
+			ULONG nScopeId{ pAddress->sin6_scope_id };
+			if (nScopeId != 0)
+			{
+				char szDigits[10];
+				int nDigits{ 0 };
+				while (nScopeId != 0)
+				{
+					szDigits[nDigits++] = static_cast<char>('0' + (nScopeId % 10));
+					nScopeId /= 10;
+				}
+				*pszText++ = '%';
+				while (nDigits > 0)
+					*pszText++ = szDigits[--nDigits];
+			}
+		}
+		return pszText;
+	}
+
+	/**
+	 * @brief Copies the written text into the caller's buffer
+	 * @param pszText The text
+	 * @param nLength Its length
+	 * @param pszBuffer The caller's buffer
+	 * @param nBufferSize Its size in characters
+	 * @return nLength, or 0 (with an empty buffer) if the text does not fit
+	 */
+	template <typename CharType>
+	size_t CopyText(const char* pszText, size_t nLength, CharType* pszBuffer, size_t nBufferSize) noexcept
+	{
+		if ((pszBuffer == nullptr) || (nBufferSize == 0))
+			return 0;
+		if (nLength >= nBufferSize)
+			nLength = 0;
+		for (size_t i = 0; i < nLength; i++)
+			pszBuffer[i] = static_cast<CharType>(pszText[i]);
+		pszBuffer[nLength] = 0;
+		return nLength;
+	}
+}
+
+/**
+ * @brief Formats an address in its numeric form
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr / in6_addr bytes
+ * @param pszBuffer Receives the null terminated text, MAX_LENGTH characters always suffice
+ * @param nBufferSize Size of pszBuffer in characters
+ * @return The length of the text, 0 for an unknown family or a buffer which is too small
+ */
+size_t CIpAddressText::Format(int nFamily, const void* pAddress, char* pszBuffer, size_t nBufferSize) noexcept
+{
+	char szText[MAX_LENGTH];
+	const char* pszEnd{ WriteAddress(nFamily, pAddress, szText) };
+	return CopyText(szText, static_cast<size_t>(pszEnd - szText), pszBuffer, nBufferSize);
+}
+
+/**
+ * @brief Formats an address in its numeric form
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr / in6_addr bytes
+ * @param pszBuffer Receives the null terminated text, MAX_LENGTH characters always suffice
+ * @param nBufferSize Size of pszBuffer in characters
+ * @return The length of the text, 0 for an unknown family or a buffer which is too small
+ */
+size_t CIpAddressText::Format(int nFamily, const void* pAddress, wchar_t* pszBuffer, size_t nBufferSize) noexcept
+{
+	char szText[MAX_LENGTH];
+	const char* pszEnd{ WriteAddress(nFamily, pAddress, szText) };
+	return CopyText(szText, static_cast<size_t>(pszEnd - szText), pszBuffer, nBufferSize);
+}
+
+/**
+ * @brief Formats a socket address in its numeric form, as getnameinfo does with NI_NUMERICHOST
+ * @param pSockAddr The socket address
+ * @param nSockAddrLen The size of the socket address
+ * @param pszBuffer Receives the null terminated text, MAX_LENGTH characters always suffice
+ * @param nBufferSize Size of pszBuffer in characters
+ * @return The length of the text, 0 if it is not an IPv4 / IPv6 address or the buffer is too small
+ */
+size_t CIpAddressText::Format(const SOCKADDR* pSockAddr, int nSockAddrLen, char* pszBuffer, size_t nBufferSize) noexcept
+{
+	char szText[MAX_LENGTH];
+	const char* pszEnd{ WriteSockAddr(pSockAddr, nSockAddrLen, szText) };
+	return CopyText(szText, static_cast<size_t>(pszEnd - szText), pszBuffer, nBufferSize);
+}
+
+/**
+ * @brief Formats a socket address in its numeric form, as GetNameInfoW does with NI_NUMERICHOST
+ * @param pSockAddr The socket address
+ * @param nSockAddrLen The size of the socket address
+ * @param pszBuffer Receives the null terminated text, MAX_LENGTH characters always suffice
+ * @param nBufferSize Size of pszBuffer in characters
+ * @return The length of the text, 0 if it is not an IPv4 / IPv6 address or the buffer is too small
+ */
+size_t CIpAddressText::Format(const SOCKADDR* pSockAddr, int nSockAddrLen, wchar_t* pszBuffer, size_t nBufferSize) noexcept
+{
+	char szText[MAX_LENGTH];
+	const char* pszEnd{ WriteSockAddr(pSockAddr, nSockAddrLen, szText) };
+	return CopyText(szText, static_cast<size_t>(pszEnd - szText), pszBuffer, nBufferSize);
+}
+
+/**
+ * @brief Parses an IPv4 or IPv6 literal
+ * @param pszText The text
+ * @param nLength Its length
+ * @param nFamily Receives AF_INET or AF_INET6
+ * @param pAddress Receives the address bytes, room for 16 bytes is needed
+ * @return true if the whole text is a literal
+ */
+bool CIpAddressText::Parse(const char* pszText, size_t nLength, int& nFamily, void* pAddress) noexcept
+{
+	if ((pszText == nullptr) || (nLength == 0))
+		return false;
+	if (memchr(pszText, ':', nLength) != nullptr)
+	{
+		if (!ParseIPv6(pszText, nLength, pAddress))
+			return false;
+		nFamily = AF_INET6;
+		return true;
+	}
+	if (!ParseIPv4(pszText, nLength, pAddress))
+		return false;
+	nFamily = AF_INET;
+	return true;
+}
+
+/**
+ * @brief Parses an IPv4 or IPv6 literal
+ * @param pszText The text
+ * @param nLength Its length
+ * @param nFamily Receives AF_INET or AF_INET6
+ * @param pAddress Receives the address bytes, room for 16 bytes is needed
+ * @return true if the whole text is a literal
+ */
+bool CIpAddressText::Parse(const wchar_t* pszText, size_t nLength, int& nFamily, void* pAddress) noexcept
+{
+	// Literals are plain ASCII, anything else is a host name
+	if ((pszText == nullptr) || (nLength == 0) || (nLength >= MAX_LENGTH))
+		return false;
+	char szText[MAX_LENGTH];
+	for (size_t i = 0; i < nLength; i++)
+	{
+		if (static_cast<ULONG>(pszText[i]) >= 0x80)
+			return false;
+		szText[i] = static_cast<char>(pszText[i]);
+	}
+	return Parse(szText, nLength, nFamily, pAddress);
+}
+
+/**
+ * @brief Parses a dotted decimal IPv4 address, four decimal octets without leading zeros
+ * @param pszText The text
+ * @param nLength Its length
+ * @param pAddress Receives the 4 address bytes
+ * @return true if the whole text is an IPv4 literal
+ */
+bool CIpAddressText::ParseIPv4(const char* pszText, size_t nLength, void* pAddress) noexcept
+{
+	if ((nLength < 7) || (nLength > 15))
+		return false;
+
+	BYTE arrBytes[4];
+	size_t i{ 0 };
+	for (int nOctet = 0; nOctet < 4; nOctet++)
+	{
+		if (nOctet > 0)
+		{
+			if ((i >= nLength) || (pszText[i] != '.'))
+				return false;
+			++i;
+		}
+		const size_t nStart{ i };
+		UINT nValue{ 0 };
+		while ((i < nLength) && ((i - nStart) < 4))
+		{
+			const BYTE nDigit{ s_DigitValue[static_cast<BYTE>(pszText[i])] };
+			if (nDigit > 9)
+				break;
+			nValue = (nValue * 10) + nDigit;
+			++i;
+		}
+		const size_t nDigits{ i - nStart };
+		if ((nDigits == 0) || (nDigits > 3) || (nValue > 255) || ((nDigits > 1) && (pszText[nStart] == '0')))
+			return false;
+		arrBytes[nOctet] = static_cast<BYTE>(nValue);
+	}
+	if (i != nLength)
+		return false;
+	memcpy(pAddress, arrBytes, sizeof(arrBytes));
+	return true;
+}
+
+/**
+ * @brief Parses an IPv6 address in any of the RFC 4291 text forms, without a scope id
+ * @param pszText The text
+ * @param nLength Its length
+ * @param pAddress Receives the 16 address bytes
+ * @return true if the whole text is an IPv6 literal
+ */
+bool CIpAddressText::ParseIPv6(const char* pszText, size_t nLength, void* pAddress) noexcept
+{
+	if ((nLength < 2) || (nLength >= MAX_LENGTH))
+		return false;
+
+	UINT arrGroups[8]{};
+	int nGroups{ 0 };
+	int nGap{ -1 }; // Index of the group which "::" stands in front of
+	size_t i{ 0 };
+	if (pszText[0] == ':')
+	{
+		if (pszText[1] != ':')
+			return false;
+		nGap = 0;
+		i = 2;
+	}
+	while (i < nLength)
+	{
+		const size_t nStart{ i };
+		UINT nValue{ 0 };
+		while ((i < nLength) && ((i - nStart) < 5))
+		{
+			const BYTE nDigit{ s_DigitValue[static_cast<BYTE>(pszText[i])] };
+			if (nDigit == 0xFF)
+				break;
+			nValue = (nValue << 4) | nDigit;
+			++i;
+		}
+		const size_t nDigits{ i - nStart };
+		if ((i < nLength) && (pszText[i] == '.'))
+		{
+			// A trailing IPv4 address fills the last two groups
+			BYTE arrBytes[4];
+			if ((nGroups > 6) || !ParseIPv4(pszText + nStart, nLength - nStart, arrBytes))
+				return false;
+			arrGroups[nGroups++] = (static_cast<UINT>(arrBytes[0]) << 8) | arrBytes[1];
+			arrGroups[nGroups++] = (static_cast<UINT>(arrBytes[2]) << 8) | arrBytes[3];
+			break;
+		}
+		if ((nDigits == 0) || (nDigits > 4) || (nGroups == 8))
+			return false;
+		arrGroups[nGroups++] = nValue;
+		if (i == nLength)
+			break;
+		if ((pszText[i] != ':') || (++i == nLength))
+			return false;
+		if (pszText[i] == ':')
+		{
+			if (nGap >= 0)
+				return false;
+			nGap = nGroups;
+			++i;
+		}
+	}
+
+	if (nGap < 0)
+	{
+		if (nGroups != 8)
+			return false;
+	}
+	else
+	{
+		// "::" stands for at least one zero group; move the groups which follow it to the end
+		if (nGroups > 7)
+			return false;
+		const int nFollowing{ nGroups - nGap };
+		for (int j = 1; j <= nFollowing; j++)
+		{
+			arrGroups[8 - j] = arrGroups[nGroups - j];
+			arrGroups[nGroups - j] = 0;
+		}
+	}
+
+	BYTE* pBytes{ static_cast<BYTE*>(pAddress) };
+	for (int j = 0; j < 8; j++)
+	{
+		pBytes[2 * j] = static_cast<BYTE>(arrGroups[j] >> 8);
+		pBytes[(2 * j) + 1] = static_cast<BYTE>(arrGroups[j] & 0xFF);
+	}
+	return true;
+}
@@ -0,0 +1,44 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IpAddressText.h : interface of the CIpAddressText class, which converts IPv4 / IPv6 addresses to and from
+// their numeric text form.
+//
+
+#pragma once
+
+// CIpAddressText: formats addresses the way inet_ntop and getnameinfo(NI_NUMERICHOST) do, IPv6 in the RFC 5952
+// canonical form with a dotted decimal tail for IPv4-mapped and IPv4-compatible addresses, and parses the same
+// literals. Everything works on caller supplied buffers through lookup tables, so no resolver library call, lock
+// or allocation is involved.
+class CIpAddressText
+{
+public:
+	static constexpr size_t MAX_LENGTH{ 64 };           // Buffer size which fits any literal, scope id and terminator included
+
+	// Format the in_addr / in6_addr bytes of nFamily; returns the length without the terminator, 0 for an unknown family
+	static size_t Format(int nFamily, const void* pAddress, char* pszBuffer, size_t nBufferSize) noexcept;
+	static size_t Format(int nFamily, const void* pAddress, wchar_t* pszBuffer, size_t nBufferSize) noexcept;
+
+	// Format a socket address, followed by "%<scope id>" for scoped IPv6 addresses
+	static size_t Format(const SOCKADDR* pSockAddr, int nSockAddrLen, char* pszBuffer, size_t nBufferSize) noexcept;
+	static size_t Format(const SOCKADDR* pSockAddr, int nSockAddrLen, wchar_t* pszBuffer, size_t nBufferSize) noexcept;
+
+	// Parse a dotted decimal IPv4 or an IPv6 literal into pAddress (at least 16 bytes); nFamily receives its family
+	static bool Parse(const char* pszText, size_t nLength, int& nFamily, void* pAddress) noexcept;
+	static bool Parse(const wchar_t* pszText, size_t nLength, int& nFamily, void* pAddress) noexcept;
+	static bool ParseIPv4(const char* pszText, size_t nLength, void* pAddress) noexcept;
+	static bool ParseIPv6(const char* pszText, size_t nLength, void* pAddress) noexcept;
+};
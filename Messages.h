@@ -17,3 +17,4 @@ NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
 
 static constexpr UINT MSG_NAVIGATE = WM_APP + 123;
 static constexpr UINT MSG_RUN_ASYNC_CALLBACK = WM_APP + 124;
+static constexpr UINT MSG_POST_RESULTS = WM_APP + 125;
@@ -0,0 +1,315 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// NameResolver.cpp : implementation of the CNameResolver class
+//
+
+#include "pch.h"
+#include "NameResolver.h"
+#include "ping.h"
+#include "Utf8Writer.h"
+#include <cstring>
+
+/**
+ * @brief Compares two addresses
+ * @param other The other address
+ * @return true if both are the same address of the same family
+ */
+bool CAddressKey::operator==(const CAddressKey& other) const noexcept
+{
+	return (nFamily == other.nFamily) && (memcmp(Address, other.Address, sizeof(Address)) == 0);
+}
+
+/**
+ * @brief Hashes an address (FNV-1a)
+ * @param key The address
+ * @return The hash value
+ */
+size_t CAddressKeyHash::operator()(const CAddressKey& key) const noexcept
+{
+	ULONGLONG nHash{ 14695981039346656037ULL ^ key.nFamily };
+	for (const BYTE nByte : key.Address)
+		nHash = (nHash ^ nByte) * 1099511628211ULL;
+	return static_cast<size_t>(nHash);
+}
+
+/**
+ * @brief Default constructor for CNameResolver; names are kept for an hour, missing names for five minutes
+ */
+CNameResolver::CNameResolver() noexcept :
+	m_pSink{ nullptr },
+	m_nPositiveTTL{ 3600ULL * 1000000ULL },
+	m_nNegativeTTL{ 300ULL * 1000000ULL },
+	m_nMaxEntries{ 4096 },
+	m_nMaxQueued{ 1024 },
+	m_bStopping{ false }
+{
+}
+
+/**
+ * @brief Destructor for CNameResolver; stops the worker threads
+ */
+CNameResolver::~CNameResolver()
+{
+	Stop();
+}
+
+/**
+ * @brief Starts the worker threads
+ * @param nThreads How many lookups may run at the same time
+ * @return true if the threads are running
+ */
+bool CNameResolver::Start(size_t nThreads)
+{
+	if (!m_arrThreads.empty())
+		return true;
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_bStopping = false;
+	}
+	if (nThreads == 0)
+		nThreads = 1;
+	for (size_t i = 0; i < nThreads; i++)
+		m_arrThreads.emplace_back(&CNameResolver::WorkerThread, this);
+	return true;
+}
+
+/**
+ * @brief Drops the queued lookups and waits for the worker threads to finish the ones they are running
+ * @details The sink may still be called until Stop returns, so stop the resolver before the sink goes away
+ */
+void CNameResolver::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_bStopping = true;
+	}
+	m_WakeUp.notify_all();
+	for (auto& thread : m_arrThreads)
+	{
+		if (thread.joinable())
+			thread.join();
+	}
+	m_arrThreads.clear();
+
+	// Lookups which never ran are forgotten, so a later Lookup queues them again
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_Queue.clear();
+	for (auto it = m_Cache.begin(); it != m_Cache.end(); )
+	{
+		if (it->second.nExpires != 0)
+			++it;
+		else if (it->second.strName.empty())
+			it = m_Cache.erase(it);
+		else
+		{
+			it->second.nExpires = 1; // Stale, looked up again when it is next asked for
+			++it;
+		}
+	}
+}
+
+/**
+ * @brief Attaches the sink which hears about names as they are found
+ * @param pSink The sink, nullptr for none
+ */
+void CNameResolver::SetSink(CNameResolverSink* pSink)
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_pSink = pSink;
+}
+
+/**
+ * @brief Sets how long answers are cached
+ * @param nPositiveTTL How long a found name is kept, microseconds
+ * @param nNegativeTTL How long an address without a name is kept, microseconds
+ */
+void CNameResolver::SetTimeToLive(ULONGLONG nPositiveTTL, ULONGLONG nNegativeTTL) noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_nPositiveTTL = nPositiveTTL;
+	m_nNegativeTTL = nNegativeTTL;
+}
+
+/**
+ * @brief Gets the host name of an address without waiting for it
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr / in6_addr bytes
+ * @param pszName Receives the UTF-8 name, empty if it is not known
+ * @param nNameSize Size of pszName in bytes
+ * @return true if a name is known; otherwise a lookup is queued, unless one is already pending or the address
+ * is known to have no name
+ * @details While a stale name is looked up again the stale name is still returned
+ */
+bool CNameResolver::Lookup(int nFamily, const void* pAddress, char* pszName, size_t nNameSize)
+{
+	CUtf8Writer name{ pszName, nNameSize };
+	CAddressKey key{};
+	key.nFamily = static_cast<WORD>(nFamily);
+	if (nFamily == AF_INET)
+		memcpy(key.Address, pAddress, 4);
+	else if (nFamily == AF_INET6)
+		memcpy(key.Address, pAddress, 16);
+	else
+		return false;
+
+	const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		auto it{ m_Cache.find(key) };
+		if (it != m_Cache.end())
+		{
+			const CEntry& entry{ it->second };
+			name.Append(entry.strName.data(), entry.strName.size());
+			if ((entry.nExpires == 0) || (entry.nExpires > nNow))
+				return !entry.strName.empty();
+		}
+		if (m_Queue.size() >= m_nMaxQueued)
+			return name.GetLength() > 0;
+		if ((it == m_Cache.end()) && (m_Cache.size() >= m_nMaxEntries))
+			PurgeLocked(nNow);
+		m_Cache[key].nExpires = 0;
+		m_Queue.push_back(key);
+	}
+	m_WakeUp.notify_one();
+	return name.GetLength() > 0;
+}
+
+/**
+ * @brief Forgets every cached name and drops the queued lookups
+ */
+void CNameResolver::Clear()
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_Cache.clear();
+	m_Queue.clear();
+}
+
+/**
+ * @brief Drops the stale entries, and if that does not make room, every entry which is not pending; m_Mutex must be held
+ * @param nNow The current CPingClock time in microseconds
+ */
+void CNameResolver::PurgeLocked(ULONGLONG nNow)
+{
+	for (auto it = m_Cache.begin(); it != m_Cache.end(); )
+	{
+		if ((it->second.nExpires != 0) && (it->second.nExpires <= nNow))
+			it = m_Cache.erase(it);
+		else
+			++it;
+	}
+	if (m_Cache.size() < m_nMaxEntries)
+		return;
+	for (auto it = m_Cache.begin(); it != m_Cache.end(); )
+	{
+		if (it->second.nExpires != 0)
+			it = m_Cache.erase(it);
+		else
+			++it;
+	}
+}
+
+/**
+ * @brief A worker thread: takes queued addresses, looks them up and caches the answers
+ */
+void CNameResolver::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	while (!m_bStopping)
+	{
+		if (m_Queue.empty())
+		{
+			m_WakeUp.wait(lock);
+			continue;
+		}
+		const CAddressKey key{ m_Queue.front() };
+		m_Queue.pop_front();
+
+		// The lookup can take seconds, so it runs without the lock
+		lock.unlock();
+		char szName[NI_MAXHOST * 3];
+		const bool bFound{ ResolveName(key, szName, sizeof(szName)) };
+		lock.lock();
+
+		auto it{ m_Cache.find(key) };
+		if (it == m_Cache.end())
+			continue; // Cleared in the meantime
+		it->second.strName = bFound ? szName : "";
+		it->second.nExpires = CPingClock::NowMicroseconds() + (bFound ? m_nPositiveTTL : m_nNegativeTTL);
+		CNameResolverSink* pSink{ m_pSink };
+		if (bFound && (pSink != nullptr))
+		{
+			// Without the lock, as the sink may well call Lookup
+			lock.unlock();
+			pSink->OnNameResolved(key.nFamily, key.Address, szName);
+			lock.lock();
+		}
+	}
+}
+
+/**
+ * @brief Looks up the host name of an address, waiting for the answer
+ * @param key The address
+ * @param pszName Receives the UTF-8 name
+ * @param nNameSize Size of pszName in bytes
+ * @return true if the address has a name
+ * @details Characters which have no business in a host name are replaced with '?', so the name can be put into
+ * the HTML results as it is
+ */
+bool CNameResolver::ResolveName(const CAddressKey& key, char* pszName, size_t nNameSize)
+{
+	SOCKADDR_STORAGE address{};
+	int nAddressLen{ 0 };
+	if (key.nFamily == AF_INET)
+	{
+#pragma warning(suppress: 26490)
+		SOCKADDR_IN* pAddress{ reinterpret_cast<SOCKADDR_IN*>(&address) };
+		pAddress->sin_family = AF_INET;
+		memcpy(&pAddress->sin_addr, key.Address, sizeof(pAddress->sin_addr));
+		nAddressLen = sizeof(SOCKADDR_IN);
+	}
+	else
+	{
+#pragma warning(suppress: 26490)
+		SOCKADDR_IN6* pAddress{ reinterpret_cast<SOCKADDR_IN6*>(&address) };
+		pAddress->sin6_family = AF_INET6;
+		memcpy(&pAddress->sin6_addr, key.Address, sizeof(pAddress->sin6_addr));
+		nAddressLen = sizeof(SOCKADDR_IN6);
+	}
+
+	CUtf8Writer name{ pszName, nNameSize };
+#ifdef _WIN32
+	wchar_t szName[NI_MAXHOST]{};
+#pragma warning(suppress: 26490)
+	if (GetNameInfoW(reinterpret_cast<const SOCKADDR*>(&address), nAddressLen, szName, NI_MAXHOST, nullptr, 0, NI_NAMEREQD) != 0)
+		return false;
+	name.AppendWide(szName, wcslen(szName));
+#else
+	char szName[NI_MAXHOST]{};
+	if (getnameinfo(reinterpret_cast<const SOCKADDR*>(&address), nAddressLen, szName, NI_MAXHOST, nullptr, 0, NI_NAMEREQD) != 0)
+		return false;
+	name.Append(szName);
+#endif //#ifdef _WIN32
+	if (name.GetLength() == 0)
+		return false;
+
+	for (size_t i = 0; i < name.GetLength(); i++)
+	{
+		const char ch{ pszName[i] };
+		if (!(((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z')) || ((ch >= '0') && (ch <= '9')) || (ch == '.') || (ch == '-') || (ch == '_')))
+			pszName[i] = '?';
+	}
+	return true;
+}
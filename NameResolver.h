@@ -0,0 +1,100 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// NameResolver.h : interface of the CNameResolver class, a pool of threads which look up the host names of
+// IP addresses in the background and cache them.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// CAddressKey: an IPv4 or IPv6 address, as the key of the name cache
+struct CAddressKey
+{
+	WORD nFamily;                         // AF_INET or AF_INET6
+	BYTE Address[16];                     // in_addr / in6_addr bytes, the unused ones zero
+
+	bool operator==(const CAddressKey& other) const noexcept;
+};
+
+struct CAddressKeyHash
+{
+	size_t operator()(const CAddressKey& key) const noexcept;
+};
+
+// CNameResolverSink: told about names as they are found; called on a resolver thread
+class CNameResolverSink
+{
+public:
+	virtual ~CNameResolverSink() = default;
+
+	virtual void OnNameResolved(int nFamily, const BYTE* pAddress, const char* pszName) = 0; // pszName is UTF-8
+};
+
+// CNameResolver: Lookup never blocks. It answers from the cache, and for an address it has not seen it queues
+// a reverse lookup for the worker threads and answers "not known yet"; the sink hears about the name once it
+// is found. Names are cached for PositiveTTL, addresses without a name for NegativeTTL, so every address is
+// looked up at most once per TTL however many replies come from it.
+class CNameResolver
+{
+public:
+	CNameResolver() noexcept;
+	CNameResolver(const CNameResolver&) = delete;
+	CNameResolver(CNameResolver&&) = delete;
+	virtual ~CNameResolver();
+
+	CNameResolver& operator=(const CNameResolver&) = delete;
+	CNameResolver& operator=(CNameResolver&&) = delete;
+
+	bool Start(size_t nThreads);                        // Starts the worker threads
+	void Stop();                                        // Drops the queued lookups and waits for the running ones
+	void SetSink(CNameResolverSink* pSink);             // Attaches (or with nullptr detaches) the sink
+	void SetTimeToLive(ULONGLONG nPositiveTTL, ULONGLONG nNegativeTTL) noexcept; // Microseconds
+	void SetMaxEntries(size_t nMaxEntries) noexcept { m_nMaxEntries = (nMaxEntries > 0) ? nMaxEntries : 1; }
+	bool Lookup(int nFamily, const void* pAddress, char* pszName, size_t nNameSize); // true with the name if it is known
+	void Clear();                                       // Forgets every cached name
+
+	static bool ResolveName(const CAddressKey& key, char* pszName, size_t nNameSize); // Blocking reverse lookup
+
+protected:
+	// The cache entry of an address
+	struct CEntry
+	{
+		std::string strName;              // The UTF-8 host name, empty if there is none
+		ULONGLONG nExpires;               // CPingClock time the entry goes stale, 0 while the lookup is pending
+	};
+
+	void WorkerThread();
+	void PurgeLocked(ULONGLONG nNow);
+
+	std::mutex m_Mutex;                                // Protects everything below
+	std::condition_variable m_WakeUp;                  // Signalled when lookups are queued or on Stop
+	std::vector<std::thread> m_arrThreads;             // The worker threads
+	std::unordered_map<CAddressKey, CEntry, CAddressKeyHash> m_Cache; // Found names, missing names and pending lookups
+	std::deque<CAddressKey> m_Queue;                   // Addresses waiting for a worker
+	CNameResolverSink* m_pSink;                        // Told about found names, nullptr while detached
+	ULONGLONG m_nPositiveTTL;                          // How long a found name is kept, microseconds
+	ULONGLONG m_nNegativeTTL;                          // How long an address without a name is kept, microseconds
+	size_t m_nMaxEntries;                              // Cache size at which stale entries are purged
+	size_t m_nMaxQueued;                               // Lookups beyond this many waiting ones are not queued
+	bool m_bStopping;                                  // Tells the worker threads to exit
+};
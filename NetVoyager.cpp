@@ -27,6 +27,7 @@ NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
 // Include version information reader and hyperlink control
 #include "VersionInfo.h"
 #include "HLinkCtrl.h"
+#include "IpAddressText.h"
 
 #ifdef _DEBUG
 // Override new operator for memory leak detection in debug builds
@@ -58,14 +59,41 @@ CNetVoyagerApp::CNetVoyagerApp() noexcept :
 	m_bResolveAddressesToHostnames{ false },  // Don't resolve IPs to hostnames by default
 	m_bPingTillStopped{ false },              // Send limited number of pings
 	m_nRequestsToSend{ 4 },                   // Default: send 4 ping requests
+	m_dwPingInterval{ 1000 },                 // Send one ping request per second
+	m_bFloodPing{ false },                    // No flood mode by default
+	m_bProbeAllAddresses{ false },            // Ping only the first address of a host name
+	m_nStatisticsInterval{ 100 },             // Interim statistics every 100 requests when pinging till stopped
+	m_nRetainLines{ 10000 },                  // Keep the last 10000 result lines, older ones are summarised
+	m_dwRetainMinutes{ 0 },                   // No age limit on the result lines
 	m_nTTL{ 128 },                            // Time To Live for packets
 	m_nTOS{ 0 },                              // Type Of Service (QoS)
 	m_wDataRequestSize{ 32 },                 // Default ping data size: 32 bytes
 	m_dwTimeout{ 5000 },                      // Timeout: 5 seconds
 	m_bDontFragment{ false },                 // Allow packet fragmentation
 	m_bIPv6{ false },                         // Use IPv4 by default
+	m_bDualStack{ false },                    // One address family per run
 	m_nHopCount{ 30 },                        // Maximum hops for traceroute
-	m_nPings{ 3 }                             // Number of pings per hop in traceroute
+	m_nPings{ 3 },                            // Number of pings per hop in traceroute
+	m_bConcurrentTraceRoute{ true },          // Probe all hops at once so silent hops cost one timeout in total
+	m_nTraceGapLimit{ 5 },                    // Give up on a filtered destination after 5 silent hops in a row
+	m_bTraceStopOnUnreachable{ true },        // Stop at the first hop which reports the destination as unreachable
+	m_bAdaptiveTimeout{ false },              // Wait the full timeout for every probe; RFC 6298 style timeouts are opt in
+	m_dwAdaptiveTimeoutFloor{ 200 },          // Never give up on a probe in less than 200 ms
+	m_bContinuousTraceRoute{ false },         // A single pass traceroute by default
+	m_nTraceCycles{ 0 },                      // Continuous traceroute: run until the Stop command
+	m_dwTraceCycleInterval{ 1000 },           // Continuous traceroute: one cycle per second
+	m_nTraceSnapshotInterval{ 10 },           // Continuous traceroute: per hop statistics every 10 cycles
+	m_bMonitorRoute{ false },                 // A single trace rather than a route monitor
+	m_nRouteChecks{ 0 },                      // Route monitor: run until the Stop command
+	m_dwRouteCheckInterval{ 60000 },          // Route monitor: check the route once a minute
+	m_bFlowStableTraceRoute{ false },         // Probes may take different load balanced paths, as with the ICMP API
+	m_bMultipathTraceRoute{ false },          // Trace a single path
+	m_nMultipathConfidence{ 95 },             // Multipath traceroute: miss a next hop of an interface at most 5% of the time
+	m_bSimulateEcmp{ false },                 // Trace the real network
+	m_dwBulkInterval{ 1000 },                 // Bulk ping: one request every millisecond
+	m_dwBulkTimeout{ 1000 },                  // Bulk ping: 1 second per request
+	m_nBulkRetries{ 2 },                      // Bulk ping: retry a timed out request twice
+	m_bBulkTraceRoute{ false }                // Bulk ping: ping the targets rather than trace them
 {
 	// Enable Restart Manager support for application recovery
 	m_dwRestartManagerSupportFlags = AFX_RESTART_MANAGER_SUPPORT_RESTART;
@@ -401,13 +429,27 @@ void CNetVoyagerApp::OnAppAbout()
  * @param nFlags Flags to control name resolution (e.g., NI_NUMERICHOST)
  * @param pnSocketPort Optional pointer to receive the port number
  * @return String representation of the address, or empty string on failure
- * @details Uses GetNameInfo to convert the address, supports both IPv4 and IPv6
+ * @details Numeric IPv4 and IPv6 addresses are formatted by CIpAddressText in a stack buffer; GetNameInfo is
+ * only called to look up host names
  */
 CString CNetVoyagerApp::AddressToString(const SOCKADDR* pSockAddr, int nSockAddrLen, int nFlags, UINT* pnSocketPort)
 {
 	// What will be the return value from this function
 	CString sSocketAddress;
 
+	if ((nFlags & NI_NUMERICHOST) != 0)
+	{
+		TCHAR szAddress[CIpAddressText::MAX_LENGTH];
+		const size_t nLength{ CIpAddressText::Format(pSockAddr, nSockAddrLen, szAddress, CIpAddressText::MAX_LENGTH) };
+		if (nLength != 0)
+		{
+			sSocketAddress.SetString(szAddress, static_cast<int>(nLength));
+			if (pnSocketPort != nullptr)
+				*pnSocketPort = ntohs(SS_PORT(pSockAddr));
+			return sSocketAddress;
+		}
+	}
+
 	int nResult{ 0 };
 #ifdef _UNICODE
 	// Use wide character version for Unicode builds
@@ -484,19 +526,14 @@ CString CNetVoyagerApp::GetIpErrorString(IP_STATUS dwError)
 
 /**
  * @brief Converts a round-trip time value to a formatted string
- * @param dwRTT Round-trip time in milliseconds
- * @return Formatted string (e.g., "<1ms" or "25ms")
- * @details Returns "<1ms" for RTT of 0, otherwise formats as "XXms"
+ * @param nRTT Round-trip time in microseconds
+ * @return Formatted string (e.g., "0.087ms" or "25.304ms")
+ * @details Formats as milliseconds with microsecond precision so that LAN latencies remain visible
  */
-CString CNetVoyagerApp::RTTAsString(DWORD dwRTT)
+CString CNetVoyagerApp::RTTAsString(ULONGLONG nRTT)
 {
 	CString sMsg;
-	if (dwRTT == 0)
-		// RTT too fast to measure accurately
-		sMsg = _T("<1ms");
-	else
-		// Format as milliseconds (e.g., "25ms")
-		sMsg.Format(_T("%ums"), dwRTT);
+	sMsg.Format(_T("%llu.%03llums"), nRTT / 1000ULL, nRTT % 1000ULL);
 	return sMsg;
 }
 
@@ -39,14 +39,43 @@ public:
 	bool m_bResolveAddressesToHostnames; // When true, reverse-resolve IP addresses to hostnames in results
 	bool m_bPingTillStopped;            // When true, ping continuously until the user stops; otherwise use m_nRequestsToSend
 	int m_nRequestsToSend;              // Number of ICMP echo requests to send (used when m_bPingTillStopped is false)
+	DWORD m_dwPingInterval;             // Time between the start of consecutive echo requests in milliseconds
+	bool m_bFloodPing;                  // When true, send each echo request as soon as the previous one completes (stress tests)
+	bool m_bProbeAllAddresses;          // When true, ping every address the host name resolves to at the same time instead of only the first
+	int m_nStatisticsInterval;          // In continuous mode, print interim ping statistics every this many requests (0 = only at the end)
+	size_t m_nRetainLines;              // Keep only the most recent result lines of an operation (0 = keep them all)
+	DWORD m_dwRetainMinutes;            // Keep only the result lines of the last minutes of an operation (0 = no age limit)
 	UCHAR m_nTTL;                       // Time-To-Live value set on outgoing packets (limits hop count)
 	UCHAR m_nTOS;                       // Type-Of-Service / DSCP byte for QoS prioritisation
 	WORD m_wDataRequestSize;            // Payload size (bytes) of each ICMP echo request
 	DWORD m_dwTimeout;                  // Per-request timeout in milliseconds before treating as a loss
 	bool m_bDontFragment;               // When true, sets the DF (Don't Fragment) bit on IP packets
 	bool m_bIPv6;                       // When true, use ICMPv6 / IPv6; otherwise use ICMPv4 / IPv4
+	bool m_bDualStack;                  // When true, ping / trace over IPv4 and IPv6 at the same time and compare them (overrides m_bIPv6)
 	UCHAR m_nHopCount;                  // Maximum number of hops (TTL limit) for traceroute
 	UCHAR m_nPings;                     // Number of probes sent per hop during traceroute
+	bool m_bConcurrentTraceRoute;       // When true, probe all traceroute hops concurrently instead of one at a time
+	UCHAR m_nTraceGapLimit;             // Stop a traceroute after this many consecutive silent hops (0 = no limit)
+	bool m_bTraceStopOnUnreachable;     // When true, stop a traceroute at a hop which reports the destination as unreachable
+	bool m_bAdaptiveTimeout;            // When true, give up on a probe after a few observed round trip times instead of m_dwTimeout
+	DWORD m_dwAdaptiveTimeoutFloor;     // The smallest adaptive timeout in milliseconds (m_dwTimeout is the largest)
+	bool m_bContinuousTraceRoute;       // When true, trace MTR style: cycle through the path and report rolling per hop statistics
+	DWORD m_nTraceCycles;               // Continuous traceroute: cycles to run (0 = until stopped)
+	DWORD m_dwTraceCycleInterval;       // Continuous traceroute: time between the start of consecutive cycles in milliseconds
+	DWORD m_nTraceSnapshotInterval;     // Continuous traceroute: report the per hop statistics every this many cycles
+	bool m_bMonitorRoute;               // When true, trace the route again and again, only re-probing what changed, and report route changes
+	DWORD m_nRouteChecks;               // Route monitor: traces to run (0 = until stopped)
+	DWORD m_dwRouteCheckInterval;       // Route monitor: time between the start of consecutive traces in milliseconds
+	bool m_bFlowStableTraceRoute;       // When true, keep all traceroute probes in one flow so load balancers send them down one path (Paris traceroute)
+	bool m_bMultipathTraceRoute;        // When true, enumerate every path through the load balancers on the route instead of tracing one
+	DWORD m_nMultipathConfidence;       // Multipath traceroute: the probability in percent of finding every next hop of an interface
+	bool m_bSimulateEcmp;               // When true, trace the built-in simulated network of load balancers instead of the host (for testing)
+	CString m_sBulkTargetList;          // Target list file (host names, addresses or CIDR blocks) used by bulk ping
+	DWORD m_dwBulkInterval;             // Bulk ping: time between consecutive requests in microseconds (pacing)
+	DWORD m_dwBulkTimeout;              // Bulk ping: per-request timeout in milliseconds
+	DWORD m_nBulkRetries;               // Bulk ping: retries of a timed out request
+	bool m_bBulkTraceRoute;             // Bulk ping: trace the route to every IPv4 target instead, skipping the hops already known
+	CString m_sTopologyFile;            // File the merged topology of the traced paths is written to after every trace, .graphml for GraphML, otherwise DOT (empty = none)
 
 // Overrides
 public:
@@ -59,7 +88,7 @@ public:
 	// Returns the system error message for a Win32 error code
 	static CString GetErrorMessage(DWORD dwError);
 	// Formats a round-trip time value as a string (e.g. "<1ms" or "25ms")
-	static CString RTTAsString(DWORD dwRTT);
+	static CString RTTAsString(ULONGLONG nRTT);
 	// Returns the descriptive string for an IP_STATUS error code from the ICMP API
 	static CString GetIpErrorString(IP_STATUS dwError);
 
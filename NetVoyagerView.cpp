@@ -30,50 +30,30 @@ NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
 #include "PleaseWait.h"
 #include "ping.h"
 #include "tracer.h"
+#include "BulkPing.h"
+#include "ProbeEngine.h"
+#include "BatchTraceRoute.h"
+#include "ContinuousTraceRoute.h"
+#include "IncrementalTraceRoute.h"
+#include "ParisTraceRoute.h"
+#include "SimulatedEcmpBackend.h"
+#include "AdaptiveTimeout.h"
+#include "IntervalScheduler.h"
+#include "ProbeStatistics.h"
+#include "Utf8Writer.h"
+#include "IpAddressText.h"
+#include "Messages.h"
+#include <atomic>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
 #endif
 
-/**
- * @brief Converts a wide character string to UTF-8 encoded string
- * @param pszText Pointer to the wide character string to convert
- * @param nLength Length of the input string, or -1 for null-terminated strings
- * @return CStringA containing the UTF-8 encoded string
- */
-CStringA W2UTF8(_In_NLS_string_(nLength) const wchar_t* pszText, _In_ int nLength)
-{
-	// First call the function to determine how much space we need to allocate
-	int nUTF8Length{ WideCharToMultiByte(CP_UTF8, 0, pszText, nLength, nullptr, 0, nullptr, nullptr) };
-
-	// If the calculated length is zero, then ensure we have at least room for a null terminator
-	if (nUTF8Length == 0)
-		nUTF8Length = 1;
-
-	// Now recall with the buffer to get the converted text
-	CStringA sUTF;
-#pragma warning(suppress: 26429)
-	// Get a writable buffer from CStringA with extra space for null terminator
-	char* const pszUTF8Text{ sUTF.GetBuffer(nUTF8Length + 1) };
-	// Perform the actual conversion from wide char to UTF-8
-	int nCharsWritten{ WideCharToMultiByte(CP_UTF8, 0, pszText, nLength, pszUTF8Text, nUTF8Length, nullptr, nullptr) };
-
-	// Ensure we null terminate the text if WideCharToMultiByte doesn't do it for us
-	if (nLength != -1)
-	{
-#pragma warning(suppress: 26477 26496)
-		ATLASSUME(nCharsWritten <= nUTF8Length);
-#pragma warning(suppress: 26481)
-		// Manually add null terminator for counted strings
-		pszUTF8Text[nCharsWritten] = '\0';
-	}
-	// Release the buffer and return the result
-	sUTF.ReleaseBuffer();
-
-	return sUTF;
-}
-
 /**
  * @brief Converts a UTF-8 encoded string to wide character string
  * @param pszText Pointer to the UTF-8 encoded string to convert
@@ -120,10 +100,15 @@ BEGIN_MESSAGE_MAP(CNetVoyagerView, CView)
 	// Standard printing commands
 	ON_WM_DESTROY()
 	ON_WM_SIZE()
+	ON_MESSAGE(MSG_POST_RESULTS, &CNetVoyagerView::OnPostResults)
 	ON_COMMAND(ID_PING, &CNetVoyagerView::OnPing)
 	ON_COMMAND(ID_TRACE_ROUTE, &CNetVoyagerView::OnTraceRoute)
 	ON_UPDATE_COMMAND_UI(ID_PING, &CNetVoyagerView::OnUpdatePing)
 	ON_UPDATE_COMMAND_UI(ID_TRACE_ROUTE, &CNetVoyagerView::OnUpdateTraceRoute)
+	ON_COMMAND(ID_BULK_PING, &CNetVoyagerView::OnBulkPing)
+	ON_UPDATE_COMMAND_UI(ID_BULK_PING, &CNetVoyagerView::OnUpdateBulkPing)
+	ON_COMMAND(ID_STOP, &CNetVoyagerView::OnStop)
+	ON_UPDATE_COMMAND_UI(ID_STOP, &CNetVoyagerView::OnUpdateStop)
 END_MESSAGE_MAP()
 
 // CNetVoyagerView construction/destruction
@@ -135,6 +120,7 @@ CNetVoyagerView::CNetVoyagerView() noexcept
 {
 	// Initialize thread ID to zero (no thread running)
 	m_nThreadID = 0;
+	m_nLinesInFile = 0;
 }
 
 /**
@@ -207,6 +193,10 @@ void CNetVoyagerView::OnInitialUpdate()
 	this->ModifyStyleEx(WS_EX_CLIENTEDGE | WS_EX_WINDOWEDGE, 0, 0);
 	this->ModifyStyle(WS_CAPTION | WS_SYSMENU | WS_MAXIMIZEBOX | WS_MINIMIZEBOX | WS_THICKFRAME | WS_BORDER, 0, 0);
 
+	// Host names are looked up in the background, a few at a time
+	m_NameResolver.SetSink(this);
+	m_NameResolver.Start(4);
+
 	// Create the Edge WebView2 browser control
 	m_pWebBrowser = std::make_unique<CWebBrowser>();
 
@@ -249,6 +239,11 @@ void CNetVoyagerView::OnInitialUpdate()
  */
 void CNetVoyagerView::OnDestroy()
 {
+	// Stop looking up names and streaming results before the view and its browser go away
+	m_NameResolver.SetSink(nullptr);
+	m_NameResolver.Stop();
+	m_ResultBatcher.Reset();
+	m_ResultBatcher.Stop();
 	// Release the web browser control before the view is destroyed
 	m_pWebBrowser.reset();
 
@@ -273,10 +268,421 @@ void CNetVoyagerView::OnSize(UINT nType, int cx, int cy)
 		m_pWebBrowser->Resize(cx, cy);
 }
 
-// Global flag to track if a network operation thread is currently running
-bool g_bThreadRunning = false;
-// Global buffer for formatting output strings from thread procedures
-TCHAR g_lpszOutputString[0x1000] = { 0, };
+// Global flag to track if a network operation thread is currently running; the Stop command clears it
+std::atomic<bool> g_bThreadRunning{ false };
+
+// Set by the Stop command until the stopped thread has finished, so that no other operation starts meanwhile
+std::atomic<bool> g_bStopping{ false };
+
+// How the Stop command interrupts the operation of the network thread, if it registered one
+std::mutex g_StopMutex;
+std::function<void()> g_StopOperation;
+
+/**
+ * @brief Registers how the Stop command interrupts the operation of the network thread, for as long as it runs
+ */
+class CStopRegistration
+{
+public:
+	explicit CStopRegistration(std::function<void()> stopOperation)
+	{
+		std::lock_guard<std::mutex> lock{ g_StopMutex };
+		g_StopOperation = std::move(stopOperation);
+	}
+	CStopRegistration(const CStopRegistration&) = delete;
+	CStopRegistration& operator=(const CStopRegistration&) = delete;
+	~CStopRegistration()
+	{
+		std::lock_guard<std::mutex> lock{ g_StopMutex };
+		g_StopOperation = nullptr;
+	}
+};
+
+/**
+ * @brief Formats a message line and adds it to the results
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param pszFormat printf style format of the line, followed by its arguments
+ * @details The line is formatted into a local string, so worker threads never share a buffer
+ */
+void AddFormattedText(CNetVoyagerView* pNetVoyagerView, _In_z_ _Printf_format_string_ LPCTSTR pszFormat, ...)
+{
+	CString sLine;
+	va_list args;
+	va_start(args, pszFormat);
+	sLine.FormatV(pszFormat, args);
+	va_end(args);
+	pNetVoyagerView->AddDocumentText(sLine);
+}
+
+/**
+ * @brief Displays the statistics of a ping run
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param stats The statistics accumulated so far
+ */
+void ReportPingStatistics(CNetVoyagerView* pNetVoyagerView, const CProbeStatistics& stats)
+{
+	AddFormattedText(pNetVoyagerView, _T("Ping statistics for <strong>%s</strong>: Sent = %llu, Received = %llu, Lost = %llu (%.1f%% loss)"), theApp.m_sHostToResolve.GetString(),
+		stats.GetSent(), stats.GetReceived(), stats.GetLost(), stats.GetLossRatio() * 100.0);
+	if (stats.GetReceived() == 0)
+		return;
+
+	// Round trip times: Welford mean / standard deviation, RFC 3550 jitter and histogram percentiles
+	AddFormattedText(pNetVoyagerView, _T("Round trip times: min = %s, avg = %s, max = %s, stddev = %s, jitter = %s"), theApp.RTTAsString(stats.GetMin()).GetString(),
+		theApp.RTTAsString(static_cast<ULONGLONG>(stats.GetMean() + 0.5)).GetString(), theApp.RTTAsString(stats.GetMax()).GetString(),
+		theApp.RTTAsString(static_cast<ULONGLONG>(stats.GetStdDev() + 0.5)).GetString(), theApp.RTTAsString(static_cast<ULONGLONG>(stats.GetJitter() + 0.5)).GetString());
+	AddFormattedText(pNetVoyagerView, _T("Percentiles: p50 = %s, p90 = %s, p99 = %s, p99.9 = %s"), theApp.RTTAsString(stats.GetPercentile(50.0)).GetString(),
+		theApp.RTTAsString(stats.GetPercentile(90.0)).GetString(), theApp.RTTAsString(stats.GetPercentile(99.0)).GetString(), theApp.RTTAsString(stats.GetPercentile(99.9)).GetString());
+}
+
+/**
+ * @brief Accounts for the outcome of an echo request and adds it to the results
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param nFamily The address family of the request
+ * @param bSuccess Did the request get a reply
+ * @param dwError The error of a request which failed
+ * @param prv4 The reply of an IPv4 request
+ * @param prv6 The reply of an IPv6 request
+ * @param pDestAddress The address the request was sent to, which a failed request names; nullptr to leave it out
+ * @param stats The statistics the outcome is added to
+ */
+void AddPingResult(CNetVoyagerView* pNetVoyagerView, int nFamily, bool bSuccess, DWORD dwError, const CPingReplyv4& prv4, const CPingReplyv6& prv6, const SOCKADDR* pDestAddress, CProbeStatistics& stats)
+{
+	CProbeResult result{};
+	result.nTimestamp = CPingClock::NowMicroseconds();
+	if (bSuccess)
+	{
+#pragma warning(suppress: 26490)
+		// Extract reply information based on IP version
+		const bool bIPv6{ nFamily == AF_INET6 };
+		const SOCKADDR* pAddress{ bIPv6 ? reinterpret_cast<const SOCKADDR*>(&prv6.Address) : reinterpret_cast<const SOCKADDR*>(&prv4.Address) };
+		const ULONGLONG& nRTT{ bIPv6 ? prv6.RTT : prv4.RTT };
+		const unsigned long& nEchoReplyStatus{ bIPv6 ? prv6.EchoReplyStatus : prv4.EchoReplyStatus };
+		if (nEchoReplyStatus == IP_SUCCESS)
+			stats.AddReply(nRTT);
+		else
+			stats.AddLoss();
+
+		// Hand over the reply as a record; it is only turned into text when it is rendered
+		result.nType = CProbeResultType::PingReply;
+		result.nStatus = nEchoReplyStatus;
+		result.nRTT = nRTT;
+		result.nDataSize = theApp.m_wDataRequestSize;
+		result.nTTL = theApp.m_nTTL;
+		result.SetAddress(pAddress);
+	}
+	else
+	{
+		// Ping failed - display error message
+		stats.AddLoss();
+		result.nType = CProbeResultType::PingError;
+		result.nStatus = dwError;
+		result.nFamily = AF_UNSPEC;
+		if (pDestAddress != nullptr)
+			result.SetAddress(pDestAddress);
+	}
+	// The host name, if wanted, is looked up in the background when the record is rendered
+	pNetVoyagerView->AddProbeResult(result, "", 0);
+}
+
+/**
+ * @brief The state of one address of a host which is pinged at all its addresses
+ */
+struct CAddressProbe
+{
+	SOCKADDR_STORAGE Address{};                      // The address which is pinged
+	TCHAR szAddress[CIpAddressText::MAX_LENGTH]{};   // The address as text, for the statistics
+	CPingReplyv4 prv4;                               // The reply to the last IPv4 request
+	CPingReplyv6 prv6;                               // The reply to the last IPv6 request
+	CProbeStatistics stats;                          // The statistics of the address
+	CAdaptiveTimeout timeout;                        // The timeout estimator of the address
+	DWORD dwTimeout{ 0 };                            // The timeout of the last request in milliseconds
+	bool bPending{ false };                          // Is the request of the round still in flight
+	bool bSuccess{ false };                          // Did the last request get a reply
+	DWORD dwError{ ERROR_SUCCESS };                  // The error of the last request which failed
+};
+
+/**
+ * @brief Accounts for the outcome of the request of a round to one address of the host
+ * @param probe The address
+ * @param completion The outcome of its request, from the probe engine
+ */
+void CompleteAddressProbe(CAddressProbe& probe, const CProbeCompletion& completion)
+{
+	probe.bPending = false;
+	probe.bSuccess = (completion.dwError == ERROR_SUCCESS);
+	probe.dwError = completion.dwError;
+	if (probe.bSuccess)
+	{
+		if (completion.nFamily == AF_INET6)
+		{
+			memcpy_s(&probe.prv6.Address, sizeof(probe.prv6.Address), &completion.Replier, sizeof(probe.prv6.Address));
+			probe.prv6.RTT = completion.RTT;
+			probe.prv6.EchoReplyStatus = completion.nStatus;
+		}
+		else
+		{
+			memcpy_s(&probe.prv4.Address, sizeof(probe.prv4.Address), &completion.Replier, sizeof(probe.prv4.Address));
+			probe.prv4.RTT = completion.RTT;
+			probe.prv4.EchoReplyStatus = completion.nStatus;
+		}
+		probe.timeout.AddSample(completion.RTT);
+	}
+	else if (probe.dwError == ERROR_TIMEOUT)
+		probe.timeout.AddLoss(probe.dwTimeout);
+}
+
+/**
+ * @brief Formats the difference between two round trip times with its sign
+ * @param fDelta The difference in microseconds
+ * @return The difference as text, e.g. "+1.2 ms"
+ */
+CString RTTDeltaAsString(double fDelta)
+{
+	const ULONGLONG nMagnitude{ static_cast<ULONGLONG>(((fDelta < 0.0) ? -fDelta : fDelta) + 0.5) };
+	return ((fDelta < 0.0) ? _T("-") : _T("+")) + theApp.RTTAsString(nMagnitude);
+}
+
+/**
+ * @brief Resolves the local address the requests of an address family are sent from
+ * @param nFamily AF_INET or AF_INET6
+ * @param bDualStack In a dual stack run a local address of the other family only means this family is not bound
+ * @param localAddress Receives the local address
+ * @param bBind Receives whether the requests are bound to localAddress
+ * @return 0 or the resolver error
+ */
+int ResolveLocalAddress(int nFamily, bool bDualStack, SOCKADDR_STORAGE& localAddress, bool& bBind)
+{
+	bBind = false;
+	if (theApp.m_sLocalBoundAddress.IsEmpty())
+		return 0;
+	BYTE literalAddress[16]{};
+	int nLiteralFamily{ AF_UNSPEC };
+	if (bDualStack && CIpAddressText::Parse(theApp.m_sLocalBoundAddress.GetString(), theApp.m_sLocalBoundAddress.GetLength(), nLiteralFamily, literalAddress) && (nLiteralFamily != nFamily))
+		return 0;
+#pragma warning(suppress: 26490)
+	const int nError{ CPingSession::ResolveAddress(theApp.m_sLocalBoundAddress, AI_PASSIVE, nFamily, reinterpret_cast<SOCKADDR*>(&localAddress), sizeof(localAddress)) };
+	bBind = (nError == 0);
+	return nError;
+}
+
+/**
+ * @brief Displays how long was spent waiting for lost probes with adaptive timeouts, next to how long the fixed
+ * timeout would have taken
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param nLosses The number of lost probes
+ * @param nLossWait Milliseconds spent waiting for them
+ * @param nFixedLossWait Milliseconds the fixed timeout would have spent waiting for them
+ */
+void ReportLossWait(CNetVoyagerView* pNetVoyagerView, ULONGLONG nLosses, ULONGLONG nLossWait, ULONGLONG nFixedLossWait)
+{
+	if (!theApp.m_bAdaptiveTimeout || (nLosses == 0))
+		return;
+	AddFormattedText(pNetVoyagerView, _T("Adaptive timeouts: %llu lost probes were given up after %.1f s in total instead of %.1f s with the fixed %u ms timeout (%.1f s saved)"),
+		nLosses, static_cast<double>(nLossWait) / 1000.0, static_cast<double>(nFixedLossWait) / 1000.0, theApp.m_dwTimeout, static_cast<double>(nFixedLossWait - nLossWait) / 1000.0);
+}
+
+/**
+ * @brief Displays the statistics of every address of a host side by side, one line per address
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param probes The addresses and their statistics
+ */
+void ReportAddressStatistics(CNetVoyagerView* pNetVoyagerView, const std::vector<std::unique_ptr<CAddressProbe>>& probes)
+{
+	AddFormattedText(pNetVoyagerView, _T("Ping statistics for the %zu addresses of <strong>%s</strong>:"), probes.size(), theApp.m_sHostToResolve.GetString());
+	for (const auto& pProbe : probes)
+	{
+		const CProbeStatistics& stats{ pProbe->stats };
+		if (stats.GetReceived() == 0)
+		{
+			AddFormattedText(pNetVoyagerView, _T("&nbsp;&nbsp;<strong>%s</strong>: Sent = %llu, Received = 0, Lost = %llu (100.0%% loss)"), pProbe->szAddress, stats.GetSent(), stats.GetLost());
+			continue;
+		}
+		AddFormattedText(pNetVoyagerView, _T("&nbsp;&nbsp;<strong>%s</strong>: Sent = %llu, Received = %llu, Lost = %llu (%.1f%% loss), min = %s, avg = %s, max = %s, p99 = %s"), pProbe->szAddress,
+			stats.GetSent(), stats.GetReceived(), stats.GetLost(), stats.GetLossRatio() * 100.0, theApp.RTTAsString(stats.GetMin()).GetString(),
+			theApp.RTTAsString(static_cast<ULONGLONG>(stats.GetMean() + 0.5)).GetString(), theApp.RTTAsString(stats.GetMax()).GetString(), theApp.RTTAsString(stats.GetPercentile(99.0)).GetString());
+	}
+
+	// A dual stack run of one address per family also gets the difference between the two stacks
+	if ((probes.size() != 2) || (probes[0]->Address.ss_family == probes[1]->Address.ss_family))
+		return;
+	const bool bIPv6First{ probes[0]->Address.ss_family == AF_INET6 };
+	const CProbeStatistics& statsv4{ probes[bIPv6First ? 1 : 0]->stats };
+	const CProbeStatistics& statsv6{ probes[bIPv6First ? 0 : 1]->stats };
+	if ((statsv4.GetReceived() == 0) || (statsv6.GetReceived() == 0))
+	{
+		AddFormattedText(pNetVoyagerView, _T("IPv6 compared to IPv4: loss %+.1f%%"), (statsv6.GetLossRatio() - statsv4.GetLossRatio()) * 100.0);
+		return;
+	}
+	AddFormattedText(pNetVoyagerView, _T("IPv6 compared to IPv4: min %s, avg %s, p50 %s, p99 %s, loss %+.1f%%"),
+		RTTDeltaAsString(static_cast<double>(statsv6.GetMin()) - static_cast<double>(statsv4.GetMin())).GetString(), RTTDeltaAsString(statsv6.GetMean() - statsv4.GetMean()).GetString(),
+		RTTDeltaAsString(static_cast<double>(statsv6.GetPercentile(50.0)) - static_cast<double>(statsv4.GetPercentile(50.0))).GetString(),
+		RTTDeltaAsString(static_cast<double>(statsv6.GetPercentile(99.0)) - static_cast<double>(statsv4.GetPercentile(99.0))).GetString(), (statsv6.GetLossRatio() - statsv4.GetLossRatio()) * 100.0);
+}
+
+/**
+ * @brief Pings several addresses of the host name at the same time: every address it resolves to instead of
+ * only the first one, and in a dual stack run both its IPv4 and its IPv6 address
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @details Every round submits one request to each address to a probe engine, which keeps all of them in flight
+ * from its one worker thread, so a round takes as long as its slowest request rather than the sum of all of them.
+ * A slow or dead backend of a load balanced or dual homed service shows up next to the healthy ones, and the two
+ * stacks are compared over the same time window instead of one run after the other.
+ */
+void PingAllAddresses(CNetVoyagerView* pNetVoyagerView)
+{
+	// Resolve the host name and the local addresses once for the whole run
+	const bool bDualStack{ theApp.m_bDualStack };
+	std::vector<SOCKADDR_STORAGE> addresses;
+	SOCKADDR_STORAGE localAddressv4{};
+	SOCKADDR_STORAGE localAddressv6{};
+	bool bBindv4{ false };
+	bool bBindv6{ false };
+	for (const int nFamily : { AF_INET, AF_INET6 })
+	{
+		if (!bDualStack && (nFamily != (theApp.m_bIPv6 ? AF_INET6 : AF_INET)))
+			continue;
+		std::vector<SOCKADDR_STORAGE> familyAddresses;
+		int nError{ 0 };
+		if (theApp.m_bProbeAllAddresses)
+			nError = CPingSession::ResolveAllAddresses(theApp.m_sHostToResolve, 0, nFamily, familyAddresses);
+		else
+		{
+			familyAddresses.resize(1);
+#pragma warning(suppress: 26490)
+			nError = CPingSession::ResolveAddress(theApp.m_sHostToResolve, 0, nFamily, reinterpret_cast<SOCKADDR*>(&familyAddresses.front()), sizeof(SOCKADDR_STORAGE));
+		}
+		if (nError == 0)
+			nError = (nFamily == AF_INET6) ? ResolveLocalAddress(nFamily, bDualStack, localAddressv6, bBindv6) : ResolveLocalAddress(nFamily, bDualStack, localAddressv4, bBindv4);
+		if (nError != 0)
+		{
+			// A host with only the one family can still be pinged in a dual stack run
+			if (bDualStack)
+				AddFormattedText(pNetVoyagerView, _T("No %s address: %s"), (nFamily == AF_INET6) ? _T("IPv6") : _T("IPv4"), theApp.GetErrorMessage(static_cast<DWORD>(nError)).GetString());
+			else
+				AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(static_cast<DWORD>(nError)).GetString());
+			continue;
+		}
+		addresses.insert(addresses.end(), familyAddresses.begin(), familyAddresses.end());
+	}
+	if (addresses.empty())
+		return;
+
+	// One probe engine sends the requests to every address, from the bound local addresses if any
+	std::vector<std::unique_ptr<CAddressProbe>> probes;
+	for (const auto& address : addresses)
+	{
+		auto pProbe{ std::make_unique<CAddressProbe>() };
+		pProbe->Address = address;
+		pProbe->timeout.SetBounds(theApp.m_dwAdaptiveTimeoutFloor, theApp.m_dwTimeout);
+#pragma warning(suppress: 26490)
+		CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&pProbe->Address), sizeof(pProbe->Address), pProbe->szAddress, _countof(pProbe->szAddress));
+		probes.push_back(std::move(pProbe));
+	}
+	CProbeEngine engine;
+	if (bBindv4)
+		engine.SetLocalAddress(localAddressv4);
+	if (bBindv6)
+		engine.SetLocalAddress(localAddressv6);
+	if (!engine.Start())
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+		return;
+	}
+	AddFormattedText(pNetVoyagerView, _T("Pinging %zu addresses at the same time"), probes.size());
+
+	CIntervalScheduler scheduler;
+	if (!scheduler.Start(theApp.m_bFloodPing ? 0 : (static_cast<ULONGLONG>(theApp.m_dwPingInterval) * 1000ULL)))
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+		return;
+	}
+
+	int nRounds{ 0 };
+	CProbeRequest request;
+	request.nTTL = theApp.m_nTTL;
+	request.nTOS = theApp.m_nTOS;
+	request.bDontFragment = theApp.m_bDontFragment;
+	request.wDataSize = theApp.m_wDataRequestSize;
+	while (g_bThreadRunning && scheduler.WaitForNextDeadline())
+	{
+		// Submit the requests of the round, the round and the index of the address as the cookie, and wait for all
+		// of them
+		const ULONG_PTR nRoundCookie{ static_cast<ULONG_PTR>(nRounds) << 16 };
+		size_t nPending{ 0 };
+		for (size_t i{ 0 }; i < probes.size(); i++)
+		{
+			CAddressProbe& probe{ *probes[i] };
+			probe.dwTimeout = theApp.m_bAdaptiveTimeout ? probe.timeout.GetTimeout() : theApp.m_dwTimeout;
+			request.nFamily = probe.Address.ss_family;
+			request.Address = probe.Address;
+			request.dwTimeout = probe.dwTimeout;
+			request.nCookie = nRoundCookie | i;
+			probe.bPending = engine.Submit(request);
+			if (probe.bPending)
+				++nPending;
+			else
+			{
+				probe.bSuccess = false;
+				probe.dwError = GetLastError();
+			}
+		}
+		CProbeCompletion completion;
+		while ((nPending > 0) && engine.GetCompletion(completion, theApp.m_dwTimeout + 1000))
+		{
+			if ((completion.nCookie & ~static_cast<ULONG_PTR>(0xFFFF)) != nRoundCookie)
+				continue;
+			CAddressProbe& probe{ *probes.at(completion.nCookie & 0xFFFF) };
+			if (!probe.bPending)
+				continue;
+			CompleteAddressProbe(probe, completion);
+			--nPending;
+		}
+		for (const auto& pProbe : probes)
+		{
+			// The engine gives up on a request at its timeout, so this only happens if the engine itself stalled
+			if (pProbe->bPending)
+			{
+				pProbe->bPending = false;
+				pProbe->bSuccess = false;
+				pProbe->dwError = ERROR_TIMEOUT;
+			}
+		}
+		++nRounds;
+
+		// Report the round in address order
+		for (const auto& pProbe : probes)
+		{
+#pragma warning(suppress: 26490)
+			AddPingResult(pNetVoyagerView, pProbe->Address.ss_family, pProbe->bSuccess, pProbe->dwError, pProbe->prv4, pProbe->prv6, reinterpret_cast<const SOCKADDR*>(&pProbe->Address), pProbe->stats);
+		}
+
+		// Check if we should stop pinging
+		if (!theApp.m_bPingTillStopped)
+		{
+			if (nRounds == theApp.m_nRequestsToSend)
+				break;
+		}
+		else if ((theApp.m_nStatisticsInterval > 0) && ((nRounds % theApp.m_nStatisticsInterval) == 0))
+			ReportAddressStatistics(pNetVoyagerView, probes);
+	}
+
+	// Display the summary of the run
+	ReportAddressStatistics(pNetVoyagerView, probes);
+	ULONGLONG nLosses{ 0 };
+	ULONGLONG nLossWait{ 0 };
+	ULONGLONG nFixedLossWait{ 0 };
+	for (const auto& pProbe : probes)
+	{
+		nLosses += pProbe->timeout.GetLosses();
+		nLossWait += pProbe->timeout.GetLossWait();
+		nFixedLossWait += pProbe->timeout.GetFixedLossWait();
+	}
+	ReportLossWait(pNetVoyagerView, nLosses, nLossWait, nFixedLossWait);
+	if (scheduler.GetMissedDeadlines() > 0)
+	{
+		AddFormattedText(pNetVoyagerView, _T("%llu scheduled rounds were skipped because a reply took longer than the %u ms interval"), scheduler.GetMissedDeadlines(), theApp.m_dwPingInterval);
+	}
+}
 
 /**
  * @brief Thread procedure for executing ping operations
@@ -286,95 +692,64 @@ TCHAR g_lpszOutputString[0x1000] = { 0, };
 DWORD WINAPI PING_ThreadProc(LPVOID lpParam)
 {
 	bool bSuccess{ false };
-	const CPing p;
+	CPingSession session;
 	CPingReplyv4 prv4;
 	CPingReplyv6 prv6;
+	CProbeStatistics stats;
+	CAdaptiveTimeout timeout;
 	int nRequestsSent{ 0 };
 
 	CNetVoyagerView* pNetVoyagerView = reinterpret_cast<CNetVoyagerView*>(lpParam);
 	ASSERT(pNetVoyagerView != nullptr);
 
 	// Display initial ping header message
-	_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Pinging <strong>%s</strong> with %u bytes of data"), theApp.m_sHostToResolve.GetString(), theApp.m_wDataRequestSize);
-	TRACE(_T("%s\n"), g_lpszOutputString);
-	pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
+	AddFormattedText(pNetVoyagerView, _T("Pinging <strong>%s</strong> with %u bytes of data"), theApp.m_sHostToResolve.GetString(), theApp.m_wDataRequestSize);
+	if (theApp.m_bProbeAllAddresses || theApp.m_bDualStack)
+	{
+		PingAllAddresses(pNetVoyagerView);
+		return 0;
+	}
+
+	// Resolve the host, open the ICMP handle and allocate the buffers once for the whole run
+	LPCTSTR pszLocalBoundAddress{ theApp.m_sLocalBoundAddress.IsEmpty() ? nullptr : theApp.m_sLocalBoundAddress.GetString() };
+	const bool bOpened{ theApp.m_bIPv6 ? session.Openv6(theApp.m_sHostToResolve, theApp.m_wDataRequestSize, pszLocalBoundAddress) :
+										 session.Openv4(theApp.m_sHostToResolve, theApp.m_wDataRequestSize, pszLocalBoundAddress) };
+	if (!bOpened)
+	{
+		// Lookup or handle creation failed - display error message
+		const DWORD dwError{ GetLastError() };
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(dwError).GetString());
+		return 0;
+	}
+
+	// Send the requests on a fixed cadence (or back to back in flood mode) which does not drift with the replies
+	CIntervalScheduler scheduler;
+	if (!scheduler.Start(theApp.m_bFloodPing ? 0 : (static_cast<ULONGLONG>(theApp.m_dwPingInterval) * 1000ULL)))
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+		return 0;
+	}
 
 	// Main ping loop - continues until stopped by user or request count reached
-	while (g_bThreadRunning)
+	timeout.SetBounds(theApp.m_dwAdaptiveTimeoutFloor, theApp.m_dwTimeout);
+	while (g_bThreadRunning && scheduler.WaitForNextDeadline())
 	{
 		// Choose IPv4 or IPv6 ping based on configuration
+		const DWORD dwTimeout{ theApp.m_bAdaptiveTimeout ? timeout.GetTimeout() : theApp.m_dwTimeout };
 		if (theApp.m_bIPv6)
-		{
-			if (theApp.m_sLocalBoundAddress.IsEmpty())
-#pragma warning(suppress: 26486)
-				// Ping using IPv6 with default local address
-				bSuccess = p.PingUsingICMPv6(theApp.m_sHostToResolve, prv6, theApp.m_nTTL, theApp.m_dwTimeout,
-					theApp.m_wDataRequestSize, theApp.m_nTOS, theApp.m_bDontFragment);
-			else
 #pragma warning(suppress: 26486)
-				// Ping using IPv6 with specific local bound address
-				bSuccess = p.PingUsingICMPv6(theApp.m_sHostToResolve, prv6, theApp.m_nTTL, theApp.m_dwTimeout,
-					theApp.m_wDataRequestSize, theApp.m_nTOS, theApp.m_bDontFragment, false, theApp.m_sLocalBoundAddress);
-		}
+			bSuccess = session.Pingv6(prv6, theApp.m_nTTL, dwTimeout, theApp.m_nTOS, theApp.m_bDontFragment);
 		else
-		{
-			if (theApp.m_sLocalBoundAddress.IsEmpty())
-#pragma warning(suppress: 26486)
-				// Ping using IPv4 with default local address
-				bSuccess = p.PingUsingICMPv4(theApp.m_sHostToResolve, prv4, theApp.m_nTTL, theApp.m_dwTimeout,
-					theApp.m_wDataRequestSize, theApp.m_nTOS, theApp.m_bDontFragment);
-			else
 #pragma warning(suppress: 26486)
-				// Ping using IPv4 with specific local bound address
-				bSuccess = p.PingUsingICMPv4(theApp.m_sHostToResolve, prv4, theApp.m_nTTL, theApp.m_dwTimeout,
-					theApp.m_wDataRequestSize, theApp.m_nTOS, theApp.m_bDontFragment, false, theApp.m_sLocalBoundAddress);
-		}
+			bSuccess = session.Pingv4(prv4, theApp.m_nTTL, dwTimeout, theApp.m_nTOS, theApp.m_bDontFragment);
+		const DWORD dwError{ bSuccess ? ERROR_SUCCESS : GetLastError() };
+		if (bSuccess)
+			timeout.AddSample(theApp.m_bIPv6 ? prv6.RTT : prv4.RTT);
+		else if (dwError == ERROR_TIMEOUT)
+			timeout.AddLoss(dwTimeout);
 
 		++nRequestsSent;
-		if (bSuccess)
-		{
-#pragma warning(suppress: 26490)
-			// Extract reply information based on IP version
-			const SOCKADDR* pAddress{ theApp.m_bIPv6 ? reinterpret_cast<SOCKADDR*>(&prv6) : reinterpret_cast<SOCKADDR*>(&prv4) };
-			const int nAddressLen{ theApp.m_bIPv6 ? static_cast<int>(sizeof(prv6)) : static_cast<int>(sizeof(prv4)) };
-			const unsigned long& nRTT{ theApp.m_bIPv6 ? prv6.RTT : prv4.RTT };
-			const unsigned long& nEchoReplyStatus{ theApp.m_bIPv6 ? prv6.EchoReplyStatus : prv4.EchoReplyStatus };
-
-			CString sHost;
-			// Attempt to resolve IP address to hostname if enabled
-			if (theApp.m_bResolveAddressesToHostnames)
-				sHost = theApp.AddressToString(pAddress, nAddressLen, 0, nullptr);
-			if (sHost.GetLength())
-			{
-				// Format output with hostname and IP address
-				if (nEchoReplyStatus == IP_SUCCESS)
-#pragma warning(suppress: 26472)
-					_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Reply from %s [%s], bytes=%d, time=%s TTL=%d"), theApp.AddressToString(pAddress, nAddressLen, NI_NUMERICHOST, nullptr).GetString(), sHost.GetString(), static_cast<int>(theApp.m_wDataRequestSize), theApp.RTTAsString(nRTT).GetString(), static_cast<int>(theApp.m_nTTL));
-				else
-					_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Reply from %s [%s]: %s"), theApp.AddressToString(pAddress, nAddressLen, NI_NUMERICHOST, nullptr).GetString(), sHost.GetString(), theApp.GetIpErrorString(nEchoReplyStatus).GetString());
-				TRACE(_T("%s\n"), g_lpszOutputString);
-				pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-			}
-			else
-			{
-				// Format output with IP address only
-				if (nEchoReplyStatus == IP_SUCCESS)
-#pragma warning(suppress: 26472)
-					_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Reply from %s, bytes=%d, time=%s TTL=%d"), theApp.AddressToString(pAddress, nAddressLen, NI_NUMERICHOST, nullptr).GetString(), static_cast<int>(theApp.m_wDataRequestSize), theApp.RTTAsString(nRTT).GetString(), static_cast<int>(theApp.m_nTTL));
-				else
-					_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Reply from %s: %s"), theApp.AddressToString(pAddress, nAddressLen, NI_NUMERICHOST, nullptr).GetString(), theApp.GetIpErrorString(nEchoReplyStatus).GetString());
-				TRACE(_T("%s\n"), g_lpszOutputString);
-				pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-			}
-		}
-		else
-		{
-			// Ping failed - display error message
-			const DWORD dwError{ GetLastError() };
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("%s"), theApp.GetErrorMessage(dwError).GetString());
-			TRACE(_T("%s\n"), g_lpszOutputString);
-			pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-		}
+		AddPingResult(pNetVoyagerView, theApp.m_bIPv6 ? AF_INET6 : AF_INET, bSuccess, dwError, prv4, prv6, nullptr, stats);
 
 		// Check if we should stop pinging
 		if (!theApp.m_bPingTillStopped)
@@ -382,18 +757,65 @@ DWORD WINAPI PING_ThreadProc(LPVOID lpParam)
 			if (nRequestsSent == theApp.m_nRequestsToSend)
 				break;
 		}
+		else if ((theApp.m_nStatisticsInterval > 0) && ((nRequestsSent % theApp.m_nStatisticsInterval) == 0))
+			ReportPingStatistics(pNetVoyagerView, stats);
+	}
+
+	// Display the summary of the run
+	ReportPingStatistics(pNetVoyagerView, stats);
+	ReportLossWait(pNetVoyagerView, timeout.GetLosses(), timeout.GetLossWait(), timeout.GetFixedLossWait());
+
+	// Report the send times which had to be skipped because a request outlasted the interval
+	if (scheduler.GetMissedDeadlines() > 0)
+	{
+		AddFormattedText(pNetVoyagerView, _T("%llu scheduled requests were skipped because a reply took longer than the %u ms interval"), scheduler.GetMissedDeadlines(), theApp.m_dwPingInterval);
 	}
 
 	return 0;
 }
 
+/**
+ * @brief Adds a traceroute hop to the results
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param nHostNum The hop number
+ * @param htmr The trace reply structure containing host information (CHostTraceMultiReplyv4 or v6)
+ */
+template <typename HostTraceMultiReply>
+void AddHopResult(CNetVoyagerView* pNetVoyagerView, int nHostNum, const HostTraceMultiReply& htmr)
+{
+	// Hand over the hop as a record; it is only turned into text when it is rendered
+	CProbeResult result{};
+	result.nTimestamp = CPingClock::NowMicroseconds();
+	result.nHop = static_cast<BYTE>(nHostNum);
+	result.nTTL = static_cast<BYTE>(nHostNum);
+	if (htmr.dwError == 0)
+	{
+		result.nType = CProbeResultType::HopReply;
+		result.nRTT = htmr.minRTT;
+		result.nAvgRTT = htmr.avgRTT;
+		result.nMaxRTT = htmr.maxRTT;
+#pragma warning(suppress: 26490)
+		result.SetAddress(reinterpret_cast<const SOCKADDR*>(&htmr.Address));
+	}
+	else
+	{
+		// Error or timeout for this hop
+		result.nType = CProbeResultType::HopError;
+		result.nStatus = htmr.dwError;
+		result.nFamily = AF_UNSPEC;
+	}
+	pNetVoyagerView->AddProbeResult(result, "", 0);
+}
+
 /**
  * @brief Class derived to implement Trace Route with custom result handling
  */
-class CMyTraceRoute : public CTraceRoute
+class CMyTraceRoute : public CParisTraceRoute
 {
 	bool OnSingleHostResult(int nHostNum, const CHostTraceMultiReplyv4& htmr) override;
 	bool OnSingleHostResult(int nHostNum, const CHostTraceMultiReplyv6& htmr) override;
+	std::unique_ptr<CPingBackend> CreateBackend() override;
+	void OnHopEnumerated(UCHAR nTTL, const CMultipathResult& result) override;
 public:
 	CNetVoyagerView* m_pNetVoyagerView{ nullptr };
 };
@@ -406,44 +828,7 @@ public:
  */
 bool CMyTraceRoute::OnSingleHostResult(int nHostNum, const CHostTraceMultiReplyv4& htmr)
 {
-	if (htmr.dwError == 0)
-	{
-		CString sHost;
-		// Attempt to resolve IP address to hostname if enabled
-		if (theApp.m_bResolveAddressesToHostnames)
-#pragma warning(suppress: 26490)
-			sHost = theApp.AddressToString(reinterpret_cast<const SOCKADDR*>(&htmr.Address), sizeof(htmr.Address), NI_NAMEREQD, nullptr);
-#pragma warning(suppress: 26490)
-		// Get numeric IP address string
-		CString sIPAddress{ theApp.AddressToString(reinterpret_cast<const SOCKADDR*>(&htmr.Address), sizeof(htmr.Address), NI_NUMERICHOST, nullptr) };
-
-		if (sHost.GetLength())
-		{
-			// Display hop with hostname and IP address
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t%s\t%s\t%s\t%s [%s]"), nHostNum, theApp.RTTAsString(htmr.minRTT).GetString(), theApp.RTTAsString(htmr.avgRTT).GetString(),
-				theApp.RTTAsString(htmr.maxRTT).GetString(), sHost.GetString(), sIPAddress.GetString());
-			TRACE(_T("%s\n"), g_lpszOutputString);
-			m_pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-		}
-		else
-		{
-			// Display hop with IP address only
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t%s\t%s\t%s\t%s"), nHostNum, theApp.RTTAsString(htmr.minRTT).GetString(), theApp.RTTAsString(htmr.avgRTT).GetString(),
-				theApp.RTTAsString(htmr.maxRTT).GetString(), sIPAddress.GetString());
-			TRACE(_T("%s\n"), g_lpszOutputString);
-			m_pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-		}
-	}
-	else
-	{
-		// Display error or timeout for this hop
-		if (htmr.dwError == ERROR_TIMEOUT)
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t*\t*\t*\tRequest timed out."), nHostNum);
-		else
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t*\t*\t*\tError:%s"), nHostNum, theApp.GetErrorMessage(htmr.dwError).GetString());
-		TRACE(_T("%s\n"), g_lpszOutputString);
-		m_pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-	}
+	AddHopResult(m_pNetVoyagerView, nHostNum, htmr);
 	// Return true to continue tracing
 	return true;
 }
@@ -456,88 +841,804 @@ bool CMyTraceRoute::OnSingleHostResult(int nHostNum, const CHostTraceMultiReplyv
  */
 bool CMyTraceRoute::OnSingleHostResult(int nHostNum, const CHostTraceMultiReplyv6& htmr)
 {
-	if (htmr.dwError == 0)
+	AddHopResult(m_pNetVoyagerView, nHostNum, htmr);
+	// Return true to continue tracing
+	return true;
+}
+
+/**
+ * @brief Creates the backend of the probes
+ * @return The backend of the simulated network when it is being traced, otherwise the default one
+ */
+std::unique_ptr<CPingBackend> CMyTraceRoute::CreateBackend()
+{
+	if (theApp.m_bSimulateEcmp)
+		return std::make_unique<CSimulatedEcmpBackend>();
+	return CParisTraceRoute::CreateBackend();
+}
+
+/**
+ * @brief Displays the interfaces a multipath trace found at a TTL
+ * @param nTTL The TTL
+ * @param result The interfaces and links found so far
+ * @details Every interface gets a line with the interfaces of the TTL before from which flows reached it.
+ */
+void CMyTraceRoute::OnHopEnumerated(UCHAR nTTL, const CMultipathResult& result)
+{
+	if (!g_bThreadRunning)
+		Cancel();
+
+	bool bAnswered{ false };
+	for (size_t i{ 0 }; i < result.arrInterfaces.size(); i++)
 	{
-		CString sHost;
-		// Attempt to resolve IP address to hostname if enabled
-		if (theApp.m_bResolveAddressesToHostnames)
-#pragma warning(suppress: 26490)
-			sHost = theApp.AddressToString(reinterpret_cast<const SOCKADDR*>(&htmr.Address), sizeof(htmr.Address), NI_NAMEREQD, nullptr);
+		const CMultipathInterface& iface{ result.arrInterfaces[i] };
+		if (iface.nTTL != nTTL)
+			continue;
+		bAnswered = true;
+		TCHAR szAddress[CIpAddressText::MAX_LENGTH]{};
 #pragma warning(suppress: 26490)
-		// Get numeric IPv6 address string
-		CString sIPAddress{ theApp.AddressToString(reinterpret_cast<const SOCKADDR*>(&htmr.Address), sizeof(htmr.Address), NI_NUMERICHOST, nullptr) };
-
-		if (sHost.GetLength())
-		{
-			// Display hop with hostname and IPv6 address
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t%s\t%s\t%s\t%s [%s]"), nHostNum, theApp.RTTAsString(htmr.minRTT).GetString(), theApp.RTTAsString(htmr.avgRTT).GetString(),
-				theApp.RTTAsString(htmr.maxRTT).GetString(), sHost.GetString(), sIPAddress.GetString());
-			TRACE(_T("%s\n"), g_lpszOutputString);
-			m_pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-		}
-		else
+		CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&iface.Address), static_cast<int>(sizeof(iface.Address)), szAddress, _countof(szAddress));
+		CString sLine;
+		sLine.Format(_T("Hop %u: %s  %s / %s / %s  %lu flows"), static_cast<UINT>(nTTL), szAddress, theApp.RTTAsString(iface.minRTT).GetString(),
+			theApp.RTTAsString(iface.avgRTT).GetString(), theApp.RTTAsString(iface.maxRTT).GetString(), iface.nFlows);
+		CString sFrom;
+		for (const auto& link : result.arrLinks)
 		{
-			// Display hop with IPv6 address only
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t%s\t%s\t%s\t%s"), nHostNum, theApp.RTTAsString(htmr.minRTT).GetString(), theApp.RTTAsString(htmr.avgRTT).GetString(),
-				theApp.RTTAsString(htmr.maxRTT).GetString(), sIPAddress.GetString());
-			TRACE(_T("%s\n"), g_lpszOutputString);
-			m_pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
+			if (link.nTo != i)
+				continue;
+#pragma warning(suppress: 26490)
+			CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&result.arrInterfaces[link.nFrom].Address), static_cast<int>(sizeof(SOCKADDR_STORAGE)), szAddress, _countof(szAddress));
+			sFrom.AppendFormat(sFrom.IsEmpty() ? _T("%s") : _T(", %s"), szAddress);
 		}
+		if (!sFrom.IsEmpty())
+			sLine.AppendFormat(_T(", from %s"), sFrom.GetString());
+		if (iface.bDestination)
+			sLine.Append(_T(" (destination)"));
+		m_pNetVoyagerView->AddDocumentText(sLine);
 	}
-	else
-	{
-		// Display error or timeout for this hop
-		if (htmr.dwError == ERROR_TIMEOUT)
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t*\t*\t*\tRequest timed out."), nHostNum);
-		else
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("  %d\t*\t*\t*\tError:%s"), nHostNum, theApp.GetErrorMessage(htmr.dwError).GetString());
-		TRACE(_T("%s\n"), g_lpszOutputString);
-		m_pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
-	}
-	// Return true to continue tracing
-	return true;
+	if (!bAnswered)
+		AddFormattedText(m_pNetVoyagerView, _T("Hop %u: *"), static_cast<UINT>(nTTL));
 }
 
 /**
- * @brief Thread procedure for executing traceroute operations
- * @param lpParam Pointer to CNetVoyagerView instance
- * @return Thread exit code (always 0)
+ * @brief Applies the traceroute options of the application to a trace
+ * @param tr The trace
  */
-DWORD WINAPI TRACE_ThreadProc(LPVOID lpParam)
+void ApplyTraceOptions(CTraceRoute& tr) noexcept
 {
-	CNetVoyagerView* pNetVoyagerView = reinterpret_cast<CNetVoyagerView*>(lpParam);
+	tr.SetConcurrentProbing(theApp.m_bConcurrentTraceRoute);
+	tr.SetGapLimit(theApp.m_nTraceGapLimit);
+	tr.SetStopOnUnreachable(theApp.m_bTraceStopOnUnreachable);
+	tr.SetAdaptiveTimeout(theApp.m_bAdaptiveTimeout, theApp.m_dwAdaptiveTimeoutFloor);
+}
+
+/**
+ * @brief Displays how long a trace spent waiting for lost probes
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param tr The trace which completed
+ */
+void ReportTraceLossWait(CNetVoyagerView* pNetVoyagerView, const CTraceRoute& tr)
+{
+	ULONGLONG nLosses{ 0 };
+	ULONGLONG nLossWait{ 0 };
+	ULONGLONG nFixedLossWait{ 0 };
+	for (const auto& hopTimeout : tr.GetHopTimeouts())
+	{
+		nLosses += hopTimeout.GetLosses();
+		nLossWait += hopTimeout.GetLossWait();
+		nFixedLossWait += hopTimeout.GetFixedLossWait();
+	}
+	ReportLossWait(pNetVoyagerView, nLosses, nLossWait, nFixedLossWait);
+}
+
+/**
+ * @brief Describes which termination policy ended a trace
+ * @param tr The trace which completed
+ * @param trr The hops of the path; the last one is where the trace stopped
+ * @return The message line
+ */
+template <typename Reply>
+CString TraceCompletionAsString(const CTraceRoute& tr, const Reply& trr)
+{
+	CString sLine;
+	switch (tr.GetStopReason())
+	{
+		case CTraceRoute::StopReason::DestinationReached:
+			sLine.Format(_T("Trace complete: destination reached in %zu hops."), trr.size());
+			break;
+		case CTraceRoute::StopReason::Unreachable:
+		{
+			// Name the hop which reported the destination as unreachable, and what exactly it said
+			const auto& htmr{ trr.back() };
+			const ULONG nStatus{ CTraceRoute::IsUnreachableStatus(htmr.nStatus) ? htmr.nStatus : htmr.dwError };
+			TCHAR szAddress[CIpAddressText::MAX_LENGTH]{};
+#pragma warning(suppress: 26490)
+			CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&htmr.Address), static_cast<int>(sizeof(htmr.Address)), szAddress, _countof(szAddress));
+			sLine.Format(_T("Trace stopped at hop %zu: %s reported %s"), trr.size(), (szAddress[0] != _T('\0')) ? szAddress : _T("a router"),
+				theApp.GetIpErrorString(static_cast<IP_STATUS>(nStatus)).GetString());
+			break;
+		}
+		case CTraceRoute::StopReason::GapLimit:
+			sLine.Format(_T("Trace stopped at hop %zu: gap limit of %d consecutive silent hops reached."), trr.size(), static_cast<int>(tr.GetGapLimit()));
+			break;
+		case CTraceRoute::StopReason::Cancelled:
+			sLine.Format(_T("Trace cancelled at hop %zu."), trr.size());
+			break;
+		default:
+			sLine.Format(_T("Trace complete: destination not reached within %zu hops."), trr.size());
+			break;
+	}
+	return sLine;
+}
+
+/**
+ * @brief Adds the hops of a path which was traced without callbacks to the results
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param pszFamily "IPv4" or "IPv6"
+ * @param tr The trace which traced the path
+ * @param trr The hops of the path
+ * @param nError 0 if the path was traced, otherwise the error
+ */
+template <typename Reply>
+void AddTracedPath(CNetVoyagerView* pNetVoyagerView, LPCTSTR pszFamily, const CTraceRoute& tr, const Reply& trr, DWORD nError)
+{
+	AddFormattedText(pNetVoyagerView, _T("<strong>%s</strong> route:"), pszFamily);
+	for (size_t i{ 0 }; i < trr.size(); i++)
+		AddHopResult(pNetVoyagerView, static_cast<int>(i + 1), trr[i]);
+	if (nError != 0)
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(nError).GetString());
+	else
+		pNetVoyagerView->AddDocumentText(TraceCompletionAsString(tr, trr));
+	ReportTraceLossWait(pNetVoyagerView, tr);
+}
+
+/**
+ * @brief Reports the size of the merged topology and writes it to the topology file, if there is one
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ */
+void ReportTopology(CNetVoyagerView* pNetVoyagerView)
+{
+	const CTopologyGraph& topology{ pNetVoyagerView->GetTopology() };
+	AddFormattedText(pNetVoyagerView, _T("Topology: %zu addresses, %zu links and %zu destinations from %llu traces (%zu KB)"), topology.GetNodes().size() - 1,
+		topology.GetLinks().size(), topology.GetDestinations().size(), topology.GetTraceCount(), (topology.GetMemoryUsage() + 1023) / 1024);
+	if (theApp.m_sTopologyFile.IsEmpty())
+		return;
+
+	std::ofstream file{ theApp.m_sTopologyFile.GetString(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary };
+	if (theApp.m_sTopologyFile.Right(8).CompareNoCase(_T(".graphml")) == 0)
+		topology.ExportGraphML(file);
+	else
+		topology.ExportDOT(file);
+	file.close();
+	if (file.fail())
+		AddFormattedText(pNetVoyagerView, _T("The topology could not be written to %s"), theApp.m_sTopologyFile.GetString());
+}
+
+/**
+ * @brief Counts the hops of a path which did not answer
+ * @param trr The hops of the path
+ * @return The number of silent hops
+ */
+template <typename Reply>
+size_t CountSilentHops(const Reply& trr) noexcept
+{
+	return static_cast<size_t>(std::count_if(trr.begin(), trr.end(), [](const auto& htmr) noexcept { return htmr.dwError != 0; }));
+}
+
+/**
+ * @brief Traces the route to the host over IPv4 and IPv6 at the same time and compares the two paths
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @details Both traces run over the same time window, so the comparison is not skewed by the time of day and
+ * the run takes as long as the longer of the two paths. The paths are shown one after the other once both are
+ * complete, followed by a hop by hop comparison and the difference in path length and round trip time.
+ */
+void TraceDualStack(CNetVoyagerView* pNetVoyagerView)
+{
+	// Resolve both addresses and the local addresses up front
+	SOCKADDR_IN destAddressv4{};
+	SOCKADDR_IN6 destAddressv6{};
+	SOCKADDR_STORAGE localAddressv4{};
+	SOCKADDR_STORAGE localAddressv6{};
+	bool bBindv4{ false };
+	bool bBindv6{ false };
+#pragma warning(suppress: 26490)
+	DWORD nErrorv4{ static_cast<DWORD>(CPingSession::ResolveAddress(theApp.m_sHostToResolve, 0, AF_INET, reinterpret_cast<SOCKADDR*>(&destAddressv4), sizeof(destAddressv4))) };
+	if (nErrorv4 == 0)
+		nErrorv4 = static_cast<DWORD>(ResolveLocalAddress(AF_INET, true, localAddressv4, bBindv4));
+#pragma warning(suppress: 26490)
+	DWORD nErrorv6{ static_cast<DWORD>(CPingSession::ResolveAddress(theApp.m_sHostToResolve, 0, AF_INET6, reinterpret_cast<SOCKADDR*>(&destAddressv6), sizeof(destAddressv6))) };
+	if (nErrorv6 == 0)
+		nErrorv6 = static_cast<DWORD>(ResolveLocalAddress(AF_INET6, true, localAddressv6, bBindv6));
+	const bool bTracev4{ nErrorv4 == 0 };
+	const bool bTracev6{ nErrorv6 == 0 };
+
+	// Trace the IPv4 path on a second thread while this one traces the IPv6 path
+	CTraceRoute trv4;
+	CTraceRoute trv6;
+	ApplyTraceOptions(trv4);
+	ApplyTraceOptions(trv6);
+	CTraceRoute::CReplyv4 trrv4;
+	CTraceRoute::CReplyv6 trrv6;
+	std::future<void> tracev4;
+	if (bTracev4)
+	{
+		tracev4 = std::async(std::launch::async, [&]()
+		{
+#pragma warning(suppress: 26490)
+			if (!trv4.Tracev4(destAddressv4, trrv4, theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, false, false, bBindv4 ? reinterpret_cast<const SOCKADDR_IN*>(&localAddressv4) : nullptr))
+				nErrorv4 = GetLastError();
+		});
+	}
+#pragma warning(suppress: 26490)
+	if (bTracev6 && !trv6.Tracev6(destAddressv6, trrv6, theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, false, false, bBindv6 ? reinterpret_cast<const SOCKADDR_IN6*>(&localAddressv6) : nullptr))
+		nErrorv6 = GetLastError();
+	if (bTracev4)
+		tracev4.wait();
+
+	// Display the two paths and merge them into the topology
+	AddTracedPath(pNetVoyagerView, _T("IPv4"), trv4, trrv4, nErrorv4);
+	AddTracedPath(pNetVoyagerView, _T("IPv6"), trv6, trrv6, nErrorv6);
+	if (nErrorv4 == 0)
+		pNetVoyagerView->GetTopology().AddTrace(destAddressv4, trrv4);
+	if (nErrorv6 == 0)
+		pNetVoyagerView->GetTopology().AddTrace(destAddressv6, trrv6);
+	if ((nErrorv4 == 0) || (nErrorv6 == 0))
+		ReportTopology(pNetVoyagerView);
+	if (!bTracev4 || !bTracev6)
+		return;
+
+	// Compare them hop by hop
+	AddFormattedText(pNetVoyagerView, _T("<strong>IPv4 and IPv6</strong> side by side:"));
+	const size_t nHops{ (std::max)(trrv4.size(), trrv6.size()) };
+	for (size_t i{ 0 }; i < nHops; i++)
+	{
+		CString sLine;
+		sLine.Format(_T("&nbsp;&nbsp;%zu: "), i + 1);
+		const bool bHopv4{ (i < trrv4.size()) && (trrv4[i].dwError == 0) };
+		const bool bHopv6{ (i < trrv6.size()) && (trrv6[i].dwError == 0) };
+		TCHAR szAddress[CIpAddressText::MAX_LENGTH]{};
+		if (bHopv4)
+		{
+			CIpAddressText::Format(AF_INET, &trrv4[i].Address.sin_addr, szAddress, _countof(szAddress));
+			sLine.AppendFormat(_T("IPv4 %s avg %s"), szAddress, theApp.RTTAsString(trrv4[i].avgRTT).GetString());
+		}
+		else
+			sLine.Append((i < trrv4.size()) ? _T("IPv4 *") : _T("IPv4 -"));
+		if (bHopv6)
+		{
+			CIpAddressText::Format(AF_INET6, &trrv6[i].Address.sin6_addr, szAddress, _countof(szAddress));
+			sLine.AppendFormat(_T(", IPv6 %s avg %s"), szAddress, theApp.RTTAsString(trrv6[i].avgRTT).GetString());
+		}
+		else
+			sLine.Append((i < trrv6.size()) ? _T(", IPv6 *") : _T(", IPv6 -"));
+		if (bHopv4 && bHopv6)
+			sLine.AppendFormat(_T(" (%s)"), RTTDeltaAsString(static_cast<double>(trrv6[i].avgRTT) - static_cast<double>(trrv4[i].avgRTT)).GetString());
+		pNetVoyagerView->AddDocumentText(sLine);
+	}
+
+	// Path length, silent hops and the round trip time to the destination
+	CString sLine;
+	sLine.Format(_T("IPv4 path: %zu hops, %zu silent; IPv6 path: %zu hops, %zu silent"), trrv4.size(), CountSilentHops(trrv4), trrv6.size(), CountSilentHops(trrv6));
+	if (!trrv4.empty() && !trrv6.empty() && (trrv4.back().dwError == 0) && (trrv6.back().dwError == 0))
+		sLine.AppendFormat(_T("; IPv6 compared to IPv4: %+d hops, %s to the destination"), static_cast<int>(trrv6.size()) - static_cast<int>(trrv4.size()),
+			RTTDeltaAsString(static_cast<double>(trrv6.back().avgRTT) - static_cast<double>(trrv4.back().avgRTT)).GetString());
+	pNetVoyagerView->AddDocumentText(sLine);
+}
+
+/**
+ * @brief Class derived to implement the continuous traceroute with custom snapshot handling
+ */
+class CMyContinuousTraceRoute : public CContinuousTraceRoute
+{
+	bool OnSnapshot(ULONGLONG nCycle) override;
+public:
+	CNetVoyagerView* m_pNetVoyagerView{ nullptr };
+};
+
+/**
+ * @brief Adds the statistics of every hop of the path, as they stand after a number of cycles, to the results
+ * @param nCycle The number of cycles completed
+ * @return true to keep cycling, false once the user has stopped the operation
+ */
+bool CMyContinuousTraceRoute::OnSnapshot(ULONGLONG nCycle)
+{
+	AddFormattedText(m_pNetVoyagerView, _T("<strong>After %llu cycles:</strong>"), nCycle);
+	const size_t nPathLength{ GetPathLength() };
+	for (size_t i{ 0 }; i < nPathLength; i++)
+	{
+		const CTraceHopStatistics& hop{ m_Hops[i] };
+		CString sLine;
+		sLine.Format(_T("&nbsp;&nbsp;%zu: "), i + 1);
+		if (!hop.HasAnswered())
+		{
+			sLine.AppendFormat(_T("* Sent = %llu, Loss = 100.0%%"), hop.Stats.GetSent());
+			m_pNetVoyagerView->AddDocumentText(sLine);
+			continue;
+		}
+		TCHAR szAddress[CIpAddressText::MAX_LENGTH]{};
+#pragma warning(suppress: 26490)
+		CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&hop.Address), static_cast<int>(sizeof(hop.Address)), szAddress, _countof(szAddress));
+		sLine.AppendFormat(_T("%s Sent = %llu, Loss = %.1f%% (last %zu: %.1f%%)"), szAddress, hop.Stats.GetSent(), hop.Stats.GetLossRatio() * 100.0,
+			hop.nWindowCount, hop.GetRollingLoss() * 100.0);
+		if (hop.Stats.GetReceived() > 0)
+		{
+			sLine.AppendFormat(_T(", last = %s, avg = %s, best = %s, worst = %s, stddev = %s, p50 = %s, p99 = %s"),
+				(hop.nLastStatus == IP_REQ_TIMED_OUT) ? _T("*") : theApp.RTTAsString(hop.nLastRTT).GetString(),
+				theApp.RTTAsString(static_cast<ULONGLONG>(hop.Stats.GetMean() + 0.5)).GetString(), theApp.RTTAsString(hop.Stats.GetMin()).GetString(),
+				theApp.RTTAsString(hop.Stats.GetMax()).GetString(), theApp.RTTAsString(static_cast<ULONGLONG>(hop.Stats.GetStdDev() + 0.5)).GetString(),
+				theApp.RTTAsString(hop.Stats.GetPercentile(50.0)).GetString(), theApp.RTTAsString(hop.Stats.GetPercentile(99.0)).GetString());
+		}
+		if (hop.nAddressChanges > 0)
+			sLine.AppendFormat(_T(", %lu address changes"), hop.nAddressChanges);
+		m_pNetVoyagerView->AddDocumentText(sLine);
+	}
+	return g_bThreadRunning;
+}
+
+/**
+ * @brief Traces the route to the host MTR style, cycling through the path until stopped
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @details Every cycle probes all hops at the same time; the per hop statistics are reported every
+ * m_nTraceSnapshotInterval cycles and once more when the trace stops.
+ */
+void ContinuousTrace(CNetVoyagerView* pNetVoyagerView)
+{
+	SOCKADDR_STORAGE destAddress{};
+#pragma warning(suppress: 26490)
+	const int nError{ CPingSession::ResolveAddress(theApp.m_sHostToResolve, 0, theApp.m_bIPv6 ? AF_INET6 : AF_INET, reinterpret_cast<SOCKADDR*>(&destAddress), sizeof(destAddress)) };
+	if (nError != 0)
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(static_cast<DWORD>(nError)).GetString());
+		return;
+	}
+
+	CMyContinuousTraceRoute tr;
+	tr.m_pNetVoyagerView = pNetVoyagerView;
+	tr.SetHopCount(theApp.m_nHopCount);
+	tr.SetTimeout(theApp.m_dwTimeout);
+	tr.SetCycleInterval(theApp.m_dwTraceCycleInterval);
+	tr.SetSnapshotInterval(theApp.m_nTraceSnapshotInterval);
+	tr.SetMaxCycles(theApp.m_nTraceCycles);
+	CStopRegistration stop{ [&tr]() { tr.Cancel(); } };
+	if (!g_bThreadRunning)
+		return;
+	if (tr.Run(destAddress))
+		AddFormattedText(pNetVoyagerView, _T("Trace stopped after %llu cycles."), tr.GetCycles());
+	else
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+}
+
+/**
+ * @brief Class derived to implement the route monitor with custom route change handling
+ */
+class CMyIncrementalTraceRoute : public CIncrementalTraceRoute
+{
+	void OnRouteChange(const CRouteChange& change) override;
+public:
+	CNetVoyagerView* m_pNetVoyagerView{ nullptr };
+};
+
+/**
+ * @brief Displays a route change
+ * @param change The first hop which differs and the length of the path before and now
+ */
+void CMyIncrementalTraceRoute::OnRouteChange(const CRouteChange& change)
+{
+	TCHAR szOldAddress[CIpAddressText::MAX_LENGTH]{};
+	TCHAR szNewAddress[CIpAddressText::MAX_LENGTH]{};
+#pragma warning(suppress: 26490)
+	CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&change.OldAddress), static_cast<int>(sizeof(change.OldAddress)), szOldAddress, _countof(szOldAddress));
+#pragma warning(suppress: 26490)
+	CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&change.NewAddress), static_cast<int>(sizeof(change.NewAddress)), szNewAddress, _countof(szNewAddress));
+	AddFormattedText(m_pNetVoyagerView, _T("<strong>Route change</strong> from hop %u: %s is now %s; the path had %zu hops and now has %zu"), change.nFirstChangedHop,
+		(szOldAddress[0] != _T('\0')) ? szOldAddress : _T("*"), (szNewAddress[0] != _T('\0')) ? szNewAddress : _T("*"), change.nOldHops, change.nNewHops);
+}
+
+/**
+ * @brief Traces the route to the host again and again, only re-probing the hops which changed
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @param pszFamily "IPv4" or "IPv6"
+ * @param destAddress The destination
+ * @param pLocalAddress The address to send the requests from, nullptr for any
+ * @details The path is shown in full the first time and whenever it changes; a check which confirms it only
+ * gets a line with the requests it took.
+ */
+template <typename Address, typename Reply>
+void MonitorRoute(CNetVoyagerView* pNetVoyagerView, LPCTSTR pszFamily, const Address& destAddress, const Address* pLocalAddress)
+{
+	CMyIncrementalTraceRoute tr;
+	tr.m_pNetVoyagerView = pNetVoyagerView;
+	ApplyTraceOptions(tr);
+	CIntervalScheduler scheduler;
+	if (!scheduler.Start(static_cast<ULONGLONG>(theApp.m_dwRouteCheckInterval) * 1000ULL))
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+		return;
+	}
+
+	CStopRegistration stop{ [&tr, &scheduler]() { tr.Cancel(); scheduler.Cancel(); } };
+
+	Reply trr;
+	DWORD nChecks{ 0 };
+	while (g_bThreadRunning && ((theApp.m_nRouteChecks == 0) || (nChecks < theApp.m_nRouteChecks)) && scheduler.WaitForNextDeadline())
+	{
+		const CRetraceSummary before{ tr.GetSummary() };
+		if (!tr.Retrace(destAddress, trr, theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, pLocalAddress))
+		{
+			if (g_bThreadRunning)
+				AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+			break;
+		}
+		++nChecks;
+		const CRetraceSummary& after{ tr.GetSummary() };
+		if ((nChecks == 1) || (after.nRouteChanges != before.nRouteChanges))
+		{
+			AddTracedPath(pNetVoyagerView, pszFamily, tr, trr, 0);
+			pNetVoyagerView->GetTopology().AddTrace(destAddress, trr);
+			ReportTopology(pNetVoyagerView);
+			continue;
+		}
+		const LPCTSTR pszHow{ (tr.GetLastKind() == RetraceKind::Verified) ? _T("verified") : ((tr.GetLastKind() == RetraceKind::Partial) ? _T("partly probed again") : _T("traced again")) };
+		AddFormattedText(pNetVoyagerView, _T("Check %lu: path of %zu hops unchanged, %s with %llu requests"), nChecks, trr.size(), pszHow, after.nProbesSent - before.nProbesSent);
+	}
+
+	const CRetraceSummary& summary{ tr.GetSummary() };
+	AddFormattedText(pNetVoyagerView, _T("%llu checks: %llu verified, %llu partly probed again, %llu traced in full; %llu route changes; %llu requests sent, full traces would have sent %llu"),
+		summary.nRetraces, summary.nVerified, summary.nPartial, summary.nFull, summary.nRouteChanges, summary.nProbesSent, summary.nSweepProbes);
+}
+
+/**
+ * @brief Resolves the host and monitors the route to it
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ */
+void MonitorRoute(CNetVoyagerView* pNetVoyagerView)
+{
+	const int nFamily{ theApp.m_bIPv6 ? AF_INET6 : AF_INET };
+	SOCKADDR_STORAGE destAddress{};
+	SOCKADDR_STORAGE localAddress{};
+	bool bBind{ false };
+#pragma warning(suppress: 26490)
+	int nError{ CPingSession::ResolveAddress(theApp.m_sHostToResolve, 0, nFamily, reinterpret_cast<SOCKADDR*>(&destAddress), sizeof(destAddress)) };
+	if (nError == 0)
+		nError = ResolveLocalAddress(nFamily, false, localAddress, bBind);
+	if (nError != 0)
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(static_cast<DWORD>(nError)).GetString());
+		return;
+	}
+	AddFormattedText(pNetVoyagerView, _T("Checking the route every %lu ms, probing only the hops needed to confirm it"), theApp.m_dwRouteCheckInterval);
+	if (nFamily == AF_INET6)
+#pragma warning(suppress: 26490)
+		MonitorRoute<SOCKADDR_IN6, CTraceRoute::CReplyv6>(pNetVoyagerView, _T("IPv6"), *reinterpret_cast<const SOCKADDR_IN6*>(&destAddress), bBind ? reinterpret_cast<const SOCKADDR_IN6*>(&localAddress) : nullptr);
+	else
+#pragma warning(suppress: 26490)
+		MonitorRoute<SOCKADDR_IN, CTraceRoute::CReplyv4>(pNetVoyagerView, _T("IPv4"), *reinterpret_cast<const SOCKADDR_IN*>(&destAddress), bBind ? reinterpret_cast<const SOCKADDR_IN*>(&localAddress) : nullptr);
+}
+
+/**
+ * @brief Resolves the destination of a trace
+ * @param nFamily AF_INET or AF_INET6
+ * @param destAddress Receives the destination: the one of the simulated network when it is being traced, otherwise the host
+ * @return 0 or the resolver error
+ */
+int ResolveTraceDestination(int nFamily, SOCKADDR_STORAGE& destAddress)
+{
+	if (theApp.m_bSimulateEcmp)
+	{
+		const CSimulatedEcmpBackend network;
+		const CSimulatedRouter& destination{ network.GetRouters()[network.GetDestination()] };
+		if (nFamily == AF_INET6)
+			memcpy(&destAddress, &destination.Addressv6, sizeof(destination.Addressv6));
+		else
+			memcpy(&destAddress, &destination.Addressv4, sizeof(destination.Addressv4));
+		return 0;
+	}
+#pragma warning(suppress: 26490)
+	return CPingSession::ResolveAddress(theApp.m_sHostToResolve, 0, nFamily, reinterpret_cast<SOCKADDR*>(&destAddress), sizeof(destAddress));
+}
+
+/**
+ * @brief Enumerates every path through the load balancers on the route to the host
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ * @details Each hop is shown as soon as its interfaces are known, followed by a summary of the paths found.
+ */
+void MultipathTrace(CNetVoyagerView* pNetVoyagerView)
+{
+	const int nFamily{ theApp.m_bIPv6 ? AF_INET6 : AF_INET };
+	SOCKADDR_STORAGE destAddress{};
+	SOCKADDR_STORAGE localAddress{};
+	bool bBind{ false };
+	int nError{ ResolveTraceDestination(nFamily, destAddress) };
+	if (nError == 0)
+		nError = ResolveLocalAddress(nFamily, false, localAddress, bBind);
+	if (nError != 0)
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(static_cast<DWORD>(nError)).GetString());
+		return;
+	}
+	AddFormattedText(pNetVoyagerView, _T("Enumerating the load balanced paths, finding every next hop of an interface with %lu%% confidence"), theApp.m_nMultipathConfidence);
+
+	CMyTraceRoute tr;
+	tr.m_pNetVoyagerView = pNetVoyagerView;
+	ApplyTraceOptions(tr);
+	CMultipathResult result;
+	const double fConfidence{ static_cast<double>(theApp.m_nMultipathConfidence) / 100.0 };
+#pragma warning(suppress: 26490)
+	const bool bEnumerated{ (nFamily == AF_INET6) ?
+		tr.EnumeratePaths(*reinterpret_cast<const SOCKADDR_IN6*>(&destAddress), result, theApp.m_nHopCount, theApp.m_dwTimeout, fConfidence, 32, 0, bBind ? reinterpret_cast<const SOCKADDR_IN6*>(&localAddress) : nullptr) :
+		tr.EnumeratePaths(*reinterpret_cast<const SOCKADDR_IN*>(&destAddress), result, theApp.m_nHopCount, theApp.m_dwTimeout, fConfidence, 32, 0, bBind ? reinterpret_cast<const SOCKADDR_IN*>(&localAddress) : nullptr) };
+	if (!bEnumerated)
+	{
+		if (g_bThreadRunning)
+			AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+		return;
+	}
+	const size_t nIncomplete{ static_cast<size_t>(std::count_if(result.arrInterfaces.begin(), result.arrInterfaces.end(), [](const CMultipathInterface& iface) noexcept { return !iface.bComplete; })) };
+	AddFormattedText(pNetVoyagerView, _T("%s: %zu interfaces and %zu links over %u hops, found with %lu flows and %llu requests"),
+		result.bReached ? _T("Destination reached") : _T("Destination not reached"), result.arrInterfaces.size(), result.arrLinks.size(), static_cast<UINT>(result.nHops),
+		result.nFlows, result.nProbesSent);
+	if (nIncomplete != 0)
+		AddFormattedText(pNetVoyagerView, _T("%zu interfaces were not probed enough to find all their next hops"), nIncomplete);
+	ReportTraceLossWait(pNetVoyagerView, tr);
+}
+
+/**
+ * @brief Thread procedure for executing traceroute operations
+ * @param lpParam Pointer to CNetVoyagerView instance
+ * @return Thread exit code (always 0)
+ */
+DWORD WINAPI TRACE_ThreadProc(LPVOID lpParam)
+{
+	CNetVoyagerView* pNetVoyagerView = reinterpret_cast<CNetVoyagerView*>(lpParam);
 	ASSERT(pNetVoyagerView != nullptr);
 
 	// Display initial traceroute header message
 #pragma warning(suppress: 26472)
-	_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Tracing route to <strong>%s</strong> over a maximum of %d hops:"), theApp.m_sHostToResolve.GetString(), static_cast<int>(theApp.m_nHopCount));
-	TRACE(_T("%s\n"), g_lpszOutputString);
-	pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
+	AddFormattedText(pNetVoyagerView, _T("Tracing route to <strong>%s</strong> over a maximum of %d hops:"), theApp.m_bSimulateEcmp ? _T("the simulated load balanced network") : theApp.m_sHostToResolve.GetString(), static_cast<int>(theApp.m_nHopCount));
+	if (theApp.m_bDualStack)
+	{
+		TraceDualStack(pNetVoyagerView);
+		return 0;
+	}
+	if (theApp.m_bContinuousTraceRoute)
+	{
+		ContinuousTrace(pNetVoyagerView);
+		return 0;
+	}
+	if (theApp.m_bMonitorRoute)
+	{
+		MonitorRoute(pNetVoyagerView);
+		return 0;
+	}
+	if (theApp.m_bMultipathTraceRoute)
+	{
+		MultipathTrace(pNetVoyagerView);
+		return 0;
+	}
 
 	// Perform the actual trace route operation
+	CString sLine;
 	CTraceRoute::CReplyv4 trrv4;
 	CTraceRoute::CReplyv6 trrv6;
 	CMyTraceRoute tr;
 	tr.m_pNetVoyagerView = pNetVoyagerView;
-	if (theApp.m_bIPv6)
+	ApplyTraceOptions(tr);
+	tr.SetFlowStable(theApp.m_bFlowStableTraceRoute);
+	const int nFamily{ theApp.m_bIPv6 ? AF_INET6 : AF_INET };
+	SOCKADDR_STORAGE destAddress{};
+	SOCKADDR_STORAGE localAddress{};
+	bool bBind{ false };
+	int nError{ ResolveTraceDestination(nFamily, destAddress) };
+	if (nError == 0)
+		nError = ResolveLocalAddress(nFamily, false, localAddress, bBind);
+	if (nError != 0)
+		sLine.Format(_T("%s"), theApp.GetErrorMessage(static_cast<DWORD>(nError)).GetString());
+	else if (theApp.m_bIPv6)
 	{
 		// Execute IPv6 traceroute
-		if (tr.Tracev6(theApp.m_sHostToResolve, trrv6, theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, false, false, theApp.m_sLocalBoundAddress.GetLength() ? theApp.m_sLocalBoundAddress : nullptr))
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Trace complete."));
+#pragma warning(suppress: 26490)
+		if (tr.Tracev6(*reinterpret_cast<const SOCKADDR_IN6*>(&destAddress), trrv6, theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, false, false, bBind ? reinterpret_cast<const SOCKADDR_IN6*>(&localAddress) : nullptr))
+			sLine = TraceCompletionAsString(tr, trrv6);
 		else
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+			sLine.Format(_T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
 	}
 	else
 	{
 		// Execute IPv4 traceroute
-		if (tr.Tracev4(theApp.m_sHostToResolve, trrv4, theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, false, false, theApp.m_sLocalBoundAddress.GetLength() ? theApp.m_sLocalBoundAddress : nullptr))
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("Trace complete."));
+#pragma warning(suppress: 26490)
+		if (tr.Tracev4(*reinterpret_cast<const SOCKADDR_IN*>(&destAddress), trrv4, theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, false, false, bBind ? reinterpret_cast<const SOCKADDR_IN*>(&localAddress) : nullptr))
+			sLine = TraceCompletionAsString(tr, trrv4);
 		else
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+			sLine.Format(_T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
 	}
 	// Display completion or error message
-	TRACE(_T("%s\n"), g_lpszOutputString);
-	pNetVoyagerView->AddDocumentText(W2UTF8(g_lpszOutputString, static_cast<int>(_tcslen(g_lpszOutputString))).GetString());
+	pNetVoyagerView->AddDocumentText(sLine);
+	ReportTraceLossWait(pNetVoyagerView, tr);
+	if (theApp.m_bFlowStableTraceRoute && (!trrv4.empty() || !trrv6.empty()) && !tr.GetFlowControlled())
+		pNetVoyagerView->AddDocumentText(_T("The probes kept their identifier and data but not their checksum, which load balancers may still split them on"));
+
+	// Merge the path into the topology
+	if (!trrv4.empty() || !trrv6.empty())
+	{
+		if (theApp.m_bIPv6)
+#pragma warning(suppress: 26490)
+			pNetVoyagerView->GetTopology().AddTrace(*reinterpret_cast<const SOCKADDR_IN6*>(&destAddress), trrv6);
+		else
+#pragma warning(suppress: 26490)
+			pNetVoyagerView->GetTopology().AddTrace(*reinterpret_cast<const SOCKADDR_IN*>(&destAddress), trrv4);
+		ReportTopology(pNetVoyagerView);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Class derived to implement Bulk Ping with custom result handling
+ */
+class CMyBulkPing : public CBulkPing
+{
+	void OnTargetComplete(const CBulkPingTarget& target) override;
+public:
+	CNetVoyagerView* m_pNetVoyagerView{ nullptr };
+};
+
+/**
+ * @brief Displays the summary line of a single bulk ping target
+ * @param target The target whose requests have all completed
+ */
+void CMyBulkPing::OnTargetComplete(const CBulkPingTarget& target)
+{
+	// Targets expanded from a CIDR block have no name, so show their address instead
+	CString sName{ target.sName.c_str() };
+	if (target.nFamily != AF_UNSPEC)
+	{
+		const int nAddressLen{ (target.nFamily == AF_INET6) ? static_cast<int>(sizeof(SOCKADDR_IN6)) : static_cast<int>(sizeof(SOCKADDR_IN)) };
+#pragma warning(suppress: 26490)
+		const CString sIPAddress{ theApp.AddressToString(reinterpret_cast<const SOCKADDR*>(&target.Address), nAddressLen, NI_NUMERICHOST, nullptr) };
+		if (sName.IsEmpty())
+			sName = sIPAddress;
+		else if (sName != sIPAddress)
+			sName.AppendFormat(_T(" [%s]"), sIPAddress.GetString());
+	}
+
+	CString sLine;
+	if (target.nFamily == AF_UNSPEC)
+		sLine.Format(_T("%s: %s"), sName.GetString(), theApp.GetErrorMessage(target.dwLastError).GetString());
+	else if (target.IsAlive())
+		sLine.Format(_T("%s is alive: %u/%u replies, min/avg/max = %s/%s/%s"), sName.GetString(), target.nReceived, target.nSent,
+			theApp.RTTAsString(target.minRTT).GetString(), theApp.RTTAsString(target.GetAvgRTT()).GetString(), theApp.RTTAsString(target.maxRTT).GetString());
+	else if (target.nReceived > 0)
+		sLine.Format(_T("%s is unreachable: %s"), sName.GetString(), theApp.GetIpErrorString(target.nLastStatus).GetString());
+	else
+		sLine.Format(_T("%s is unreachable: %u requests timed out"), sName.GetString(), target.nSent);
+	m_pNetVoyagerView->AddDocumentText(sLine);
+}
+
+/**
+ * @brief Class derived to implement the batch traceroute with custom result handling
+ */
+class CMyBatchTraceRoute : public CBatchTraceRoute
+{
+	bool OnTargetComplete(size_t nTarget, const CBatchTraceTarget& target) override;
+public:
+	CNetVoyagerView* m_pNetVoyagerView{ nullptr };
+};
+
+/**
+ * @brief Displays the path to a single destination of a batch traceroute
+ * @param nTarget Index of the destination
+ * @param target The destination and its path
+ * @return true to trace the next destination, false once the user has stopped the operation
+ */
+bool CMyBatchTraceRoute::OnTargetComplete(size_t nTarget, const CBatchTraceTarget& target)
+{
+	TCHAR szAddress[CIpAddressText::MAX_LENGTH]{};
+	CIpAddressText::Format(AF_INET, &target.Address.sin_addr, szAddress, _countof(szAddress));
+	AddFormattedText(m_pNetVoyagerView, _T("%zu. Route to <strong>%s</strong>: %u hops probed from hop %u, %u hops known from earlier paths"), nTarget + 1, szAddress,
+		target.nProbedHops, target.nStartHop, target.nCopiedHops);
+	for (size_t i{ 0 }; i < target.trr.size(); i++)
+		AddHopResult(m_pNetVoyagerView, static_cast<int>(i + 1), target.trr[i]);
+	m_pNetVoyagerView->AddDocumentText(TraceCompletionAsString(*this, target.trr));
+	m_pNetVoyagerView->GetTopology().AddTrace(target.Address, target.trr);
+	return g_bThreadRunning;
+}
+
+/**
+ * @brief Traces the route to every IPv4 target of the target list, sharing the hops they have in common
+ * @param pNetVoyagerView Pointer to CNetVoyagerView instance
+ */
+void BulkTrace(CNetVoyagerView* pNetVoyagerView)
+{
+	// Load and resolve the target list; CIDR blocks are expanded just like for a bulk ping
+	CBulkPing targets;
+	if (!targets.LoadTargets(theApp.m_sBulkTargetList, AF_INET))
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+		return;
+	}
+	CMyBatchTraceRoute bt;
+	bt.m_pNetVoyagerView = pNetVoyagerView;
+	ApplyTraceOptions(bt);
+	for (const auto& target : targets.GetTargets())
+	{
+		if (target.nFamily == AF_INET)
+#pragma warning(suppress: 26490)
+			bt.AddTarget(*reinterpret_cast<const SOCKADDR_IN*>(&target.Address));
+		else
+			AddFormattedText(pNetVoyagerView, _T("%s: %s"), target.sName.c_str(), theApp.GetErrorMessage(target.dwLastError).GetString());
+	}
+	AddFormattedText(pNetVoyagerView, _T("Tracing the route to <strong>%zu</strong> targets from <strong>%s</strong> over a maximum of %d hops"), bt.GetTargets().size(),
+		theApp.m_sBulkTargetList.GetString(), static_cast<int>(theApp.m_nHopCount));
+
+	// Trace them one after the other, one path per target as it completes
+	SOCKADDR_STORAGE localAddress{};
+	bool bBind{ false };
+	const int nError{ ResolveLocalAddress(AF_INET, false, localAddress, bBind) };
+	if (nError != 0)
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(static_cast<DWORD>(nError)).GetString());
+		return;
+	}
+	CStopRegistration stop{ [&bt]() { bt.Cancel(); } };
+	if (!g_bThreadRunning)
+		bt.Cancel();
+#pragma warning(suppress: 26490)
+	const bool bCompleted{ bt.Run(theApp.m_nHopCount, theApp.m_dwTimeout, theApp.m_nPings, 32, 0, bBind ? reinterpret_cast<const SOCKADDR_IN*>(&localAddress) : nullptr) };
+	const CBatchTraceSummary& summary{ bt.GetSummary() };
+	AddFormattedText(pNetVoyagerView, _T("%zu targets, %zu reached, %llu requests sent in %.3f s; %llu hops probed and %llu hops taken from the stop sets"), summary.nTargets,
+		summary.nReached, summary.nProbesSent, static_cast<double>(summary.nElapsed) / 1000000.0, summary.nProbedHops, summary.nCopiedHops);
+	ReportTopology(pNetVoyagerView);
+	if (!bCompleted && g_bThreadRunning)
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+}
+
+/**
+ * @brief Thread procedure for executing bulk ping operations
+ * @param lpParam Pointer to CNetVoyagerView instance
+ * @return Thread exit code (always 0)
+ */
+DWORD WINAPI BULK_ThreadProc(LPVOID lpParam)
+{
+	CNetVoyagerView* pNetVoyagerView = reinterpret_cast<CNetVoyagerView*>(lpParam);
+	ASSERT(pNetVoyagerView != nullptr);
+	if (theApp.m_bBulkTraceRoute)
+	{
+		BulkTrace(pNetVoyagerView);
+		return 0;
+	}
+
+	// Load the target list
+	CMyBulkPing bp;
+	bp.m_pNetVoyagerView = pNetVoyagerView;
+	if (!bp.LoadTargets(theApp.m_sBulkTargetList, theApp.m_bIPv6 ? AF_INET6 : AF_INET))
+	{
+		AddFormattedText(pNetVoyagerView, _T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+		return 0;
+	}
+
+	// Display initial bulk ping header message
+	AddFormattedText(pNetVoyagerView, _T("Pinging <strong>%zu</strong> targets from <strong>%s</strong> with %u bytes of data"), bp.GetTargets().size(), theApp.m_sBulkTargetList.GetString(), theApp.m_wDataRequestSize);
+
+	// Ping all the targets, one result line per target as it completes
+	bp.SetInterval(theApp.m_dwBulkInterval);
+	bp.SetTimeout(theApp.m_dwBulkTimeout);
+	bp.SetRetries(theApp.m_nBulkRetries);
+	bp.SetDataSize(theApp.m_wDataRequestSize);
+	bp.SetTTL(theApp.m_nTTL);
+	CStopRegistration stop{ [&bp]() { bp.Cancel(); } };
+	if (!g_bThreadRunning)
+		bp.Cancel();
+	CString sLine;
+	if (bp.Run())
+	{
+		const CBulkPingSummary& summary{ bp.GetSummary() };
+		sLine.Format(_T("%zu targets, %zu alive, %llu requests sent, %llu replies received in %.3f s (%.0f requests/sec)"), summary.nTargets, summary.nAlive,
+			summary.nProbesSent, summary.nRepliesReceived, static_cast<double>(summary.nElapsed) / 1000000.0, summary.GetProbesPerSecond());
+	}
+	else
+		sLine.Format(_T("%s"), theApp.GetErrorMessage(GetLastError()).GetString());
+	// Display summary or error message
+	pNetVoyagerView->AddDocumentText(sLine);
 
 	return 0;
 }
@@ -583,7 +1684,7 @@ bool WaitWithMessageLoop(HANDLE hEvent, DWORD dwTimeout)
 void CNetVoyagerView::OnPing()
 {
 	// Only allow one network operation at a time
-	if (!g_bThreadRunning)
+	if (!g_bThreadRunning && !g_bStopping)
 	{
 		CInputBox pInputBox(this);
 		if (pInputBox.DoModal() == IDOK)
@@ -595,11 +1696,12 @@ void CNetVoyagerView::OnPing()
 			theApp.m_bIPv6 = pInputBox.m_bIPv6;                                              // propagate IPv6 option
 
 			// Clear previous results
-			if (m_arrDocumentText.size() > 0)
-				m_arrDocumentText.erase(m_arrDocumentText.begin(), m_arrDocumentText.end());
+			ClearDocument();
 			// Create new temporary HTML file for results
 			SetDocumentPath(NewDocumentPath());
 			ExportDocument();
+			// Show the results page now; result lines are streamed into it as they arrive
+			ShowDocument();
 
 			// Create and show progress dialog
 			CPleaseWait dlgPleaseWait(this);
@@ -620,18 +1722,15 @@ void CNetVoyagerView::OnPing()
 			// Wait for thread completion while keeping UI responsive
 			VERIFY(WaitWithMessageLoop(hThread, INFINITE));
 
-			// Navigate to the results HTML file
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("file:///%s"), GetDocumentPath().c_str());
-			CString strURL(g_lpszOutputString);
-			// Convert backslashes to forward slashes for file URL
-			strURL.Replace(_T("\\"), _T("/"));
-			m_pWebBrowser->Navigate(g_lpszOutputString, nullptr);
+			// Deliver the last result lines to the page
+			m_ResultBatcher.Stop();
 
 			// Clean up progress dialog
 			VERIFY(dlgPleaseWait.DestroyWindow());
 
 			// Clear thread running flag
 			g_bThreadRunning = false;
+			g_bStopping = false;
 		}
 	}
 }
@@ -642,7 +1741,7 @@ void CNetVoyagerView::OnPing()
  */
 void CNetVoyagerView::OnUpdatePing(CCmdUI *pCmdUI)
 {
-	pCmdUI->Enable(!g_bThreadRunning);
+	pCmdUI->Enable(!g_bThreadRunning && !g_bStopping);
 }
 
 /**
@@ -652,7 +1751,7 @@ void CNetVoyagerView::OnUpdatePing(CCmdUI *pCmdUI)
 void CNetVoyagerView::OnTraceRoute()
 {
 	// Only allow one network operation at a time
-	if (!g_bThreadRunning)
+	if (!g_bThreadRunning && !g_bStopping)
 	{
 		CInputBox pInputBox(this);
 		if (pInputBox.DoModal() == IDOK)
@@ -664,11 +1763,12 @@ void CNetVoyagerView::OnTraceRoute()
 			theApp.m_bIPv6 = pInputBox.m_bIPv6;                                              // propagate IPv6 option
 
 			// Clear previous results
-			if (m_arrDocumentText.size() > 0)
-				m_arrDocumentText.erase(m_arrDocumentText.begin(), m_arrDocumentText.end());
+			ClearDocument();
 			// Create new temporary HTML file for results
 			SetDocumentPath(NewDocumentPath());
 			ExportDocument();
+			// Show the results page now; result lines are streamed into it as they arrive
+			ShowDocument();
 
 			// Create and show progress dialog
 			CPleaseWait dlgPleaseWait(this);
@@ -689,18 +1789,15 @@ void CNetVoyagerView::OnTraceRoute()
 			// Wait for thread completion while keeping UI responsive
 			VERIFY(WaitWithMessageLoop(hThread, INFINITE));
 
-			// Navigate to the results HTML file
-			_stprintf_s(g_lpszOutputString, _countof(g_lpszOutputString) - 1, _T("file:///%s"), GetDocumentPath().c_str());
-			CString strURL(g_lpszOutputString);
-			// Convert backslashes to forward slashes for file URL
-			strURL.Replace(_T("\\"), _T("/"));
-			m_pWebBrowser->Navigate(g_lpszOutputString, nullptr);
+			// Deliver the last result lines to the page
+			m_ResultBatcher.Stop();
 
 			// Clean up progress dialog
 			VERIFY(dlgPleaseWait.DestroyWindow());
 
 			// Clear thread running flag
 			g_bThreadRunning = false;
+			g_bStopping = false;
 		}
 	}
 }
@@ -711,7 +1808,97 @@ void CNetVoyagerView::OnTraceRoute()
  */
 void CNetVoyagerView::OnUpdateTraceRoute(CCmdUI *pCmdUI)
 {
-	pCmdUI->Enable(!g_bThreadRunning);
+	pCmdUI->Enable(!g_bThreadRunning && !g_bStopping);
+}
+
+/**
+ * @brief Handles the Bulk Ping command
+ * Prompts user for a target list file and executes bulk ping operation in a separate thread
+ */
+void CNetVoyagerView::OnBulkPing()
+{
+	// Only allow one network operation at a time
+	if (!g_bThreadRunning && !g_bStopping)
+	{
+		CFileDialog dlgFile(TRUE, _T("txt"), nullptr, OFN_FILEMUSTEXIST | OFN_HIDEREADONLY, _T("Target Lists (*.txt)|*.txt|All Files (*.*)|*.*||"), this);
+		if (dlgFile.DoModal() == IDOK)
+		{
+			// Set thread running flag
+			g_bThreadRunning = true;
+			theApp.m_sBulkTargetList = dlgFile.GetPathName();
+
+			// Clear previous results
+			ClearDocument();
+			// Create new temporary HTML file for results
+			SetDocumentPath(NewDocumentPath());
+			ExportDocument();
+			// Show the results page now; result lines are streamed into it as they arrive
+			ShowDocument();
+
+			// Create and show progress dialog
+			CPleaseWait dlgPleaseWait(this);
+			VERIFY(dlgPleaseWait.Create(IDD_PLEASEWAIT, this));
+			dlgPleaseWait.m_ctrlProgress.SetMarquee(TRUE, 40);
+			dlgPleaseWait.CenterWindow();
+			dlgPleaseWait.ShowWindow(SW_SHOW);
+
+			// Create bulk ping worker thread
+			HANDLE hThread = ::CreateThread(
+				NULL,
+				0,
+				(LPTHREAD_START_ROUTINE)BULK_ThreadProc,
+				this,
+				0,
+				&m_nThreadID);
+
+			// Wait for thread completion while keeping UI responsive
+			VERIFY(WaitWithMessageLoop(hThread, INFINITE));
+
+			// Deliver the last result lines to the page
+			m_ResultBatcher.Stop();
+
+			// Clean up progress dialog
+			VERIFY(dlgPleaseWait.DestroyWindow());
+
+			// Clear thread running flag
+			g_bThreadRunning = false;
+			g_bStopping = false;
+		}
+	}
+}
+
+/**
+ * @brief Updates the UI state for the Bulk Ping command
+ * @param pCmdUI Pointer to the command UI object
+ */
+void CNetVoyagerView::OnUpdateBulkPing(CCmdUI *pCmdUI)
+{
+	pCmdUI->Enable(!g_bThreadRunning && !g_bStopping);
+}
+
+/**
+ * @brief Handles the Stop command
+ * Tells the running network operation to stop; a continuous traceroute or a route monitor is also interrupted
+ * straight away rather than at its next check of the flag
+ */
+void CNetVoyagerView::OnStop()
+{
+	if (!g_bThreadRunning)
+		return;
+	g_bStopping = true;
+	g_bThreadRunning = false;
+	std::lock_guard<std::mutex> lock{ g_StopMutex };
+	if (g_StopOperation)
+		g_StopOperation();
+}
+
+/**
+ * @brief Updates the UI state for the Stop command
+ * @param pCmdUI Pointer to the command UI object
+ */
+void CNetVoyagerView::OnUpdateStop(CCmdUI *pCmdUI)
+{
+	pCmdUI->Enable(g_bThreadRunning);
 }
 
 /**
@@ -741,27 +1928,218 @@ const std::wstring CNetVoyagerView::NewDocumentPath()
 }
 
 /**
- * @brief Exports the current document text to an HTML file
- * Creates a complete HTML document with Bootstrap styling
+ * @brief Starts the HTML file over with the header, the accumulated result lines and the footer
+ * @details Later lines are appended in place by AddDocumentText, which keeps the file open
  */
 void CNetVoyagerView::ExportDocument()
 {
-	std::ofstream htmlFile(GetDocumentPath().c_str(), std::ofstream::out);
-	if (!htmlFile.is_open())
+	std::lock_guard<std::mutex> lock{ m_DocumentMutex };
+	ExportDocumentLocked();
+}
+
+/**
+ * @brief Starts the HTML file over from the retained result lines; m_DocumentMutex must be held
+ */
+void CNetVoyagerView::ExportDocumentLocked()
+{
+	std::ostringstream htmlHeader, htmlFooter;
+	WriteHtmlHeader(htmlHeader);
+	WriteHtmlFooter(htmlFooter);
+	if (!m_HtmlReport.Open(GetDocumentPath().c_str(), htmlHeader.str(), htmlFooter.str()))
 		return; // Failed to open file for writing
 
-	// Write the complete HTML document structure
-	WriteHtmlHeader(htmlFile);
-	WriteHtmlBody(htmlFile);
-	WriteHtmlFooter(htmlFile);
-	// File is automatically closed by ofstream destructor
+	// Render the lines retained so far, the footer follows them after each one
+	char szLine[0x1000];
+	for (size_t i = 0; i < m_ResultStore.GetCount(); i++)
+	{
+		const size_t nLength{ RenderResult(m_ResultStore.Get(i), szLine, sizeof(szLine)) };
+		m_HtmlReport.Append(szLine, nLength);
+	}
+	m_nLinesInFile = m_ResultStore.GetCount();
+}
+
+/**
+ * @brief Discards the result lines of the previous operation
+ * @details The retention settings are applied to the new operation, so a change takes effect at the next one
+ */
+void CNetVoyagerView::ClearDocument()
+{
+	std::lock_guard<std::mutex> lock{ m_DocumentMutex };
+	m_ResultStore.Clear();
+	m_ResultStore.SetRetention(theApp.m_nRetainLines, static_cast<ULONGLONG>(theApp.m_dwRetainMinutes) * 60000000ULL);
+	m_nLinesInFile = 0;
+}
+
+/**
+ * @brief Appends a message line to the document and to the HTML file
+ * @param pszText The UTF-8 text of the line
+ * @param nLength The length of the text in bytes
+ */
+void CNetVoyagerView::AddDocumentText(const char* pszText, size_t nLength)
+{
+	CProbeResult result{};
+	result.nTimestamp = CPingClock::NowMicroseconds();
+	result.nType = CProbeResultType::Text;
+	result.nFamily = AF_UNSPEC;
+	AddProbeResult(result, pszText, nLength);
+}
+
+/**
+ * @brief Appends a message line to the document and to the HTML file
+ * @param sText The text of the line
+ */
+void CNetVoyagerView::AddDocumentText(const CString& sText)
+{
+	char szText[0x1000];
+	CUtf8Writer text{ szText, sizeof(szText) };
+	text.AppendWide(sText.GetString(), static_cast<size_t>(sText.GetLength()));
+	AddDocumentText(text.GetString(), text.GetLength());
 }
 
 /**
- * @brief Writes the HTML header section to the output file
- * @param file Reference to the output file stream
+ * @brief Appends a result record to the document and renders it into the HTML file and the results page
+ * @param result The record
+ * @param pszText The UTF-8 message of a CProbeResultType::Text record, empty for the other records
+ * @param nLength The length of the text in bytes
+ * @details Only the new line and the fixed footer are written, so every line costs the same however long the
+ * report already is. Once the store evicts lines the file is rewritten from it whenever it holds twice as
+ * many lines as the store, which keeps the file bounded at an amortised constant cost per line. The line is
+ * rendered into a stack buffer and copied into reused buffers from there, so once the store and the batcher
+ * have grown a reply is added without any heap allocation.
  */
-void CNetVoyagerView::WriteHtmlHeader(std::ofstream& file)
+void CNetVoyagerView::AddProbeResult(const CProbeResult& result, const char* pszText, size_t nLength)
+{
+	std::lock_guard<std::mutex> lock{ m_DocumentMutex };
+	m_ResultStore.Add(result, pszText, nLength);
+	char szLine[0x1000];
+	const size_t nLineLength{ RenderResult(m_ResultStore.Get(m_ResultStore.GetCount() - 1), szLine, sizeof(szLine)) };
+	TRACE("%s\n", szLine);
+	if (!m_HtmlReport.IsOpen() || ((m_ResultStore.GetEvicted().nLines > 0) && (m_nLinesInFile >= (2 * m_ResultStore.GetCount()))))
+		ExportDocumentLocked(); // Includes the new line
+	else
+	{
+		m_HtmlReport.Append(szLine, nLineLength);
+		++m_nLinesInFile;
+	}
+	m_ResultBatcher.Add(szLine, nLineLength);
+}
+
+/**
+ * @brief Renders a retained record as a UTF-8 result line
+ * @param stored The record and its text
+ * @param pszBuffer Receives the line, always null terminated
+ * @param nBufferSize Size of pszBuffer in bytes
+ * @return The length of the line, without the terminator
+ * @details Only records which report an error look up a description, the others are formatted without any
+ * allocation. The description is converted to UTF-8 on the stack as well. Host names come from the name
+ * cache, which never blocks; a name which is not known yet is filled in by OnNameResolved.
+ */
+size_t CNetVoyagerView::RenderResult(const CStoredResult& stored, char* pszBuffer, size_t nBufferSize)
+{
+	const CProbeResult& result{ stored.Result };
+	if (result.nType == CProbeResultType::Text)
+	{
+		const size_t nLength{ (stored.strText.size() < nBufferSize) ? stored.strText.size() : (nBufferSize - 1) };
+		memcpy(pszBuffer, stored.strText.data(), nLength);
+		pszBuffer[nLength] = '\0';
+		return nLength;
+	}
+
+	char szStatus[0x400];
+	CUtf8Writer status{ szStatus, sizeof(szStatus) };
+	if ((result.nType == CProbeResultType::PingReply) && (result.nStatus != IP_SUCCESS))
+	{
+		const CString sError{ theApp.GetIpErrorString(result.nStatus) };
+		status.AppendWide(sError.GetString(), static_cast<size_t>(sError.GetLength()));
+	}
+	else if ((result.nType == CProbeResultType::PingError) || ((result.nType == CProbeResultType::HopError) && (result.nStatus != ERROR_TIMEOUT)))
+	{
+		const CString sError{ theApp.GetErrorMessage(result.nStatus) };
+		status.AppendWide(sError.GetString(), static_cast<size_t>(sError.GetLength()));
+	}
+	char szHost[NI_MAXHOST * 3];
+	const char* pszHost{ nullptr };
+	if (theApp.m_bResolveAddressesToHostnames && ((result.nType == CProbeResultType::PingReply) || (result.nType == CProbeResultType::HopReply)))
+	{
+		m_NameResolver.Lookup(result.nFamily, result.Address, szHost, sizeof(szHost));
+		pszHost = szHost;
+	}
+	return FormatProbeResult(result, pszHost, status.GetString(), pszBuffer, nBufferSize);
+}
+
+/**
+ * @brief Navigates to the HTML file and streams the result lines added from now on into the page
+ * @details The page shows whatever the file holds when it is loaded; once navigation completes the batcher
+ * delivers the remaining lines, and the page skips the ones it already shows
+ */
+void CNetVoyagerView::ShowDocument()
+{
+	m_ResultBatcher.Reset();
+	m_ResultBatcher.Start();
+
+	CString strURL;
+	strURL.Format(_T("file:///%s"), GetDocumentPath().c_str());
+	// Convert backslashes to forward slashes for file URL
+	strURL.Replace(_T("\\"), _T("/"));
+	m_pWebBrowser->Navigate(strURL, [this]() {
+		m_ResultBatcher.SetSink(this);
+	});
+}
+
+/**
+ * @brief Fills in the host name of an address wherever the results show it
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr / in6_addr bytes
+ * @param pszName The UTF-8 host name
+ * @details Called on a resolver thread. A script which sets the name goes into the HTML file, for a page which
+ * loads it later, and the name goes into the result stream, for the page which is already showing
+ */
+void CNetVoyagerView::OnNameResolved(int nFamily, const BYTE* pAddress, const char* pszName)
+{
+	char szAddress[CIpAddressText::MAX_LENGTH];
+	CIpAddressText::Format(nFamily, pAddress, szAddress, sizeof(szAddress));
+	char szScript[0x400];
+	CUtf8Writer script{ szScript, sizeof(szScript) };
+	script.Append("<script>setNames([[").AppendJsonString(szAddress, strlen(szAddress)).Append(',').AppendJsonString(pszName, strlen(pszName)).Append("]]);</script>\n");
+
+	std::lock_guard<std::mutex> lock{ m_DocumentMutex };
+	if (!script.IsTruncated())
+		m_HtmlReport.AppendFragment(script.GetString(), script.GetLength());
+	m_ResultBatcher.AddName(szAddress, pszName);
+}
+
+/**
+ * @brief Hands a batch of result lines over to the UI thread, which posts it to the page
+ * @param strJson The UTF-8 JSON batch
+ * @details Called on the batcher's delivery thread
+ */
+void CNetVoyagerView::PostBatch(const std::string& strJson)
+{
+	auto pJson = std::make_unique<std::string>(strJson);
+	if (PostMessage(MSG_POST_RESULTS, 0, reinterpret_cast<LPARAM>(pJson.get())))
+		pJson.release(); // Now owned by OnPostResults
+}
+
+/**
+ * @brief Posts a batch of result lines to the results page
+ * @param wParam Unused
+ * @param lParam Pointer to the UTF-8 JSON batch, which is deleted here
+ * @return 0
+ */
+LRESULT CNetVoyagerView::OnPostResults(WPARAM wParam, LPARAM lParam)
+{
+	UNREFERENCED_PARAMETER(wParam);
+	std::unique_ptr<std::string> pJson(reinterpret_cast<std::string*>(lParam));
+	if (m_pWebBrowser != nullptr)
+		m_pWebBrowser->PostWebMessageAsJson(UTF82W(pJson->c_str(), static_cast<int>(pJson->size())));
+	return 0;
+}
+
+/**
+ * @brief Writes the HTML header section to the output stream
+ * @param file Reference to the output stream
+ */
+void CNetVoyagerView::WriteHtmlHeader(std::ostream& file)
 {
 	// Write HTML5 doctype and opening tags
 	file << "<!DOCTYPE html>\n"
@@ -773,30 +2151,93 @@ void CNetVoyagerView::WriteHtmlHeader(std::ofstream& file)
 		<< "<link href=\"https://cdn.jsdelivr.net/npm/bootstrap@5.3.7/dist/css/bootstrap.min.css\" "
 		<< "rel=\"stylesheet\" integrity=\"sha384-LN+7fdVzj6u52u30Kp6M/trliBMCMKTyK833zpbD+pXdCLuTusPj697FH4R/5mcr\" "
 		<< "crossorigin=\"anonymous\">\n"
+		// Appends the result lines streamed by the application, skipping those already loaded from this file
+		<< "<script>\n"
+		<< "var nShownLines = -1, nLinesInPage = 0;\n"
+		<< "function appendResults(batch) {\n"
+		<< "  var row = document.getElementById('row');\n"
+		<< "  if (nShownLines < 0) {\n"
+		<< "    nLinesInPage = row.getElementsByTagName('br').length;\n"
+		<< "    nShownLines = parseInt(row.dataset.first) + nLinesInPage;\n"
+		<< "  }\n"
+		<< "  for (var i = Math.max(0, nShownLines - batch.first); i < batch.lines.length; i++) {\n"
+		<< "    row.insertAdjacentHTML('beforeend', batch.lines[i] + '<br>\\n');\n"
+		<< "    nShownLines = batch.first + i + 1;\n"
+		<< "    nLinesInPage++;\n"
+		<< "  }\n"
+		// Keep no more lines in the page than the application retains
+		<< "  var nKeep = parseInt(row.dataset.keep);\n"
+		<< "  while ((nKeep > 0) && (nLinesInPage > nKeep)) {\n"
+		<< "    var node;\n"
+		<< "    do { node = row.firstChild; row.removeChild(node); } while (node.nodeName !== 'BR');\n"
+		<< "    nLinesInPage--;\n"
+		<< "  }\n"
+		<< "  fillNames(row);\n"
+		<< "  window.scrollTo(0, document.body.scrollHeight);\n"
+		<< "}\n"
+		// Host names are found in the background; fill them into the spans which show their address
+		<< "var hostNames = {};\n"
+		<< "function fillNames(root) {\n"
+		<< "  var spans = root.querySelectorAll('span.ptr:empty');\n"
+		<< "  for (var i = 0; i < spans.length; i++) {\n"
+		<< "    var name = hostNames[spans[i].dataset.addr];\n"
+		<< "    if (name) spans[i].textContent = ' [' + name + ']';\n"
+		<< "  }\n"
+		<< "}\n"
+		<< "function setNames(names) {\n"
+		<< "  for (var i = 0; i < names.length; i++) hostNames[names[i][0]] = names[i][1];\n"
+		<< "  fillNames(document);\n"
+		<< "}\n"
+		<< "if (window.chrome && window.chrome.webview) window.chrome.webview.addEventListener('message', function (e) {\n"
+		<< "  appendResults(e.data);\n"
+		<< "  if (e.data.names) setNames(e.data.names);\n"
+		<< "});\n"
+		<< "</script>\n"
 		<< "</head>\n"
 		<< "<body>\n"
-		<< "<div class=\"container\">\n"
-		<< "<div id=\"row\">\n";
+		<< "<div class=\"container\">\n";
+	WriteEvictedSummary(file);
+	// data-first is the index of the first line below since the operation started, data-keep the line limit
+	file << "<div id=\"row\" data-first=\"" << m_ResultStore.GetFirstIndex() << "\" data-keep=\"" << m_ResultStore.GetMaxLines() << "\">\n";
 }
 
 /**
- * @brief Writes the HTML body content to the output file
- * @param file Reference to the output file stream
+ * @brief Writes a paragraph which sums up the result lines evicted from the store, if there are any
+ * @param file Reference to the output stream
  */
-void CNetVoyagerView::WriteHtmlBody(std::ofstream& file)
+void CNetVoyagerView::WriteEvictedSummary(std::ostream& file)
 {
-	// Iterate through all document text lines and write them to HTML
-	for (const auto& text : m_arrDocumentText)
+	const CEvictedSummary& evicted{ m_ResultStore.GetEvicted() };
+	if (evicted.nLines == 0)
+		return;
+
+	const ULONGLONG nSeconds{ (evicted.nLastTime - evicted.nFirstTime) / 1000000ULL };
+	CString strSummary;
+	strSummary.Format(_T("%llu earlier lines spanning %llu:%02llu:%02llu are not shown"), evicted.nLines, nSeconds / 3600, (nSeconds / 60) % 60, nSeconds % 60);
+	const CProbeStatistics& stats{ evicted.Statistics };
+	if (stats.GetSent() > 0)
 	{
-		file << text << "<br>\n";
+		CString strProbes;
+		strProbes.Format(_T("; they reported Sent = %llu, Received = %llu, Lost = %llu (%.1f%% loss)"), stats.GetSent(), stats.GetReceived(), stats.GetLost(), stats.GetLossRatio() * 100.0);
+		strSummary += strProbes;
+		if (stats.GetReceived() > 0)
+		{
+			strProbes.Format(_T(", RTT min = %s, avg = %s, max = %s, p99 = %s"), theApp.RTTAsString(stats.GetMin()).GetString(), theApp.RTTAsString(static_cast<ULONGLONG>(stats.GetMean() + 0.5)).GetString(),
+				theApp.RTTAsString(stats.GetMax()).GetString(), theApp.RTTAsString(stats.GetPercentile(99.0)).GetString());
+			strSummary += strProbes;
+		}
 	}
+	char szSummary[0x400];
+	CUtf8Writer summary{ szSummary, sizeof(szSummary) };
+	summary.AppendWide(strSummary.GetString(), static_cast<size_t>(strSummary.GetLength()));
+	file << "<p class=\"text-muted\">" << summary.GetString() << "</p>\n";
 }
 
 /**
- * @brief Writes the HTML footer section to the output file
- * @param file Reference to the output file stream
+ * @brief Writes the HTML footer section to the output stream
+ * @param file Reference to the output stream
  */
-void CNetVoyagerView::WriteHtmlFooter(std::ofstream& file)
+void CNetVoyagerView::WriteHtmlFooter(std::ostream& file)
 {
 	// Close HTML tags and include Bootstrap JavaScript from CDN
 	file << "</div>\n"
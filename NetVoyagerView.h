@@ -18,10 +18,18 @@ NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
 
 #pragma once
 #include "EdgeWebBrowser.h"
+#include "HtmlReportWriter.h"
+#include "ResultBatcher.h"
+#include "ResultStore.h"
+#include "NameResolver.h"
+#include "TopologyGraph.h"
+#include <mutex>
 
 // CNetVoyagerView: MFC view class that hosts the Edge WebView2 browser control
-// and orchestrates ping and traceroute network operations.
-class CNetVoyagerView : public CView
+// and orchestrates ping and traceroute network operations. Results are streamed
+// into the page as JSON batches while an operation runs; host names are looked up in the background and filled
+// in when they are found.
+class CNetVoyagerView : public CView, public CResultSink, public CNameResolverSink
 {
 protected: // create from serialization only
 	CNetVoyagerView() noexcept;          // Protected constructor; instances are created via MFC dynamic creation
@@ -53,29 +61,49 @@ public:
 protected:
 	DWORD m_nThreadID;                          // Thread ID of the active ping/traceroute worker thread
 	std::wstring m_strDocumentPath;             // Full path to the temporary HTML file that holds operation results
-	std::vector<std::string> m_arrDocumentText; // Accumulated UTF-8 output lines written into the HTML results file
+	CResultStore m_ResultStore;                 // Retained UTF-8 output lines (and a summary of the evicted ones) of the HTML results file
+	ULONGLONG m_nLinesInFile;                   // Result lines in the HTML results file, which is compacted when evictions make it twice the store
+	CHtmlReportWriter m_HtmlReport;             // Keeps the HTML results file open and appends each new line in place
+	CResultBatcher m_ResultBatcher;             // Groups new result lines into JSON batches for the results page
+	CNameResolver m_NameResolver;               // Looks up and caches the host names of the addresses in the results
+	std::mutex m_DocumentMutex;                 // Serialises the worker thread and the resolver threads on the store and the HTML file
+	CTopologyGraph m_Topology;                  // The paths traced in this session merged into one graph; only touched by the worker thread
 
 // Generated message map functions
 protected:
 	virtual void OnInitialUpdate();                    // Called on first update; creates and initializes the browser control
 	afx_msg void OnDestroy();                          // Releases the browser control when the view is destroyed
 	afx_msg void OnSize(UINT nType, int cx, int cy);   // Resizes the browser control to fill the view's client area
+	afx_msg LRESULT OnPostResults(WPARAM wParam, LPARAM lParam); // Posts a batch of result lines to the results page (UI thread)
 public:
 	afx_msg void OnPing();                             // Handles the Ping menu command; prompts for host and runs ping thread
 	afx_msg void OnUpdatePing(CCmdUI *pCmdUI);         // Disables the Ping command while a network thread is running
 	afx_msg void OnTraceRoute();                       // Handles the Trace Route command; prompts for host and runs trace thread
 	afx_msg void OnUpdateTraceRoute(CCmdUI *pCmdUI);   // Disables the Trace Route command while a network thread is running
+	afx_msg void OnBulkPing();                         // Handles the Bulk Ping command; prompts for a target list and runs bulk ping thread
+	afx_msg void OnUpdateBulkPing(CCmdUI *pCmdUI);     // Disables the Bulk Ping command while a network thread is running
+	afx_msg void OnStop();                             // Handles the Stop command; stops the running network operation
+	afx_msg void OnUpdateStop(CCmdUI *pCmdUI);         // Enables the Stop command only while a network thread is running
 	// Custom functions
 	const std::wstring NewDocumentPath();              // Generates a unique temporary .html file path for storing results
 	const std::wstring GetDocumentPath() { return m_strDocumentPath; }                                              // Returns the current HTML output file path
 	void SetDocumentPath(const std::wstring strNewDocPath) { m_strDocumentPath = strNewDocPath; }                   // Sets the HTML output file path
-	void AddDocumentText(const std::string strNewDocText) { m_arrDocumentText.push_back(strNewDocText); ExportDocument(); } // Appends a result line and re-exports the HTML file
-	void ExportDocument(); // Writes all accumulated result lines to the HTML output file
+	CTopologyGraph& GetTopology() { return m_Topology; }                                                            // The merged topology of the traced paths
+	void AddDocumentText(const char* pszText, size_t nLength); // Appends a UTF-8 message line to the document and to the HTML file
+	void AddDocumentText(const CString& sText);        // Appends a message line, converted to UTF-8 in a stack buffer
+	void AddProbeResult(const CProbeResult& result, const char* pszText, size_t nLength); // Appends a result record; it is rendered into the HTML file and the results page
+	void ClearDocument();  // Discards the result lines of the previous operation and applies the retention settings
+	void ExportDocument(); // Starts the HTML output file over with all retained result lines
+	void ShowDocument();   // Navigates to the HTML output file and streams new result lines into it
+	virtual void PostBatch(const std::string& strJson) override; // CResultSink: hands a batch over to the UI thread
+	virtual void OnNameResolved(int nFamily, const BYTE* pAddress, const char* pszName) override; // CNameResolverSink: fills in a host name
 
 private:
-	void WriteHtmlHeader(std::ofstream& file); // Writes the HTML5 doctype, <head>, and opening <body> tags with Bootstrap CSS
-	void WriteHtmlBody(std::ofstream& file);   // Writes each result line as a <br>-terminated paragraph in the HTML body
-	void WriteHtmlFooter(std::ofstream& file); // Writes the closing </body> and </html> tags with Bootstrap JS bundle
+	void ExportDocumentLocked(); // ExportDocument with m_DocumentMutex held
+	size_t RenderResult(const CStoredResult& stored, char* pszBuffer, size_t nBufferSize); // Renders a retained record as a UTF-8 line
+	void WriteHtmlHeader(std::ostream& file); // Writes the HTML5 doctype, <head>, and opening <body> tags with Bootstrap CSS
+	void WriteEvictedSummary(std::ostream& file); // Writes the summary of the result lines which are no longer retained
+	void WriteHtmlFooter(std::ostream& file); // Writes the closing </body> and </html> tags with Bootstrap JS bundle
 
 	DECLARE_MESSAGE_MAP() // Declares the MFC message map for this class
 };
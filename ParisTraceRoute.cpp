@@ -0,0 +1,576 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ParisTraceRoute.cpp : implementation of the CParisTraceRoute class
+//
+
+#include "pch.h"
+#include "ParisTraceRoute.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	/**
+	 * @brief Compares the address of an interface with an IPv4 address
+	 * @return true if they are the same address
+	 */
+	bool SameAddress(const SOCKADDR_STORAGE& address1, const SOCKADDR_IN& address2) noexcept
+	{
+		const SOCKADDR_IN* pAddress1{ reinterpret_cast<const SOCKADDR_IN*>(&address1) };
+		return (address1.ss_family == AF_INET) && (pAddress1->sin_addr.s_addr == address2.sin_addr.s_addr);
+	}
+
+	/**
+	 * @brief Compares the address of an interface with an IPv6 address
+	 * @return true if they are the same address
+	 */
+	bool SameAddress(const SOCKADDR_STORAGE& address1, const SOCKADDR_IN6& address2) noexcept
+	{
+		const SOCKADDR_IN6* pAddress1{ reinterpret_cast<const SOCKADDR_IN6*>(&address1) };
+		return (address1.ss_family == AF_INET6) && (memcmp(&pAddress1->sin6_addr, &address2.sin6_addr, sizeof(address2.sin6_addr)) == 0);
+	}
+
+	/**
+	 * @brief Checks whether a session is open towards an IPv4 destination
+	 */
+	bool SessionMatches(const CPingSession& session, const SOCKADDR_IN& destAddress) noexcept
+	{
+		return (session.GetFamily() == AF_INET) && (session.GetDestAddressv4().sin_addr.s_addr == destAddress.sin_addr.s_addr);
+	}
+
+	/**
+	 * @brief Checks whether a session is open towards an IPv6 destination
+	 */
+	bool SessionMatches(const CPingSession& session, const SOCKADDR_IN6& destAddress) noexcept
+	{
+		return (session.GetFamily() == AF_INET6) && (memcmp(&session.GetDestAddressv6().sin6_addr, &destAddress.sin6_addr, sizeof(destAddress.sin6_addr)) == 0);
+	}
+
+	/**
+	 * @brief Makes the key of the local address a session is opened with
+	 * @param pLocalAddress The local address, nullptr for any
+	 * @return The address, or family AF_UNSPEC for any
+	 */
+	template <typename Address>
+	SOCKADDR_STORAGE MakeLocalKey(const Address* pLocalAddress) noexcept
+	{
+		SOCKADDR_STORAGE key{};
+		if (pLocalAddress != nullptr)
+			memcpy(&key, pLocalAddress, sizeof(Address));
+		return key;
+	}
+}
+
+const UINT CParisTraceRoute::NONE;
+const UINT CParisTraceRoute::SILENT;
+const UINT CParisTraceRoute::NOT_PROBED;
+
+/**
+ * @brief Default constructor for CParisTraceRoute; flow stable probing is off
+ */
+CParisTraceRoute::CParisTraceRoute() :
+	m_bFlowStable{ false },
+	m_wFlow{ 0 },
+	m_bFlowControlled{ false },
+	m_nMaxFlows{ 1024 },
+	m_SessionLocalAddress{},
+	m_nEnumeratedHops{ 0 },
+	m_nFlows{ 0 }
+{
+}
+
+/**
+ * @brief Computes the number of probes which rule out a further next hop
+ * @param nNextHops The next hops found so far, k; 0 counts as 1
+ * @param fConfidence The probability of not missing a next hop, between 0 and 1
+ * @return n(k), the smallest number of probes after which k + 1 equally likely next hops would all have been
+ * seen at least once with probability fConfidence, bounding the miss of any one of them by (1 - fConfidence) / (k + 1)
+ */
+UINT CParisTraceRoute::GetStoppingPoint(UINT nNextHops, double fConfidence) noexcept
+{
+	const double k{ static_cast<double>(std::max<UINT>(nNextHops, 1)) };
+	const double fAlpha{ 1.0 - fConfidence };
+	return static_cast<UINT>(std::ceil(std::log(fAlpha / (k + 1.0)) / std::log(k / (k + 1.0))));
+}
+
+/**
+ * @brief Opens the flow stable session towards an IPv4 destination, unless it is open towards it already
+ * @param destAddress The destination
+ * @param wDataSize Payload size of each probe in bytes
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true if the session is open, false otherwise; GetLastError tells why
+ * @details The session is only reopened when something changes, as reopening it gives the probes a new
+ * identifier and so a new flow. The caller holds m_SessionMutex.
+ */
+bool CParisTraceRoute::OpenSession(const SOCKADDR_IN& destAddress, WORD wDataSize, const SOCKADDR_IN* pLocalAddress)
+{
+	const SOCKADDR_STORAGE localKey{ MakeLocalKey(pLocalAddress) };
+	if ((m_pSession != nullptr) && m_pSession->IsOpen() && SessionMatches(*m_pSession, destAddress) && (m_pSession->GetRequestData().size() == wDataSize) &&
+		(memcmp(&localKey, &m_SessionLocalAddress, sizeof(localKey)) == 0))
+		return true;
+	if (m_pSession == nullptr)
+		m_pSession = std::make_unique<CPingSession>(CreateBackend());
+	m_SessionLocalAddress = localKey;
+	return m_pSession->Openv4(destAddress, wDataSize, pLocalAddress);
+}
+
+/**
+ * @brief Opens the flow stable session towards an IPv6 destination, unless it is open towards it already
+ * @param destAddress The destination
+ * @param wDataSize Payload size of each probe in bytes
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true if the session is open, false otherwise; GetLastError tells why
+ */
+bool CParisTraceRoute::OpenSession(const SOCKADDR_IN6& destAddress, WORD wDataSize, const SOCKADDR_IN6* pLocalAddress)
+{
+	const SOCKADDR_STORAGE localKey{ MakeLocalKey(pLocalAddress) };
+	if ((m_pSession != nullptr) && m_pSession->IsOpen() && SessionMatches(*m_pSession, destAddress) && (m_pSession->GetRequestData().size() == wDataSize) &&
+		(memcmp(&localKey, &m_SessionLocalAddress, sizeof(localKey)) == 0))
+		return true;
+	if (m_pSession == nullptr)
+		m_pSession = std::make_unique<CPingSession>(CreateBackend());
+	m_SessionLocalAddress = localKey;
+	return m_pSession->Openv6(destAddress, wDataSize, pLocalAddress);
+}
+
+/**
+ * @brief Sends one IPv4 probe in a given flow over the flow stable session
+ * @param destAddress The destination
+ * @param htsr Receives the reply
+ * @param nTTL TTL of the probe
+ * @param dwTimeout Timeout in milliseconds
+ * @param wDataSize Payload size in bytes
+ * @param nTOS Type of service
+ * @param bDontFragment Sets the don't fragment flag
+ * @param pLocalAddress The address to send the probe from, nullptr for any
+ * @param wFlow The flow of the probe
+ * @return true if the probe was answered, false otherwise; GetLastError tells why
+ */
+bool CParisTraceRoute::PingFlow(const SOCKADDR_IN& destAddress, CHostTraceSingleReplyv4& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, const SOCKADDR_IN* pLocalAddress, WORD wFlow)
+{
+	std::lock_guard<std::mutex> lock{ m_SessionMutex };
+	if (!OpenSession(destAddress, wDataSize, pLocalAddress))
+		return false;
+	m_bFlowControlled = m_pSession->GetBackend()->SetFlow(wFlow);
+	if (!m_pSession->Pingv4(m_Replyv4, nTTL, dwTimeout, nTOS, bDontFragment, false))
+		return false;
+	htsr.Address = m_Replyv4.Address;
+	htsr.RTT = m_Replyv4.RTT;
+	htsr.nStatus = static_cast<ULONG>(m_Replyv4.EchoReplyStatus);
+	return true;
+}
+
+/**
+ * @brief Sends one IPv6 probe in a given flow over the flow stable session
+ * @param destAddress The destination
+ * @param htsr Receives the reply
+ * @param nTTL Hop limit of the probe
+ * @param dwTimeout Timeout in milliseconds
+ * @param wDataSize Payload size in bytes
+ * @param nTOS Traffic class
+ * @param bDontFragment Sets the don't fragment flag
+ * @param pLocalAddress The address to send the probe from, nullptr for any
+ * @param wFlow The flow of the probe
+ * @return true if the probe was answered, false otherwise; GetLastError tells why
+ */
+bool CParisTraceRoute::PingFlow(const SOCKADDR_IN6& destAddress, CHostTraceSingleReplyv6& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, const SOCKADDR_IN6* pLocalAddress, WORD wFlow)
+{
+	std::lock_guard<std::mutex> lock{ m_SessionMutex };
+	if (!OpenSession(destAddress, wDataSize, pLocalAddress))
+		return false;
+	m_bFlowControlled = m_pSession->GetBackend()->SetFlow(wFlow);
+	if (!m_pSession->Pingv6(m_Replyv6, nTTL, dwTimeout, nTOS, bDontFragment, false))
+		return false;
+	htsr.Address = m_Replyv6.Address;
+	htsr.RTT = m_Replyv6.RTT;
+	htsr.nStatus = static_cast<ULONG>(m_Replyv6.EchoReplyStatus);
+	return true;
+}
+
+/**
+ * @brief Sends one IPv4 probe of Tracev4
+ * @details With flow stable probing the probe goes over the shared session in the flow of the trace; otherwise
+ * it is sent like CTraceRoute sends it, and so possibly in a flow of its own.
+ */
+bool CParisTraceRoute::Pingv4(const SOCKADDR_IN& destAddress, CHostTraceSingleReplyv4& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, bool bFlagReverse, const SOCKADDR_IN* pLocalAddress)
+{
+	if (m_bFlowStable)
+		return PingFlow(destAddress, htsr, nTTL, dwTimeout, wDataSize, nTOS, bDontFragment, pLocalAddress, m_wFlow);
+	return CTraceRoute::Pingv4(destAddress, htsr, nTTL, dwTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress);
+}
+
+/**
+ * @brief Sends one IPv6 probe of Tracev6
+ * @details With flow stable probing the probe goes over the shared session in the flow of the trace; otherwise
+ * it is sent like CTraceRoute sends it, and so possibly in a flow of its own.
+ */
+bool CParisTraceRoute::Pingv6(const SOCKADDR_IN6& destAddress, CHostTraceSingleReplyv6& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, bool bFlagReverse, const SOCKADDR_IN6* pLocalAddress)
+{
+	if (m_bFlowStable)
+		return PingFlow(destAddress, htsr, nTTL, dwTimeout, wDataSize, nTOS, bDontFragment, pLocalAddress, m_wFlow);
+	return CTraceRoute::Pingv6(destAddress, htsr, nTTL, dwTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress);
+}
+
+/**
+ * @brief Enumerates every path to an IPv4 destination through per flow load balancers
+ * @param destAddress The destination
+ * @param result Receives the interfaces and links found
+ * @param nHopCount The largest TTL probed
+ * @param dwTimeout Timeout of each probe in milliseconds; the ceiling when adaptive timeouts are on
+ * @param fConfidence The probability of finding every next hop of an interface, between 0 and 1 exclusive
+ * @param wDataSize Payload size of each probe in bytes, at least 2 for the flow word
+ * @param nTOS Type of service of each probe
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true if the paths were enumerated, false if it was cancelled or failed; GetLastError tells why
+ */
+bool CParisTraceRoute::EnumeratePaths(const SOCKADDR_IN& destAddress, CMultipathResult& result, UCHAR nHopCount, DWORD dwTimeout, double fConfidence, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN* pLocalAddress)
+{
+	return EnumerateT<SOCKADDR_IN, CHostTraceSingleReplyv4>(destAddress, result, nHopCount, dwTimeout, fConfidence, wDataSize, nTOS, pLocalAddress);
+}
+
+/**
+ * @brief Enumerates every path to an IPv6 destination through per flow load balancers
+ * @param destAddress The destination
+ * @param result Receives the interfaces and links found
+ * @param nHopCount The largest hop limit probed
+ * @param dwTimeout Timeout of each probe in milliseconds; the ceiling when adaptive timeouts are on
+ * @param fConfidence The probability of finding every next hop of an interface, between 0 and 1 exclusive
+ * @param wDataSize Payload size of each probe in bytes, at least 2 for the flow word
+ * @param nTOS Traffic class of each probe
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true if the paths were enumerated, false if it was cancelled or failed; GetLastError tells why
+ */
+bool CParisTraceRoute::EnumeratePaths(const SOCKADDR_IN6& destAddress, CMultipathResult& result, UCHAR nHopCount, DWORD dwTimeout, double fConfidence, WORD wDataSize, UCHAR nTOS, const SOCKADDR_IN6* pLocalAddress)
+{
+	return EnumerateT<SOCKADDR_IN6, CHostTraceSingleReplyv6>(destAddress, result, nHopCount, dwTimeout, fConfidence, wDataSize, nTOS, pLocalAddress);
+}
+
+/**
+ * @brief Checks whether a path ends at an interface
+ * @param iface The interface
+ * @return true for the destination, and for a router which reported the destination as unreachable when the
+ * trace stops at those
+ */
+bool CParisTraceRoute::IsEndOfPath(const CMultipathInterface& iface) const noexcept
+{
+	return iface.bDestination || (m_bStopOnUnreachable && IsUnreachableStatus(iface.nStatus));
+}
+
+/**
+ * @brief Records that a flow went over a link
+ * @param result The result the link belongs to
+ * @param nFrom The interface at the lower TTL
+ * @param nTo The interface at the next TTL
+ */
+void CParisTraceRoute::AddLink(CMultipathResult& result, UINT nFrom, UINT nTo)
+{
+	const ULONGLONG nKey{ (static_cast<ULONGLONG>(nFrom) << 32) | nTo };
+	const auto it{ m_LinkIndex.find(nKey) };
+	if (it != m_LinkIndex.end())
+	{
+		++result.arrLinks[it->second].nFlows;
+		return;
+	}
+	CMultipathLink link;
+	link.nFrom = nFrom;
+	link.nTo = nTo;
+	link.nFlows = 1;
+	m_LinkIndex.emplace(nKey, static_cast<UINT>(result.arrLinks.size()));
+	result.arrLinks.push_back(link);
+}
+
+/**
+ * @brief Finds or adds the interface which answered a probe
+ * @param destAddress The destination
+ * @param result The result the interface belongs to
+ * @param nTTL The TTL of the probe
+ * @param htsr The reply
+ * @param bNew Receives true if the interface was not known yet
+ * @return The index of the interface
+ */
+template <typename Address, typename Single>
+UINT CParisTraceRoute::InternInterface(const Address& destAddress, CMultipathResult& result, UCHAR nTTL, const Single& htsr, bool& bNew)
+{
+	std::vector<UINT>& arrInterfaces{ m_InterfacesByTTL[nTTL - 1] };
+	for (const UINT nInterface : arrInterfaces)
+	{
+		CMultipathInterface& iface{ result.arrInterfaces[nInterface] };
+		if (SameAddress(iface.Address, htsr.Address))
+		{
+			bNew = false;
+			iface.minRTT = (std::min)(iface.minRTT, htsr.RTT);
+			iface.maxRTT = (std::max)(iface.maxRTT, htsr.RTT);
+			iface.avgRTT = ((iface.avgRTT * iface.nFlows) + htsr.RTT) / (static_cast<ULONGLONG>(iface.nFlows) + 1);
+			++iface.nFlows;
+			return nInterface;
+		}
+	}
+
+	bNew = true;
+	CMultipathInterface iface;
+	memcpy(&iface.Address, &htsr.Address, sizeof(htsr.Address));
+	iface.nTTL = nTTL;
+	iface.nStatus = htsr.nStatus;
+	iface.bDestination = (htsr.nStatus == IP_SUCCESS) || SameAddress(iface.Address, destAddress);
+	iface.nFlows = 1;
+	iface.minRTT = htsr.RTT;
+	iface.avgRTT = htsr.RTT;
+	iface.maxRTT = htsr.RTT;
+	const UINT nInterface{ static_cast<UINT>(result.arrInterfaces.size()) };
+	result.arrInterfaces.push_back(iface);
+	arrInterfaces.push_back(nInterface);
+	return nInterface;
+}
+
+/**
+ * @brief Probes a flow at a TTL and records the interface which answered it and the links it reveals
+ * @param destAddress The destination
+ * @param result The result being built
+ * @param nFlow The flow, an index from 0
+ * @param nTTL The TTL
+ * @param dwTimeout Timeout of the probe in milliseconds; the ceiling when adaptive timeouts are on
+ * @param wDataSize Payload size in bytes
+ * @param nTOS Type of service / traffic class
+ * @param pLocalAddress The address to send the probe from, nullptr for any
+ * @param nInterface Receives the interface which answered, or SILENT
+ * @param bNew Receives true if the interface was not known yet
+ * @return true unless the probe could not be sent at all; GetLastError tells why
+ */
+template <typename Address, typename Single>
+bool CParisTraceRoute::ProbeFlow(const Address& destAddress, CMultipathResult& result, UINT nFlow, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress, UINT& nInterface, bool& bNew)
+{
+	nInterface = SILENT;
+	bNew = false;
+	CAdaptiveTimeout& hopTimeout{ m_arrHopTimeouts.at(nTTL - 1) };
+	const DWORD dwProbeTimeout{ m_bAdaptiveTimeout ? hopTimeout.GetTimeout() : dwTimeout };
+	++m_nProbesSent;
+	Single htsr{};
+	if (PingFlow(destAddress, htsr, nTTL, dwProbeTimeout, wDataSize, nTOS, false, pLocalAddress, static_cast<WORD>(m_wFlow + nFlow)))
+	{
+		hopTimeout.AddSample(htsr.RTT);
+		nInterface = InternInterface(destAddress, result, nTTL, htsr, bNew);
+	}
+	else if (GetLastError() == ERROR_TIMEOUT)
+		hopTimeout.AddLoss(dwProbeTimeout);
+	else
+		return false;
+
+	// Link the interface with the ones the flow was answered by one TTL before and after
+	FlowHop(nFlow, nTTL) = nInterface;
+	if (nInterface != SILENT)
+	{
+		if ((nTTL > 1) && (FlowHop(nFlow, nTTL - 1) < NOT_PROBED))
+			AddLink(result, FlowHop(nFlow, nTTL - 1), nInterface);
+		if ((nTTL < m_nEnumeratedHops) && (FlowHop(nFlow, nTTL + 1) < NOT_PROBED))
+			AddLink(result, nInterface, FlowHop(nFlow, nTTL + 1));
+	}
+	return true;
+}
+
+/**
+ * @brief Finds the next hops of one interface at the TTL before, to the stated confidence
+ * @param destAddress The destination
+ * @param result The result being built
+ * @param arrPrevious The interfaces at the TTL before whose next hops are wanted, NONE for the vantage point or
+ * a TTL at which nothing answered; interfaces found there meanwhile are added to it
+ * @param nPrevious The entry of arrPrevious to do
+ * @param nTTL The TTL of the next hops
+ * @param dwTimeout Timeout of each probe in milliseconds
+ * @param fConfidence The probability of finding every next hop
+ * @param wDataSize Payload size in bytes
+ * @param nTOS Type of service / traffic class
+ * @param pLocalAddress The address to send the probes from, nullptr for any
+ * @return true unless it was cancelled or a probe could not be sent
+ * @details When a single interface answered at the TTL before, every flow is taken to go through it. Otherwise
+ * new flows are sent to the TTL before until one goes through the interface; the search gives up, leaving the
+ * interface incomplete, after 8 misses for every interface at that TTL in a row, or when the flows run out.
+ */
+template <typename Address, typename Single>
+bool CParisTraceRoute::EnumerateNextHops(const Address& destAddress, CMultipathResult& result, std::vector<UINT>& arrPrevious, size_t nPrevious, UCHAR nTTL, DWORD dwTimeout, double fConfidence, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress)
+{
+	const UINT nPrevInterface{ arrPrevious[nPrevious] };
+	if ((nPrevInterface != NONE) && IsEndOfPath(result.arrInterfaces[nPrevInterface]))
+	{
+		CMultipathInterface& iface{ result.arrInterfaces[nPrevInterface] };
+		iface.bComplete = true;
+		if (iface.bDestination)
+			result.bReached = true;
+		return true;
+	}
+	const bool bAnyFlow{ (nTTL == 1) || (m_InterfacesByTTL[nTTL - 2].size() <= 1) };
+
+	std::vector<UINT> arrNextHops;
+	UINT nMisses{ 0 };
+	while (!m_bCancelled)
+	{
+		// Count the flows through the interface which were probed at this TTL, and what answered them
+		UINT nProbed{ 0 };
+		UINT nCandidate{ NONE };
+		arrNextHops.clear();
+		for (UINT nFlow{ 0 }; nFlow < m_nFlows; nFlow++)
+		{
+			const UINT nPrevHop{ (nTTL > 1) ? FlowHop(nFlow, nTTL - 1) : NOT_PROBED };
+			if ((nPrevHop != nPrevInterface) && !(bAnyFlow && (nPrevHop >= NOT_PROBED)))
+				continue;
+			const UINT nHop{ FlowHop(nFlow, nTTL) };
+			if (nHop == NOT_PROBED)
+			{
+				if (nCandidate == NONE)
+					nCandidate = nFlow;
+				continue;
+			}
+			++nProbed;
+			if ((nHop != SILENT) && (std::find(arrNextHops.begin(), arrNextHops.end(), nHop) == arrNextHops.end()))
+				arrNextHops.push_back(nHop);
+		}
+		if (nProbed >= GetStoppingPoint(static_cast<UINT>(arrNextHops.size()), fConfidence))
+		{
+			if (nPrevInterface != NONE)
+			{
+				result.arrInterfaces[nPrevInterface].bComplete = true;
+				result.arrInterfaces[nPrevInterface].nNextHops = static_cast<ULONG>(arrNextHops.size());
+			}
+			return true;
+		}
+
+		// Probe the next flow known to go through the interface, or find a new one which does
+		UINT nInterface{ SILENT };
+		bool bNew{ false };
+		if (nCandidate != NONE)
+		{
+			if (!ProbeFlow<Address, Single>(destAddress, result, nCandidate, nTTL, dwTimeout, wDataSize, nTOS, pLocalAddress, nInterface, bNew))
+				return false;
+			continue;
+		}
+		if (m_nFlows >= m_nMaxFlows)
+			break;
+		const UINT nFlow{ m_nFlows++ };
+		m_FlowHops.resize(m_FlowHops.size() + m_nEnumeratedHops, NOT_PROBED);
+		if (bAnyFlow)
+			continue;
+		if (!ProbeFlow<Address, Single>(destAddress, result, nFlow, static_cast<UCHAR>(nTTL - 1), dwTimeout, wDataSize, nTOS, pLocalAddress, nInterface, bNew))
+			return false;
+		if (bNew)
+			arrPrevious.push_back(nInterface);
+		if (nInterface == nPrevInterface)
+			nMisses = 0;
+		else if (++nMisses >= 8 * m_InterfacesByTTL[nTTL - 2].size())
+			break;
+	}
+
+	// Out of flows, or the interface is too rarely reached to get enough of them through it
+	if (nPrevInterface != NONE)
+		result.arrInterfaces[nPrevInterface].nNextHops = static_cast<ULONG>(arrNextHops.size());
+	return !m_bCancelled;
+}
+
+/**
+ * @brief Enumerates every path to a destination through per flow load balancers
+ * @details See CParisTraceRoute in ParisTraceRoute.h. The TTLs are done in order; at each of them the next
+ * hops of every interface at the TTL before are found, and the enumeration stops when every interface at a TTL
+ * ends a path, at the gap limit of TTLs at which nothing answered, or at the hop count.
+ */
+template <typename Address, typename Single>
+bool CParisTraceRoute::EnumerateT(const Address& destAddress, CMultipathResult& result, UCHAR nHopCount, DWORD dwTimeout, double fConfidence, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress)
+{
+	result = CMultipathResult{};
+	if ((nHopCount == 0) || !((fConfidence > 0.0) && (fConfidence < 1.0)) || (wDataSize < 2) || (m_nMaxFlows == 0))
+	{
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return false;
+	}
+
+	// Varying the flow of the probes needs a backend which can keep it
+	{
+		std::lock_guard<std::mutex> lock{ m_SessionMutex };
+		if (!OpenSession(destAddress, wDataSize, pLocalAddress))
+			return false;
+		if (!m_pSession->GetBackend()->SupportsFlow())
+		{
+			SetLastError(ERROR_NOT_SUPPORTED);
+			return false;
+		}
+	}
+
+	m_bCancelled = false;
+	m_nProbesSent = 0;
+	m_StopReason = StopReason::HopCount;
+	ResetHopTimeouts(nHopCount, dwTimeout);
+	m_nEnumeratedHops = nHopCount;
+	m_nFlows = 0;
+	m_FlowHops.clear();
+	m_InterfacesByTTL.assign(nHopCount, std::vector<UINT>{});
+	m_LinkIndex.clear();
+	result.fConfidence = fConfidence;
+
+	std::vector<UINT> arrPrevious{ NONE };
+	UCHAR nSilentHops{ 0 };
+	for (UCHAR nTTL{ 1 }; nTTL <= nHopCount; nTTL++)
+	{
+		result.nHops = nTTL;
+		for (size_t i{ 0 }; i < arrPrevious.size(); i++)
+		{
+			if (!EnumerateNextHops<Address, Single>(destAddress, result, arrPrevious, i, nTTL, dwTimeout, fConfidence, wDataSize, nTOS, pLocalAddress))
+			{
+				if (m_bCancelled)
+				{
+					m_StopReason = StopReason::Cancelled;
+					SetLastError(ERROR_CANCELLED);
+				}
+				result.nFlows = m_nFlows;
+				result.nProbesSent = m_nProbesSent;
+				return false;
+			}
+		}
+		result.nFlows = m_nFlows;
+		result.nProbesSent = m_nProbesSent;
+		OnHopEnumerated(nTTL, result);
+
+		// Carry on from the interfaces at this TTL which do not end a path, or from any flow if none answered
+		const std::vector<UINT>& arrInterfaces{ m_InterfacesByTTL[nTTL - 1] };
+		if (arrInterfaces.empty())
+		{
+			arrPrevious.assign(1, NONE);
+			if ((m_nGapLimit != 0) && (++nSilentHops >= m_nGapLimit))
+			{
+				m_StopReason = StopReason::GapLimit;
+				break;
+			}
+			continue;
+		}
+		nSilentHops = 0;
+		arrPrevious.clear();
+		for (const UINT nInterface : arrInterfaces)
+		{
+			CMultipathInterface& iface{ result.arrInterfaces[nInterface] };
+			if (iface.bDestination)
+				result.bReached = true;
+			if (IsEndOfPath(iface))
+				iface.bComplete = true;
+			else
+				arrPrevious.push_back(nInterface);
+		}
+		if (arrPrevious.empty())
+		{
+			m_StopReason = result.bReached ? StopReason::DestinationReached : StopReason::Unreachable;
+			break;
+		}
+	}
+
+	result.bComplete = std::all_of(result.arrInterfaces.begin(), result.arrInterfaces.end(), [](const CMultipathInterface& iface) noexcept { return iface.bComplete; });
+	return true;
+}
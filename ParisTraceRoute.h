@@ -0,0 +1,150 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ParisTraceRoute.h : interface of the CParisTraceRoute class, a traceroute which keeps the flow of its probes
+// constant so that load balancers send them all down the same path, and which can enumerate every path of a
+// load balanced route (the Multipath Detection Algorithm).
+//
+
+#pragma once
+
+#include "ping.h"
+#include "tracer.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// An interface found by CParisTraceRoute::EnumeratePaths
+struct CMultipathInterface
+{
+	SOCKADDR_STORAGE Address{};           // The address it answered from
+	UCHAR nTTL{ 0 };                      // The TTL it answered at
+	ULONG nStatus{ IP_SUCCESS };          // The IP_STATUS of its first reply e.g. IP_TTL_EXPIRED_TRANSIT, IP_SUCCESS or IP_DEST_HOST_UNREACHABLE
+	bool bDestination{ false };           // It is the destination
+	bool bComplete{ false };              // Enough flows went through it to have found all its next hops at the stated confidence
+	ULONG nFlows{ 0 };                    // Flows whose probe it answered
+	ULONG nNextHops{ 0 };                 // Interfaces found at the next TTL behind it
+	ULONGLONG minRTT{ 0 };                // Round trip times of its replies in microseconds
+	ULONGLONG avgRTT{ 0 };
+	ULONGLONG maxRTT{ 0 };
+};
+
+// A link between interfaces at consecutive TTLs, seen when the probes of one flow were answered by both
+struct CMultipathLink
+{
+	UINT nFrom{ 0 };                      // The interface at the lower TTL
+	UINT nTo{ 0 };                        // The interface at the next TTL
+	ULONG nFlows{ 0 };                    // Flows seen going over the link
+};
+
+// The result of CParisTraceRoute::EnumeratePaths
+struct CMultipathResult
+{
+	std::vector<CMultipathInterface> arrInterfaces; // The interfaces found, ordered by TTL
+	std::vector<CMultipathLink> arrLinks;           // The links found between them
+	UCHAR nHops{ 0 };                     // TTLs probed
+	ULONG nFlows{ 0 };                    // Flows used
+	ULONGLONG nProbesSent{ 0 };           // Echo requests sent
+	double fConfidence{ 0.0 };            // The probability of not missing a next hop of an interface, as asked for
+	bool bReached{ false };               // At least one path reached the destination
+	bool bComplete{ false };              // Every interface has its next hops enumerated or ends a path
+};
+
+// CParisTraceRoute: per flow load balancers send an echo request down one of several paths depending on its
+// addresses and the type, code, checksum and identifier of its ICMP header. A plain CTraceRoute gives every
+// probe a new sequence number, and concurrent probes a session of their own, so the checksum and identifier of
+// its probes change and consecutive hops of its path may come from different paths.
+//
+// With flow stable probing on, all probes of a trace go over one CPingSession whose backend keeps them in a
+// single flow (see CPingBackend::SetFlow), so Tracev4 / Tracev6 report one real path. Probes share the session,
+// so concurrent probing is serialised. The Windows ICMP API chooses the identifier and sequence number of its
+// requests itself; with it the probes only keep their identifier and data, which GetFlowControlled reports.
+//
+// EnumeratePaths implements the Multipath Detection Algorithm (Augustin, Friedman and Teixeira): every probe is
+// sent in a flow of its own choosing, and for every interface at a TTL, flows which went through it are probed
+// at the next TTL until, with k next hops found so far, n(k) of them have been sent without finding another one.
+// n(k) is the smallest n for which k + 1 equally likely next hops would all have shown up with the stated
+// confidence: 6, 11, 16, 21, 27, ... at 95%. When too few flows are known to go through an interface, new flows
+// are sent to its TTL until enough of them reach it (node control). EnumeratePaths needs a backend which
+// supports flows and fails with ERROR_NOT_SUPPORTED otherwise.
+class CParisTraceRoute : public CTraceRoute
+{
+public:
+	static const UINT NONE{ 0xFFFFFFFF };        // No interface
+
+	CParisTraceRoute();
+	CParisTraceRoute(const CParisTraceRoute&) = delete;
+	CParisTraceRoute(CParisTraceRoute&&) = delete;
+	virtual ~CParisTraceRoute() = default;
+
+	CParisTraceRoute& operator=(const CParisTraceRoute&) = delete;
+	CParisTraceRoute& operator=(CParisTraceRoute&&) = delete;
+
+	// Flow stable probing for Tracev4 / Tracev6
+	void SetFlowStable(bool bFlowStable, WORD wFlow = 0) noexcept { m_bFlowStable = bFlowStable; m_wFlow = wFlow; }
+	bool GetFlowStable() const noexcept { return m_bFlowStable; }
+	WORD GetFlow() const noexcept { return m_wFlow; }                         // The flow of the probes; EnumeratePaths counts up from it
+	bool GetFlowControlled() const noexcept { return m_bFlowControlled; }     // The backend of the last probe kept its flow
+
+	// Multipath detection
+	bool EnumeratePaths(const SOCKADDR_IN& destAddress, CMultipathResult& result, UCHAR nHopCount = 30, DWORD dwTimeout = 5000, double fConfidence = 0.95, WORD wDataSize = 32, UCHAR nTOS = 0, const SOCKADDR_IN* pLocalAddress = nullptr);
+	bool EnumeratePaths(const SOCKADDR_IN6& destAddress, CMultipathResult& result, UCHAR nHopCount = 30, DWORD dwTimeout = 5000, double fConfidence = 0.95, WORD wDataSize = 32, UCHAR nTOS = 0, const SOCKADDR_IN6* pLocalAddress = nullptr);
+	void SetMaxFlows(UINT nMaxFlows) noexcept { m_nMaxFlows = (nMaxFlows > 65536) ? 65536 : nMaxFlows; } // Flows EnumeratePaths may use
+	UINT GetMaxFlows() const noexcept { return m_nMaxFlows; }
+	void Cancel() noexcept { m_bCancelled = true; }                           // Stops after the current probe; safe to call from any thread
+	static UINT GetStoppingPoint(UINT nNextHops, double fConfidence) noexcept; // n(k) for k next hops found
+
+protected:
+	static const UINT SILENT{ 0xFFFFFFFE };      // The probe of a flow at a TTL was not answered
+	static const UINT NOT_PROBED{ 0xFFFFFFFD };  // A flow was not probed at a TTL
+
+	// Called on the thread which called EnumeratePaths when the interfaces at a TTL are known
+	virtual void OnHopEnumerated(UCHAR /*nTTL*/, const CMultipathResult& /*result*/) {}
+
+	bool Pingv4(const SOCKADDR_IN& destAddress, CHostTraceSingleReplyv4& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, bool bFlagReverse, const SOCKADDR_IN* pLocalAddress) override;
+	bool Pingv6(const SOCKADDR_IN6& destAddress, CHostTraceSingleReplyv6& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, bool bFlagReverse, const SOCKADDR_IN6* pLocalAddress) override;
+	bool PingFlow(const SOCKADDR_IN& destAddress, CHostTraceSingleReplyv4& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, const SOCKADDR_IN* pLocalAddress, WORD wFlow);
+	bool PingFlow(const SOCKADDR_IN6& destAddress, CHostTraceSingleReplyv6& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, const SOCKADDR_IN6* pLocalAddress, WORD wFlow);
+	bool OpenSession(const SOCKADDR_IN& destAddress, WORD wDataSize, const SOCKADDR_IN* pLocalAddress);
+	bool OpenSession(const SOCKADDR_IN6& destAddress, WORD wDataSize, const SOCKADDR_IN6* pLocalAddress);
+
+	template <typename Address, typename Single>
+	bool EnumerateT(const Address& destAddress, CMultipathResult& result, UCHAR nHopCount, DWORD dwTimeout, double fConfidence, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress);
+	template <typename Address, typename Single>
+	bool EnumerateNextHops(const Address& destAddress, CMultipathResult& result, std::vector<UINT>& arrPrevious, size_t nPrevious, UCHAR nTTL, DWORD dwTimeout, double fConfidence, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress);
+	template <typename Address, typename Single>
+	bool ProbeFlow(const Address& destAddress, CMultipathResult& result, UINT nFlow, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, const Address* pLocalAddress, UINT& nInterface, bool& bNew);
+	template <typename Address, typename Single>
+	UINT InternInterface(const Address& destAddress, CMultipathResult& result, UCHAR nTTL, const Single& htsr, bool& bNew);
+	void AddLink(CMultipathResult& result, UINT nFrom, UINT nTo);
+	UINT& FlowHop(UINT nFlow, UCHAR nTTL) { return m_FlowHops[(static_cast<size_t>(nFlow) * m_nEnumeratedHops) + nTTL - 1]; }
+	bool IsEndOfPath(const CMultipathInterface& iface) const noexcept;
+
+	bool m_bFlowStable;                                 // Should Tracev4 / Tracev6 keep their probes in one flow
+	WORD m_wFlow;                                       // The flow of their probes
+	bool m_bFlowControlled;                             // The backend of the last probe kept its flow
+	UINT m_nMaxFlows;                                   // The most flows EnumeratePaths may use
+	std::mutex m_SessionMutex;                          // Serialises the probes which go over m_pSession
+	std::unique_ptr<CPingSession> m_pSession;           // The session of the flow stable probes, kept open between traces to the same destination
+	SOCKADDR_STORAGE m_SessionLocalAddress;             // The local address m_pSession was opened with, family AF_UNSPEC for none
+	CPingReplyv4 m_Replyv4;                             // Scratch space of PingFlow
+	CPingReplyv6 m_Replyv6;
+	UCHAR m_nEnumeratedHops;                            // The hop count of the running EnumeratePaths
+	UINT m_nFlows;                                      // The flows it has used
+	std::vector<UINT> m_FlowHops;                       // The interface which answered each flow at each TTL, SILENT or NOT_PROBED
+	std::vector<std::vector<UINT>> m_InterfacesByTTL;   // The interfaces found at each TTL
+	std::unordered_map<ULONGLONG, UINT> m_LinkIndex;    // From interface << 32 | to interface -> link
+};
@@ -0,0 +1,171 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// PosixCompat.h : the subset of Win32 / ATL / IP Helper types used by the probe engine
+// (ping.h, tracer.h and friends), so that the engine compiles unchanged on Linux.
+// Only included from pch.h when _WIN32 is not defined.
+//
+
+#pragma once
+
+#ifdef _WIN32
+#error "PosixCompat.h is only meant for non Windows builds"
+#endif
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+// Basic Win32 types
+using BYTE = std::uint8_t;
+using UCHAR = std::uint8_t;
+using WORD = std::uint16_t;
+using USHORT = std::uint16_t;
+using DWORD = std::uint32_t;
+using ULONG = std::uint32_t;
+using UINT = unsigned int;
+using ULONGLONG = std::uint64_t;
+using LONGLONG = std::int64_t;
+using ULONG_PTR = std::uintptr_t;
+using TCHAR = char;
+using LPTSTR = char*;
+using LPCTSTR = const char*;
+using IPAddr = std::uint32_t;
+using IP_STATUS = ULONG;
+
+#ifndef _T
+#define _T(x) x
+#endif
+#define _tcslen strlen
+
+// SAL annotations and MSVC attributes
+#define _In_
+#define _In_z_
+#define _In_opt_
+#define _In_opt_z_
+#define _Inout_
+#define _Out_
+#define _Out_opt_
+#define _In_reads_bytes_(size)
+#define _Out_writes_bytes_(size)
+#define _Inout_updates_bytes_(size)
+#define _Out_writes_z_(size)
+#define _NODISCARD [[nodiscard]]
+#define ATLASSERT(expr) assert(expr)
+#define ATLASSUME(expr) assert(expr)
+
+// Socket address types
+using SOCKADDR = sockaddr;
+using SOCKADDR_IN = sockaddr_in;
+using SOCKADDR_IN6 = sockaddr_in6;
+using SOCKADDR_STORAGE = sockaddr_storage;
+using ADDRINFOT = addrinfo;
+#define SS_PORT(ssp) (reinterpret_cast<const sockaddr_in*>(ssp)->sin_port)
+
+// Win32 error codes reported via GetLastError
+#define ERROR_SUCCESS 0
+#define ERROR_INVALID_HANDLE 6
+#define ERROR_NOT_ENOUGH_MEMORY 8
+#define ERROR_NOT_SUPPORTED 50
+#define ERROR_INVALID_PARAMETER 87
+#define ERROR_OPEN_FAILED 110
+#define ERROR_CANCELLED 1223
+#define ERROR_TIMEOUT 1460
+
+// The per thread last error value, mirroring the Win32 semantics
+inline DWORD& LastErrorValue() noexcept
+{
+	thread_local DWORD dwLastError{ ERROR_SUCCESS };
+	return dwLastError;
+}
+inline DWORD GetLastError() noexcept { return LastErrorValue(); }
+inline void SetLastError(DWORD dwError) noexcept { LastErrorValue() = dwError; }
+
+inline int memcpy_s(void* pDest, size_t nDestSize, const void* pSrc, size_t nCount) noexcept
+{
+	if (nCount > nDestSize)
+		return EINVAL;
+	memcpy(pDest, pSrc, nCount);
+	return 0;
+}
+
+// IP Helper status codes (ipexport.h)
+#define IP_SUCCESS 0
+#define IP_STATUS_BASE 11000
+#define IP_BUF_TOO_SMALL (IP_STATUS_BASE + 1)
+#define IP_DEST_NET_UNREACHABLE (IP_STATUS_BASE + 2)
+#define IP_DEST_HOST_UNREACHABLE (IP_STATUS_BASE + 3)
+#define IP_DEST_PROT_UNREACHABLE (IP_STATUS_BASE + 4)
+#define IP_DEST_PORT_UNREACHABLE (IP_STATUS_BASE + 5)
+#define IP_NO_RESOURCES (IP_STATUS_BASE + 6)
+#define IP_PACKET_TOO_BIG (IP_STATUS_BASE + 9)
+#define IP_REQ_TIMED_OUT (IP_STATUS_BASE + 10)
+#define IP_BAD_ROUTE (IP_STATUS_BASE + 12)
+#define IP_TTL_EXPIRED_TRANSIT (IP_STATUS_BASE + 13)
+#define IP_TTL_EXPIRED_REASSEM (IP_STATUS_BASE + 14)
+#define IP_PARAM_PROBLEM (IP_STATUS_BASE + 15)
+#define IP_SOURCE_QUENCH (IP_STATUS_BASE + 16)
+#define IP_DEST_NO_ROUTE (IP_STATUS_BASE + 2)
+#define IP_DEST_ADDR_UNREACHABLE (IP_STATUS_BASE + 3)
+#define IP_DEST_PROHIBITED (IP_STATUS_BASE + 4)
+#define IP_HOP_LIMIT_EXCEEDED (IP_STATUS_BASE + 13)
+#define IP_GENERAL_FAILURE (IP_STATUS_BASE + 50)
+
+#define IP_FLAG_REVERSE 0x1
+#define IP_FLAG_DF 0x2
+
+// ICMP API structures (ipexport.h)
+struct IP_OPTION_INFORMATION
+{
+	UCHAR Ttl;
+	UCHAR Tos;
+	UCHAR Flags;
+	UCHAR OptionsSize;
+	UCHAR* OptionsData;
+};
+
+struct ICMP_ECHO_REPLY
+{
+	IPAddr Address;
+	ULONG Status;
+	ULONG RoundTripTime;
+	USHORT DataSize;
+	USHORT Reserved;
+	void* Data;
+	IP_OPTION_INFORMATION Options;
+};
+
+struct IPV6_ADDRESS_EX
+{
+	USHORT sin6_port;
+	ULONG sin6_flowinfo;
+	USHORT sin6_addr[8];
+	ULONG sin6_scope_id;
+};
+
+struct ICMPV6_ECHO_REPLY
+{
+	IPV6_ADDRESS_EX Address;
+	ULONG Status;
+	unsigned int RoundTripTime;
+};
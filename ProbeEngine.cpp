@@ -0,0 +1,733 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ProbeEngine.cpp : implementation of the CProbeEngine class
+//
+
+#include "pch.h"
+#include "ProbeEngine.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <linux/errqueue.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#endif //#ifndef _WIN32
+
+/**
+ * @brief The per request state kept while a request is in flight
+ * @details Instances are pooled by the engine so that steady state operation does not allocate
+ */
+struct CProbeEngine::CPendingProbe
+{
+	CProbeEngine* pEngine{ nullptr };    // The owning engine (needed by the APC routine)
+	CProbeRequest request;               // The request being serviced
+	ULONG nGeneration{ 0 };              // Incremented every time the slot is recycled
+	ULONGLONG nSendTime{ 0 };            // Monotonic time in microseconds when the request was sent
+#ifdef _WIN32
+	std::vector<BYTE> RequestData;       // The echo request payload
+	std::vector<BYTE> Reply;             // The reply buffer handed to IcmpSendEcho2Ex / Icmp6SendEcho2
+#else
+	WORD wSequence{ 0 };                 // The ICMP sequence number used for the request
+	bool bInFlight{ false };             // Is the request registered in m_InFlight
+#endif //#ifdef _WIN32
+};
+
+/**
+ * @brief Default constructor for CProbeEngine
+ */
+CProbeEngine::CProbeEngine() noexcept :
+	m_bRunning{ false },
+	m_nOutstanding{ 0 },
+	m_LocalAddress{},
+#ifdef _WIN32
+	m_hIcmpv4{ INVALID_HANDLE_VALUE },
+	m_hIcmpv6{ INVALID_HANDLE_VALUE },
+	m_hWakeEvent{ nullptr }
+#else
+	m_nSocketv4{ -1 },
+	m_nSocketv6{ -1 },
+	m_nEpoll{ -1 },
+	m_nWakeFd{ -1 },
+	m_nLastTTL{ -1, -1 },
+	m_nLastTOS{ -1, -1 },
+	m_nLastDF{ -1, -1 },
+	m_wNextSequence{ 1, 1 }
+#endif //#ifdef _WIN32
+{
+}
+
+/**
+ * @brief Destructor for CProbeEngine; stops the worker thread if it is still running
+ */
+CProbeEngine::~CProbeEngine()
+{
+	Stop();
+}
+
+/**
+ * @brief Sets the local address the requests of its family are sent from
+ * @param address An IPv4 or IPv6 address of this host; an address of another family is ignored
+ * @details Takes effect at the next Start; by default the requests of both families are sent from any address.
+ */
+void CProbeEngine::SetLocalAddress(const SOCKADDR_STORAGE& address) noexcept
+{
+	if ((address.ss_family == AF_INET) || (address.ss_family == AF_INET6))
+		m_LocalAddress[(address.ss_family == AF_INET6) ? 1 : 0] = address;
+}
+
+/**
+ * @brief Creates the ICMP handles / sockets and starts the worker thread
+ * @param callback Function called on the worker thread for each completion, or empty to queue completions
+ * @return true if the engine was started
+ */
+bool CProbeEngine::Start(CompletionCallback callback)
+{
+	if (m_bRunning)
+		return true;
+	m_Callback = std::move(callback);
+
+#ifdef _WIN32
+	// IPv6 may not be installed, so only fail if neither family is available
+	m_hIcmpv4 = IcmpCreateFile();
+	m_hIcmpv6 = Icmp6CreateFile();
+	if ((m_hIcmpv4 == INVALID_HANDLE_VALUE) && (m_hIcmpv6 == INVALID_HANDLE_VALUE))
+		return false;
+	m_hWakeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_hWakeEvent == nullptr)
+	{
+		Stop();
+		return false;
+	}
+#else
+	// Non-blocking unprivileged ICMP sockets, reporting ICMP errors on the error queue. The receive buffer
+	// is enlarged because a burst of submissions can produce replies faster than the worker drains them
+	const int nOn{ 1 };
+	const int nReceiveBuffer{ 4 * 1024 * 1024 };
+	m_nSocketv4 = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_ICMP);
+	if (m_nSocketv4 != -1)
+	{
+		setsockopt(m_nSocketv4, SOL_IP, IP_RECVERR, &nOn, sizeof(nOn));
+		setsockopt(m_nSocketv4, SOL_SOCKET, SO_RCVBUF, &nReceiveBuffer, sizeof(nReceiveBuffer));
+	}
+	m_nSocketv6 = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_ICMPV6);
+	if (m_nSocketv6 != -1)
+	{
+		setsockopt(m_nSocketv6, SOL_IPV6, IPV6_RECVERR, &nOn, sizeof(nOn));
+		setsockopt(m_nSocketv6, SOL_SOCKET, SO_RCVBUF, &nReceiveBuffer, sizeof(nReceiveBuffer));
+	}
+	if ((m_nSocketv4 == -1) && (m_nSocketv6 == -1))
+	{
+		SetLastError(static_cast<DWORD>(errno));
+		return false;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		const int nSocket{ (i == 1) ? m_nSocketv6 : m_nSocketv4 };
+		if ((nSocket == -1) || (m_LocalAddress[i].ss_family == AF_UNSPEC))
+			continue;
+#pragma warning(suppress: 26490)
+		if (bind(nSocket, reinterpret_cast<const sockaddr*>(&m_LocalAddress[i]), (i == 1) ? sizeof(sockaddr_in6) : sizeof(sockaddr_in)) == -1)
+		{
+			SetLastError(static_cast<DWORD>(errno));
+			Stop();
+			return false;
+		}
+	}
+	m_nEpoll = epoll_create1(0);
+	m_nWakeFd = eventfd(0, EFD_NONBLOCK);
+	if ((m_nEpoll == -1) || (m_nWakeFd == -1))
+	{
+		SetLastError(static_cast<DWORD>(errno));
+		Stop();
+		return false;
+	}
+	// The event data identifies the descriptor: 0 = IPv4 socket, 1 = IPv6 socket, 2 = wake descriptor
+	const int arrDescriptors[3]{ m_nSocketv4, m_nSocketv6, m_nWakeFd };
+	for (UINT i = 0; i < 3; i++)
+	{
+		if (arrDescriptors[i] == -1)
+			continue;
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.u32 = i;
+		epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, arrDescriptors[i], &event);
+	}
+	// Sequence numbers index the in flight table, so it covers the whole 16 bit space
+	m_InFlight[0].assign(0x10000, nullptr);
+	m_InFlight[1].assign(0x10000, nullptr);
+	m_SendBuf.reserve(0x10000 + 8);
+	m_RecvBuf.resize(0x10000 + 8);
+#endif //#ifdef _WIN32
+
+	m_bRunning = true;
+	m_Worker = std::thread{ &CProbeEngine::WorkerThread, this };
+	return true;
+}
+
+/**
+ * @brief Stops the worker thread and releases the handles / sockets
+ * @details Requests which were not yet sent complete with ERROR_CANCELLED. On Windows the requests already
+ * issued to the ICMP driver are allowed to run to their timeout because their buffers are still in use.
+ */
+void CProbeEngine::Stop()
+{
+	if (m_bRunning)
+	{
+		m_bRunning = false;
+		Wake();
+	}
+	if (m_Worker.joinable())
+		m_Worker.join();
+
+#ifdef _WIN32
+	if (m_hIcmpv4 != INVALID_HANDLE_VALUE)
+		IcmpCloseHandle(m_hIcmpv4);
+	if (m_hIcmpv6 != INVALID_HANDLE_VALUE)
+		IcmpCloseHandle(m_hIcmpv6);
+	if (m_hWakeEvent != nullptr)
+		CloseHandle(m_hWakeEvent);
+	m_hIcmpv4 = INVALID_HANDLE_VALUE;
+	m_hIcmpv6 = INVALID_HANDLE_VALUE;
+	m_hWakeEvent = nullptr;
+#else
+	for (int* pDescriptor : { &m_nSocketv4, &m_nSocketv6, &m_nEpoll, &m_nWakeFd })
+	{
+		if (*pDescriptor != -1)
+			close(*pDescriptor);
+		*pDescriptor = -1;
+	}
+	m_Deadlines = decltype(m_Deadlines){};
+	for (int i = 0; i < 2; i++)
+	{
+		m_nLastTTL[i] = -1;
+		m_nLastTOS[i] = -1;
+		m_nLastDF[i] = -1;
+	}
+#endif //#ifdef _WIN32
+}
+
+/**
+ * @brief Queues a request for the worker thread
+ * @param request The request to send
+ * @return true if the request was queued, false if the engine is not running
+ */
+bool CProbeEngine::Submit(const CProbeRequest& request)
+{
+	if (!m_bRunning)
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_Submitted.push_back(request);
+		++m_nOutstanding;
+	}
+	Wake();
+	return true;
+}
+
+/**
+ * @brief Dequeues the next completion when the engine was started without a callback
+ * @param completion Receives the completion
+ * @param dwTimeout Maximum time to wait in milliseconds
+ * @return true if a completion was dequeued
+ */
+bool CProbeEngine::GetCompletion(CProbeCompletion& completion, DWORD dwTimeout)
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	if (!m_CompletedEvent.wait_for(lock, std::chrono::milliseconds{ dwTimeout }, [this]() { return !m_Completed.empty(); }))
+		return false;
+	completion = m_Completed.front();
+	m_Completed.pop_front();
+	return true;
+}
+
+/**
+ * @brief Waits until every submitted request has completed
+ * @param dwTimeout Maximum time to wait in milliseconds
+ * @return true if the engine is idle
+ */
+bool CProbeEngine::WaitForIdle(DWORD dwTimeout)
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	return m_CompletedEvent.wait_for(lock, std::chrono::milliseconds{ dwTimeout }, [this]() { return m_nOutstanding == 0; });
+}
+
+/**
+ * @brief Wakes the worker thread so that it picks up new requests or notices a stop request
+ */
+void CProbeEngine::Wake() noexcept
+{
+#ifdef _WIN32
+	if (m_hWakeEvent != nullptr)
+		SetEvent(m_hWakeEvent);
+#else
+	if (m_nWakeFd != -1)
+	{
+		const uint64_t nValue{ 1 };
+		const ssize_t nWritten{ write(m_nWakeFd, &nValue, sizeof(nValue)) };
+		(void)nWritten;
+	}
+#endif //#ifdef _WIN32
+}
+
+/**
+ * @brief Takes a request slot from the pool, growing the pool if needed
+ * @return The slot; only ever called on the worker thread
+ */
+CProbeEngine::CPendingProbe* CProbeEngine::AllocateProbe()
+{
+	if (m_FreeProbes.empty())
+	{
+		m_Probes.push_back(std::make_unique<CPendingProbe>());
+		m_Probes.back()->pEngine = this;
+		return m_Probes.back().get();
+	}
+	CPendingProbe* pProbe{ m_FreeProbes.back() };
+	m_FreeProbes.pop_back();
+	return pProbe;
+}
+
+/**
+ * @brief Returns a request slot to the pool
+ * @param pProbe The slot to recycle
+ */
+void CProbeEngine::FreeProbe(CPendingProbe* pProbe) noexcept
+{
+	++pProbe->nGeneration;
+	m_FreeProbes.push_back(pProbe);
+}
+
+/**
+ * @brief Reports the outcome of a request and recycles its slot
+ * @param probe The request which completed
+ * @param dwError ERROR_SUCCESS if a reply arrived, otherwise the error
+ * @param nStatus The IP_STATUS of the reply
+ * @param pReplier The address of the host which replied, or nullptr
+ * @param nRTT Round trip time in microseconds
+ */
+void CProbeEngine::Complete(CPendingProbe& probe, DWORD dwError, ULONG nStatus, const SOCKADDR* pReplier, ULONGLONG nRTT)
+{
+	CProbeCompletion completion;
+	completion.nCookie = probe.request.nCookie;
+	completion.nFamily = probe.request.nFamily;
+	completion.nTTL = probe.request.nTTL;
+	completion.dwError = dwError;
+	completion.nStatus = nStatus;
+	completion.RTT = nRTT;
+	if (pReplier != nullptr)
+		memcpy(&completion.Replier, pReplier, (pReplier->sa_family == AF_INET6) ? sizeof(SOCKADDR_IN6) : sizeof(SOCKADDR_IN));
+	FreeProbe(&probe);
+
+	if (m_Callback)
+	{
+		m_Callback(completion);
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		--m_nOutstanding;
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_Completed.push_back(completion);
+		--m_nOutstanding;
+	}
+	m_CompletedEvent.notify_all();
+}
+
+/**
+ * @brief The worker thread: issues submitted requests and services their completions
+ */
+void CProbeEngine::WorkerThread()
+{
+	while (m_bRunning)
+	{
+		// Issue everything which was submitted since we last looked
+		for (;;)
+		{
+			CProbeRequest request;
+			{
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				if (m_Submitted.empty())
+					break;
+				request = m_Submitted.front();
+				m_Submitted.pop_front();
+			}
+			CPendingProbe* pProbe{ AllocateProbe() };
+			pProbe->request = request;
+			SendProbe(*pProbe);
+		}
+
+#ifdef _WIN32
+		// An alertable wait, which is where the ICMP completion APCs get delivered
+		WaitForSingleObjectEx(m_hWakeEvent, INFINITE, TRUE);
+#else
+		epoll_event events[64];
+		const int nEvents{ epoll_wait(m_nEpoll, events, 64, GetWaitTimeout()) };
+		for (int i = 0; i < nEvents; i++)
+		{
+			const uint32_t nIndex{ events[i].data.u32 };
+			if (nIndex == 2)
+			{
+				uint64_t nValue{ 0 };
+				const ssize_t nRead{ read(m_nWakeFd, &nValue, sizeof(nValue)) };
+				(void)nRead;
+				continue;
+			}
+			const int nFamily{ (nIndex == 1) ? AF_INET6 : AF_INET };
+			if (events[i].events & EPOLLERR)
+				ReadReplies(nFamily, true);
+			if (events[i].events & EPOLLIN)
+				ReadReplies(nFamily, false);
+		}
+		ExpireTimeouts();
+#endif //#ifdef _WIN32
+	}
+
+	// Cancel whatever was never sent
+	std::deque<CProbeRequest> cancelled;
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		cancelled.swap(m_Submitted);
+	}
+	for (const auto& request : cancelled)
+	{
+		CPendingProbe* pProbe{ AllocateProbe() };
+		pProbe->request = request;
+		Complete(*pProbe, ERROR_CANCELLED, IP_SUCCESS, nullptr, 0);
+	}
+
+#ifdef _WIN32
+	// The ICMP driver still owns the buffers of the requests in flight, so wait for their APCs
+	while (m_nOutstanding > 0)
+		SleepEx(100, TRUE);
+#else
+	for (int i = 0; i < 2; i++)
+	{
+		for (auto& pProbe : m_InFlight[i])
+		{
+			if (pProbe != nullptr)
+			{
+				CPendingProbe* pCancelled{ pProbe };
+				pProbe = nullptr;
+				pCancelled->bInFlight = false;
+				Complete(*pCancelled, ERROR_CANCELLED, IP_SUCCESS, nullptr, 0);
+			}
+		}
+	}
+#endif //#ifdef _WIN32
+}
+
+#ifdef _WIN32
+/**
+ * @brief Sends a request through the ICMP API with an APC completion routine
+ * @param probe The request to send
+ */
+void CProbeEngine::SendProbe(CPendingProbe& probe)
+{
+	const CProbeRequest& request{ probe.request };
+	HANDLE hIcmp{ (request.nFamily == AF_INET6) ? m_hIcmpv6 : m_hIcmpv4 };
+	if (hIcmp == INVALID_HANDLE_VALUE)
+	{
+		Complete(probe, ERROR_INVALID_HANDLE, IP_GENERAL_FAILURE, nullptr, 0);
+		return;
+	}
+
+	// The reply buffer must also have room for the IO_STATUS_BLOCK used by the asynchronous API
+	probe.RequestData.resize(request.wDataSize);
+	memset(probe.RequestData.data(), 'E', request.wDataSize);
+	const size_t nHeader{ (request.nFamily == AF_INET6) ? sizeof(ICMPV6_ECHO_REPLY) : sizeof(ICMP_ECHO_REPLY) };
+	probe.Reply.resize(nHeader + request.wDataSize + 8 + 2 * sizeof(void*) + 16);
+
+	IP_OPTION_INFORMATION OptionInfo{};
+	OptionInfo.Ttl = request.nTTL;
+	OptionInfo.Tos = request.nTOS;
+	if (request.bDontFragment)
+		OptionInfo.Flags = IP_FLAG_DF;
+
+#pragma warning(suppress: 26490)
+	const FARPROC pApcRoutine{ reinterpret_cast<FARPROC>(&CProbeEngine::OnIcmpApc) };
+	DWORD dwResult{ 0 };
+	probe.nSendTime = CPingClock::NowMicroseconds();
+	if (request.nFamily == AF_INET6)
+	{
+		SOCKADDR_IN6 SrcAddress{};
+		SrcAddress.sin6_family = AF_INET6;
+		SrcAddress.sin6_addr = in6addr_any;
+		if (m_LocalAddress[1].ss_family == AF_INET6)
+#pragma warning(suppress: 26490)
+			SrcAddress.sin6_addr = reinterpret_cast<const SOCKADDR_IN6*>(&m_LocalAddress[1])->sin6_addr;
+#pragma warning(suppress: 26490)
+		SOCKADDR_IN6 DestAddress{ *reinterpret_cast<const SOCKADDR_IN6*>(&request.Address) };
+#pragma warning(suppress: 26472)
+		dwResult = Icmp6SendEcho2(hIcmp, nullptr, pApcRoutine, &probe, &SrcAddress, &DestAddress, probe.RequestData.data(), request.wDataSize, &OptionInfo, probe.Reply.data(), static_cast<DWORD>(probe.Reply.size()), request.dwTimeout);
+	}
+	else
+	{
+#pragma warning(suppress: 26490)
+		const IPAddr DestAddress{ reinterpret_cast<const SOCKADDR_IN*>(&request.Address)->sin_addr.s_addr };
+#pragma warning(suppress: 26490)
+		const IPAddr SrcAddress{ (m_LocalAddress[0].ss_family == AF_INET) ? reinterpret_cast<const SOCKADDR_IN*>(&m_LocalAddress[0])->sin_addr.s_addr : INADDR_ANY };
+#pragma warning(suppress: 26472)
+		dwResult = IcmpSendEcho2Ex(hIcmp, nullptr, pApcRoutine, &probe, SrcAddress, DestAddress, probe.RequestData.data(), request.wDataSize, &OptionInfo, probe.Reply.data(), static_cast<DWORD>(probe.Reply.size()), request.dwTimeout);
+	}
+
+	// ERROR_IO_PENDING means the APC will be delivered later
+	if (dwResult == 0)
+	{
+		const DWORD dwError{ GetLastError() };
+		if (dwError != ERROR_IO_PENDING)
+			Complete(probe, dwError, IP_GENERAL_FAILURE, nullptr, 0);
+	}
+}
+
+/**
+ * @brief The APC routine which the ICMP API calls on the worker thread when a request completes
+ * @param pApcContext The CPendingProbe of the request
+ */
+VOID NTAPI CProbeEngine::OnIcmpApc(PVOID pApcContext, PVOID /*pIoStatusBlock*/, ULONG /*nReserved*/)
+{
+	auto pProbe{ static_cast<CPendingProbe*>(pApcContext) };
+	pProbe->pEngine->CompleteIcmpProbe(*pProbe);
+}
+
+/**
+ * @brief Parses the reply buffer of a completed request and reports it
+ * @param probe The request which completed
+ */
+void CProbeEngine::CompleteIcmpProbe(CPendingProbe& probe)
+{
+#pragma warning(suppress: 26472)
+	const DWORD dwReplySize{ static_cast<DWORD>(probe.Reply.size()) };
+	const ULONGLONG nElapsed{ CPingClock::NowMicroseconds() - probe.nSendTime };
+	if (probe.request.nFamily == AF_INET6)
+	{
+		Icmp6ParseReplies(probe.Reply.data(), dwReplySize);
+#pragma warning(suppress: 26490)
+		const auto pEchoReply{ reinterpret_cast<const ICMPV6_ECHO_REPLY*>(probe.Reply.data()) };
+		if (pEchoReply->Status == IP_REQ_TIMED_OUT)
+		{
+			Complete(probe, ERROR_TIMEOUT, pEchoReply->Status, nullptr, 0);
+			return;
+		}
+		SOCKADDR_IN6 replier{};
+		replier.sin6_family = AF_INET6;
+		replier.sin6_port = pEchoReply->Address.sin6_port;
+		replier.sin6_flowinfo = pEchoReply->Address.sin6_flowinfo;
+		memcpy_s(&replier.sin6_addr, sizeof(replier.sin6_addr), pEchoReply->Address.sin6_addr, sizeof(pEchoReply->Address.sin6_addr));
+		replier.sin6_scope_id = pEchoReply->Address.sin6_scope_id;
+#pragma warning(suppress: 26490)
+		Complete(probe, ERROR_SUCCESS, pEchoReply->Status, reinterpret_cast<const SOCKADDR*>(&replier), CPingClock::ReconcileRTT(nElapsed, pEchoReply->RoundTripTime));
+	}
+	else
+	{
+		IcmpParseReplies(probe.Reply.data(), dwReplySize);
+#pragma warning(suppress: 26490)
+		const auto pEchoReply{ reinterpret_cast<const ICMP_ECHO_REPLY*>(probe.Reply.data()) };
+		if (pEchoReply->Status == IP_REQ_TIMED_OUT)
+		{
+			Complete(probe, ERROR_TIMEOUT, pEchoReply->Status, nullptr, 0);
+			return;
+		}
+		SOCKADDR_IN replier{};
+		replier.sin_family = AF_INET;
+		replier.sin_addr.s_addr = pEchoReply->Address;
+#pragma warning(suppress: 26490)
+		Complete(probe, ERROR_SUCCESS, pEchoReply->Status, reinterpret_cast<const SOCKADDR*>(&replier), CPingClock::ReconcileRTT(nElapsed, pEchoReply->RoundTripTime));
+	}
+}
+#else
+/**
+ * @brief Sends a request on the non-blocking socket of its family and registers its timeout
+ * @param probe The request to send
+ */
+void CProbeEngine::SendProbe(CPendingProbe& probe)
+{
+	const CProbeRequest& request{ probe.request };
+	const int nIndex{ (request.nFamily == AF_INET6) ? 1 : 0 };
+	const int nSocket{ GetSocket(request.nFamily) };
+	if (nSocket == -1)
+	{
+		Complete(probe, ERROR_INVALID_HANDLE, IP_GENERAL_FAILURE, nullptr, 0);
+		return;
+	}
+
+	// Find a free sequence number, which is how replies are matched back to their request
+	std::vector<CPendingProbe*>& inFlight{ m_InFlight[nIndex] };
+	bool bFound{ false };
+	for (UINT i = 0; (i < 0x10000) && !bFound; i++)
+	{
+		probe.wSequence = m_wNextSequence[nIndex]++;
+		bFound = (inFlight[probe.wSequence] == nullptr);
+	}
+	if (!bFound)
+	{
+		Complete(probe, ERROR_NOT_ENOUGH_MEMORY, IP_NO_RESOURCES, nullptr, 0);
+		return;
+	}
+
+	// Only touch the socket options when they change from the previous request
+	const int nTTL{ request.nTTL };
+	if (nTTL != m_nLastTTL[nIndex])
+	{
+		if (nIndex == 1)
+			setsockopt(nSocket, SOL_IPV6, IPV6_UNICAST_HOPS, &nTTL, sizeof(nTTL));
+		else
+			setsockopt(nSocket, SOL_IP, IP_TTL, &nTTL, sizeof(nTTL));
+		m_nLastTTL[nIndex] = nTTL;
+	}
+	const int nTOS{ request.nTOS };
+	if (nTOS != m_nLastTOS[nIndex])
+	{
+		if (nIndex == 1)
+			setsockopt(nSocket, SOL_IPV6, IPV6_TCLASS, &nTOS, sizeof(nTOS));
+		else
+			setsockopt(nSocket, SOL_IP, IP_TOS, &nTOS, sizeof(nTOS));
+		m_nLastTOS[nIndex] = nTOS;
+	}
+	const int nDF{ request.bDontFragment ? 1 : 0 };
+	if (nDF != m_nLastDF[nIndex])
+	{
+		const int nMode{ nDF ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT };
+		if (nIndex == 1)
+			setsockopt(nSocket, SOL_IPV6, IPV6_MTU_DISCOVER, &nMode, sizeof(nMode));
+		else
+			setsockopt(nSocket, SOL_IP, IP_MTU_DISCOVER, &nMode, sizeof(nMode));
+		m_nLastDF[nIndex] = nDF;
+	}
+
+	// Form the echo request; the kernel fills in the identifier and checksum
+	m_SendBuf.resize(static_cast<size_t>(8) + request.wDataSize);
+	BYTE* pPacket{ m_SendBuf.data() };
+	memset(pPacket, 0, 8);
+	pPacket[0] = (nIndex == 1) ? ICMP6_ECHO_REQUEST : ICMP_ECHO;
+	const WORD wSequence{ htons(probe.wSequence) };
+	memcpy(pPacket + 6, &wSequence, sizeof(wSequence));
+	memset(pPacket + 8, 'E', request.wDataSize);
+
+	const socklen_t nAddressLen{ (nIndex == 1) ? static_cast<socklen_t>(sizeof(SOCKADDR_IN6)) : static_cast<socklen_t>(sizeof(SOCKADDR_IN)) };
+	probe.nSendTime = CPingClock::NowMicroseconds();
+	if (sendto(nSocket, pPacket, m_SendBuf.size(), MSG_DONTWAIT, reinterpret_cast<const SOCKADDR*>(&request.Address), nAddressLen) == -1)
+	{
+		Complete(probe, static_cast<DWORD>(errno), IP_GENERAL_FAILURE, nullptr, 0);
+		return;
+	}
+
+	inFlight[probe.wSequence] = &probe;
+	probe.bInFlight = true;
+	m_Deadlines.push(CDeadline{ probe.nSendTime + (static_cast<ULONGLONG>(request.dwTimeout) * 1000ULL), &probe, probe.nGeneration });
+}
+
+/**
+ * @brief Drains the echo replies (or the ICMP errors on the error queue) of one socket
+ * @param nFamily The family of the socket to read
+ * @param bErrorQueue true to read the error queue
+ */
+void CProbeEngine::ReadReplies(int nFamily, bool bErrorQueue)
+{
+	const int nIndex{ (nFamily == AF_INET6) ? 1 : 0 };
+	const int nSocket{ GetSocket(nFamily) };
+	const BYTE nExpectedType{ (nIndex == 1) ? (bErrorQueue ? BYTE{ ICMP6_ECHO_REQUEST } : BYTE{ ICMP6_ECHO_REPLY }) : (bErrorQueue ? BYTE{ ICMP_ECHO } : BYTE{ ICMP_ECHOREPLY }) };
+	for (;;)
+	{
+		SOCKADDR_STORAGE replier{};
+		char control[512];
+		iovec iov{ m_RecvBuf.data(), m_RecvBuf.size() };
+		msghdr msg{};
+		msg.msg_name = &replier;
+		msg.msg_namelen = sizeof(replier);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		const ssize_t nRead{ recvmsg(nSocket, &msg, MSG_DONTWAIT | (bErrorQueue ? MSG_ERRQUEUE : 0)) };
+		if (nRead < 0)
+			return;
+		if ((nRead < 8) || (m_RecvBuf[0] != nExpectedType))
+			continue;
+
+		// Match the datagram back to its request
+		WORD wSequence{ 0 };
+		memcpy(&wSequence, m_RecvBuf.data() + 6, sizeof(wSequence));
+		CPendingProbe*& pSlot{ m_InFlight[nIndex][ntohs(wSequence)] };
+		if (pSlot == nullptr)
+			continue;
+		CPendingProbe& probe{ *pSlot };
+		const ULONGLONG nRTT{ CPingClock::NowMicroseconds() - probe.nSendTime };
+
+		if (!bErrorQueue)
+		{
+			pSlot = nullptr;
+			probe.bInFlight = false;
+			Complete(probe, ERROR_SUCCESS, IP_SUCCESS, reinterpret_cast<const SOCKADDR*>(&replier), nRTT);
+			continue;
+		}
+
+		for (cmsghdr* pCmsg{ CMSG_FIRSTHDR(&msg) }; pCmsg != nullptr; pCmsg = CMSG_NXTHDR(&msg, pCmsg))
+		{
+			const bool bRecvErr{ ((pCmsg->cmsg_level == SOL_IP) && (pCmsg->cmsg_type == IP_RECVERR)) || ((pCmsg->cmsg_level == SOL_IPV6) && (pCmsg->cmsg_type == IPV6_RECVERR)) };
+			if (!bRecvErr)
+				continue;
+			const auto pError{ reinterpret_cast<const sock_extended_err*>(CMSG_DATA(pCmsg)) };
+			pSlot = nullptr;
+			probe.bInFlight = false;
+			if ((pError->ee_origin == SO_EE_ORIGIN_ICMP) || (pError->ee_origin == SO_EE_ORIGIN_ICMP6))
+				Complete(probe, ERROR_SUCCESS, CDatagramPingBackend::MapIcmpError(nFamily, pError->ee_type, pError->ee_code), SO_EE_OFFENDER(pError), nRTT);
+			else
+				Complete(probe, pError->ee_errno, (pError->ee_errno == EMSGSIZE) ? IP_PACKET_TOO_BIG : IP_GENERAL_FAILURE, nullptr, 0);
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Completes every request whose deadline has passed with ERROR_TIMEOUT
+ */
+void CProbeEngine::ExpireTimeouts()
+{
+	const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+	while (!m_Deadlines.empty() && (m_Deadlines.top().nDeadline <= nNow))
+	{
+		const CDeadline deadline{ m_Deadlines.top() };
+		m_Deadlines.pop();
+
+		// Entries for requests which already completed (and maybe got recycled) are stale
+		CPendingProbe& probe{ *deadline.pProbe };
+		if ((probe.nGeneration != deadline.nGeneration) || !probe.bInFlight)
+			continue;
+		m_InFlight[(probe.request.nFamily == AF_INET6) ? 1 : 0][probe.wSequence] = nullptr;
+		probe.bInFlight = false;
+		Complete(probe, ERROR_TIMEOUT, IP_REQ_TIMED_OUT, nullptr, 0);
+	}
+}
+
+/**
+ * @brief Works out how long epoll_wait may block before the next request times out
+ * @return Milliseconds to wait, or -1 to wait until something happens
+ */
+int CProbeEngine::GetWaitTimeout() const noexcept
+{
+	if (m_Deadlines.empty())
+		return -1;
+	const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+	const ULONGLONG nDeadline{ m_Deadlines.top().nDeadline };
+	if (nDeadline <= nNow)
+		return 0;
+	return static_cast<int>((nDeadline - nNow + 999) / 1000);
+}
+#endif //#ifdef _WIN32
@@ -0,0 +1,138 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ProbeEngine.h : interface of the CProbeEngine class, an event driven probe engine which keeps
+// thousands of ICMP echo requests in flight from a single worker thread.
+//
+
+#pragma once
+
+#include "ping.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+// A single echo request submitted to the engine
+struct CProbeRequest
+{
+	int nFamily{ AF_INET };               // AF_INET or AF_INET6
+	SOCKADDR_STORAGE Address{};           // The already resolved destination address
+	UCHAR nTTL{ 128 };                    // Time-To-Live / hop limit of the request
+	UCHAR nTOS{ 0 };                      // Type-Of-Service / traffic class of the request
+	bool bDontFragment{ false };          // Set the DF bit on the request
+	WORD wDataSize{ 32 };                 // Payload size in bytes
+	DWORD dwTimeout{ 5000 };              // Timeout in milliseconds
+	ULONG_PTR nCookie{ 0 };               // Opaque caller value handed back in the completion
+};
+
+// The outcome of a single echo request
+struct CProbeCompletion
+{
+	ULONG_PTR nCookie{ 0 };               // The cookie of the matching CProbeRequest
+	int nFamily{ AF_INET };               // AF_INET or AF_INET6
+	UCHAR nTTL{ 0 };                      // The TTL the request was sent with
+	DWORD dwError{ ERROR_SUCCESS };       // ERROR_SUCCESS if a reply arrived, ERROR_TIMEOUT or another error otherwise
+	ULONG nStatus{ IP_SUCCESS };          // The IP_STATUS of the reply (e.g. IP_TTL_EXPIRED_TRANSIT)
+	SOCKADDR_STORAGE Replier{};           // The address of the host which replied
+	ULONGLONG RTT{ 0 };                   // Round trip time in microseconds
+};
+
+// CProbeEngine: owns one worker thread which multiplexes every outstanding echo request. On Windows the
+// requests are issued with IcmpSendEcho2Ex / Icmp6SendEcho2 and completed through APCs delivered to the
+// alertable worker thread; on other platforms they are sent on non-blocking datagram ICMP sockets which are
+// serviced with epoll. Completions are either handed to a callback (on the worker thread) or queued for
+// GetCompletion.
+class CProbeEngine
+{
+public:
+	using CompletionCallback = std::function<void(const CProbeCompletion&)>;
+
+	CProbeEngine() noexcept;
+	CProbeEngine(const CProbeEngine&) = delete;
+	CProbeEngine(CProbeEngine&&) = delete;
+	virtual ~CProbeEngine();
+
+	CProbeEngine& operator=(const CProbeEngine&) = delete;
+	CProbeEngine& operator=(CProbeEngine&&) = delete;
+
+	void SetLocalAddress(const SOCKADDR_STORAGE& address) noexcept; // Sends the requests of its family from this address; call before Start
+	bool Start(CompletionCallback callback = nullptr); // Creates the handles / sockets and starts the worker thread
+	void Stop();                                       // Stops the worker thread; outstanding requests are abandoned
+	bool Submit(const CProbeRequest& request);         // Queues a request; safe to call from any thread
+	bool GetCompletion(CProbeCompletion& completion, DWORD dwTimeout); // Dequeues a completion when no callback was given
+	bool WaitForIdle(DWORD dwTimeout);                 // Waits until every submitted request has completed
+	size_t GetOutstanding() const noexcept { return m_nOutstanding; } // Requests submitted but not yet completed
+	bool IsRunning() const noexcept { return m_bRunning; }
+
+protected:
+	struct CPendingProbe;
+
+	void WorkerThread();
+	void SendProbe(CPendingProbe& probe);
+	void Complete(CPendingProbe& probe, DWORD dwError, ULONG nStatus, const SOCKADDR* pReplier, ULONGLONG nRTT);
+	CPendingProbe* AllocateProbe();
+	void FreeProbe(CPendingProbe* pProbe) noexcept;
+	void Wake() noexcept;
+#ifdef _WIN32
+	static VOID NTAPI OnIcmpApc(PVOID pApcContext, PVOID pIoStatusBlock, ULONG nReserved);
+	void CompleteIcmpProbe(CPendingProbe& probe);
+#else
+	int GetSocket(int nFamily) const noexcept { return (nFamily == AF_INET6) ? m_nSocketv6 : m_nSocketv4; }
+	void ReadReplies(int nFamily, bool bErrorQueue);
+	void ExpireTimeouts();
+	int GetWaitTimeout() const noexcept;
+#endif //#ifdef _WIN32
+
+	CompletionCallback m_Callback;                    // Completion callback, or empty to use the completion queue
+	std::thread m_Worker;                             // The single worker thread servicing all requests
+	std::atomic<bool> m_bRunning;                     // Is the worker thread running
+	std::atomic<size_t> m_nOutstanding;               // Requests submitted but not completed yet
+	std::mutex m_Mutex;                               // Protects m_Submitted and m_Completed
+	std::condition_variable m_CompletedEvent;         // Signalled when a completion is queued or the engine goes idle
+	std::deque<CProbeRequest> m_Submitted;            // Requests waiting to be picked up by the worker thread
+	std::deque<CProbeCompletion> m_Completed;         // Completions waiting for GetCompletion
+	std::vector<std::unique_ptr<CPendingProbe>> m_Probes; // Pool of per request state, reused so steady state does not allocate
+	std::vector<CPendingProbe*> m_FreeProbes;         // The members of m_Probes which are not in flight
+	SOCKADDR_STORAGE m_LocalAddress[2];               // The address the IPv4 / IPv6 requests are sent from, family AF_UNSPEC for any
+#ifdef _WIN32
+	HANDLE m_hIcmpv4;                                 // ICMP handle used for all IPv4 requests
+	HANDLE m_hIcmpv6;                                 // ICMP handle used for all IPv6 requests
+	HANDLE m_hWakeEvent;                              // Wakes the worker when new requests are submitted
+#else
+	struct CDeadline
+	{
+		ULONGLONG nDeadline;                          // Monotonic time in microseconds when the request times out
+		CPendingProbe* pProbe;                        // The request
+		ULONG nGeneration;                            // Detects requests which completed before their deadline
+		bool operator>(const CDeadline& other) const noexcept { return nDeadline > other.nDeadline; }
+	};
+	int m_nSocketv4;                                  // Non-blocking datagram ICMP socket for IPv4 requests
+	int m_nSocketv6;                                  // Non-blocking datagram ICMPv6 socket for IPv6 requests
+	int m_nEpoll;                                     // The epoll instance servicing the sockets and the wake descriptor
+	int m_nWakeFd;                                    // eventfd used to wake the worker when new requests are submitted
+	int m_nLastTTL[2];                                // The TTL last applied to each socket
+	int m_nLastTOS[2];                                // The TOS last applied to each socket
+	int m_nLastDF[2];                                 // The DF setting last applied to each socket
+	WORD m_wNextSequence[2];                          // The next ICMP sequence number to try for each socket
+	std::vector<CPendingProbe*> m_InFlight[2];        // Requests in flight indexed by ICMP sequence number, per socket
+	std::priority_queue<CDeadline, std::vector<CDeadline>, std::greater<CDeadline>> m_Deadlines; // Pending timeouts
+	std::vector<BYTE> m_SendBuf;                      // Preallocated buffer for outgoing ICMP packets
+	std::vector<BYTE> m_RecvBuf;                      // Preallocated buffer for incoming datagrams
+#endif //#ifdef _WIN32
+};
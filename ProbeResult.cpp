@@ -0,0 +1,140 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ProbeResult.cpp : implementation of the CProbeResult record and its rendering
+//
+
+#include "pch.h"
+#include "ProbeResult.h"
+#include "Utf8Writer.h"
+#include <cstring>
+
+/**
+ * @brief Copies the address of the replier into the record
+ * @param pAddress An IPv4 or IPv6 socket address, nullptr for none
+ */
+void CProbeResult::SetAddress(const SOCKADDR* pAddress) noexcept
+{
+	memset(Address, 0, sizeof(Address));
+	nFamily = AF_UNSPEC;
+	if (pAddress == nullptr)
+		return;
+	if (pAddress->sa_family == AF_INET)
+	{
+#pragma warning(suppress: 26490)
+		memcpy(Address, &reinterpret_cast<const SOCKADDR_IN*>(pAddress)->sin_addr, 4);
+		nFamily = AF_INET;
+	}
+	else if (pAddress->sa_family == AF_INET6)
+	{
+#pragma warning(suppress: 26490)
+		memcpy(Address, &reinterpret_cast<const SOCKADDR_IN6*>(pAddress)->sin6_addr, 16);
+		nFamily = AF_INET6;
+	}
+}
+
+/**
+ * @brief Rebuilds the socket address of the replier
+ * @param address Receives the socket address
+ * @return The length of the socket address, 0 if the record has no address
+ */
+int CProbeResult::GetSockAddr(SOCKADDR_STORAGE& address) const noexcept
+{
+	memset(&address, 0, sizeof(address));
+	if (nFamily == AF_INET)
+	{
+#pragma warning(suppress: 26490)
+		SOCKADDR_IN* pAddress{ reinterpret_cast<SOCKADDR_IN*>(&address) };
+		pAddress->sin_family = AF_INET;
+		memcpy(&pAddress->sin_addr, Address, 4);
+		return static_cast<int>(sizeof(SOCKADDR_IN));
+	}
+	if (nFamily == AF_INET6)
+	{
+#pragma warning(suppress: 26490)
+		SOCKADDR_IN6* pAddress{ reinterpret_cast<SOCKADDR_IN6*>(&address) };
+		pAddress->sin6_family = AF_INET6;
+		memcpy(&pAddress->sin6_addr, Address, 16);
+		return static_cast<int>(sizeof(SOCKADDR_IN6));
+	}
+	return 0;
+}
+
+/**
+ * @brief Appends the span which holds the name of the replier, e.g. <span class="ptr" data-addr="192.0.2.1"> [host]</span>
+ * @param line The line being rendered
+ * @param result The record
+ * @param pszHost The name, nullptr for no span, empty for an empty span
+ */
+static void AppendHostSpan(CUtf8Writer& line, const CProbeResult& result, const char* pszHost) noexcept
+{
+	if (pszHost == nullptr)
+		return;
+	line.Append("<span class=\"ptr\" data-addr=\"").AppendAddress(result.nFamily, result.Address).Append("\">");
+	if (pszHost[0] != '\0')
+		line.Append(" [").Append(pszHost).Append(']');
+	line.Append("</span>");
+}
+
+/**
+ * @brief Renders a record as a UTF-8 result line
+ * @param result The record
+ * @param pszHost The resolved name of the replier, nullptr when names are not wanted, empty while it is not known
+ * @param pszStatusText The description of result.nStatus, used by records which report an error
+ * @param pszBuffer Receives the line, always null terminated
+ * @param nBufferSize Size of pszBuffer in bytes
+ * @return The length of the line, without the terminator
+ * @details Each record type has a fixed template which is written piece by piece with CUtf8Writer, so rendering
+ * neither allocates nor parses a format string. When names are wanted the numeric address is followed by a
+ * span which holds the name; the span is written even while the name is not known, so that the results page
+ * can fill it in once the name is found.
+ */
+size_t FormatProbeResult(const CProbeResult& result, const char* pszHost, const char* pszStatusText, char* pszBuffer, size_t nBufferSize) noexcept
+{
+	CUtf8Writer line{ pszBuffer, nBufferSize };
+	switch (result.nType)
+	{
+	case CProbeResultType::PingReply:
+		line.Append("Reply from ").AppendAddress(result.nFamily, result.Address);
+		AppendHostSpan(line, result, pszHost);
+		if (result.nStatus == IP_SUCCESS)
+			line.Append(", bytes=").AppendUnsigned(result.nDataSize).Append(", time=").AppendRTT(result.nRTT).Append(" TTL=").AppendUnsigned(result.nTTL);
+		else
+			line.Append(": ").Append(pszStatusText);
+		break;
+	case CProbeResultType::PingError:
+		// When several addresses of a host are pinged the failed request names the address it was sent to
+		if (result.nFamily != AF_UNSPEC)
+			line.AppendAddress(result.nFamily, result.Address).Append(": ");
+		line.Append(pszStatusText);
+		break;
+	case CProbeResultType::HopReply:
+		line.Append("  ").AppendUnsigned(result.nHop).Append('\t').AppendRTT(result.nRTT).Append('\t').AppendRTT(result.nAvgRTT).Append('\t').AppendRTT(result.nMaxRTT).Append('\t');
+		line.AppendAddress(result.nFamily, result.Address);
+		AppendHostSpan(line, result, pszHost);
+		break;
+	case CProbeResultType::HopError:
+		line.Append("  ").AppendUnsigned(result.nHop);
+		if (result.nStatus == ERROR_TIMEOUT)
+			line.Append("\t*\t*\t*\tRequest timed out.");
+		else
+			line.Append("\t*\t*\t*\tError:").Append(pszStatusText);
+		break;
+	case CProbeResultType::Text:
+	default:
+		break;
+	}
+	return line.GetLength();
+}
@@ -0,0 +1,60 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ProbeResult.h : interface of the CProbeResult record, the typed result of a probe which is only
+// turned into text when it is rendered or exported.
+//
+
+#pragma once
+
+#include <type_traits>
+
+// What a result record reports
+enum class CProbeResultType : BYTE
+{
+	Text,                                 // A message line; its text is kept beside the record
+	PingReply,                            // An echo reply; nStatus is its IP_STATUS
+	PingError,                            // An echo request which failed; nStatus is a Win32 error code, the address is its destination if set
+	HopReply,                             // A traceroute hop which answered; nRTT, nAvgRTT and nMaxRTT are set
+	HopError,                             // A traceroute hop which did not answer; nStatus is a Win32 error code
+};
+
+// CProbeResult: a fixed size record which the worker threads fill in instead of formatting text. It is
+// trivially copyable, so it can be stored and passed around by value without any allocation.
+struct CProbeResult
+{
+	ULONGLONG nTimestamp;                 // CPingClock time of the result in microseconds
+	ULONGLONG nRTT;                       // Round trip time in microseconds (the minimum for a hop)
+	ULONGLONG nAvgRTT;                    // Average round trip time of a hop in microseconds
+	ULONGLONG nMaxRTT;                    // Maximum round trip time of a hop in microseconds
+	DWORD nStatus;                        // IP_STATUS of a reply or Win32 error code
+	WORD nFamily;                         // AF_INET, AF_INET6 or AF_UNSPEC when there is no address
+	WORD nDataSize;                       // Payload size of the request in bytes
+	CProbeResultType nType;               // What the record reports
+	BYTE nHop;                            // Hop number of a traceroute result
+	BYTE nTTL;                            // Time-To-Live / hop limit of the request
+	BYTE Address[16];                     // The replier: 4 bytes for IPv4, 16 for IPv6
+
+	void SetAddress(const SOCKADDR* pAddress) noexcept;               // Copies the address bytes and family of a socket address
+	int GetSockAddr(SOCKADDR_STORAGE& address) const noexcept;      // Rebuilds the socket address, returns its length (0 if none)
+	bool IsReply() const noexcept { return (nType == CProbeResultType::PingReply) && (nStatus == IP_SUCCESS); }
+	bool IsLoss() const noexcept { return ((nType == CProbeResultType::PingReply) && (nStatus != IP_SUCCESS)) || (nType == CProbeResultType::PingError); }
+};
+static_assert(std::is_trivially_copyable<CProbeResult>::value, "CProbeResult must stay a plain record");
+
+// Renders a record as a UTF-8 result line into pszBuffer, always null terminated, and returns its length.
+// pszHost is the name of the replier, nullptr when names are not wanted and empty while it is not known, and
+// pszStatusText the description of nStatus, which is only used by records which report an error.
+size_t FormatProbeResult(const CProbeResult& result, const char* pszHost, const char* pszStatusText, char* pszBuffer, size_t nBufferSize) noexcept;
@@ -0,0 +1,169 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ProbeStatistics.cpp : implementation of the CProbeStatistics class
+//
+
+#include "pch.h"
+#include "ProbeStatistics.h"
+#include <cmath>
+
+/**
+ * @brief Default constructor for CProbeStatistics
+ */
+CProbeStatistics::CProbeStatistics() noexcept
+{
+	Reset();
+}
+
+/**
+ * @brief Discards every sample accounted for so far
+ */
+void CProbeStatistics::Reset() noexcept
+{
+	m_nSent = 0;
+	m_nReceived = 0;
+	m_nMin = 0;
+	m_nMax = 0;
+	m_fMean = 0.0;
+	m_fM2 = 0.0;
+	m_fJitter = 0.0;
+	m_nLastRTT = 0;
+	m_Histogram.fill(0);
+}
+
+/**
+ * @brief Accounts for a request which got a reply
+ * @param nRTT Round trip time in microseconds
+ */
+void CProbeStatistics::AddReply(ULONGLONG nRTT) noexcept
+{
+	++m_nSent;
+	++m_nReceived;
+
+	if ((m_nReceived == 1) || (nRTT < m_nMin))
+		m_nMin = nRTT;
+	if (nRTT > m_nMax)
+		m_nMax = nRTT;
+
+	// Welford's update of the running mean and sum of squares
+	const double fValue{ static_cast<double>(nRTT) };
+	const double fDelta{ fValue - m_fMean };
+	m_fMean += fDelta / static_cast<double>(m_nReceived);
+	m_fM2 += fDelta * (fValue - m_fMean);
+
+	// RFC 3550 section 6.4.1: J += (|D| - J) / 16, where D is the change in transit time between consecutive packets
+	if (m_nReceived > 1)
+	{
+		const double fDifference{ std::fabs(fValue - static_cast<double>(m_nLastRTT)) };
+		m_fJitter += (fDifference - m_fJitter) / 16.0;
+	}
+	m_nLastRTT = nRTT;
+
+	++m_Histogram[GetBucketIndex(nRTT)];
+}
+
+/**
+ * @brief Accounts for a request which got no reply
+ */
+void CProbeStatistics::AddLoss() noexcept
+{
+	++m_nSent;
+}
+
+/**
+ * @brief Gets the sample standard deviation of the round trip times
+ * @return The standard deviation in microseconds, 0 with fewer than two replies
+ */
+double CProbeStatistics::GetStdDev() const noexcept
+{
+	if (m_nReceived < 2)
+		return 0.0;
+	return std::sqrt(m_fM2 / static_cast<double>(m_nReceived - 1));
+}
+
+/**
+ * @brief Maps a value to its histogram bucket
+ * @param nValue The value in microseconds; larger values than the histogram covers land in the last bucket
+ * @return The bucket index
+ * @details Values below 2 * SUB_BUCKET_COUNT get a bucket each. Above that every power of two range is split
+ * into SUB_BUCKET_COUNT equal buckets, so the bucket width is at most 1 / SUB_BUCKET_COUNT of the value.
+ */
+size_t CProbeStatistics::GetBucketIndex(ULONGLONG nValue) noexcept
+{
+	const ULONGLONG nMaxValue{ (1ULL << MAX_VALUE_BITS) - 1 };
+	if (nValue > nMaxValue)
+		nValue = nMaxValue;
+	if (nValue < (2 * SUB_BUCKET_COUNT))
+		return static_cast<size_t>(nValue);
+
+	// The position of the highest set bit selects the power of two range
+	UINT nHighestBit{ 0 };
+	for (ULONGLONG n = nValue >> 1; n != 0; n >>= 1)
+		++nHighestBit;
+	const UINT nShift{ nHighestBit - SUB_BUCKET_BITS };
+	return static_cast<size_t>((2 * SUB_BUCKET_COUNT) + ((nShift - 1) * SUB_BUCKET_COUNT) + ((nValue >> nShift) - SUB_BUCKET_COUNT));
+}
+
+/**
+ * @brief Gets the value which represents a histogram bucket
+ * @param nIndex The bucket index
+ * @return The midpoint of the values which map to the bucket
+ */
+ULONGLONG CProbeStatistics::GetBucketMidpoint(size_t nIndex) noexcept
+{
+	if (nIndex < (2 * SUB_BUCKET_COUNT))
+		return nIndex;
+	const ULONGLONG nOffset{ nIndex - (2 * SUB_BUCKET_COUNT) };
+	const UINT nShift{ static_cast<UINT>(nOffset / SUB_BUCKET_COUNT) + 1 };
+	const ULONGLONG nLowest{ (SUB_BUCKET_COUNT + (nOffset % SUB_BUCKET_COUNT)) << nShift };
+	return nLowest + ((1ULL << nShift) >> 1);
+}
+
+/**
+ * @brief Gets a percentile of the round trip times
+ * @param fPercentile The percentile wanted, between 0 and 100
+ * @return The percentile in microseconds, accurate to the width of a histogram bucket
+ */
+ULONGLONG CProbeStatistics::GetPercentile(double fPercentile) const noexcept
+{
+	if (m_nReceived == 0)
+		return 0;
+	if (fPercentile <= 0.0)
+		return m_nMin;
+	if (fPercentile >= 100.0)
+		return m_nMax;
+
+	// The smallest value which at least fPercentile% of the samples do not exceed
+	ULONGLONG nRank{ static_cast<ULONGLONG>(std::ceil((fPercentile / 100.0) * static_cast<double>(m_nReceived))) };
+	if (nRank == 0)
+		nRank = 1;
+	ULONGLONG nCumulative{ 0 };
+	for (size_t i = 0; i < m_Histogram.size(); i++)
+	{
+		nCumulative += m_Histogram[i];
+		if (nCumulative >= nRank)
+		{
+			// The exact extremes are known, so never report a value outside of them
+			const ULONGLONG nValue{ GetBucketMidpoint(i) };
+			if (nValue < m_nMin)
+				return m_nMin;
+			if (nValue > m_nMax)
+				return m_nMax;
+			return nValue;
+		}
+	}
+	return m_nMax;
+}
@@ -0,0 +1,67 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ProbeStatistics.h : interface of the CProbeStatistics class, an online accumulator of round trip
+// time statistics which uses constant memory however long a run lasts.
+//
+
+#pragma once
+
+#include <array>
+
+// CProbeStatistics: every sample is accounted for in O(1) and nothing is kept per sample.
+// - mean and standard deviation use Welford's online algorithm
+// - jitter is the RFC 3550 interarrival jitter estimator applied to consecutive RTTs
+// - percentiles come from a log-linear (HDR style) histogram whose buckets are at most 1/64 (~1.6%) wide
+//   relative to their value, covering 0 to 2^40 microseconds
+class CProbeStatistics
+{
+public:
+	CProbeStatistics() noexcept;
+
+	void Reset() noexcept;
+	void AddReply(ULONGLONG nRTT) noexcept;            // Accounts for a reply; nRTT in microseconds
+	void AddLoss() noexcept;                           // Accounts for a request which got no reply
+
+	ULONGLONG GetSent() const noexcept { return m_nSent; }
+	ULONGLONG GetReceived() const noexcept { return m_nReceived; }
+	ULONGLONG GetLost() const noexcept { return m_nSent - m_nReceived; }
+	double GetLossRatio() const noexcept { return (m_nSent > 0) ? (static_cast<double>(m_nSent - m_nReceived) / static_cast<double>(m_nSent)) : 0.0; }
+	ULONGLONG GetMin() const noexcept { return m_nMin; }     // Microseconds, 0 if there were no replies
+	ULONGLONG GetMax() const noexcept { return m_nMax; }     // Microseconds
+	double GetMean() const noexcept { return m_fMean; }      // Microseconds
+	double GetStdDev() const noexcept;                       // Sample standard deviation in microseconds
+	double GetJitter() const noexcept { return m_fJitter; }  // RFC 3550 jitter in microseconds
+	ULONGLONG GetPercentile(double fPercentile) const noexcept; // e.g. 50, 90, 99 or 99.9; microseconds
+
+protected:
+	static const UINT SUB_BUCKET_BITS{ 6 };
+	static const ULONGLONG SUB_BUCKET_COUNT{ 1ULL << SUB_BUCKET_BITS };
+	static const UINT MAX_VALUE_BITS{ 40 };
+	static const size_t BUCKET_COUNT{ (2 * SUB_BUCKET_COUNT) + ((MAX_VALUE_BITS - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT) };
+
+	static size_t GetBucketIndex(ULONGLONG nValue) noexcept;
+	static ULONGLONG GetBucketMidpoint(size_t nIndex) noexcept;
+
+	ULONGLONG m_nSent;                                 // Requests accounted for
+	ULONGLONG m_nReceived;                             // Replies accounted for
+	ULONGLONG m_nMin;                                  // Minimum RTT in microseconds
+	ULONGLONG m_nMax;                                  // Maximum RTT in microseconds
+	double m_fMean;                                    // Welford running mean
+	double m_fM2;                                      // Welford running sum of squared differences from the mean
+	double m_fJitter;                                  // RFC 3550 running jitter estimate
+	ULONGLONG m_nLastRTT;                              // Previous RTT, for the jitter estimator
+	std::array<ULONGLONG, BUCKET_COUNT> m_Histogram;   // Log-linear RTT histogram
+};
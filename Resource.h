@@ -41,13 +41,14 @@
 #define ID_PING                         32771
 #define ID_TRACE_ROUTE                  32772
 #define ID_STOP                         32773
+#define ID_BULK_PING                    32774
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        312
-#define _APS_NEXT_COMMAND_VALUE         32774
+#define _APS_NEXT_COMMAND_VALUE         32775
 #define _APS_NEXT_CONTROL_VALUE         1005
 #define _APS_NEXT_SYMED_VALUE           312
 #endif
@@ -0,0 +1,261 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ResultBatcher.cpp : implementation of the CResultBatcher class
+//
+
+#include "pch.h"
+#include "ResultBatcher.h"
+#include "ping.h"
+#include "Utf8Writer.h"
+#include <chrono>
+
+/**
+ * @brief Default constructor for CResultBatcher; batches of up to 64 lines, delivered within 100 ms
+ */
+CResultBatcher::CResultBatcher() noexcept :
+	m_pSink{ nullptr },
+	m_nPendingLines{ 0 },
+	m_nFirstPending{ 0 },
+	m_nPendingSince{ 0 },
+	m_nBatches{ 0 },
+	m_nMaxLines{ 64 },
+	m_nMaxDelay{ 100000 },
+	m_bStopping{ false }
+{
+}
+
+/**
+ * @brief Destructor for CResultBatcher; stops the delivery thread
+ */
+CResultBatcher::~CResultBatcher()
+{
+	Stop();
+}
+
+/**
+ * @brief Starts the delivery thread
+ * @return true if the thread is running
+ */
+bool CResultBatcher::Start()
+{
+	if (m_Thread.joinable())
+		return true;
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_bStopping = false;
+	}
+	m_Thread = std::thread{ &CResultBatcher::DeliveryThread, this };
+	return m_Thread.joinable();
+}
+
+/**
+ * @brief Delivers the pending lines, if there is a sink, and stops the delivery thread
+ */
+void CResultBatcher::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_bStopping = true;
+	}
+	m_WakeUp.notify_all();
+	if (m_Thread.joinable())
+		m_Thread.join();
+	Flush();
+}
+
+/**
+ * @brief Discards the pending lines and detaches the sink, ready for a new operation
+ */
+void CResultBatcher::Reset()
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_pSink = nullptr;
+	m_strPending.clear();
+	m_nPendingLines = 0;
+	m_strPendingNames.clear();
+	m_nFirstPending = 0;
+	m_nPendingSince = 0;
+	m_nBatches = 0;
+}
+
+/**
+ * @brief Attaches the sink which receives the batches; the lines kept so far are delivered to it straight away
+ * @param pSink The sink, nullptr to keep lines until one is attached
+ */
+void CResultBatcher::SetSink(CResultSink* pSink)
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_pSink = pSink;
+	DeliverLocked();
+}
+
+/**
+ * @brief Queues a result line
+ * @param pszLine The UTF-8 line, as it is written into the results file
+ * @param nLength The length of the line in bytes
+ * @details The line is escaped straight into the pending batch, whose buffer keeps its capacity from one batch
+ * to the next, so once it has grown queueing a line does not allocate.
+ */
+void CResultBatcher::Add(const char* pszLine, size_t nLength)
+{
+	bool bWake{ false };
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		if (!IsPendingLocked())
+		{
+			m_nPendingSince = CPingClock::NowMicroseconds();
+			bWake = true; // The delivery thread has to arm the deadline of the new batch
+		}
+		if (m_nPendingLines > 0)
+			m_strPending += ',';
+		AppendJsonString(m_strPending, pszLine, nLength);
+		++m_nPendingLines;
+		if (m_nPendingLines >= m_nMaxLines)
+			bWake = true;
+	}
+	if (bWake)
+		m_WakeUp.notify_all();
+}
+
+/**
+ * @brief Queues the host name of an address, for the page to fill in wherever the address is shown
+ * @param pszAddress The numeric address, as the result lines show it
+ * @param pszName The UTF-8 host name
+ */
+void CResultBatcher::AddName(const char* pszAddress, const char* pszName)
+{
+	bool bWake{ false };
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		if (!IsPendingLocked())
+		{
+			m_nPendingSince = CPingClock::NowMicroseconds();
+			bWake = true;
+		}
+		else if (!m_strPendingNames.empty())
+			m_strPendingNames += ',';
+		m_strPendingNames += '[';
+		AppendJsonString(m_strPendingNames, pszAddress, strlen(pszAddress));
+		m_strPendingNames += ',';
+		AppendJsonString(m_strPendingNames, pszName, strlen(pszName));
+		m_strPendingNames += ']';
+	}
+	if (bWake)
+		m_WakeUp.notify_all();
+}
+
+/**
+ * @brief Delivers the pending lines now
+ */
+void CResultBatcher::Flush()
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	DeliverLocked();
+}
+
+/**
+ * @brief Gets how many lines were queued since the last Reset
+ * @return The number of lines
+ */
+ULONGLONG CResultBatcher::GetLineCount() const
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	return m_nFirstPending + m_nPendingLines;
+}
+
+/**
+ * @brief Gets how many batches were delivered since the last Reset
+ * @return The number of batches
+ */
+ULONGLONG CResultBatcher::GetBatchCount() const
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	return m_nBatches;
+}
+
+/**
+ * @brief Formats the pending lines as a batch and hands it to the sink; m_Mutex must be held
+ */
+void CResultBatcher::DeliverLocked()
+{
+	if ((m_pSink == nullptr) || !IsPendingLocked())
+		return;
+
+	char szFirst[32]{};
+	CUtf8Writer first{ szFirst, sizeof(szFirst) };
+	first.AppendUnsigned(m_nFirstPending);
+	std::string strJson;
+	strJson.reserve(m_strPending.size() + m_strPendingNames.size() + first.GetLength() + 36);
+	strJson += "{\"first\":";
+	strJson.append(first.GetString(), first.GetLength());
+	strJson += ",\"lines\":[";
+	strJson += m_strPending;
+	strJson += ']';
+	if (!m_strPendingNames.empty())
+	{
+		strJson += ",\"names\":[";
+		strJson += m_strPendingNames;
+		strJson += ']';
+	}
+	strJson += '}';
+	m_nFirstPending += m_nPendingLines;
+	m_strPending.clear();
+	m_nPendingLines = 0;
+	m_strPendingNames.clear();
+	++m_nBatches;
+
+	// Batches are handed over under the lock, so they reach the sink in order; sinks only post them on
+	m_pSink->PostBatch(strJson);
+}
+
+/**
+ * @brief The delivery thread: sleeps until a batch is full or the oldest pending line reached its deadline
+ */
+void CResultBatcher::DeliveryThread()
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	while (!m_bStopping)
+	{
+		if ((m_pSink == nullptr) || !IsPendingLocked())
+		{
+			m_WakeUp.wait(lock);
+			continue;
+		}
+		const ULONGLONG nDeadline{ m_nPendingSince + m_nMaxDelay };
+		const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+		if ((m_nPendingLines >= m_nMaxLines) || (nNow >= nDeadline))
+			DeliverLocked();
+		else
+			m_WakeUp.wait_for(lock, std::chrono::microseconds{ nDeadline - nNow });
+	}
+}
+
+/**
+ * @brief Appends a string to a JSON document as a quoted and escaped JSON string
+ * @param strJson The JSON document being built
+ * @param pszText The UTF-8 text; bytes of multi-byte characters are copied unchanged
+ * @param nLength The length of the text in bytes
+ * @details The text is escaped by CUtf8Writer::AppendJsonString straight into the end of strJson, which is first
+ * grown to the longest escaped form (every byte as \u00XX) and then cut back to what was written.
+ */
+void CResultBatcher::AppendJsonString(std::string& strJson, const char* pszText, size_t nLength)
+{
+	const size_t nOffset{ strJson.size() };
+	strJson.resize(nOffset + (6 * nLength) + 2);
+	CUtf8Writer writer{ &strJson[nOffset], strJson.size() - nOffset + 1 };
+	writer.AppendJsonString(pszText, nLength);
+	strJson.resize(nOffset + writer.GetLength());
+}
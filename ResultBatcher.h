@@ -0,0 +1,87 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ResultBatcher.h : interface of the CResultBatcher class, which groups result lines into JSON batches
+// and hands them to a sink (the WebView of the view) while an operation is still running.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// CResultSink: receives the JSON batches; called on the batcher's own thread
+class CResultSink
+{
+public:
+	virtual ~CResultSink() = default;
+
+	virtual void PostBatch(const std::string& strJson) = 0; // strJson is a UTF-8 JSON object
+};
+
+// CResultBatcher: result lines are queued from any thread and delivered as one message per batch, either as
+// soon as MaxLines lines are waiting or MaxDelay after the first of them was queued, whichever comes first.
+// A batch looks like {"first":12,"lines":["...","..."]} where first is the index of its first line since the
+// last Reset, so a page which already shows some of the lines (loaded from the results file) can skip them.
+// Until a sink is attached lines are only kept, and they are all delivered when it is. Host names found after
+// their lines were queued travel in the same stream, as "names":[["192.0.2.1","host"]], so they reach the page
+// after the lines which show the address.
+class CResultBatcher
+{
+public:
+	CResultBatcher() noexcept;
+	CResultBatcher(const CResultBatcher&) = delete;
+	CResultBatcher(CResultBatcher&&) = delete;
+	virtual ~CResultBatcher();
+
+	CResultBatcher& operator=(const CResultBatcher&) = delete;
+	CResultBatcher& operator=(CResultBatcher&&) = delete;
+
+	bool Start();                                       // Starts the delivery thread
+	void Stop();                                        // Delivers what is pending and stops the delivery thread
+	void Reset();                                       // Discards pending lines and detaches the sink; line indexes start from 0 again
+	void SetSink(CResultSink* pSink);                   // Attaches (or with nullptr detaches) the sink
+	void SetMaxLines(size_t nMaxLines) noexcept { m_nMaxLines = (nMaxLines > 0) ? nMaxLines : 1; }
+	void SetMaxDelay(ULONGLONG nMaxDelay) noexcept { m_nMaxDelay = nMaxDelay; } // Microseconds
+	void Add(const char* pszLine, size_t nLength);      // Queues a UTF-8 line; safe to call from any thread
+	void Add(const std::string& strLine) { Add(strLine.data(), strLine.size()); }
+	void AddName(const char* pszAddress, const char* pszName); // Queues the host name of an address
+	void Flush();                                       // Delivers the pending lines now, if there is a sink
+	ULONGLONG GetLineCount() const;                     // Lines queued since the last Reset
+	ULONGLONG GetBatchCount() const;                    // Batches delivered since the last Reset
+
+	static void AppendJsonString(std::string& strJson, const char* pszText, size_t nLength); // Appends the text as a quoted JSON string
+
+protected:
+	void DeliveryThread();
+	void DeliverLocked();
+	bool IsPendingLocked() const noexcept { return (m_nPendingLines > 0) || !m_strPendingNames.empty(); }
+
+	mutable std::mutex m_Mutex;                        // Protects everything below
+	std::condition_variable m_WakeUp;                  // Signalled when lines are queued or on Stop
+	std::thread m_Thread;                              // Delivers batches which reached their deadline
+	CResultSink* m_pSink;                              // Receives the batches, nullptr while detached
+	std::string m_strPending;                          // Lines not delivered yet, as comma separated JSON strings
+	size_t m_nPendingLines;                            // Number of lines in m_strPending
+	std::string m_strPendingNames;                     // Names not delivered yet, as comma separated JSON pairs
+	ULONGLONG m_nFirstPending;                         // Index of the first pending line since the last Reset
+	ULONGLONG m_nPendingSince;                         // CPingClock time the oldest pending line or name was queued
+	ULONGLONG m_nBatches;                              // Batches delivered since the last Reset
+	size_t m_nMaxLines;                                // Lines which trigger a delivery straight away
+	ULONGLONG m_nMaxDelay;                             // Longest time a line waits for its batch, microseconds
+	bool m_bStopping;                                  // Tells the delivery thread to exit
+};
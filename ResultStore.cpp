@@ -0,0 +1,128 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ResultStore.cpp : implementation of the CResultStore class
+//
+
+#include "pch.h"
+#include "ResultStore.h"
+#include "ping.h"
+
+/**
+ * @brief Default constructor for CResultStore; nothing is evicted until a retention is set
+ */
+CResultStore::CResultStore() noexcept :
+	m_nHead{ 0 },
+	m_nCount{ 0 },
+	m_nMaxLines{ 0 },
+	m_nMaxAge{ 0 }
+{
+}
+
+/**
+ * @brief Sets the retention policy; lines beyond a new limit are evicted straight away
+ * @param nMaxLines The number of most recent lines to keep, 0 for no limit
+ * @param nMaxAge The age in microseconds after which lines are evicted, 0 for no limit
+ */
+void CResultStore::SetRetention(size_t nMaxLines, ULONGLONG nMaxAge)
+{
+	m_nMaxLines = nMaxLines;
+	m_nMaxAge = nMaxAge;
+	while ((m_nMaxLines > 0) && (m_nCount > m_nMaxLines))
+		EvictOldest();
+	Expire(CPingClock::NowMicroseconds());
+}
+
+/**
+ * @brief Discards every line and the summary of the evicted ones
+ * @details The ring keeps its slots (and the strings their buffers) for the next operation
+ */
+void CResultStore::Clear()
+{
+	m_nHead = 0;
+	m_nCount = 0;
+	m_Evicted.nLines = 0;
+	m_Evicted.nFirstTime = 0;
+	m_Evicted.nLastTime = 0;
+	m_Evicted.Statistics.Reset();
+}
+
+/**
+ * @brief Adds a record, evicting the oldest ones as the retention policy requires
+ * @param result The record; its timestamp is the time used by the age limit
+ * @param pszText The UTF-8 message of a CProbeResultType::Text record, empty for the others
+ * @param nLength The length of the text in bytes
+ */
+void CResultStore::Add(const CProbeResult& result, const char* pszText, size_t nLength)
+{
+	Expire(result.nTimestamp);
+	if ((m_nMaxLines > 0) && (m_nCount >= m_nMaxLines))
+		EvictOldest();
+	if (m_nCount == m_arrRing.size())
+		Grow();
+
+	// Assigning into the reused slot keeps its string buffer, so a full ring stops allocating
+	CStoredResult& stored{ m_arrRing[(m_nHead + m_nCount) % m_arrRing.size()] };
+	stored.Result = result;
+	stored.strText.assign(pszText, nLength);
+	++m_nCount;
+}
+
+/**
+ * @brief Evicts the lines which are older than the age limit
+ * @param nNow The current CPingClock time in microseconds
+ */
+void CResultStore::Expire(ULONGLONG nNow)
+{
+	if (m_nMaxAge == 0)
+		return;
+	while ((m_nCount > 0) && (nNow > Get(0).Result.nTimestamp) && ((nNow - Get(0).Result.nTimestamp) > m_nMaxAge))
+		EvictOldest();
+}
+
+/**
+ * @brief Accounts for the oldest retained line in the summary and drops it
+ */
+void CResultStore::EvictOldest()
+{
+	const CProbeResult& result{ m_arrRing[m_nHead].Result };
+	if (m_Evicted.nLines == 0)
+		m_Evicted.nFirstTime = result.nTimestamp;
+	m_Evicted.nLastTime = result.nTimestamp;
+	++m_Evicted.nLines;
+	if (result.IsReply())
+		m_Evicted.Statistics.AddReply(result.nRTT);
+	else if (result.IsLoss())
+		m_Evicted.Statistics.AddLoss();
+
+	m_nHead = (m_nHead + 1) % m_arrRing.size();
+	--m_nCount;
+}
+
+/**
+ * @brief Doubles the capacity of the ring (up to the line limit), moving the lines to the start of it
+ */
+void CResultStore::Grow()
+{
+	size_t nCapacity{ (m_arrRing.size() > 0) ? (m_arrRing.size() * 2) : 256 };
+	if ((m_nMaxLines > 0) && (nCapacity > m_nMaxLines))
+		nCapacity = m_nMaxLines;
+
+	std::vector<CStoredResult> arrRing(nCapacity);
+	for (size_t i = 0; i < m_nCount; i++)
+		arrRing[i] = std::move(m_arrRing[(m_nHead + i) % m_arrRing.size()]);
+	m_arrRing.swap(arrRing);
+	m_nHead = 0;
+}
@@ -0,0 +1,75 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ResultStore.h : interface of the CResultStore class, a bounded store of the result records of an
+// operation which keeps the most recent ones and a summary of those it had to let go.
+//
+
+#pragma once
+
+#include "ProbeResult.h"
+#include "ProbeStatistics.h"
+#include <string>
+#include <vector>
+
+// A retained result line
+struct CStoredResult
+{
+	CProbeResult Result{};                // The typed record
+	std::string strText;                  // The UTF-8 message of a CProbeResultType::Text record, empty for the others
+};
+
+// Aggregate of the lines which were evicted
+struct CEvictedSummary
+{
+	ULONGLONG nLines{ 0 };                // Number of evicted lines
+	ULONGLONG nFirstTime{ 0 };            // CPingClock time of the oldest evicted line
+	ULONGLONG nLastTime{ 0 };             // CPingClock time of the newest evicted line
+	CProbeStatistics Statistics;          // Replies and losses among the evicted lines
+};
+
+// CResultStore: a ring buffer which keeps the last N lines and / or the lines of the last T microseconds. The
+// ring only grows (by doubling) until it holds N lines, and slots are reused afterwards, so with a line limit
+// memory stays flat however long a run lasts. Lines are indexed from 0 (the oldest retained) to GetCount() - 1.
+// Lines are kept as records and only turned into text by whoever renders them.
+class CResultStore
+{
+public:
+	CResultStore() noexcept;
+
+	void SetRetention(size_t nMaxLines, ULONGLONG nMaxAge); // 0 = no limit; nMaxAge in microseconds
+	size_t GetMaxLines() const noexcept { return m_nMaxLines; }
+	ULONGLONG GetMaxAge() const noexcept { return m_nMaxAge; }
+	void Clear();                                      // Discards every line and the summary
+	void Add(const CProbeResult& result, const char* pszText, size_t nLength); // The text as CStoredResult::strText
+	void Expire(ULONGLONG nNow);                       // Evicts the lines older than the age limit at nNow
+
+	size_t GetCount() const noexcept { return m_nCount; }
+	ULONGLONG GetTotalCount() const noexcept { return m_Evicted.nLines + m_nCount; } // Lines added since Clear
+	ULONGLONG GetFirstIndex() const noexcept { return m_Evicted.nLines; } // Index since Clear of the oldest retained line
+	const CStoredResult& Get(size_t nIndex) const { return m_arrRing[(m_nHead + nIndex) % m_arrRing.size()]; }
+	const CEvictedSummary& GetEvicted() const noexcept { return m_Evicted; }
+
+protected:
+	void EvictOldest();
+	void Grow();
+
+	std::vector<CStoredResult> m_arrRing;              // The ring; its slots are reused once it is full
+	size_t m_nHead;                                    // Slot of the oldest retained line
+	size_t m_nCount;                                   // Number of retained lines
+	size_t m_nMaxLines;                                // Line limit, 0 for none
+	ULONGLONG m_nMaxAge;                               // Age limit in microseconds, 0 for none
+	CEvictedSummary m_Evicted;                         // Summary of the evicted lines
+};
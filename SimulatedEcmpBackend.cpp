@@ -0,0 +1,333 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// SimulatedEcmpBackend.cpp : implementation of the CSimulatedEcmpBackend class
+//
+
+#include "pch.h"
+#include "SimulatedEcmpBackend.h"
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+	std::atomic<UINT> g_nSimulatedSockets{ 0 }; // Simulated sockets opened by the process, which gives each its identifier
+
+	/**
+	 * @brief Adds bytes to a 32 bit FNV-1a hash
+	 * @param nHash The hash so far
+	 * @param pData The bytes
+	 * @param nSize Number of bytes
+	 * @return The hash including the bytes
+	 */
+	DWORD HashBytes(DWORD nHash, const void* pData, size_t nSize) noexcept
+	{
+		const BYTE* pBytes{ static_cast<const BYTE*>(pData) };
+		for (size_t i{ 0 }; i < nSize; i++)
+		{
+			nHash ^= pBytes[i];
+			nHash *= 16777619U;
+		}
+		return nHash;
+	}
+
+	/**
+	 * @brief Mixes the bits of a hash, so that its low bits depend on all of them (the MurmurHash3 finalizer).
+	 * The low bit of an FNV-1a hash is just the parity of the low bits of its bytes, and a modulo by 2 would
+	 * make every router choose in step with the one before it
+	 * @param nHash The hash
+	 * @return The mixed hash
+	 */
+	DWORD MixHash(DWORD nHash) noexcept
+	{
+		nHash ^= nHash >> 16;
+		nHash *= 0x85EBCA6BU;
+		nHash ^= nHash >> 13;
+		nHash *= 0xC2B2AE35U;
+		nHash ^= nHash >> 16;
+		return nHash;
+	}
+
+	/**
+	 * @brief Computes the Internet checksum (RFC 1071) of a message
+	 * @param pData The message, with its checksum field zero
+	 * @param nSize Size of the message in bytes
+	 * @return The checksum, in network byte order
+	 */
+	WORD InternetChecksum(const BYTE* pData, size_t nSize) noexcept
+	{
+		DWORD dwSum{ 0 };
+		for (size_t i{ 0 }; i + 1 < nSize; i += 2)
+			dwSum += (static_cast<DWORD>(pData[i]) << 8) | pData[i + 1];
+		if (nSize & 1)
+			dwSum += static_cast<DWORD>(pData[nSize - 1]) << 8;
+		while (dwSum >> 16)
+			dwSum = (dwSum & 0xFFFF) + (dwSum >> 16);
+		return htons(static_cast<WORD>(~dwSum));
+	}
+
+	/**
+	 * @brief Makes the IPv4 address 10.0.<hop>.<router> of a router of the built-in network
+	 */
+	SOCKADDR_IN MakeAddressv4(BYTE nHop, BYTE nRouter) noexcept
+	{
+		SOCKADDR_IN address{};
+		address.sin_family = AF_INET;
+		const BYTE bytes[4]{ 10, 0, nHop, nRouter };
+		memcpy(&address.sin_addr, bytes, sizeof(bytes));
+		return address;
+	}
+
+	/**
+	 * @brief Makes the IPv6 address fd00::<hop>:<router> of a router of the built-in network
+	 */
+	SOCKADDR_IN6 MakeAddressv6(BYTE nHop, BYTE nRouter) noexcept
+	{
+		SOCKADDR_IN6 address{};
+		address.sin6_family = AF_INET6;
+		BYTE bytes[16]{ 0xFD, 0x00 };
+		bytes[13] = nHop;
+		bytes[15] = nRouter;
+		memcpy(&address.sin6_addr, bytes, sizeof(bytes));
+		return address;
+	}
+}
+
+/**
+ * @brief Default constructor for CSimulatedEcmpBackend; loads the built-in network
+ */
+CSimulatedEcmpBackend::CSimulatedEcmpBackend() :
+	m_nDestination{ 0 },
+	m_nFamily{ AF_UNSPEC },
+	m_wIdentifier{ 0 },
+	m_wSequence{ 0 },
+	m_nRequestsSent{ 0 }
+{
+	LoadDefaultNetwork();
+}
+
+/**
+ * @brief Replaces the network with the built-in one described in SimulatedEcmpBackend.h
+ */
+void CSimulatedEcmpBackend::LoadDefaultNetwork()
+{
+	// The routers of each hop, then the links of the diagram
+	Clear();
+	const BYTE nRouters[7]{ 1, 2, 4, 1, 3, 2, 1 };
+	UINT nFirstOfHop[7]{};
+	for (BYTE nHop{ 1 }; nHop <= 7; nHop++)
+	{
+		nFirstOfHop[nHop - 1] = static_cast<UINT>(m_Routers.size());
+		for (BYTE nRouter{ 1 }; nRouter <= nRouters[nHop - 1]; nRouter++)
+			AddRouter(MakeAddressv4(nHop, nRouter), MakeAddressv6(nHop, nRouter), nHop * 1000ULL);
+	}
+	const UINT A{ nFirstOfHop[0] }, B{ nFirstOfHop[1] }, C{ nFirstOfHop[2] }, D{ nFirstOfHop[3] }, E{ nFirstOfHop[4] }, F{ nFirstOfHop[5] }, G{ nFirstOfHop[6] };
+	AddLink(A, B);
+	AddLink(A, B + 1);
+	AddLink(B, C);
+	AddLink(B, C + 1);
+	AddLink(B + 1, C + 2);
+	AddLink(B + 1, C + 3);
+	for (UINT i{ 0 }; i < 4; i++)
+		AddLink(C + i, D);
+	for (UINT i{ 0 }; i < 3; i++)
+		AddLink(D, E + i);
+	AddLink(E, F);
+	AddLink(E + 1, F);
+	AddLink(E + 2, F + 1);
+	AddLink(F, G);
+	AddLink(F + 1, G);
+	SetDestination(G);
+}
+
+/**
+ * @brief Removes every router
+ */
+void CSimulatedEcmpBackend::Clear()
+{
+	m_Routers.clear();
+	m_nDestination = 0;
+}
+
+/**
+ * @brief Adds a router to the network
+ * @param addressv4 The address it answers IPv4 requests from
+ * @param addressv6 The address it answers IPv6 requests from
+ * @param nDelay The round trip time of a request which it answers, in microseconds
+ * @return The index of the router
+ */
+UINT CSimulatedEcmpBackend::AddRouter(const SOCKADDR_IN& addressv4, const SOCKADDR_IN6& addressv6, ULONGLONG nDelay)
+{
+	CSimulatedRouter router;
+	router.Addressv4 = addressv4;
+	router.Addressv6 = addressv6;
+	router.nDelay = nDelay;
+	m_Routers.push_back(std::move(router));
+	return static_cast<UINT>(m_Routers.size() - 1);
+}
+
+/**
+ * @brief Makes a router one of the next hops of another
+ * @param nFrom The router which balances over its next hops
+ * @param nTo The next hop
+ */
+void CSimulatedEcmpBackend::AddLink(UINT nFrom, UINT nTo)
+{
+	m_Routers.at(nFrom).arrNextHops.push_back(nTo);
+}
+
+/**
+ * @brief Opens the simulated socket
+ * @param nFamily AF_INET or AF_INET6
+ * @return true
+ * @details Like the kernel does for a new datagram socket, every Open in the process gives the requests a new
+ * identifier, so their flows change.
+ */
+bool CSimulatedEcmpBackend::Open(int nFamily)
+{
+	m_nFamily = nFamily;
+	m_wIdentifier = static_cast<WORD>((++g_nSimulatedSockets * 31421U) + 6927U);
+	return true;
+}
+
+/**
+ * @brief Closes the simulated socket
+ */
+void CSimulatedEcmpBackend::Close() noexcept
+{
+	m_nFamily = AF_UNSPEC;
+}
+
+/**
+ * @brief Routes a request through the network
+ * @param nFamily AF_INET or AF_INET6
+ * @param pDestAddress The destination address of the request
+ * @param nDestAddressSize Size of the destination address in bytes
+ * @param pRequestData The request data
+ * @param wDataSize Size of the request data in bytes
+ * @param nTTL The TTL of the request
+ * @param nRouter Receives the index of the router which answers
+ * @return IP_SUCCESS if the request got to the destination, IP_TTL_EXPIRED_TRANSIT if its TTL ran out, or
+ * IP_DEST_HOST_UNREACHABLE if it got to a router without next hops which is not the destination
+ */
+ULONG CSimulatedEcmpBackend::Route(int nFamily, const void* pDestAddress, size_t nDestAddressSize, const BYTE* pRequestData, WORD wDataSize, UCHAR nTTL, UINT& nRouter)
+{
+	// Build the ICMP message the way the datagram backend and the kernel would: the identifier of the socket, the
+	// next sequence number, the request data with the flow word, and the checksum over all of it. The IPv6 pseudo
+	// header is the same for every request to the destination, so it is left out of the checksum
+	++m_wSequence;
+	++m_nRequestsSent;
+	m_Packet.assign(static_cast<size_t>(8) + wDataSize, 0);
+	BYTE* pPacket{ m_Packet.data() };
+	pPacket[0] = (nFamily == AF_INET6) ? 128 : 8; // ICMPv6 / ICMP echo request
+	const WORD wIdentifier{ htons(m_wIdentifier) };
+	const WORD wSequence{ htons(m_wSequence) };
+	memcpy(pPacket + 4, &wIdentifier, sizeof(wIdentifier));
+	memcpy(pPacket + 6, &wSequence, sizeof(wSequence));
+	if (wDataSize)
+		memcpy(pPacket + 8, pRequestData, wDataSize);
+	ApplyFlow(m_wSequence, pPacket + 8, wDataSize);
+	const WORD wChecksum{ InternetChecksum(pPacket, m_Packet.size()) };
+	memcpy(pPacket + 2, &wChecksum, sizeof(wChecksum));
+
+	// Walk the network, every router choosing its next hop from the flow of the request
+	nRouter = 0;
+	for (UCHAR nHop{ 1 }; ; nHop++)
+	{
+		const CSimulatedRouter& router{ m_Routers.at(nRouter) };
+		if (nRouter == m_nDestination)
+			return IP_SUCCESS;
+		if (nHop >= nTTL)
+			return IP_TTL_EXPIRED_TRANSIT;
+		if (router.arrNextHops.empty())
+			return IP_DEST_HOST_UNREACHABLE;
+		DWORD nHash{ HashBytes(2166136261U, &nRouter, sizeof(nRouter)) };
+		nHash = HashBytes(nHash, pDestAddress, nDestAddressSize);
+		nHash = HashBytes(nHash, pPacket, 6);
+		nRouter = router.arrNextHops[MixHash(nHash) % router.arrNextHops.size()];
+	}
+}
+
+/**
+ * @brief Answers an IPv4 echo request from the simulated network
+ * @param destAddress The destination of the request
+ * @param pSrcAddress Not used
+ * @param optionInfo The options of the request; only the TTL is used
+ * @param pRequestData The request data
+ * @param wDataSize Size of the request data in bytes
+ * @param pr Receives the reply
+ * @param dwTimeout Timeout in milliseconds; a router further away than that does not answer in time
+ * @return true if the request was answered, false otherwise; GetLastError tells why
+ */
+bool CSimulatedEcmpBackend::SendEchov4(const SOCKADDR_IN& destAddress, const SOCKADDR_IN* /*pSrcAddress*/, const IP_OPTION_INFORMATION& optionInfo, const BYTE* pRequestData, WORD wDataSize, CPingReplyv4& pr, DWORD dwTimeout)
+{
+	if ((m_nFamily != AF_INET) || m_Routers.empty())
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return false;
+	}
+
+	UINT nRouter{ 0 };
+	const ULONG nStatus{ Route(AF_INET, &destAddress.sin_addr, sizeof(destAddress.sin_addr), pRequestData, wDataSize, optionInfo.Ttl, nRouter) };
+	const CSimulatedRouter& router{ m_Routers[nRouter] };
+	if (router.nDelay > dwTimeout * 1000ULL)
+	{
+		SetLastError(ERROR_TIMEOUT);
+		return false;
+	}
+	pr.Address = router.Addressv4;
+	pr.RTT = router.nDelay;
+	pr.EchoReplyStatus = nStatus;
+	SetLastError(ERROR_SUCCESS);
+	return true;
+}
+
+/**
+ * @brief Answers an IPv6 echo request from the simulated network
+ * @param destAddress The destination of the request
+ * @param srcAddress Not used
+ * @param optionInfo The options of the request; only the hop limit is used
+ * @param pRequestData The request data
+ * @param wDataSize Size of the request data in bytes
+ * @param pr Receives the reply
+ * @param dwTimeout Timeout in milliseconds; a router further away than that does not answer in time
+ * @return true if the request was answered, false otherwise; GetLastError tells why
+ */
+bool CSimulatedEcmpBackend::SendEchov6(const SOCKADDR_IN6& destAddress, const SOCKADDR_IN6& /*srcAddress*/, const IP_OPTION_INFORMATION& optionInfo, const BYTE* pRequestData, WORD wDataSize, CPingReplyv6& pr, DWORD dwTimeout)
+{
+	if ((m_nFamily != AF_INET6) || m_Routers.empty())
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return false;
+	}
+
+	UINT nRouter{ 0 };
+	ULONG nStatus{ Route(AF_INET6, &destAddress.sin6_addr, sizeof(destAddress.sin6_addr), pRequestData, wDataSize, optionInfo.Ttl, nRouter) };
+	if (nStatus == IP_TTL_EXPIRED_TRANSIT)
+		nStatus = IP_HOP_LIMIT_EXCEEDED;
+	else if (nStatus == IP_DEST_HOST_UNREACHABLE)
+		nStatus = IP_DEST_ADDR_UNREACHABLE;
+	const CSimulatedRouter& router{ m_Routers[nRouter] };
+	if (router.nDelay > dwTimeout * 1000ULL)
+	{
+		SetLastError(ERROR_TIMEOUT);
+		return false;
+	}
+	pr.Address = router.Addressv6;
+	pr.RTT = router.nDelay;
+	pr.EchoReplyStatus = nStatus;
+	SetLastError(ERROR_SUCCESS);
+	return true;
+}
@@ -0,0 +1,97 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// SimulatedEcmpBackend.h : interface of the CSimulatedEcmpBackend class, a ping backend which answers from a
+// simulated network of per flow (ECMP) load balancing routers instead of sending anything.
+//
+
+#pragma once
+
+#include "ping.h"
+#include <vector>
+
+// A router of the simulated network
+struct CSimulatedRouter
+{
+	SOCKADDR_IN Addressv4{};              // The address it answers IPv4 requests from
+	SOCKADDR_IN6 Addressv6{};             // The address it answers IPv6 requests from
+	std::vector<UINT> arrNextHops;        // The routers one hop further, between which it balances per flow
+	ULONGLONG nDelay{ 0 };                // The round trip time of a request which it answers, in microseconds
+};
+
+// CSimulatedEcmpBackend: routes every request through the simulated network the way per flow load balancers
+// would, and answers it like the network would. It keeps an identifier per Open and a sequence number per
+// request like the datagram backend, puts the same flow word into the request data, and computes the ICMP
+// checksum of each request, so the checksum it balances on is the one a real request would carry. Each router
+// picks its next hop from a hash of the type, code, checksum and identifier of the request and of the
+// destination address, salted with the router itself so the choices of consecutive routers are independent.
+// The first router is at TTL 1; a request whose TTL runs out is answered with a time exceeded from the router it
+// is at, and one which gets to the destination router with an echo reply from it, whatever the destination
+// address of the request. CSimulatedEcmpBackend is meant for testing flow stable and multipath traces; it sends
+// nothing to the network and is not thread safe.
+//
+// The built-in network has 7 hops. The first router balances over 2, each of which balances over its own 2; all
+// 4 meet again at hop 4, which balances over 3; 2 of those go on to one router at hop 6 and the third to
+// another, and both of them lead to the destination:
+//
+//                      +- 10.0.3.1 -+
+//          +- 10.0.2.1 +            |                +- 10.0.5.1 -+
+//          |           +- 10.0.3.2 -+                |            +- 10.0.6.1 -+
+// 10.0.1.1 +                        +- 10.0.4.1 -----+- 10.0.5.2 -+            +- 10.0.7.1
+//          |           +- 10.0.3.3 -+                |                         |
+//          +- 10.0.2.2 +            |                +- 10.0.5.3 --- 10.0.6.2 -+
+//                      +- 10.0.3.4 -+
+//
+// The IPv6 addresses are fd00::<hop>:<router> in the same places, and every hop adds 1 ms to the round trip time.
+class CSimulatedEcmpBackend : public CPingBackend
+{
+public:
+	CSimulatedEcmpBackend();
+	CSimulatedEcmpBackend(const CSimulatedEcmpBackend&) = delete;
+	CSimulatedEcmpBackend(CSimulatedEcmpBackend&&) = delete;
+	virtual ~CSimulatedEcmpBackend() = default;
+
+	CSimulatedEcmpBackend& operator=(const CSimulatedEcmpBackend&) = delete;
+	CSimulatedEcmpBackend& operator=(CSimulatedEcmpBackend&&) = delete;
+
+	// The network
+	void LoadDefaultNetwork();                                     // The built-in network above; the constructor loads it
+	void Clear();                                                  // No routers
+	UINT AddRouter(const SOCKADDR_IN& addressv4, const SOCKADDR_IN6& addressv6, ULONGLONG nDelay); // Returns its index; the first one added is at TTL 1
+	void AddLink(UINT nFrom, UINT nTo);                            // nTo becomes one of the next hops of nFrom
+	void SetDestination(UINT nRouter) noexcept { m_nDestination = nRouter; } // The router which is the destination
+	const std::vector<CSimulatedRouter>& GetRouters() const noexcept { return m_Routers; }
+	UINT GetDestination() const noexcept { return m_nDestination; }
+	ULONGLONG GetRequestsSent() const noexcept { return m_nRequestsSent; }
+
+	// CPingBackend
+	bool Open(int nFamily) override;
+	void Close() noexcept override;
+	bool IsOpen() const noexcept override { return m_nFamily != AF_UNSPEC; }
+	bool SupportsFlow() const noexcept override { return true; }
+	bool SendEchov4(const SOCKADDR_IN& destAddress, const SOCKADDR_IN* pSrcAddress, const IP_OPTION_INFORMATION& optionInfo, const BYTE* pRequestData, WORD wDataSize, CPingReplyv4& pr, DWORD dwTimeout) override;
+	bool SendEchov6(const SOCKADDR_IN6& destAddress, const SOCKADDR_IN6& srcAddress, const IP_OPTION_INFORMATION& optionInfo, const BYTE* pRequestData, WORD wDataSize, CPingReplyv6& pr, DWORD dwTimeout) override;
+
+protected:
+	ULONG Route(int nFamily, const void* pDestAddress, size_t nDestAddressSize, const BYTE* pRequestData, WORD wDataSize, UCHAR nTTL, UINT& nRouter);
+
+	std::vector<CSimulatedRouter> m_Routers;        // The routers, the one at TTL 1 first
+	UINT m_nDestination;                            // The index of the destination router
+	int m_nFamily;                                  // The family of the last Open, AF_UNSPEC when closed
+	WORD m_wIdentifier;                             // The identifier of the requests since the last Open
+	WORD m_wSequence;                               // The sequence number of the last request
+	std::vector<BYTE> m_Packet;                     // Scratch space for the ICMP message of a request
+	ULONGLONG m_nRequestsSent;                      // Requests routed since construction
+};
@@ -0,0 +1,156 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// AdaptiveTimeoutTest.cpp : unit test of CAdaptiveTimeout, and of the adaptive timeouts of CTraceRoute on a
+// simulated path with a slow (satellite) hop behind fast ones.
+//
+
+#include "pch.h"
+#include "tracer.h"
+#include "Check.h"
+
+namespace
+{
+	// The simulated path: hops 1 to 4 answer in a few milliseconds, hop 5 onwards are behind a 600 ms satellite
+	// link, and the destination is hop 8. Hop 2 drops every second probe sent to it. Nothing is sent; every probe
+	// is answered (or lost) at once, and the time a real one would have taken is added to the simulated clock
+	class CSimulatedPath : public CTraceRoute
+	{
+	public:
+		static constexpr UCHAR DESTINATION_HOP{ 8 };
+		static constexpr UCHAR SATELLITE_HOP{ 5 };
+
+		bool Pingv4(const SOCKADDR_IN& destAddress, CHostTraceSingleReplyv4& htsr, UCHAR nTTL, DWORD dwTimeout, WORD /*wDataSize*/, UCHAR /*nTOS*/,
+			bool /*bDontFragment*/, bool /*bFlagReverse*/, const SOCKADDR_IN* /*pLocalAddress*/) override
+		{
+			const UCHAR nHop{ (nTTL < DESTINATION_HOP) ? nTTL : DESTINATION_HOP };
+			const ULONGLONG nProbe{ m_arrProbes[nHop]++ };
+
+			// A few milliseconds per hop with some jitter, plus 600 ms from the satellite hop on
+			ULONGLONG nRTT{ (2000ULL * nHop) + (300ULL * (nProbe % 3)) };
+			if (nHop >= SATELLITE_HOP)
+				nRTT += 600000;
+
+			if (((nHop == 2) && ((nProbe % 2) == 1)) || (nRTT > (1000ULL * dwTimeout)))
+			{
+				m_nClock += 1000ULL * dwTimeout;
+				SetLastError(ERROR_TIMEOUT);
+				return false;
+			}
+			m_nClock += nRTT;
+			htsr = CHostTraceSingleReplyv4{};
+			htsr.Address.sin_family = AF_INET;
+			htsr.Address.sin_addr.s_addr = (nHop == DESTINATION_HOP) ? destAddress.sin_addr.s_addr : htonl(0x0A000000 + nHop);
+			htsr.RTT = nRTT;
+			htsr.nStatus = (nHop == DESTINATION_HOP) ? IP_SUCCESS : IP_TTL_EXPIRED_TRANSIT;
+			return true;
+		}
+
+		ULONGLONG GetClock() const noexcept { return m_nClock; }
+
+	protected:
+		ULONGLONG m_arrProbes[DESTINATION_HOP + 1]{}; // Probes sent to every hop
+		ULONGLONG m_nClock{ 0 };                      // Microseconds the probes would have taken
+	};
+
+	/**
+	 * @brief Traces the simulated path
+	 * @param tr The simulated path
+	 * @param trr Receives the hops
+	 * @return Whether the trace succeeded
+	 */
+	bool TracePath(CSimulatedPath& tr, CTraceRoute::CReplyv4& trr)
+	{
+		SOCKADDR_IN destAddress{};
+		destAddress.sin_family = AF_INET;
+		destAddress.sin_addr.s_addr = htonl(0xC0000201);
+		return tr.Tracev4(destAddress, trr, 30, 5000, 3);
+	}
+
+	// The timeout is the ceiling until the first answer, then follows RFC 6298 within the floor and the ceiling
+	void TestEstimator()
+	{
+		CAdaptiveTimeout timeout;
+		timeout.SetBounds(200, 5000);
+		CHECK(!timeout.HasEstimate());
+		CHECK(timeout.GetTimeout() == 5000);
+
+		// SRTT 10 ms, RTTVAR 5 ms: 30 ms, raised to the floor
+		timeout.AddSample(10000);
+		CHECK(timeout.HasEstimate());
+		CHECK(timeout.GetTimeout() == 200);
+
+		// Every loss doubles the timeout, up to the ceiling, until the next answer
+		timeout.AddLoss(200);
+		CHECK(timeout.GetTimeout() == 400);
+		timeout.AddLoss(400);
+		CHECK(timeout.GetTimeout() == 800);
+		for (int i = 0; i < 10; i++)
+			timeout.AddLoss(timeout.GetTimeout());
+		CHECK(timeout.GetTimeout() == 5000);
+		CHECK(timeout.GetLosses() == 12);
+		CHECK(timeout.GetFixedLossWait() == 12 * 5000);
+		timeout.AddSample(10000);
+		CHECK(timeout.GetTimeout() == 200);
+
+		// SRTT 600 ms, RTTVAR 300 ms: 1.8 s
+		CAdaptiveTimeout slow;
+		slow.SetBounds(200, 5000);
+		slow.AddSample(600000);
+		CHECK(slow.GetTimeout() == 1800);
+
+		timeout.Reset();
+		CHECK(!timeout.HasEstimate());
+		CHECK(timeout.GetLosses() == 0);
+		CHECK(timeout.GetTimeout() == 5000);
+	}
+
+	// Adaptive timeouts are off unless asked for, and then a slow hop behind fast ones is not declared lost: it is
+	// given the full timeout until it has answered itself. Waiting for the probes which are lost still gets shorter
+	void TestSlowHop()
+	{
+		CSimulatedPath fixed;
+		CHECK(!fixed.GetAdaptiveTimeout());
+		CTraceRoute::CReplyv4 trrFixed;
+		CHECK(TracePath(fixed, trrFixed));
+
+		CSimulatedPath adaptive;
+		adaptive.SetAdaptiveTimeout(true, 200);
+		CTraceRoute::CReplyv4 trr;
+		CHECK(TracePath(adaptive, trr));
+		CHECK(adaptive.GetStopReason() == CTraceRoute::StopReason::DestinationReached);
+		CHECK(trr.size() == CSimulatedPath::DESTINATION_HOP);
+		const std::vector<CAdaptiveTimeout>& arrTimeouts{ adaptive.GetHopTimeouts() };
+		for (size_t i = 0; (i < trr.size()) && (i < arrTimeouts.size()); i++)
+		{
+			CHECK(trr[i].nStatus != IP_REQ_TIMED_OUT);
+			if (i != 1)
+				CHECK(arrTimeouts[i].GetLosses() == 0);
+		}
+		CHECK((trr.size() == trrFixed.size()) && (memcmp(&trr.back().Address, &trrFixed.back().Address, sizeof(trr.back().Address)) == 0));
+
+		// Hop 2 answered before its probe was lost, so that probe was given up after the floor rather than 5 s
+		CHECK((arrTimeouts.size() > 1) && (arrTimeouts[1].GetLosses() == 1));
+		CHECK((arrTimeouts.size() > 1) && (arrTimeouts[1].GetLossWait() == 200));
+		CHECK(adaptive.GetClock() + 4800000 == fixed.GetClock());
+	}
+}
+
+int main()
+{
+	TestEstimator();
+	TestSlowHop();
+	return CheckResult("AdaptiveTimeoutTest");
+}
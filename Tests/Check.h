@@ -0,0 +1,50 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// Check.h : the assertion macro of the Linux unit tests. A failed CHECK prints where it failed and the test
+// carries on; CheckResult gives the exit code of the test.
+//
+
+#pragma once
+
+#include <cstdio>
+
+inline int g_nCheckFailures{ 0 };
+
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			std::printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expression); \
+			++g_nCheckFailures; \
+		} \
+	} while (false)
+
+/**
+ * @brief Reports the outcome of a test
+ * @param pszTest The name of the test
+ * @return The exit code of the test: 0 if every check passed, otherwise 1
+ */
+inline int CheckResult(const char* pszTest)
+{
+	if (g_nCheckFailures != 0)
+	{
+		std::printf("%s: %d checks failed\n", pszTest, g_nCheckFailures);
+		return 1;
+	}
+	std::printf("%s: all checks passed\n", pszTest);
+	return 0;
+}
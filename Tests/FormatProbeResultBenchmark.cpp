@@ -0,0 +1,189 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// FormatProbeResultBenchmark.cpp : measures turning a result record and the UTF-16 name of its replier into a
+// UTF-8 result line with CUtf8Writer and FormatProbeResult, against the path they replaced: the name converted
+// by W2UTF8 into a CStringA and copied into a std::string, the line formatted with snprintf and inet_ntop, and
+// copied into a std::string for the batcher. WideCharToMultiByte and CStringA do not exist here, so the old
+// conversion is stood in for by the same two passes (measure, then convert into a new string) with wcrtomb.
+//
+// Usage: FormatProbeResultBenchmark [lines]
+//
+
+#include "pch.h"
+#include "ProbeResult.h"
+#include "Utf8Writer.h"
+#include "ping.h"
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+
+namespace
+{
+	/**
+	 * @brief The replaced W2UTF8: measures the UTF-8 length of the text, then converts it into a new string
+	 * @param strText The UTF-16 text
+	 * @return The UTF-8 text
+	 */
+	std::string LegacyW2UTF8(const std::wstring& strText)
+	{
+		char szCharacter[MB_LEN_MAX]{};
+		std::mbstate_t state{};
+		size_t nLength{ 0 };
+		for (const wchar_t ch : strText)
+			nLength += std::wcrtomb(szCharacter, ch, &state);
+		std::string strUTF8(nLength, '\0');
+		state = std::mbstate_t{};
+		size_t nOffset{ 0 };
+		for (const wchar_t ch : strText)
+			nOffset += std::wcrtomb(&strUTF8[nOffset], ch, &state);
+		return strUTF8;
+	}
+
+	/**
+	 * @brief The replaced FormatProbeResult, which used snprintf and inet_ntop
+	 */
+	size_t LegacyFormatProbeResult(const CProbeResult& result, const char* pszHost, const char* pszStatusText, char* pszBuffer, size_t nBufferSize)
+	{
+		if ((pszBuffer == nullptr) || (nBufferSize == 0))
+			return 0;
+		pszBuffer[0] = '\0';
+		if (pszStatusText == nullptr)
+			pszStatusText = "";
+		const bool bHost{ (pszHost != nullptr) && (pszHost[0] != '\0') };
+
+		char szAddress[64]{};
+		if (result.nFamily != AF_UNSPEC)
+			inet_ntop(result.nFamily, result.Address, szAddress, sizeof(szAddress));
+
+		int nLength{ 0 };
+		switch (result.nType)
+		{
+		case CProbeResultType::PingReply:
+			if (result.nStatus == IP_SUCCESS)
+			{
+				if (bHost)
+					nLength = snprintf(pszBuffer, nBufferSize, "Reply from %s [%s], bytes=%u, time=%llu.%03llums TTL=%u", szAddress, pszHost, static_cast<UINT>(result.nDataSize),
+						result.nRTT / 1000ULL, result.nRTT % 1000ULL, static_cast<UINT>(result.nTTL));
+				else
+					nLength = snprintf(pszBuffer, nBufferSize, "Reply from %s, bytes=%u, time=%llu.%03llums TTL=%u", szAddress, static_cast<UINT>(result.nDataSize),
+						result.nRTT / 1000ULL, result.nRTT % 1000ULL, static_cast<UINT>(result.nTTL));
+			}
+			else if (bHost)
+				nLength = snprintf(pszBuffer, nBufferSize, "Reply from %s [%s]: %s", szAddress, pszHost, pszStatusText);
+			else
+				nLength = snprintf(pszBuffer, nBufferSize, "Reply from %s: %s", szAddress, pszStatusText);
+			break;
+		case CProbeResultType::PingError:
+			nLength = snprintf(pszBuffer, nBufferSize, "%s", pszStatusText);
+			break;
+		case CProbeResultType::HopReply:
+			if (bHost)
+				nLength = snprintf(pszBuffer, nBufferSize, "  %u\t%llu.%03llums\t%llu.%03llums\t%llu.%03llums\t%s [%s]", static_cast<UINT>(result.nHop), result.nRTT / 1000ULL, result.nRTT % 1000ULL,
+					result.nAvgRTT / 1000ULL, result.nAvgRTT % 1000ULL, result.nMaxRTT / 1000ULL, result.nMaxRTT % 1000ULL, pszHost, szAddress);
+			else
+				nLength = snprintf(pszBuffer, nBufferSize, "  %u\t%llu.%03llums\t%llu.%03llums\t%llu.%03llums\t%s", static_cast<UINT>(result.nHop), result.nRTT / 1000ULL, result.nRTT % 1000ULL,
+					result.nAvgRTT / 1000ULL, result.nAvgRTT % 1000ULL, result.nMaxRTT / 1000ULL, result.nMaxRTT % 1000ULL, szAddress);
+			break;
+		case CProbeResultType::HopError:
+			if (result.nStatus == ERROR_TIMEOUT)
+				nLength = snprintf(pszBuffer, nBufferSize, "  %u\t*\t*\t*\tRequest timed out.", static_cast<UINT>(result.nHop));
+			else
+				nLength = snprintf(pszBuffer, nBufferSize, "  %u\t*\t*\t*\tError:%s", static_cast<UINT>(result.nHop), pszStatusText);
+			break;
+		case CProbeResultType::Text:
+		default:
+			break;
+		}
+		if (nLength < 0)
+			return 0;
+		return (static_cast<size_t>(nLength) < nBufferSize) ? static_cast<size_t>(nLength) : (nBufferSize - 1);
+	}
+
+	/**
+	 * @brief Makes the records of a ping and a trace: IPv4 and IPv6 replies and hops, and timed out hops
+	 * @param nRecord The number of the record
+	 * @return The record
+	 */
+	CProbeResult MakeRecord(size_t nRecord)
+	{
+		CProbeResult result{};
+		const CProbeResultType types[]{ CProbeResultType::PingReply, CProbeResultType::HopReply, CProbeResultType::PingReply, CProbeResultType::HopError };
+		result.nType = types[nRecord % 4];
+		result.nStatus = (result.nType == CProbeResultType::HopError) ? ERROR_TIMEOUT : IP_SUCCESS;
+		result.nRTT = 1000 + ((nRecord * 7919) % 250000);
+		result.nAvgRTT = result.nRTT + 250;
+		result.nMaxRTT = result.nRTT + 900;
+		result.nDataSize = 32;
+		result.nHop = static_cast<BYTE>(1 + (nRecord % 30));
+		result.nTTL = 57;
+		if ((nRecord % 8) < 4)
+		{
+			result.nFamily = AF_INET;
+			const BYTE address[4]{ 192, 0, 2, static_cast<BYTE>(nRecord) };
+			memcpy(result.Address, address, sizeof(address));
+		}
+		else
+		{
+			result.nFamily = AF_INET6;
+			const BYTE address[16]{ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, static_cast<BYTE>(nRecord) };
+			memcpy(result.Address, address, sizeof(address));
+		}
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t nLines{ (argc > 1) ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 1000000U };
+	std::setlocale(LC_ALL, "C.UTF-8");
+	std::vector<CProbeResult> arrRecords;
+	for (size_t i{ 0 }; i < 1024; i++)
+		arrRecords.push_back(MakeRecord(i));
+	const std::wstring strHost{ L"router-42.core.example.net" };
+
+	// The old path, per line: W2UTF8 of the name, a std::string of it, snprintf and a std::string of the line
+	size_t nLegacyBytes{ 0 };
+	ULONGLONG nStart{ CPingClock::NowMicroseconds() };
+	for (size_t i{ 0 }; i < nLines; i++)
+	{
+		const std::string strName{ LegacyW2UTF8(strHost) };
+		char szLine[256];
+		const size_t nLength{ LegacyFormatProbeResult(arrRecords[i % arrRecords.size()], strName.c_str(), "", szLine, sizeof(szLine)) };
+		const std::string strLine(szLine, nLength);
+		nLegacyBytes += strLine.size();
+	}
+	const double fLegacy{ static_cast<double>(CPingClock::NowMicroseconds() - nStart) * 1000.0 / static_cast<double>(nLines) };
+
+	// The new path, per line: the name and the line written into stack buffers
+	size_t nBytes{ 0 };
+	nStart = CPingClock::NowMicroseconds();
+	for (size_t i{ 0 }; i < nLines; i++)
+	{
+		char szName[128];
+		CUtf8Writer name{ szName, sizeof(szName) };
+		name.AppendWide(strHost.c_str(), strHost.size());
+		char szLine[256];
+		nBytes += FormatProbeResult(arrRecords[i % arrRecords.size()], name.GetString(), "", szLine, sizeof(szLine));
+	}
+	const double fWriter{ static_cast<double>(CPingClock::NowMicroseconds() - nStart) * 1000.0 / static_cast<double>(nLines) };
+
+	// The lines now also carry the span which holds the name of the replier, so they are longer than the old ones
+	std::printf("%zu lines\n", nLines);
+	std::printf("%-36s %8.1f ns per line, %5.1f bytes on average\n", "W2UTF8, snprintf and std::string", fLegacy, static_cast<double>(nLegacyBytes) / static_cast<double>(nLines));
+	std::printf("%-36s %8.1f ns per line, %5.1f bytes on average\n", "CUtf8Writer and FormatProbeResult", fWriter, static_cast<double>(nBytes) / static_cast<double>(nLines));
+	return ((nBytes != 0) && (nLegacyBytes != 0)) ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// HtmlReportWriterBenchmark.cpp : measures what it costs to add a line to a results file of 1k, 10k and 100k
+// lines with CHtmlReportWriter::Append, against rewriting the whole document for every line as the view used to.
+//
+// Usage: HtmlReportWriterBenchmark [lines]
+//
+
+#include "pch.h"
+#include "HtmlReportWriter.h"
+#include "ping.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	const std::string g_strHeader{ "<!DOCTYPE html>\n<html lang=\"en\">\n<head><meta charset=\"utf-8\"><title>NetVoyager</title></head>\n<body>\n" };
+	const std::string g_strFooter{ "</body>\n</html>\n" };
+
+	/**
+	 * @brief Makes the text of a result line
+	 * @param nLine The number of the line
+	 * @return A line like the ones a ping writes
+	 */
+	std::string MakeLine(size_t nLine)
+	{
+		char szLine[128]{};
+		std::snprintf(szLine, sizeof(szLine), "Reply from 192.0.2.%zu: bytes=32 time=%zu.%03zu ms TTL=57", nLine % 256, 10 + (nLine % 7), nLine % 1000);
+		return szLine;
+	}
+
+	/**
+	 * @brief Writes the whole document, the way every line used to be saved
+	 * @param strFileName The results file
+	 * @param arrLines The lines of the document
+	 */
+	void RewriteDocument(const std::string& strFileName, const std::vector<std::string>& arrLines)
+	{
+		std::ofstream file{ strFileName, std::ofstream::out };
+		file << g_strHeader;
+		for (const auto& strLine : arrLines)
+			file << strLine << "<br>\n";
+		file << g_strFooter;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t nLines{ (argc > 1) ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 100000U };
+	const std::filesystem::path directory{ std::filesystem::temp_directory_path() };
+	const std::string strAppendFile{ (directory / "HtmlReportWriterBenchmark.append.html").string() };
+	const std::string strRewriteFile{ (directory / "HtmlReportWriterBenchmark.rewrite.html").string() };
+	const size_t nBlock{ 1000 };
+
+	// Append every line, timing the last block of lines before each checkpoint
+	CHtmlReportWriter writer;
+	if (!writer.Open(strAppendFile.c_str(), g_strHeader, g_strFooter))
+	{
+		std::printf("Cannot create %s\n", strAppendFile.c_str());
+		return 1;
+	}
+	std::vector<std::string> arrLines;
+	arrLines.reserve(nLines);
+	std::vector<std::pair<size_t, double>> arrAppendCosts;
+	const ULONGLONG nStart{ CPingClock::NowMicroseconds() };
+	ULONGLONG nBlockStart{ nStart };
+	for (size_t i{ 1 }; i <= nLines; i++)
+	{
+		arrLines.push_back(MakeLine(i));
+		if (!writer.Append(arrLines.back()))
+		{
+			std::printf("Cannot append to %s\n", strAppendFile.c_str());
+			return 1;
+		}
+		if ((i % nBlock) == 0)
+		{
+			const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+			if ((i == nBlock) || (i == 10 * nBlock) || (i == 100 * nBlock) || (i == nLines))
+				arrAppendCosts.emplace_back(i, static_cast<double>(nNow - nBlockStart) / nBlock);
+			nBlockStart = nNow;
+		}
+	}
+	const double fAppendTotal{ static_cast<double>(CPingClock::NowMicroseconds() - nStart) / 1000000.0 };
+	writer.Close();
+
+	// The n-th line used to cost a rewrite of a document of n lines
+	std::printf("%10s %22s %22s\n", "lines", "Append per line", "rewrite per line");
+	double fRewriteLast{ 0.0 };
+	for (const auto& [nAt, fAppend] : arrAppendCosts)
+	{
+		const std::vector<std::string> arrDocument(arrLines.begin(), arrLines.begin() + static_cast<std::ptrdiff_t>(nAt));
+		const int nRepeats{ 3 };
+		const ULONGLONG nRewriteStart{ CPingClock::NowMicroseconds() };
+		for (int i{ 0 }; i < nRepeats; i++)
+			RewriteDocument(strRewriteFile, arrDocument);
+		fRewriteLast = static_cast<double>(CPingClock::NowMicroseconds() - nRewriteStart) / nRepeats;
+		std::printf("%10zu %19.2f us %19.1f us\n", nAt, fAppend, fRewriteLast);
+	}
+
+	// Rewriting costs about the same per byte, so all n rewrites add up to about n / 2 times the last one
+	std::printf("%zu lines: %.2f s with Append, about %.0f s rewriting the document for every line\n", nLines, fAppendTotal, fRewriteLast * static_cast<double>(nLines) / 2.0 / 1000000.0);
+	std::filesystem::remove(strAppendFile);
+	std::filesystem::remove(strRewriteFile);
+	return 0;
+}
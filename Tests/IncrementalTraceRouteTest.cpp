@@ -0,0 +1,239 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IncrementalTraceRouteTest.cpp : unit test of CIncrementalTraceRoute against a simulated network whose route
+// is changed between the traces.
+//
+
+#include "pch.h"
+#include "IncrementalTraceRoute.h"
+#include "SimulatedEcmpBackend.h"
+#include "Check.h"
+
+namespace
+{
+	// The routes of the simulated network, one router per hop and no load balancing
+	enum class SimulatedRoute
+	{
+		Original,                         // 10.0.1.1 ... 10.0.5.1, then the destination 10.0.9.1 at hop 6
+		NewMiddle,                        // Hops 4 and 5 go through 10.0.4.2 and 10.0.5.2 instead
+		LongerTail                        // A new router 10.0.6.1 at hop 6 puts the destination at hop 7
+	};
+
+	const DWORD PINGS_PER_HOST{ 3 };
+
+	/**
+	 * @brief Makes the IPv4 address of a router of the simulated network
+	 * @param nHop Its hop
+	 * @param nRouter Its number within the hop
+	 * @return 10.0.<hop>.<router>
+	 */
+	SOCKADDR_IN RouterAddress(BYTE nHop, BYTE nRouter) noexcept
+	{
+		SOCKADDR_IN address{};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(0x0A000000U | (static_cast<ULONG>(nHop) << 8) | nRouter);
+		return address;
+	}
+
+	// A simulated network whose route the test can change: every session loads the current route before a request
+	class CSwitchableBackend : public CSimulatedEcmpBackend
+	{
+	public:
+		explicit CSwitchableBackend(const SimulatedRoute& route) noexcept : m_Route{ route }, m_Loaded{ route }
+		{
+			Load();
+		}
+
+		bool SendEchov4(const SOCKADDR_IN& destAddress, const SOCKADDR_IN* pSrcAddress, const IP_OPTION_INFORMATION& optionInfo, const BYTE* pRequestData, WORD wDataSize, CPingReplyv4& pr, DWORD dwTimeout) override
+		{
+			if (m_Loaded != m_Route)
+			{
+				m_Loaded = m_Route;
+				Load();
+			}
+			return CSimulatedEcmpBackend::SendEchov4(destAddress, pSrcAddress, optionInfo, pRequestData, wDataSize, pr, dwTimeout);
+		}
+
+	protected:
+		void Load()
+		{
+			Clear();
+			std::vector<SOCKADDR_IN> arrHops;
+			for (BYTE nHop = 1; nHop <= 5; nHop++)
+				arrHops.push_back(RouterAddress(nHop, ((nHop >= 4) && (m_Loaded == SimulatedRoute::NewMiddle)) ? 2 : 1));
+			if (m_Loaded == SimulatedRoute::LongerTail)
+				arrHops.push_back(RouterAddress(6, 1));
+			arrHops.push_back(RouterAddress(9, 1));
+			for (size_t i = 0; i < arrHops.size(); i++)
+			{
+				SOCKADDR_IN6 addressv6{};
+				addressv6.sin6_family = AF_INET6;
+				const UINT nRouter{ AddRouter(arrHops[i], addressv6, 1000ULL * (i + 1)) };
+				if (nRouter > 0)
+					AddLink(nRouter - 1, nRouter);
+				SetDestination(nRouter);
+			}
+		}
+
+		const SimulatedRoute& m_Route;        // The route the test wants
+		SimulatedRoute m_Loaded;             // The route the routers were made for
+	};
+
+	// An incremental traceroute through the simulated network which records the route changes it reports
+	class CSimulatedIncrementalTraceRoute : public CIncrementalTraceRoute
+	{
+	public:
+		SimulatedRoute m_Route{ SimulatedRoute::Original };
+		std::vector<CRouteChange> m_arrChanges;
+
+	protected:
+		std::unique_ptr<CPingBackend> CreateBackend() override
+		{
+			return std::make_unique<CSwitchableBackend>(m_Route);
+		}
+
+		void OnRouteChange(const CRouteChange& change) override
+		{
+			m_arrChanges.push_back(change);
+		}
+	};
+
+	/**
+	 * @brief Gets the IPv4 address of a hop of a trace
+	 * @param trr The hops of the trace
+	 * @param nTTL The hop
+	 * @return Its address in network byte order, 0 if the trace is shorter
+	 */
+	ULONG HopAddress(const CTraceRoute::CReplyv4& trr, size_t nTTL) noexcept
+	{
+		return (nTTL <= trr.size()) ? trr[nTTL - 1].Address.sin_addr.s_addr : 0;
+	}
+
+	/**
+	 * @brief Gets the IPv4 address of a socket address reported in a route change
+	 * @param address The address, AF_INET or AF_UNSPEC
+	 * @return The address in network byte order, 0 for AF_UNSPEC
+	 */
+	ULONG ChangeAddress(const SOCKADDR_STORAGE& address) noexcept
+	{
+		if (address.ss_family != AF_INET)
+			return 0;
+#pragma warning(suppress: 26490)
+		return reinterpret_cast<const SOCKADDR_IN*>(&address)->sin_addr.s_addr;
+	}
+
+	// The first trace probes every hop, and an unchanged path then costs just the two verification probes
+	void TestVerified()
+	{
+		const SOCKADDR_IN destAddress{ RouterAddress(9, 1) };
+		CSimulatedIncrementalTraceRoute tr;
+		CTraceRoute::CReplyv4 trr;
+		CHECK(tr.Retrace(destAddress, trr, 30, 5000, PINGS_PER_HOST));
+		CHECK(tr.GetLastKind() == RetraceKind::Full);
+		CHECK(trr.size() == 6);
+		CHECK(HopAddress(trr, 6) == destAddress.sin_addr.s_addr);
+		CHECK(tr.GetSummary().nProbesSent == 6 * PINGS_PER_HOST);
+
+		for (int i = 0; i < 3; i++)
+		{
+			const ULONGLONG nProbesSent{ tr.GetSummary().nProbesSent };
+			CTraceRoute::CReplyv4 trrAgain;
+			CHECK(tr.Retrace(destAddress, trrAgain, 30, 5000, PINGS_PER_HOST));
+			CHECK(tr.GetLastKind() == RetraceKind::Verified);
+			CHECK(tr.GetSummary().nProbesSent - nProbesSent == 2);
+			CHECK(trrAgain.size() == trr.size());
+			for (size_t nTTL = 1; nTTL <= trr.size(); nTTL++)
+				CHECK(HopAddress(trrAgain, nTTL) == HopAddress(trr, nTTL));
+		}
+		CHECK(tr.GetSummary().nVerified == 3);
+		CHECK(tr.m_arrChanges.empty());
+	}
+
+	// When the last responsive hop changes, the hops before it are probed backwards until one answers as before,
+	// and the route change is reported at the first hop which differs
+	void TestChangedMiddle()
+	{
+		const SOCKADDR_IN destAddress{ RouterAddress(9, 1) };
+		CSimulatedIncrementalTraceRoute tr;
+		CTraceRoute::CReplyv4 trr;
+		CHECK(tr.Retrace(destAddress, trr, 30, 5000, PINGS_PER_HOST));
+
+		tr.m_Route = SimulatedRoute::NewMiddle;
+		const ULONGLONG nProbesSent{ tr.GetSummary().nProbesSent };
+		CHECK(tr.Retrace(destAddress, trr, 30, 5000, PINGS_PER_HOST));
+		CHECK(tr.GetLastKind() == RetraceKind::Partial);
+
+		// The destination, hop 5, then hop 4 which changed too and hop 3 which did not
+		CHECK(tr.GetSummary().nProbesSent - nProbesSent == 4);
+		CHECK(trr.size() == 6);
+		CHECK(HopAddress(trr, 3) == RouterAddress(3, 1).sin_addr.s_addr);
+		CHECK(HopAddress(trr, 4) == RouterAddress(4, 2).sin_addr.s_addr);
+		CHECK(HopAddress(trr, 5) == RouterAddress(5, 2).sin_addr.s_addr);
+		CHECK(tr.m_arrChanges.size() == 1);
+		if (tr.m_arrChanges.size() == 1)
+		{
+			const CRouteChange& change{ tr.m_arrChanges.front() };
+			CHECK(change.nFirstChangedHop == 4);
+			CHECK(ChangeAddress(change.OldAddress) == RouterAddress(4, 1).sin_addr.s_addr);
+			CHECK(ChangeAddress(change.NewAddress) == RouterAddress(4, 2).sin_addr.s_addr);
+			CHECK((change.nOldHops == 6) && (change.nNewHops == 6));
+		}
+
+		// The repaired path is cached
+		CHECK(tr.Retrace(destAddress, trr, 30, 5000, PINGS_PER_HOST));
+		CHECK(tr.GetLastKind() == RetraceKind::Verified);
+		CHECK(tr.m_arrChanges.size() == 1);
+	}
+
+	// When only the last hop changes, just the hops after the last responsive hop are probed again
+	void TestLongerTail()
+	{
+		const SOCKADDR_IN destAddress{ RouterAddress(9, 1) };
+		CSimulatedIncrementalTraceRoute tr;
+		CTraceRoute::CReplyv4 trr;
+		CHECK(tr.Retrace(destAddress, trr, 30, 5000, PINGS_PER_HOST));
+
+		tr.m_Route = SimulatedRoute::LongerTail;
+		const ULONGLONG nProbesSent{ tr.GetSummary().nProbesSent };
+		CHECK(tr.Retrace(destAddress, trr, 30, 5000, PINGS_PER_HOST));
+		CHECK(tr.GetLastKind() == RetraceKind::Partial);
+
+		// The old last hop and hop 5 to verify, then the new destination at hop 7 in full
+		CHECK(tr.GetSummary().nProbesSent - nProbesSent == 2 + PINGS_PER_HOST);
+		CHECK(trr.size() == 7);
+		CHECK(HopAddress(trr, 6) == RouterAddress(6, 1).sin_addr.s_addr);
+		CHECK(HopAddress(trr, 7) == destAddress.sin_addr.s_addr);
+		CHECK(tr.GetStopReason() == CTraceRoute::StopReason::DestinationReached);
+		CHECK(tr.m_arrChanges.size() == 1);
+		if (tr.m_arrChanges.size() == 1)
+		{
+			const CRouteChange& change{ tr.m_arrChanges.front() };
+			CHECK(change.nFirstChangedHop == 6);
+			CHECK(ChangeAddress(change.OldAddress) == destAddress.sin_addr.s_addr);
+			CHECK(ChangeAddress(change.NewAddress) == RouterAddress(6, 1).sin_addr.s_addr);
+			CHECK((change.nOldHops == 6) && (change.nNewHops == 7));
+		}
+		CHECK(tr.GetSummary().nRouteChanges == 1);
+	}
+}
+
+int main()
+{
+	TestVerified();
+	TestChangedMiddle();
+	TestLongerTail();
+	return CheckResult("IncrementalTraceRouteTest");
+}
@@ -0,0 +1,116 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// IpAddressTextTest.cpp : unit test of CIpAddressText against the text which inet_ntop and getnameinfo give.
+//
+
+#include "pch.h"
+#include "IpAddressText.h"
+#include "Check.h"
+#include <cstring>
+
+namespace
+{
+	/**
+	 * @brief Checks that an address is written as inet_ntop writes it and parsed back to the same bytes
+	 * @param nFamily AF_INET or AF_INET6
+	 * @param pszLiteral Any text form of the address
+	 */
+	void CheckAddress(int nFamily, const char* pszLiteral)
+	{
+		BYTE address[16]{};
+		if (inet_pton(nFamily, pszLiteral, address) != 1)
+		{
+			std::printf("inet_pton cannot parse %s\n", pszLiteral);
+			++g_nCheckFailures;
+			return;
+		}
+		char szExpected[CIpAddressText::MAX_LENGTH]{};
+		inet_ntop(nFamily, address, szExpected, sizeof(szExpected));
+		char szText[CIpAddressText::MAX_LENGTH]{};
+		const size_t nLength{ CIpAddressText::Format(nFamily, address, szText, sizeof(szText)) };
+		if (strcmp(szText, szExpected) != 0)
+			std::printf("%s: \"%s\" instead of \"%s\"\n", pszLiteral, szText, szExpected);
+		CHECK(strcmp(szText, szExpected) == 0);
+		CHECK(nLength == strlen(szExpected));
+
+		int nParsedFamily{ AF_UNSPEC };
+		BYTE parsed[16]{};
+		CHECK(CIpAddressText::Parse(pszLiteral, strlen(pszLiteral), nParsedFamily, parsed));
+		CHECK(nParsedFamily == nFamily);
+		CHECK(memcmp(parsed, address, (nFamily == AF_INET) ? 4 : 16) == 0);
+	}
+
+	// Every form of IPv4 and IPv6 address is written as inet_ntop writes it
+	void TestFormat()
+	{
+		const char* arrIPv4[]{ "0.0.0.0", "127.0.0.1", "192.0.2.1", "10.20.30.40", "255.255.255.255" };
+		for (const char* pszLiteral : arrIPv4)
+			CheckAddress(AF_INET, pszLiteral);
+
+		const char* arrIPv6[]{ "::", "::1", "::2", "::0.0.1.0", "::192.0.2.1", "::ffff:192.0.2.1", "::ffff:0:192.0.2.1", "::1:0:0:0:1",
+			"2001:db8::1", "2001:DB8:0:0:1:0:0:1", "2001:db8:0:1:1:1:1:1", "2001:db8::1:0:0:1", "fe80::1", "1::", "1:2:3:4:5:6:7:8",
+			"ff02::1:ff00:1", "0:0:1::", "64:ff9b::192.0.2.1" };
+		for (const char* pszLiteral : arrIPv6)
+			CheckAddress(AF_INET6, pszLiteral);
+	}
+
+	// A socket address is written as getnameinfo(NI_NUMERICHOST) writes it, scope id included
+	void TestSockAddr()
+	{
+		SOCKADDR_IN6 address{};
+		address.sin6_family = AF_INET6;
+		inet_pton(AF_INET6, "fe80::1", &address.sin6_addr);
+		address.sin6_scope_id = 4096;
+		char szText[CIpAddressText::MAX_LENGTH]{};
+		CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&address), sizeof(address), szText, sizeof(szText));
+		CHECK(strcmp(szText, "fe80::1%4096") == 0);
+
+		inet_pton(AF_INET6, "::192.0.2.1", &address.sin6_addr);
+		address.sin6_scope_id = 0;
+		char szExpected[NI_MAXHOST]{};
+		CHECK(getnameinfo(reinterpret_cast<const SOCKADDR*>(&address), sizeof(address), szExpected, sizeof(szExpected), nullptr, 0, NI_NUMERICHOST) == 0);
+		CIpAddressText::Format(reinterpret_cast<const SOCKADDR*>(&address), sizeof(address), szText, sizeof(szText));
+		CHECK(strcmp(szText, szExpected) == 0);
+	}
+
+	// Malformed literals and buffers which are too small are refused
+	void TestRejects()
+	{
+		const char* arrBad[]{ "", "1.2.3", "1.2.3.4.5", "256.1.1.1", "01.2.3.4", "1..2.3", ":::", "1:2:3:4:5:6:7:8:9", "1::2::3", "12345::", "::g", "host.example" };
+		for (const char* pszLiteral : arrBad)
+		{
+			int nFamily{ AF_UNSPEC };
+			BYTE address[16]{};
+			if (CIpAddressText::Parse(pszLiteral, strlen(pszLiteral), nFamily, address))
+				std::printf("\"%s\" was parsed\n", pszLiteral);
+			CHECK(!CIpAddressText::Parse(pszLiteral, strlen(pszLiteral), nFamily, address));
+		}
+
+		const BYTE address[16]{ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+		char szText[11]{ 'x' };
+		CHECK(CIpAddressText::Format(AF_INET6, address, szText, sizeof(szText)) == 0);
+		CHECK(szText[0] == '\0');
+		CHECK(CIpAddressText::Format(AF_INET6, address, szText, 12) == 11);
+	}
+}
+
+int main()
+{
+	TestFormat();
+	TestSockAddr();
+	TestRejects();
+	return CheckResult("IpAddressTextTest");
+}
@@ -0,0 +1,165 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ParisTraceRouteTest.cpp : unit test of CParisTraceRoute against the built-in network of CSimulatedEcmpBackend,
+// whose 7 hops hold 14 routers joined by 18 load balanced links.
+//
+
+#include "pch.h"
+#include "ParisTraceRoute.h"
+#include "SimulatedEcmpBackend.h"
+#include "Check.h"
+#include <set>
+
+namespace
+{
+	// A Paris traceroute whose probes go through the simulated network
+	class CSimulatedParisTraceRoute : public CParisTraceRoute
+	{
+	protected:
+		std::unique_ptr<CPingBackend> CreateBackend() override
+		{
+			return std::make_unique<CSimulatedEcmpBackend>();
+		}
+	};
+
+	using CLink = std::pair<ULONG, ULONG>;
+
+	const CSimulatedEcmpBackend g_Network;
+	const size_t g_nHops{ 7 };
+
+	/**
+	 * @brief Gets the links of the simulated network
+	 * @return The IPv4 addresses (network byte order) of both ends of every link
+	 */
+	std::set<CLink> GetNetworkLinks()
+	{
+		std::set<CLink> links;
+		const std::vector<CSimulatedRouter>& routers{ g_Network.GetRouters() };
+		for (const auto& router : routers)
+			for (const UINT nNextHop : router.arrNextHops)
+				links.emplace(router.Addressv4.sin_addr.s_addr, routers[nNextHop].Addressv4.sin_addr.s_addr);
+		return links;
+	}
+
+	/**
+	 * @brief Tells whether a trace followed a path which exists in the simulated network
+	 * @param trr The hops of the trace
+	 * @return true if the trace has a hop for every TTL up to the destination and every two of them are linked
+	 */
+	bool IsNetworkPath(const CTraceRoute::CReplyv4& trr)
+	{
+		static const std::set<CLink> links{ GetNetworkLinks() };
+		if (trr.size() != g_nHops)
+			return false;
+		for (size_t i = 1; i < trr.size(); i++)
+			if (links.count(CLink{ trr[i - 1].Address.sin_addr.s_addr, trr[i].Address.sin_addr.s_addr }) == 0)
+				return false;
+		return true;
+	}
+
+	/**
+	 * @brief Gets the hop addresses of a trace
+	 * @param trr The hops of the trace
+	 * @return Their IPv4 addresses in network byte order
+	 */
+	std::vector<ULONG> GetPath(const CTraceRoute::CReplyv4& trr)
+	{
+		std::vector<ULONG> arrPath;
+		for (const auto& hop : trr)
+			arrPath.push_back(hop.Address.sin_addr.s_addr);
+		return arrPath;
+	}
+
+	// MDA finds every router and every link of the network, and reaches the destination
+	void TestMultipath()
+	{
+		const std::set<CLink> networkLinks{ GetNetworkLinks() };
+		CSimulatedParisTraceRoute tr;
+		CMultipathResult result;
+		CHECK(tr.EnumeratePaths(g_Network.GetRouters()[g_Network.GetDestination()].Addressv4, result));
+		CHECK(result.arrInterfaces.size() == 14);
+		CHECK(result.arrLinks.size() == 18);
+		CHECK(result.bReached);
+		CHECK(result.bComplete);
+		for (const auto& link : result.arrLinks)
+		{
+			const bool bFound{ (link.nFrom < result.arrInterfaces.size()) && (link.nTo < result.arrInterfaces.size()) };
+			CHECK(bFound);
+			if (!bFound)
+				continue;
+			const CLink ends{ reinterpret_cast<const SOCKADDR_IN*>(&result.arrInterfaces[link.nFrom].Address)->sin_addr.s_addr,
+				reinterpret_cast<const SOCKADDR_IN*>(&result.arrInterfaces[link.nTo].Address)->sin_addr.s_addr };
+			CHECK(networkLinks.count(ends) == 1);
+		}
+
+		CSimulatedParisTraceRoute tr6;
+		CMultipathResult result6;
+		CHECK(tr6.EnumeratePaths(g_Network.GetRouters()[g_Network.GetDestination()].Addressv6, result6));
+		CHECK(result6.arrInterfaces.size() == 14);
+		CHECK(result6.arrLinks.size() == 18);
+		CHECK(result6.bReached);
+		CHECK(result6.bComplete);
+	}
+
+	// A flow stable trace follows one path of the network, and the same one every time it is repeated, sequential
+	// or concurrent; different flows spread over the paths
+	void TestFlowStable()
+	{
+		const SOCKADDR_IN& destAddress{ g_Network.GetRouters()[g_Network.GetDestination()].Addressv4 };
+		std::set<std::vector<ULONG>> paths;
+		for (WORD wFlow = 0; wFlow < 32; wFlow++)
+		{
+			CSimulatedParisTraceRoute tr;
+			tr.SetFlowStable(true, wFlow);
+			CTraceRoute::CReplyv4 trr;
+			CHECK(tr.Tracev4(destAddress, trr, 30, 5000, 3));
+			CHECK(IsNetworkPath(trr));
+			for (int nRepeat = 0; nRepeat < 2; nRepeat++)
+			{
+				tr.SetConcurrentProbing(nRepeat == 1);
+				CTraceRoute::CReplyv4 trrRepeat;
+				CHECK(tr.Tracev4(destAddress, trrRepeat, 30, 5000, 3));
+				CHECK(GetPath(trrRepeat) == GetPath(trr));
+			}
+			paths.insert(GetPath(trr));
+		}
+		CHECK(paths.size() > 1);
+	}
+
+	// Without flow stable probes every probe may take another path, so traces mix hops of different paths
+	void TestMixedPaths()
+	{
+		const SOCKADDR_IN& destAddress{ g_Network.GetRouters()[g_Network.GetDestination()].Addressv4 };
+		int nMixed{ 0 };
+		for (int i = 0; i < 32; i++)
+		{
+			CSimulatedParisTraceRoute tr;
+			CTraceRoute::CReplyv4 trr;
+			CHECK(tr.Tracev4(destAddress, trr, 30, 5000, 3));
+			if (!IsNetworkPath(trr))
+				++nMixed;
+		}
+		CHECK(nMixed > 0);
+	}
+}
+
+int main()
+{
+	TestMultipath();
+	TestFlowStable();
+	TestMixedPaths();
+	return CheckResult("ParisTraceRouteTest");
+}
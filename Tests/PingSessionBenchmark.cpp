@@ -0,0 +1,110 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// PingSessionBenchmark.cpp : measures the per probe overhead of pinging and tracing 127.0.0.1 with a new
+// ICMP handle / socket for every probe (CPing) against reusing one (CPingSession, CTraceRoute).
+//
+// Usage: PingSessionBenchmark [probes]
+//
+
+#include "pch.h"
+#include "ping.h"
+#include "tracer.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	// CTraceRoute as it probed before sessions were reused: a new CPing, and so a new socket, per probe
+	class CPerProbeTraceRoute : public CTraceRoute
+	{
+	protected:
+		bool Pingv4(const SOCKADDR_IN& destAddress, CHostTraceSingleReplyv4& htsr, UCHAR nTTL, DWORD dwTimeout, WORD wDataSize, UCHAR nTOS, bool bDontFragment, bool bFlagReverse, const SOCKADDR_IN* pLocalAddress) override
+		{
+			CPingReplyv4 pr;
+			const CPing ping;
+			if (!ping.PingUsingICMPv4(destAddress, pr, nTTL, dwTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress))
+				return false;
+			htsr.Address = pr.Address;
+			htsr.RTT = pr.RTT;
+			htsr.nStatus = pr.EchoReplyStatus;
+			return true;
+		}
+	};
+
+	/**
+	 * @brief Runs a probe function a number of times and prints the mean time it took
+	 * @param pszName What is measured
+	 * @param nProbes How many times to run it
+	 * @param probe Sends one probe; returns false if it failed
+	 * @return The mean time per probe in microseconds, or a negative value if a probe failed
+	 */
+	template <typename Probe>
+	double Measure(const char* pszName, unsigned nProbes, Probe probe)
+	{
+		for (unsigned i{ 0 }; i < (nProbes / 10) + 1; i++) // warm up
+		{
+			if (!probe())
+				return -1.0;
+		}
+		const ULONGLONG nStart{ CPingClock::NowMicroseconds() };
+		for (unsigned i{ 0 }; i < nProbes; i++)
+		{
+			if (!probe())
+			{
+				std::printf("%-44s failed, error %lu\n", pszName, static_cast<unsigned long>(GetLastError()));
+				return -1.0;
+			}
+		}
+		const double fMean{ static_cast<double>(CPingClock::NowMicroseconds() - nStart) / nProbes };
+		std::printf("%-44s %8.1f us per probe\n", pszName, fMean);
+		return fMean;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned nProbes{ (argc > 1) ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 5000U };
+	SOCKADDR_IN destAddress{};
+	destAddress.sin_family = AF_INET;
+	destAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	CPingSession session;
+	if (!session.Openv4(destAddress))
+	{
+		std::printf("Cannot open an ICMP socket (error %lu); net.ipv4.ping_group_range must include the group of this user\n", static_cast<unsigned long>(GetLastError()));
+		return 1;
+	}
+	std::printf("%u echo requests to 127.0.0.1 per measurement\n", nProbes);
+
+	// Ping: the per probe open of CPing, with and without the lookup of the host name, against an open session
+	const CPing ping;
+	CPingReplyv4 pr;
+	const double fByName{ Measure("CPing, host name", nProbes, [&]() { return ping.PingUsingICMPv4(_T("127.0.0.1"), pr); }) };
+	const double fByAddress{ Measure("CPing, address", nProbes, [&]() { return ping.PingUsingICMPv4(destAddress, pr); }) };
+	const double fSession{ Measure("CPingSession", nProbes, [&]() { return session.Pingv4(pr); }) };
+
+	// Traceroute: every trace is a single probe to the destination, which answers at TTL 1
+	CPerProbeTraceRoute perProbeTrace;
+	CTraceRoute trace;
+	CTraceRoute::CReplyv4 trr;
+	const double fPerProbeTrace{ Measure("CTraceRoute, a socket per probe", nProbes, [&]() { trr.clear(); return perProbeTrace.Tracev4(destAddress, trr, 30, 5000, 1); }) };
+	const double fSessionTrace{ Measure("CTraceRoute, sessions reused", nProbes, [&]() { trr.clear(); return trace.Tracev4(destAddress, trr, 30, 5000, 1); }) };
+	if ((fByName < 0.0) || (fByAddress < 0.0) || (fSession < 0.0) || (fPerProbeTrace < 0.0) || (fSessionTrace < 0.0))
+		return 1;
+
+	std::printf("Reusing the session saves %.1f us per ping (%.1f us with the lookup) and %.1f us per traceroute probe\n", fByAddress - fSession, fByName - fSession, fPerProbeTrace - fSessionTrace);
+	return 0;
+}
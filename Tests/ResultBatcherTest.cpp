@@ -0,0 +1,185 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// ResultBatcherTest.cpp : unit test of CResultBatcher against a sink which records the batches.
+//
+
+#include "pch.h"
+#include "ResultBatcher.h"
+#include "ping.h"
+#include "Check.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace
+{
+	// Records the batches and lets the test wait for them
+	class CRecordingSink : public CResultSink
+	{
+	public:
+		void PostBatch(const std::string& strJson) override
+		{
+			{
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				m_arrBatches.push_back(strJson);
+				m_arrTimes.push_back(CPingClock::NowMicroseconds());
+			}
+			m_Posted.notify_all();
+		}
+
+		// Waits until nBatches batches were posted, for at most nTimeout milliseconds
+		bool WaitFor(size_t nBatches, unsigned nTimeout)
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			return m_Posted.wait_for(lock, std::chrono::milliseconds{ nTimeout }, [&]() { return m_arrBatches.size() >= nBatches; });
+		}
+
+		std::vector<std::string> GetBatches()
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			return m_arrBatches;
+		}
+
+		ULONGLONG GetTime(size_t nBatch)
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			return m_arrTimes.at(nBatch);
+		}
+
+	protected:
+		std::mutex m_Mutex;
+		std::condition_variable m_Posted;
+		std::vector<std::string> m_arrBatches;
+		std::vector<ULONGLONG> m_arrTimes;
+	};
+
+	// A full batch is delivered straight away, a partial one not before MaxDelay
+	void TestMaxLines()
+	{
+		CRecordingSink sink;
+		CResultBatcher batcher;
+		batcher.SetMaxLines(3);
+		batcher.SetMaxDelay(10000000);
+		CHECK(batcher.Start());
+		batcher.SetSink(&sink);
+		batcher.Add("a");
+		batcher.Add("b");
+		batcher.Add("c");
+		CHECK(sink.WaitFor(1, 2000));
+		batcher.Add("d");
+		CHECK(!sink.WaitFor(2, 200));
+		const std::vector<std::string> arrBatches{ sink.GetBatches() };
+		CHECK(arrBatches.size() == 1);
+		CHECK((arrBatches.size() == 1) && (arrBatches[0] == "{\"first\":0,\"lines\":[\"a\",\"b\",\"c\"]}"));
+		batcher.SetSink(nullptr);
+		batcher.Stop();
+	}
+
+	// A partial batch is delivered MaxDelay after its first line was queued
+	void TestMaxDelay()
+	{
+		CRecordingSink sink;
+		CResultBatcher batcher;
+		batcher.SetMaxLines(100);
+		batcher.SetMaxDelay(50000);
+		CHECK(batcher.Start());
+		batcher.SetSink(&sink);
+		const ULONGLONG nQueued{ CPingClock::NowMicroseconds() };
+		batcher.Add("late");
+		CHECK(sink.WaitFor(1, 2000));
+		const std::vector<std::string> arrBatches{ sink.GetBatches() };
+		CHECK((arrBatches.size() == 1) && (arrBatches[0] == "{\"first\":0,\"lines\":[\"late\"]}"));
+		if (arrBatches.size() == 1)
+			CHECK(sink.GetTime(0) - nQueued >= 50000);
+		batcher.SetSink(nullptr);
+		batcher.Stop();
+	}
+
+	// Every batch starts at the index which follows the last line of the batch before
+	void TestFirstIndex()
+	{
+		CRecordingSink sink;
+		CResultBatcher batcher;
+		batcher.SetSink(&sink);
+		batcher.Add("1");
+		batcher.Add("2");
+		batcher.Flush();
+		batcher.Add("3");
+		batcher.Add("4");
+		batcher.Add("5");
+		batcher.Flush();
+		batcher.Flush();
+		const std::vector<std::string> arrBatches{ sink.GetBatches() };
+		CHECK(arrBatches.size() == 2);
+		CHECK((arrBatches.size() == 2) && (arrBatches[0] == "{\"first\":0,\"lines\":[\"1\",\"2\"]}"));
+		CHECK((arrBatches.size() == 2) && (arrBatches[1] == "{\"first\":2,\"lines\":[\"3\",\"4\",\"5\"]}"));
+		CHECK(batcher.GetLineCount() == 5);
+		CHECK(batcher.GetBatchCount() == 2);
+	}
+
+	// Names travel in the batch of the lines queued before them, or in a batch of their own, escaped like lines
+	void TestNames()
+	{
+		CRecordingSink sink;
+		CResultBatcher batcher;
+		batcher.SetSink(&sink);
+		batcher.Add("Reply from 192.0.2.1");
+		batcher.AddName("192.0.2.1", "host.example");
+		batcher.AddName("192.0.2.2", "\"quoted\"\t\x01");
+		batcher.Flush();
+		batcher.AddName("2001:db8::1", "v6.example");
+		batcher.Flush();
+		const std::vector<std::string> arrBatches{ sink.GetBatches() };
+		CHECK(arrBatches.size() == 2);
+		CHECK((arrBatches.size() == 2) && (arrBatches[0] == "{\"first\":0,\"lines\":[\"Reply from 192.0.2.1\"],\"names\":[[\"192.0.2.1\",\"host.example\"],[\"192.0.2.2\",\"\\\"quoted\\\"\\t\\u0001\"]]}"));
+		CHECK((arrBatches.size() == 2) && (arrBatches[1] == "{\"first\":1,\"lines\":[],\"names\":[[\"2001:db8::1\",\"v6.example\"]]}"));
+	}
+
+	// Lines are kept until a sink is attached, and Reset discards them and starts the indexes again
+	void TestResetAndReplay()
+	{
+		CRecordingSink sink;
+		CResultBatcher batcher;
+		batcher.Add("kept 1");
+		batcher.Add("kept 2");
+		batcher.Flush();
+		CHECK(sink.GetBatches().empty());
+		batcher.SetSink(&sink);
+		std::vector<std::string> arrBatches{ sink.GetBatches() };
+		CHECK((arrBatches.size() == 1) && (arrBatches[0] == "{\"first\":0,\"lines\":[\"kept 1\",\"kept 2\"]}"));
+
+		batcher.Add("discarded");
+		batcher.Reset();
+		CHECK(batcher.GetLineCount() == 0);
+		CHECK(batcher.GetBatchCount() == 0);
+		batcher.Add("after reset");
+		batcher.Flush();
+		CHECK(sink.GetBatches().size() == 1); // Reset detached the sink
+		batcher.SetSink(&sink);
+		arrBatches = sink.GetBatches();
+		CHECK((arrBatches.size() == 2) && (arrBatches[1] == "{\"first\":0,\"lines\":[\"after reset\"]}"));
+	}
+}
+
+int main()
+{
+	TestMaxLines();
+	TestMaxDelay();
+	TestFirstIndex();
+	TestNames();
+	TestResetAndReplay();
+	return CheckResult("ResultBatcherTest");
+}
@@ -0,0 +1,469 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// TopologyGraph.cpp : implementation of the CTopologyGraph class
+//
+
+#include "pch.h"
+#include "TopologyGraph.h"
+#include "IpAddressText.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+/**
+ * @brief Accounts for one more path over the link
+ * @param fDelta The latency the link added on that path, in microseconds; negative when the far hop answered faster
+ */
+void CTopologyLink::AddSample(double fDelta) noexcept
+{
+	if ((nSamples == 0) || (fDelta < fMin))
+		fMin = fDelta;
+	if ((nSamples == 0) || (fDelta > fMax))
+		fMax = fDelta;
+	++nSamples;
+	const double fDifference{ fDelta - fMean };
+	fMean += fDifference / static_cast<double>(nSamples);
+	fM2 += fDifference * (fDelta - fMean);
+}
+
+/**
+ * @brief Gets the standard deviation of the latency the link adds
+ * @return The sample standard deviation in microseconds, 0 for fewer than two samples
+ */
+double CTopologyLink::GetStdDev() const noexcept
+{
+	return (nSamples > 1) ? std::sqrt(fM2 / static_cast<double>(nSamples - 1)) : 0.0;
+}
+
+/**
+ * @brief Default constructor for CTopologyGraph; the graph holds the vantage point only
+ */
+CTopologyGraph::CTopologyGraph() :
+	m_nTraces{ 0 }
+{
+	Clear();
+}
+
+/**
+ * @brief Forgets every merged path
+ */
+void CTopologyGraph::Clear()
+{
+	m_Nodes.clear();
+	m_NodeIndex.clear();
+	m_Links.clear();
+	m_LinkIndex.clear();
+	m_PathNodes.clear();
+	m_PathIndex.clear();
+	m_Destinations.clear();
+	m_DestinationIndex.clear();
+	m_nTraces = 0;
+
+	// The vantage point is the root of every path
+	m_Nodes.emplace_back();
+	m_Nodes.back().arrPaths.push_back(0);
+	m_PathNodes.push_back(CPathNode{ NONE, VANTAGE_POINT, NONE, NONE, NONE });
+}
+
+/**
+ * @brief Merges the path of an IPv4 trace into the graph
+ * @param destAddress The destination which was traced
+ * @param trr The hops of the path, as CTraceRoute::Tracev4 gives them
+ */
+void CTopologyGraph::AddTrace(const SOCKADDR_IN& destAddress, const CTraceRoute::CReplyv4& trr)
+{
+	AddPath(MakeKey(AF_INET, &destAddress.sin_addr), trr);
+}
+
+/**
+ * @brief Merges the path of an IPv6 trace into the graph
+ * @param destAddress The destination which was traced
+ * @param trr The hops of the path, as CTraceRoute::Tracev6 gives them
+ */
+void CTopologyGraph::AddTrace(const SOCKADDR_IN6& destAddress, const CTraceRoute::CReplyv6& trr)
+{
+	AddPath(MakeKey(AF_INET6, &destAddress.sin6_addr), trr);
+}
+
+/**
+ * @brief Gets the in_addr bytes of an IPv4 hop
+ * @param address The address of the hop
+ * @return Its in_addr
+ */
+static const void* HopAddress(const SOCKADDR_IN& address) noexcept
+{
+	return &address.sin_addr;
+}
+
+/**
+ * @brief Gets the in6_addr bytes of an IPv6 hop
+ * @param address The address of the hop
+ * @return Its in6_addr
+ */
+static const void* HopAddress(const SOCKADDR_IN6& address) noexcept
+{
+	return &address.sin6_addr;
+}
+
+/**
+ * @brief Interns the hops and the links of a path and files it under its destination
+ * @param destination The destination which was traced
+ * @param trr The hops of the path
+ * @details A link joins two hops which answered with only silent hops in between, as the hops which did not
+ * answer cannot be told apart. The latency of a link is the difference between the average round trip times at
+ * its two ends, and the first link of every path starts at the vantage point with a round trip time of 0.
+ */
+template <typename Reply>
+void CTopologyGraph::AddPath(const CAddressKey& destination, const Reply& trr)
+{
+	UINT nPath{ 0 };
+	UINT nPrevious{ VANTAGE_POINT };
+	double fPreviousRTT{ 0.0 };
+	UCHAR nSilentHops{ 0 };
+	bool bReached{ false };
+	for (const auto& htmr : trr)
+	{
+		if (htmr.dwError != 0)
+		{
+			nPath = InternPathNode(nPath, SILENT_HOP);
+			if (nSilentHops < UCHAR_MAX)
+				++nSilentHops;
+			continue;
+		}
+
+		const UINT nNode{ InternNode(MakeKey(destination.nFamily, HopAddress(htmr.Address))) };
+		++m_Nodes[nNode].nSeen;
+		CTopologyLink& link{ InternLink(nPrevious, nNode) };
+		if ((link.nSamples == 0) || (nSilentHops < link.nSilentHops))
+			link.nSilentHops = nSilentHops;
+		const double fRTT{ static_cast<double>(htmr.avgRTT) };
+		link.AddSample(fRTT - fPreviousRTT);
+		nPath = InternPathNode(nPath, nNode);
+		nPrevious = nNode;
+		fPreviousRTT = fRTT;
+		nSilentHops = 0;
+		bReached = (m_Nodes[nNode].Address == destination);
+	}
+	if (bReached)
+		m_Nodes[nPrevious].bDestination = true;
+
+	UINT nDestination{ NONE };
+	const auto it{ m_DestinationIndex.find(destination) };
+	if (it == m_DestinationIndex.end())
+	{
+		nDestination = static_cast<UINT>(m_Destinations.size());
+		m_Destinations.emplace_back();
+		m_Destinations.back().Address = destination;
+		m_Destinations.back().nPath = NONE;
+		m_DestinationIndex.emplace(destination, nDestination);
+	}
+	else
+		nDestination = it->second;
+	MoveDestination(nDestination, nPath);
+	++m_Destinations[nDestination].nTraces;
+	m_Destinations[nDestination].bReached = bReached;
+	++m_nTraces;
+}
+
+/**
+ * @brief Gets the node of an address, adding it if the graph does not have it yet
+ * @param address The address
+ * @return The node
+ */
+UINT CTopologyGraph::InternNode(const CAddressKey& address)
+{
+	const auto it{ m_NodeIndex.find(address) };
+	if (it != m_NodeIndex.end())
+		return it->second;
+	const UINT nNode{ static_cast<UINT>(m_Nodes.size()) };
+	m_Nodes.emplace_back();
+	m_Nodes.back().Address = address;
+	m_NodeIndex.emplace(address, nNode);
+	return nNode;
+}
+
+/**
+ * @brief Gets the trie node of a hop, adding it if no path went this way yet
+ * @param nParent The trie node of the hop before
+ * @param nNode The graph node of the hop, SILENT_HOP if it did not answer
+ * @return The trie node
+ */
+UINT CTopologyGraph::InternPathNode(UINT nParent, UINT nNode)
+{
+	const ULONGLONG nKey{ (static_cast<ULONGLONG>(nParent) << 32) | nNode };
+	const auto it{ m_PathIndex.find(nKey) };
+	if (it != m_PathIndex.end())
+		return it->second;
+	const UINT nPath{ static_cast<UINT>(m_PathNodes.size()) };
+	m_PathNodes.push_back(CPathNode{ nParent, nNode, NONE, m_PathNodes[nParent].nFirstChild, NONE });
+	m_PathNodes[nParent].nFirstChild = nPath;
+	m_PathIndex.emplace(nKey, nPath);
+	if (nNode != SILENT_HOP)
+		m_Nodes[nNode].arrPaths.push_back(nPath);
+	return nPath;
+}
+
+/**
+ * @brief Gets the link between two nodes, adding it if the graph does not have it yet
+ * @param nFrom The node nearer to the vantage point
+ * @param nTo The node further away
+ * @return The link
+ */
+CTopologyLink& CTopologyGraph::InternLink(UINT nFrom, UINT nTo)
+{
+	const ULONGLONG nKey{ (static_cast<ULONGLONG>(nFrom) << 32) | nTo };
+	const auto it{ m_LinkIndex.find(nKey) };
+	if (it != m_LinkIndex.end())
+		return m_Links[it->second];
+	m_LinkIndex.emplace(nKey, static_cast<UINT>(m_Links.size()));
+	m_Links.emplace_back();
+	m_Links.back().nFrom = nFrom;
+	m_Links.back().nTo = nTo;
+	return m_Links.back();
+}
+
+/**
+ * @brief Files a destination under the trie node its latest path ends at
+ * @param nDestination The destination
+ * @param nPath The trie node
+ */
+void CTopologyGraph::MoveDestination(UINT nDestination, UINT nPath)
+{
+	CTopologyDestination& destination{ m_Destinations[nDestination] };
+	if (destination.nPath == nPath)
+		return;
+	if (destination.nPath != NONE)
+	{
+		// Unlink it from the destinations of its earlier trie node
+		UINT* pLink{ &m_PathNodes[destination.nPath].nFirstDestination };
+		while ((*pLink != NONE) && (*pLink != nDestination))
+			pLink = &m_Destinations[*pLink].nNextAtPath;
+		if (*pLink == nDestination)
+			*pLink = destination.nNextAtPath;
+	}
+	destination.nPath = nPath;
+	destination.nNextAtPath = m_PathNodes[nPath].nFirstDestination;
+	m_PathNodes[nPath].nFirstDestination = nDestination;
+}
+
+/**
+ * @brief Builds the key of an address
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr / in6_addr bytes
+ * @return The key, the unused bytes zero
+ */
+CAddressKey CTopologyGraph::MakeKey(int nFamily, const void* pAddress) noexcept
+{
+	CAddressKey key{};
+	key.nFamily = static_cast<WORD>(nFamily);
+	memcpy(key.Address, pAddress, (nFamily == AF_INET6) ? 16 : 4);
+	return key;
+}
+
+/**
+ * @brief Finds the node of an address
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr / in6_addr bytes
+ * @return The node, NONE if no merged path went through the address
+ */
+UINT CTopologyGraph::FindNode(int nFamily, const void* pAddress) const
+{
+	const auto it{ m_NodeIndex.find(MakeKey(nFamily, pAddress)) };
+	return (it != m_NodeIndex.end()) ? it->second : NONE;
+}
+
+/**
+ * @brief Finds a destination
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr / in6_addr bytes
+ * @return The destination, NONE if no path to the address was merged
+ */
+UINT CTopologyGraph::FindDestination(int nFamily, const void* pAddress) const
+{
+	const auto it{ m_DestinationIndex.find(MakeKey(nFamily, pAddress)) };
+	return (it != m_DestinationIndex.end()) ? it->second : NONE;
+}
+
+/**
+ * @brief Finds the link between two nodes
+ * @param nFrom The node nearer to the vantage point
+ * @param nTo The node further away
+ * @return The link, NONE if no merged path went from one to the other
+ */
+UINT CTopologyGraph::FindLink(UINT nFrom, UINT nTo) const
+{
+	const auto it{ m_LinkIndex.find((static_cast<ULONGLONG>(nFrom) << 32) | nTo) };
+	return (it != m_LinkIndex.end()) ? it->second : NONE;
+}
+
+/**
+ * @brief Gets the destinations whose last merged path goes through a node
+ * @param nNode The node, e.g. from FindNode
+ * @param arrDestinations Receives the destinations in ascending order
+ * @details Only the trie subtrees below the trie nodes of the node are visited, so the cost follows the number of
+ * path prefixes behind the node rather than the size of the graph.
+ */
+void CTopologyGraph::GetDestinationsVia(UINT nNode, std::vector<UINT>& arrDestinations) const
+{
+	arrDestinations.clear();
+	if (nNode >= m_Nodes.size())
+		return;
+	std::vector<UINT> arrStack{ m_Nodes[nNode].arrPaths };
+	while (!arrStack.empty())
+	{
+		const CPathNode& path{ m_PathNodes[arrStack.back()] };
+		arrStack.pop_back();
+		for (UINT nDestination = path.nFirstDestination; nDestination != NONE; nDestination = m_Destinations[nDestination].nNextAtPath)
+			arrDestinations.push_back(nDestination);
+		for (UINT nChild = path.nFirstChild; nChild != NONE; nChild = m_PathNodes[nChild].nNextSibling)
+			arrStack.push_back(nChild);
+	}
+
+	// A path which runs through the node twice is found from both of its trie nodes
+	std::sort(arrDestinations.begin(), arrDestinations.end());
+	arrDestinations.erase(std::unique(arrDestinations.begin(), arrDestinations.end()), arrDestinations.end());
+}
+
+/**
+ * @brief Gets the hops of the last merged path to a destination
+ * @param nDestination The destination, e.g. from FindDestination
+ * @param arrNodes Receives the node of every hop from the first one on, SILENT_HOP for a hop which did not answer
+ */
+void CTopologyGraph::GetPath(UINT nDestination, std::vector<UINT>& arrNodes) const
+{
+	arrNodes.clear();
+	if (nDestination >= m_Destinations.size())
+		return;
+	for (UINT nPath = m_Destinations[nDestination].nPath; (nPath != NONE) && (nPath != 0); nPath = m_PathNodes[nPath].nParent)
+		arrNodes.push_back(m_PathNodes[nPath].nNode);
+	std::reverse(arrNodes.begin(), arrNodes.end());
+}
+
+/**
+ * @brief Estimates the heap memory held by the graph
+ * @return The estimate in bytes; hash table entries are counted with a node pointer and a bucket each
+ */
+size_t CTopologyGraph::GetMemoryUsage() const noexcept
+{
+	size_t nBytes{ (m_Nodes.capacity() * sizeof(CTopologyNode)) + (m_Links.capacity() * sizeof(CTopologyLink)) +
+		(m_PathNodes.capacity() * sizeof(CPathNode)) + (m_Destinations.capacity() * sizeof(CTopologyDestination)) };
+	for (const auto& node : m_Nodes)
+		nBytes += node.arrPaths.capacity() * sizeof(UINT);
+	nBytes += (m_NodeIndex.size() * (sizeof(CAddressKey) + sizeof(UINT) + sizeof(void*))) + (m_NodeIndex.bucket_count() * sizeof(void*));
+	nBytes += (m_LinkIndex.size() * (sizeof(ULONGLONG) + sizeof(UINT) + sizeof(void*))) + (m_LinkIndex.bucket_count() * sizeof(void*));
+	nBytes += (m_PathIndex.size() * (sizeof(ULONGLONG) + sizeof(UINT) + sizeof(void*))) + (m_PathIndex.bucket_count() * sizeof(void*));
+	nBytes += (m_DestinationIndex.size() * (sizeof(CAddressKey) + sizeof(UINT) + sizeof(void*))) + (m_DestinationIndex.bucket_count() * sizeof(void*));
+	return nBytes;
+}
+
+/**
+ * @brief Formats the label of a node
+ * @param node The node
+ * @param pszBuffer Receives the address, or "vantage point"
+ * @param nBufferSize Size of pszBuffer, at least CIpAddressText::MAX_LENGTH
+ * @return The length of the label
+ */
+size_t CTopologyGraph::FormatNode(const CTopologyNode& node, char* pszBuffer, size_t nBufferSize) noexcept
+{
+	if (node.Address.nFamily == AF_UNSPEC)
+	{
+		static const char szVantagePoint[]{ "vantage point" };
+		memcpy(pszBuffer, szVantagePoint, sizeof(szVantagePoint));
+		return sizeof(szVantagePoint) - 1;
+	}
+	return CIpAddressText::Format(node.Address.nFamily, node.Address.Address, pszBuffer, nBufferSize);
+}
+
+/**
+ * @brief Writes the graph in the Graphviz DOT language
+ * @param out The stream to write to
+ * @details Links with silent hops in between are dashed and labelled with their count, and addresses at which a
+ * path reached its destination are drawn with a double border.
+ */
+void CTopologyGraph::ExportDOT(std::ostream& out) const
+{
+	const std::ios_base::fmtflags flags{ out.flags() };
+	const std::streamsize nPrecision{ out.precision() };
+	out << std::fixed << std::setprecision(3);
+	out << "digraph topology {\n\tnode [shape=box];\n";
+	char szLabel[CIpAddressText::MAX_LENGTH]{};
+	for (size_t i = 0; i < m_Nodes.size(); i++)
+	{
+		FormatNode(m_Nodes[i], szLabel, sizeof(szLabel));
+		out << "\tn" << i << " [label=\"" << szLabel << '"';
+		if (m_Nodes[i].bDestination)
+			out << ", peripheries=2";
+		out << "];\n";
+	}
+	for (const auto& link : m_Links)
+	{
+		out << "\tn" << link.nFrom << " -> n" << link.nTo << " [label=\"";
+		if (link.nSilentHops > 0)
+			out << '+' << static_cast<int>(link.nSilentHops) << " * ";
+		out << (link.fMean / 1000.0) << " ms\"";
+		if (link.nSilentHops > 0)
+			out << ", style=dashed";
+		out << "];\n";
+	}
+	out << "}\n";
+	out.flags(flags);
+	out.precision(nPrecision);
+}
+
+/**
+ * @brief Writes the graph as GraphML
+ * @param out The stream to write to
+ * @details Nodes carry their address, how often they were seen and whether a path reached its destination there;
+ * links carry their sample count, the silent hops in between and the latency they add in milliseconds.
+ */
+void CTopologyGraph::ExportGraphML(std::ostream& out) const
+{
+	const std::ios_base::fmtflags flags{ out.flags() };
+	const std::streamsize nPrecision{ out.precision() };
+	out << std::fixed << std::setprecision(3);
+	out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+		"\t<key id=\"address\" for=\"node\" attr.name=\"address\" attr.type=\"string\"/>\n"
+		"\t<key id=\"seen\" for=\"node\" attr.name=\"seen\" attr.type=\"long\"/>\n"
+		"\t<key id=\"destination\" for=\"node\" attr.name=\"destination\" attr.type=\"boolean\"/>\n"
+		"\t<key id=\"samples\" for=\"edge\" attr.name=\"samples\" attr.type=\"long\"/>\n"
+		"\t<key id=\"silent\" for=\"edge\" attr.name=\"silent\" attr.type=\"int\"/>\n"
+		"\t<key id=\"min\" for=\"edge\" attr.name=\"min_ms\" attr.type=\"double\"/>\n"
+		"\t<key id=\"mean\" for=\"edge\" attr.name=\"mean_ms\" attr.type=\"double\"/>\n"
+		"\t<key id=\"max\" for=\"edge\" attr.name=\"max_ms\" attr.type=\"double\"/>\n"
+		"\t<key id=\"stddev\" for=\"edge\" attr.name=\"stddev_ms\" attr.type=\"double\"/>\n"
+		"\t<graph id=\"topology\" edgedefault=\"directed\">\n";
+	char szLabel[CIpAddressText::MAX_LENGTH]{};
+	for (size_t i = 0; i < m_Nodes.size(); i++)
+	{
+		const CTopologyNode& node{ m_Nodes[i] };
+		FormatNode(node, szLabel, sizeof(szLabel));
+		out << "\t\t<node id=\"n" << i << "\"><data key=\"address\">" << szLabel << "</data><data key=\"seen\">" << node.nSeen
+			<< "</data><data key=\"destination\">" << (node.bDestination ? "true" : "false") << "</data></node>\n";
+	}
+	for (size_t i = 0; i < m_Links.size(); i++)
+	{
+		const CTopologyLink& link{ m_Links[i] };
+		out << "\t\t<edge id=\"e" << i << "\" source=\"n" << link.nFrom << "\" target=\"n" << link.nTo << "\"><data key=\"samples\">" << link.nSamples
+			<< "</data><data key=\"silent\">" << static_cast<int>(link.nSilentHops) << "</data><data key=\"min\">" << (link.fMin / 1000.0)
+			<< "</data><data key=\"mean\">" << (link.fMean / 1000.0) << "</data><data key=\"max\">" << (link.fMax / 1000.0)
+			<< "</data><data key=\"stddev\">" << (link.GetStdDev() / 1000.0) << "</data></edge>\n";
+	}
+	out << "\t</graph>\n</graphml>\n";
+	out.flags(flags);
+	out.precision(nPrecision);
+}
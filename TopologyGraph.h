@@ -0,0 +1,136 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// TopologyGraph.h : interface of the CTopologyGraph class, which merges the paths of many traceroutes into a
+// single graph of the hops and the links between them.
+//
+
+#pragma once
+
+#include "tracer.h"
+#include "NameResolver.h"
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+// A node of the topology graph: a hop address, stored once however many paths go through it
+struct CTopologyNode
+{
+	CAddressKey Address{};                // The hop address; family AF_UNSPEC for the vantage point
+	ULONG nSeen{ 0 };                     // Times the address answered as a hop of a merged path
+	bool bDestination{ false };           // A merged path reached its destination at this address
+	std::vector<UINT> arrPaths;           // The path trie nodes of the address, one per distinct path prefix ending in it
+};
+
+// A link between two addresses which answered at consecutive answering hops of a path
+struct CTopologyLink
+{
+	UINT nFrom{ 0 };                      // The node nearer to the vantage point
+	UINT nTo{ 0 };                        // The node further away
+	UCHAR nSilentHops{ 0 };               // Hops in between which did not answer, the fewest seen
+	ULONG nSamples{ 0 };                  // Paths which went over the link
+	double fMin{ 0.0 };                   // The latency the link adds, the average RTT at nTo less the one at nFrom, in microseconds
+	double fMax{ 0.0 };
+	double fMean{ 0.0 };
+	double fM2{ 0.0 };                    // Sum of the squared differences from the mean (Welford)
+
+	void AddSample(double fDelta) noexcept;
+	double GetStdDev() const noexcept;
+};
+
+// A destination whose path was merged into the graph
+struct CTopologyDestination
+{
+	CAddressKey Address{};                // The destination
+	UINT nPath{ 0 };                      // The path trie node at which its last merged path ends
+	UINT nNextAtPath{ 0 };                // The next destination whose path ends at the same trie node, NONE for the last one
+	ULONG nTraces{ 0 };                   // Paths merged for it
+	bool bReached{ false };               // Its last merged path reached it
+};
+
+// CTopologyGraph: every merged path is interned. Addresses become nodes, stored once; consecutive answering
+// hops become links, stored once with running latency statistics; and the path itself is stored as a branch of
+// a trie rooted at the vantage point, so a prefix shared by many paths is stored once and a destination only
+// keeps the trie node its path ends at. The storage grows with the distinct addresses, links and path
+// prefixes, not with the number of traces. Every node knows the trie nodes it sits at, so the destinations
+// behind a router are found by walking only the subtrees below it.
+// CTopologyGraph is not thread safe; it is meant to be fed by one thread at a time.
+class CTopologyGraph
+{
+public:
+	static const UINT NONE{ 0xFFFFFFFF };        // No node / no trie node / no destination
+	static const UINT SILENT_HOP{ 0xFFFFFFFE };  // The node of a hop which did not answer
+	static const UINT VANTAGE_POINT{ 0 };        // The node of the vantage point, the root of every path
+
+	CTopologyGraph();
+	CTopologyGraph(const CTopologyGraph&) = delete;
+	CTopologyGraph(CTopologyGraph&&) = delete;
+	virtual ~CTopologyGraph() = default;
+
+	CTopologyGraph& operator=(const CTopologyGraph&) = delete;
+	CTopologyGraph& operator=(CTopologyGraph&&) = delete;
+
+	// Merge the path of a trace into the graph; a later path to the same destination replaces the earlier one
+	void AddTrace(const SOCKADDR_IN& destAddress, const CTraceRoute::CReplyv4& trr);
+	void AddTrace(const SOCKADDR_IN6& destAddress, const CTraceRoute::CReplyv6& trr);
+	void Clear();
+
+	// Queries
+	const std::vector<CTopologyNode>& GetNodes() const noexcept { return m_Nodes; }
+	const std::vector<CTopologyLink>& GetLinks() const noexcept { return m_Links; }
+	const std::vector<CTopologyDestination>& GetDestinations() const noexcept { return m_Destinations; }
+	size_t GetPathNodeCount() const noexcept { return m_PathNodes.size(); }
+	ULONGLONG GetTraceCount() const noexcept { return m_nTraces; }
+	UINT FindNode(int nFamily, const void* pAddress) const;          // NONE if the address is not in the graph
+	UINT FindDestination(int nFamily, const void* pAddress) const;   // NONE if no path to the address was merged
+	UINT FindLink(UINT nFrom, UINT nTo) const;                       // NONE if there is no such link
+	void GetDestinationsVia(UINT nNode, std::vector<UINT>& arrDestinations) const; // The destinations whose last path goes through the node
+	void GetPath(UINT nDestination, std::vector<UINT>& arrNodes) const;           // The hops of the last path to a destination, SILENT_HOP for a silent one
+	size_t GetMemoryUsage() const noexcept;                          // An estimate of the heap memory held, in bytes
+
+	// Export
+	void ExportDOT(std::ostream& out) const;                         // Graphviz
+	void ExportGraphML(std::ostream& out) const;
+
+protected:
+	// A node of the path trie: a hop of one or more paths, identified by the hops before it
+	struct CPathNode
+	{
+		UINT nParent;                     // The trie node of the hop before, NONE for the root
+		UINT nNode;                       // The graph node of the hop, SILENT_HOP if it did not answer
+		UINT nFirstChild;                 // The first trie node of the hops after it, NONE for none
+		UINT nNextSibling;                // The next trie node with the same parent, NONE for the last one
+		UINT nFirstDestination;           // The first destination whose path ends here, NONE for none
+	};
+
+	template <typename Reply>
+	void AddPath(const CAddressKey& destination, const Reply& trr);
+	UINT InternNode(const CAddressKey& address);
+	UINT InternPathNode(UINT nParent, UINT nNode);
+	CTopologyLink& InternLink(UINT nFrom, UINT nTo);
+	void MoveDestination(UINT nDestination, UINT nPath);
+	static CAddressKey MakeKey(int nFamily, const void* pAddress) noexcept;
+	static size_t FormatNode(const CTopologyNode& node, char* pszBuffer, size_t nBufferSize) noexcept;
+
+	std::vector<CTopologyNode> m_Nodes;                                          // The nodes, VANTAGE_POINT first
+	std::unordered_map<CAddressKey, UINT, CAddressKeyHash> m_NodeIndex;          // Address -> node
+	std::vector<CTopologyLink> m_Links;                                          // The links
+	std::unordered_map<ULONGLONG, UINT> m_LinkIndex;                             // From node << 32 | to node -> link
+	std::vector<CPathNode> m_PathNodes;                                          // The path trie, its root first
+	std::unordered_map<ULONGLONG, UINT> m_PathIndex;                             // Parent trie node << 32 | graph node -> trie node
+	std::vector<CTopologyDestination> m_Destinations;                            // The destinations
+	std::unordered_map<CAddressKey, UINT, CAddressKeyHash> m_DestinationIndex;   // Address -> destination
+	ULONGLONG m_nTraces;                                                         // Paths merged since the last Clear
+};
@@ -0,0 +1,291 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// Utf8Writer.cpp : implementation of the CUtf8Writer class
+//
+
+#include "pch.h"
+#include "Utf8Writer.h"
+#include "IpAddressText.h"
+#include <cstring>
+
+/**
+ * @brief Constructs a writer over a caller supplied buffer, which it empties
+ * @param pszBuffer The buffer
+ * @param nBufferSize The size of the buffer in bytes, including room for the terminator
+ */
+CUtf8Writer::CUtf8Writer(char* pszBuffer, size_t nBufferSize) noexcept :
+	m_pszBuffer{ pszBuffer },
+	m_nCapacity{ ((pszBuffer != nullptr) && (nBufferSize > 0)) ? (nBufferSize - 1) : 0 },
+	m_nLength{ 0 },
+	m_bTruncated{ false }
+{
+	if (m_pszBuffer != nullptr && nBufferSize > 0)
+		m_pszBuffer[0] = '\0';
+}
+
+/**
+ * @brief Checks that the next nLength bytes fit, flagging the writer as truncated when they do not
+ * @param nLength The number of bytes about to be written
+ * @return true if they fit
+ */
+bool CUtf8Writer::Reserve(size_t nLength) noexcept
+{
+	if (m_bTruncated || ((m_nCapacity - m_nLength) < nLength))
+	{
+		m_bTruncated = true;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Appends a single (ASCII) character
+ * @param ch The character
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::Append(char ch) noexcept
+{
+	if (Reserve(1))
+	{
+		m_pszBuffer[m_nLength++] = ch;
+		m_pszBuffer[m_nLength] = '\0';
+	}
+	return *this;
+}
+
+/**
+ * @brief Appends null terminated UTF-8 text
+ * @param pszText The text, nullptr appends nothing
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::Append(const char* pszText) noexcept
+{
+	if (pszText != nullptr)
+		Append(pszText, strlen(pszText));
+	return *this;
+}
+
+/**
+ * @brief Appends counted UTF-8 text; text which does not fit is cut at a character boundary
+ * @param pszText The text
+ * @param nLength Its length in bytes
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::Append(const char* pszText, size_t nLength) noexcept
+{
+	if (m_bTruncated || (nLength == 0))
+		return *this;
+	size_t nCopy{ nLength };
+	if ((m_nCapacity - m_nLength) < nLength)
+	{
+		// Do not leave half of a multi-byte sequence behind
+		nCopy = m_nCapacity - m_nLength;
+		while ((nCopy > 0) && ((static_cast<unsigned char>(pszText[nCopy]) & 0xC0) == 0x80))
+			--nCopy;
+		m_bTruncated = true;
+	}
+	memcpy(m_pszBuffer + m_nLength, pszText, nCopy);
+	m_nLength += nCopy;
+	m_pszBuffer[m_nLength] = '\0';
+	return *this;
+}
+
+/**
+ * @brief Appends UTF-16 text, encoding it as UTF-8 on the fly
+ * @param pszText The text
+ * @param nLength Its length in UTF-16 code units
+ * @return *this
+ * @details Unpaired surrogates are replaced with U+FFFD, like WideCharToMultiByte does
+ */
+CUtf8Writer& CUtf8Writer::AppendWide(const wchar_t* pszText, size_t nLength) noexcept
+{
+	for (size_t i = 0; (i < nLength) && !m_bTruncated; i++)
+	{
+		ULONG nCodePoint{ static_cast<ULONG>(pszText[i]) & 0xFFFF };
+		if ((nCodePoint >= 0xD800) && (nCodePoint <= 0xDBFF) && ((i + 1) < nLength) &&
+			((static_cast<ULONG>(pszText[i + 1]) & 0xFFFF) >= 0xDC00) && ((static_cast<ULONG>(pszText[i + 1]) & 0xFFFF) <= 0xDFFF))
+		{
+			nCodePoint = 0x10000 + ((nCodePoint - 0xD800) << 10) + ((static_cast<ULONG>(pszText[i + 1]) & 0xFFFF) - 0xDC00);
+			++i;
+		}
+		else if ((nCodePoint >= 0xD800) && (nCodePoint <= 0xDFFF))
+			nCodePoint = 0xFFFD;
+
+		if (nCodePoint < 0x80)
+		{
+			if (Reserve(1))
+				m_pszBuffer[m_nLength++] = static_cast<char>(nCodePoint);
+		}
+		else if (nCodePoint < 0x800)
+		{
+			if (Reserve(2))
+			{
+				m_pszBuffer[m_nLength++] = static_cast<char>(0xC0 | (nCodePoint >> 6));
+				m_pszBuffer[m_nLength++] = static_cast<char>(0x80 | (nCodePoint & 0x3F));
+			}
+		}
+		else if (nCodePoint < 0x10000)
+		{
+			if (Reserve(3))
+			{
+				m_pszBuffer[m_nLength++] = static_cast<char>(0xE0 | (nCodePoint >> 12));
+				m_pszBuffer[m_nLength++] = static_cast<char>(0x80 | ((nCodePoint >> 6) & 0x3F));
+				m_pszBuffer[m_nLength++] = static_cast<char>(0x80 | (nCodePoint & 0x3F));
+			}
+		}
+		else if (Reserve(4))
+		{
+			m_pszBuffer[m_nLength++] = static_cast<char>(0xF0 | (nCodePoint >> 18));
+			m_pszBuffer[m_nLength++] = static_cast<char>(0x80 | ((nCodePoint >> 12) & 0x3F));
+			m_pszBuffer[m_nLength++] = static_cast<char>(0x80 | ((nCodePoint >> 6) & 0x3F));
+			m_pszBuffer[m_nLength++] = static_cast<char>(0x80 | (nCodePoint & 0x3F));
+		}
+	}
+	if (m_pszBuffer != nullptr)
+		m_pszBuffer[m_nLength] = '\0';
+	return *this;
+}
+
+/**
+ * @brief Appends an unsigned decimal number
+ * @param nValue The number
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::AppendUnsigned(ULONGLONG nValue) noexcept
+{
+	return AppendPadded(nValue, 1);
+}
+
+/**
+ * @brief Appends a signed decimal number
+ * @param nValue The number
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::AppendSigned(LONGLONG nValue) noexcept
+{
+	if (nValue < 0)
+	{
+		Append('-');
+		return AppendUnsigned(0ULL - static_cast<ULONGLONG>(nValue));
+	}
+	return AppendUnsigned(static_cast<ULONGLONG>(nValue));
+}
+
+/**
+ * @brief Appends an unsigned decimal number with leading zeros
+ * @param nValue The number
+ * @param nDigits The minimum number of digits
+ * @return *this
+ * @details Two digits are produced per step from a table of the pairs 00 to 99
+ */
+CUtf8Writer& CUtf8Writer::AppendPadded(ULONGLONG nValue, UINT nDigits) noexcept
+{
+	static const char szDigitPairs[]{
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899" };
+
+	char szDigits[24];
+	size_t nPos{ sizeof(szDigits) };
+	while (nValue >= 100)
+	{
+		const size_t nPair{ static_cast<size_t>(nValue % 100) * 2 };
+		nValue /= 100;
+		szDigits[--nPos] = szDigitPairs[nPair + 1];
+		szDigits[--nPos] = szDigitPairs[nPair];
+	}
+	if (nValue >= 10)
+	{
+		const size_t nPair{ static_cast<size_t>(nValue) * 2 };
+		szDigits[--nPos] = szDigitPairs[nPair + 1];
+		szDigits[--nPos] = szDigitPairs[nPair];
+	}
+	else
+		szDigits[--nPos] = static_cast<char>('0' + nValue);
+	while (((sizeof(szDigits) - nPos) < nDigits) && (nPos > 0))
+		szDigits[--nPos] = '0';
+
+	const size_t nLength{ sizeof(szDigits) - nPos };
+	if (Reserve(nLength))
+	{
+		memcpy(m_pszBuffer + m_nLength, szDigits + nPos, nLength);
+		m_nLength += nLength;
+		m_pszBuffer[m_nLength] = '\0';
+	}
+	return *this;
+}
+
+/**
+ * @brief Appends a round trip time as milliseconds with microsecond precision
+ * @param nRTT The round trip time in microseconds
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::AppendRTT(ULONGLONG nRTT) noexcept
+{
+	AppendUnsigned(nRTT / 1000ULL);
+	Append('.');
+	AppendPadded(nRTT % 1000ULL, 3);
+	return Append("ms", 2);
+}
+
+/**
+ * @brief Appends the numeric literal of an IP address
+ * @param nFamily AF_INET or AF_INET6
+ * @param pAddress The in_addr or in6_addr bytes, in network order
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::AppendAddress(int nFamily, const void* pAddress) noexcept
+{
+	char szAddress[CIpAddressText::MAX_LENGTH];
+	const size_t nLength{ CIpAddressText::Format(nFamily, pAddress, szAddress, sizeof(szAddress)) };
+	return Append(szAddress, nLength);
+}
+
+/**
+ * @brief Appends text as a quoted JSON string, escaping what JSON requires
+ * @param pszText The UTF-8 text; bytes of multi-byte characters are copied unchanged
+ * @param nLength Its length in bytes
+ * @return *this
+ */
+CUtf8Writer& CUtf8Writer::AppendJsonString(const char* pszText, size_t nLength) noexcept
+{
+	static const char szHexDigits[]{ "0123456789abcdef" };
+	Append('"');
+	for (size_t i = 0; (i < nLength) && !m_bTruncated; i++)
+	{
+		const unsigned char nByte{ static_cast<unsigned char>(pszText[i]) };
+		switch (nByte)
+		{
+		case '"': Append("\\\"", 2); break;
+		case '\\': Append("\\\\", 2); break;
+		case '\n': Append("\\n", 2); break;
+		case '\r': Append("\\r", 2); break;
+		case '\t': Append("\\t", 2); break;
+		default:
+			if (nByte < 0x20)
+			{
+				const char szEscape[6]{ '\\', 'u', '0', '0', szHexDigits[nByte >> 4], szHexDigits[nByte & 0x0F] };
+				Append(szEscape, sizeof(szEscape));
+			}
+			else if (Reserve(1))
+				m_pszBuffer[m_nLength++] = static_cast<char>(nByte);
+			break;
+		}
+	}
+	if (m_pszBuffer != nullptr)
+		m_pszBuffer[m_nLength] = '\0';
+	return Append('"');
+}
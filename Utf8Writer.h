@@ -0,0 +1,58 @@
+/* Copyright (C) 2025-2026 Stefan-Mihai MOGA
+This file is part of NetVoyager application developed by Stefan-Mihai MOGA.
+Diagnose network issues instantly with real-time ping and traceroute tools in a sleek, user-friendly interface.
+
+NetVoyager is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the Open
+Source Initiative, either version 3 of the License, or any later version.
+
+NetVoyager is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
+
+// Utf8Writer.h : interface of the CUtf8Writer class, which formats UTF-8 text straight into a buffer
+// supplied by the caller.
+//
+
+#pragma once
+
+// CUtf8Writer: appends text, numbers, round trip times, IP address literals and UTF-16 strings to a caller
+// supplied buffer, without allocating and without going through the code page conversion APIs. The buffer is
+// always null terminated; text which does not fit is cut off (never in the middle of a character) and
+// IsTruncated() reports it.
+class CUtf8Writer
+{
+public:
+	CUtf8Writer(char* pszBuffer, size_t nBufferSize) noexcept;
+	CUtf8Writer(const CUtf8Writer&) = delete;
+	CUtf8Writer(CUtf8Writer&&) = delete;
+
+	CUtf8Writer& operator=(const CUtf8Writer&) = delete;
+	CUtf8Writer& operator=(CUtf8Writer&&) = delete;
+
+	CUtf8Writer& Append(char ch) noexcept;
+	CUtf8Writer& Append(const char* pszText) noexcept;                  // Null terminated UTF-8
+	CUtf8Writer& Append(const char* pszText, size_t nLength) noexcept;  // Counted UTF-8
+	CUtf8Writer& AppendWide(const wchar_t* pszText, size_t nLength) noexcept; // UTF-16, converted as it is copied
+	CUtf8Writer& AppendUnsigned(ULONGLONG nValue) noexcept;
+	CUtf8Writer& AppendSigned(LONGLONG nValue) noexcept;
+	CUtf8Writer& AppendPadded(ULONGLONG nValue, UINT nDigits) noexcept; // Zero padded to at least nDigits digits
+	CUtf8Writer& AppendRTT(ULONGLONG nRTT) noexcept;                    // Microseconds as milliseconds, e.g. "25.304ms"
+	CUtf8Writer& AppendAddress(int nFamily, const void* pAddress) noexcept; // IPv4 / IPv6 literal of in_addr / in6_addr bytes
+	CUtf8Writer& AppendJsonString(const char* pszText, size_t nLength) noexcept; // Quoted and escaped JSON string
+
+	const char* GetString() const noexcept { return m_pszBuffer; }
+	size_t GetLength() const noexcept { return m_nLength; }
+	bool IsTruncated() const noexcept { return m_bTruncated; }
+
+protected:
+	bool Reserve(size_t nLength) noexcept;
+
+	char* m_pszBuffer;                                 // The caller's buffer
+	size_t m_nCapacity;                                // Room for text, i.e. the buffer size less the terminator
+	size_t m_nLength;                                  // Length of the text so far
+	bool m_bTruncated;                                 // Something did not fit
+};
@@ -23,6 +23,15 @@ NetVoyager. If not, see <http://www.opensource.org/licenses/gpl-3.0.html>*/
 #define PCH_H
 
 // add headers that you want to pre-compile here
+#ifdef _WIN32
 #include "framework.h"
+#else
+// Non Windows builds only compile the portable probe engine (ping, tracer and friends)
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "PosixCompat.h"
+#endif //#ifdef _WIN32
 
 #endif //PCH_H
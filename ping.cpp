@@ -174,11 +174,20 @@ to maintain a single distribution point for the source code.
 
 #include "pch.h"
 #include "ping.h"
+#include "IpAddressText.h"
 
 
 ///////////////////////////////// Macros / Defines ////////////////////////////
 
+#ifdef _WIN32
 #pragma comment(lib, "Iphlpapi.lib")
+#else
+#include <poll.h>
+#include <time.h>
+#include <linux/errqueue.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#endif //#ifdef _WIN32
 
 
 ///////////////////////////////// Implementation //////////////////////////////
@@ -220,81 +229,263 @@ void CPing::FillIcmpData(_Out_writes_bytes_(dwRequestSize) BYTE* pRequestData, _
 
 bool CPing::PingUsingICMPv4(_In_z_ LPCTSTR pszHostName, _Inout_ CPingReplyv4& pr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_z_ LPCTSTR pszLocalBoundAddress) const
 {
-	//Do the address lookup
-	ATL::CSocketAddr lookup;
-	int nError{ lookup.FindAddr(pszHostName, 0, 0, AF_INET, 0, 0) };
-	if (nError != 0)
-	{
-		SetLastError(nError);
+	//A one shot ping is just a session which is used for a single request
+	CPingSession session;
+	if (!session.Openv4(pszHostName, wDataSize, pszLocalBoundAddress))
 		return false;
-	}
 
-	//Note we always use the first address returned from ATL::CSocketAddr::FindAddr. If you want to use a different
-	//Address then do the lookup yourself and pass in the correct value in the "pszHostName" parameter
-	const ADDRINFOT* pAddress{ lookup.GetAddrInfoList() };
-#pragma warning(suppress: 26477)
-	ATLASSUME(pAddress != nullptr);
-#pragma warning(suppress: 26477)
-	ATLASSERT(pAddress->ai_family == AF_INET);
-#pragma warning(suppress: 26489 26490)
-	auto pDestAddress{ reinterpret_cast<const sockaddr_in*>(pAddress->ai_addr) };
+	//Allow derived classes to decide what gets put into the request packet
+	std::vector<BYTE>& sendBuf{ session.GetRequestData() };
+#pragma warning(suppress: 26472)
+	FillIcmpData(sendBuf.data(), static_cast<DWORD>(sendBuf.size()));
 
-	//Create the ICMP handle
-	HANDLE hIP{ IcmpCreateFile() };
-	if (hIP == INVALID_HANDLE_VALUE)
+	return session.Pingv4(pr, nTTL, dwTimeout, nTOS, bDontFragment, bFlagReverse);
+}
+
+bool CPing::PingUsingICMPv6(_In_z_ LPCTSTR pszHostName, _Inout_ CPingReplyv6& pr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_z_ LPCTSTR pszLocalBoundAddress) const
+{
+	//A one shot ping is just a session which is used for a single request
+	CPingSession session;
+	if (!session.Openv6(pszHostName, wDataSize, pszLocalBoundAddress))
 		return false;
 
-	//Set up the option info structure
-	IP_OPTION_INFORMATION OptionInfo{};
-	OptionInfo.Ttl = nTTL;
-	OptionInfo.Tos = nTOS;
-	if (bDontFragment)
-		OptionInfo.Flags = IP_FLAG_DF;
-	if (bFlagReverse)
-		OptionInfo.Flags |= IP_FLAG_REVERSE;
+	//Allow derived classes to decide what gets put into the request packet
+	std::vector<BYTE>& sendBuf{ session.GetRequestData() };
+#pragma warning(suppress: 26472)
+	FillIcmpData(sendBuf.data(), static_cast<DWORD>(sendBuf.size()));
 
-	//Set up the data which will be sent
-	std::vector<BYTE> sendBuf{ wDataSize, std::allocator<BYTE>{} };
-	FillIcmpData(sendBuf.data(), wDataSize);
+	return session.Pingv6(pr, nTTL, dwTimeout, nTOS, bDontFragment, bFlagReverse);
+}
 
-	//Do the actual Ping
+bool CPing::PingUsingICMPv4(_In_ const SOCKADDR_IN& destAddress, _Inout_ CPingReplyv4& pr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN* pLocalAddress) const
+{
+	//The caller has already resolved the addresses, so this never touches the resolver
+	CPingSession session;
+	if (!session.Openv4(destAddress, wDataSize, pLocalAddress))
+		return false;
+
+	//Allow derived classes to decide what gets put into the request packet
+	std::vector<BYTE>& sendBuf{ session.GetRequestData() };
+#pragma warning(suppress: 26472)
+	FillIcmpData(sendBuf.data(), static_cast<DWORD>(sendBuf.size()));
+
+	return session.Pingv4(pr, nTTL, dwTimeout, nTOS, bDontFragment, bFlagReverse);
+}
+
+bool CPing::PingUsingICMPv6(_In_ const SOCKADDR_IN6& destAddress, _Inout_ CPingReplyv6& pr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN6* pLocalAddress) const
+{
+	//The caller has already resolved the addresses, so this never touches the resolver
+	CPingSession session;
+	if (!session.Openv6(destAddress, wDataSize, pLocalAddress))
+		return false;
+
+	//Allow derived classes to decide what gets put into the request packet
+	std::vector<BYTE>& sendBuf{ session.GetRequestData() };
+#pragma warning(suppress: 26472)
+	FillIcmpData(sendBuf.data(), static_cast<DWORD>(sendBuf.size()));
+
+	return session.Pingv6(pr, nTTL, dwTimeout, nTOS, bDontFragment, bFlagReverse);
+}
+
+
+CHostNameCache::CHostNameCache() noexcept : m_nTimeToLive{ 60ULL * 1000000ULL },
+m_nMaxEntries{ 1024 }
+{
+}
+
+CHostNameCache& CHostNameCache::Instance()
+{
+	static CHostNameCache cache;
+	return cache;
+}
+
+bool CHostNameCache::Find(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _Out_writes_bytes_(nAddressLen) SOCKADDR* pAddress, _In_ int nAddressLen)
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	if (m_nTimeToLive == 0)
+		return false;
+	const auto it{ m_Entries.find(Key{ pszHostName, { nFlags, nFamily } }) };
+	if (it == m_Entries.end())
+		return false;
+	if (it->second.nExpires <= CPingClock::NowMicroseconds())
+	{
+		m_Entries.erase(it);
+		return false;
+	}
+	memset(pAddress, 0, nAddressLen);
 #pragma warning(suppress: 26472)
-	const DWORD dwReplySize{ static_cast<DWORD>(sizeof(ICMP_ECHO_REPLY) + wDataSize + 8) };
-	pr.Reply.resize(dwReplySize);
+	memcpy_s(pAddress, nAddressLen, &it->second.Address, (std::min)(static_cast<size_t>(it->second.nAddressLen), static_cast<size_t>(nAddressLen)));
+	return true;
+}
 
-	//Bind to the local address if need be
-	IPAddr srcAddress{ 0 };
-	bool bBindSourceIPAddress{ false };
-	if ((pszLocalBoundAddress != nullptr) && _tcslen(pszLocalBoundAddress))
+void CHostNameCache::Add(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _In_reads_bytes_(nAddressLen) const SOCKADDR* pAddress, _In_ int nAddressLen)
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	if ((m_nTimeToLive == 0) || (nAddressLen <= 0))
+		return;
+	const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+
+	//Make room by dropping the stale entries, and failing that everything
+	if (m_Entries.size() >= m_nMaxEntries)
 	{
-		bBindSourceIPAddress = true;
-		nError = lookup.FindAddr(pszLocalBoundAddress, 0, AI_PASSIVE, AF_INET, 0, 0);
-		if (nError != 0)
+		for (auto it = m_Entries.begin(); it != m_Entries.end(); )
 		{
-			IcmpCloseHandle(hIP);
-			SetLastError(nError);
-			return false;
+			if (it->second.nExpires <= nNow)
+				it = m_Entries.erase(it);
+			else
+				++it;
 		}
+		if (m_Entries.size() >= m_nMaxEntries)
+			m_Entries.clear();
+	}
 
-		pAddress = lookup.GetAddrInfoList();
-#pragma warning(suppress: 26477)
-		ATLASSUME(pAddress != nullptr);
-#pragma warning(suppress: 26477)
-		ATLASSERT(pAddress->ai_family == AF_INET);
-#pragma warning(suppress: 26489 26490)
-		auto pLookupAddress{ reinterpret_cast<const sockaddr_in*>(pAddress->ai_addr) };
-#pragma warning(suppress: 26489)
-		srcAddress = pLookupAddress->sin_addr.S_un.S_addr;
+	CEntry& entry{ m_Entries[Key{ pszHostName, { nFlags, nFamily } }] };
+	entry.Address = SOCKADDR_STORAGE{};
+	entry.nAddressLen = (std::min)(nAddressLen, static_cast<int>(sizeof(entry.Address)));
+#pragma warning(suppress: 26472)
+	memcpy(&entry.Address, pAddress, static_cast<size_t>(entry.nAddressLen));
+	entry.nExpires = nNow + m_nTimeToLive;
+}
+
+void CHostNameCache::SetTimeToLive(_In_ ULONGLONG nTimeToLive) noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_nTimeToLive = nTimeToLive;
+	if (m_nTimeToLive == 0)
+		m_Entries.clear();
+}
+
+ULONGLONG CHostNameCache::GetTimeToLive() const noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	return m_nTimeToLive;
+}
+
+void CHostNameCache::Clear()
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_Entries.clear();
+}
+
+ULONGLONG CPingClock::NowMicroseconds() noexcept
+{
+#ifdef _WIN32
+	static const LONGLONG nFrequency{ []() noexcept
+	{
+		LARGE_INTEGER frequency{};
+		QueryPerformanceFrequency(&frequency);
+		return frequency.QuadPart;
+	}() };
+	LARGE_INTEGER counter{};
+	QueryPerformanceCounter(&counter);
+	//Split the conversion to avoid overflowing 64 bits for large counter values
+	const ULONGLONG nSeconds{ static_cast<ULONGLONG>(counter.QuadPart / nFrequency) };
+	const ULONGLONG nRemainder{ static_cast<ULONGLONG>(counter.QuadPart % nFrequency) };
+	return (nSeconds * 1000000ULL) + ((nRemainder * 1000000ULL) / static_cast<ULONGLONG>(nFrequency));
+#else
+	timespec ts{};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (static_cast<ULONGLONG>(ts.tv_sec) * 1000000ULL) + (static_cast<ULONGLONG>(ts.tv_nsec) / 1000ULL);
+#endif //#ifdef _WIN32
+}
+
+ULONGLONG CPingClock::ReconcileRTT(_In_ ULONGLONG nElapsedMicroseconds, _In_ ULONG nReportedMilliseconds) noexcept
+{
+	//The ICMP API only reports whole milliseconds, so prefer our own measurement around the call. It can only
+	//overstate the RTT (by the API overhead or a late completion), so fall back to the reported value if it
+	//disagrees by more than the reported resolution
+	const ULONGLONG nReported{ static_cast<ULONGLONG>(nReportedMilliseconds) * 1000ULL };
+	if (nElapsedMicroseconds > (nReported + 1000ULL))
+		return nReported;
+	return nElapsedMicroseconds;
+}
+
+
+DWORD CPingBackend::GetReplySize(_In_ int nFamily, _In_ WORD wDataSize) const noexcept
+{
+	//By default the reply is a ICMP_ECHO_REPLY / ICMPV6_ECHO_REPLY followed by the echoed data
+#pragma warning(suppress: 26472)
+	return (nFamily == AF_INET6) ? static_cast<DWORD>(sizeof(ICMPV6_ECHO_REPLY) + wDataSize + 8) : static_cast<DWORD>(sizeof(ICMP_ECHO_REPLY) + wDataSize + 8);
+}
+
+std::unique_ptr<CPingBackend> CPingBackend::CreateDefault()
+{
+#ifdef _WIN32
+	return std::make_unique<CIcmpPingBackend>();
+#else
+	return std::make_unique<CDatagramPingBackend>();
+#endif //#ifdef _WIN32
+}
+
+bool CPingBackend::SetFlow(_In_ WORD wFlow) noexcept
+{
+	if (!SupportsFlow())
+	{
+		SetLastError(ERROR_NOT_SUPPORTED);
+		return false;
 	}
+	m_bFlow = true;
+	m_wFlow = wFlow;
+	return true;
+}
+
+void CPingBackend::ApplyFlow(_In_ WORD wSequence, _Inout_updates_bytes_(wDataSize) BYTE* pRequestData, _In_ WORD wDataSize) const noexcept
+{
+	if (!m_bFlow || (wDataSize < 2))
+		return;
+
+	//The ICMP checksum is the ones complement of the ones complement sum of the 16 bit words of the message. Choosing
+	//the first data word as m_wFlow - wSequence in ones complement arithmetic makes the sum of the two always m_wFlow,
+	//so the checksum only depends on the flow, the identifier and the rest of the data. The ones complement sum does
+	//not depend on the byte order, so the arithmetic is done in host order and the result stored in network order
+	DWORD dwSum{ static_cast<DWORD>(m_wFlow) + static_cast<WORD>(~wSequence) };
+	dwSum = (dwSum & 0xFFFF) + (dwSum >> 16);
+	const WORD wCompensation{ htons(static_cast<WORD>(dwSum)) };
+	memcpy(pRequestData, &wCompensation, sizeof(wCompensation));
+}
+
+
+#ifdef _WIN32
+CIcmpPingBackend::~CIcmpPingBackend()
+{
+	Close();
+}
+
+bool CIcmpPingBackend::Open(_In_ int nFamily)
+{
+	//Release any existing handle
+	Close();
+
+	//Create the ICMP handle
+	m_hIP = (nFamily == AF_INET6) ? Icmp6CreateFile() : IcmpCreateFile();
+	return m_hIP != INVALID_HANDLE_VALUE;
+}
 
-#pragma warning(suppress: 26486 26489)
-	const DWORD dwRecvPackets{ bBindSourceIPAddress ? IcmpSendEcho2Ex(hIP, nullptr, nullptr, nullptr, srcAddress, pDestAddress->sin_addr.S_un.S_addr, sendBuf.data(), wDataSize, &OptionInfo, pr.Reply.data(), dwReplySize, dwTimeout) :
-													 IcmpSendEcho(hIP, pDestAddress->sin_addr.S_un.S_addr, sendBuf.data(), wDataSize, &OptionInfo, pr.Reply.data(), dwReplySize, dwTimeout) };
+void CIcmpPingBackend::Close() noexcept
+{
+	if (m_hIP != INVALID_HANDLE_VALUE)
+	{
+		//Preserve the last error value across the call to IcmpCloseHandle
+		const DWORD dwLastError{ GetLastError() };
+		IcmpCloseHandle(m_hIP);
+		m_hIP = INVALID_HANDLE_VALUE;
+		SetLastError(dwLastError);
+	}
+}
 
-	//Close the ICMP handle
-	IcmpCloseHandle(hIP);
+bool CIcmpPingBackend::SendEchov4(_In_ const SOCKADDR_IN& destAddress, _In_opt_ const SOCKADDR_IN* pSrcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv4& pr, _In_ DWORD dwTimeout)
+{
+	//Do the actual Ping
+	IP_OPTION_INFORMATION OptionInfo{ optionInfo };
+#pragma warning(suppress: 26472)
+	const DWORD dwReplySize{ static_cast<DWORD>(pr.Reply.size()) };
+	const ULONGLONG nStart{ CPingClock::NowMicroseconds() };
+#pragma warning(suppress: 26486 26489 26492)
+	const DWORD dwRecvPackets{ (pSrcAddress != nullptr) ? IcmpSendEcho2Ex(m_hIP, nullptr, nullptr, nullptr, pSrcAddress->sin_addr.s_addr, destAddress.sin_addr.s_addr, const_cast<BYTE*>(pRequestData), wDataSize, &OptionInfo, pr.Reply.data(), dwReplySize, dwTimeout) :
+														   IcmpSendEcho(m_hIP, destAddress.sin_addr.s_addr, const_cast<BYTE*>(pRequestData), wDataSize, &OptionInfo, pr.Reply.data(), dwReplySize, dwTimeout) };
 
 	//Check we got the packet back
+	const ULONGLONG nElapsed{ CPingClock::NowMicroseconds() - nStart };
 	const bool bSuccess{ dwRecvPackets >= 1 };
 	if (bSuccess)
 	{
@@ -302,44 +493,438 @@ bool CPing::PingUsingICMPv4(_In_z_ LPCTSTR pszHostName, _Inout_ CPingReplyv4& pr
 		pr.Address = SOCKADDR_IN{};
 		pr.Address.sin_family = AF_INET;
 		const ICMP_ECHO_REPLY* pEchoReply{ pr.GetICMP_ECHO_REPLY() };
-		pr.Address.sin_addr.S_un.S_addr = pEchoReply->Address;
-		pr.RTT = pEchoReply->RoundTripTime;
+		pr.Address.sin_addr.s_addr = pEchoReply->Address;
+		pr.RTT = CPingClock::ReconcileRTT(nElapsed, pEchoReply->RoundTripTime);
 		pr.EchoReplyStatus = pEchoReply->Status;
 		SetLastError(ERROR_SUCCESS);
 	}
 	else
-		SetLastError(ERROR_TIMEOUT);
+	{
+		//Pass an IP_STATUS such as IP_DEST_HOST_UNREACHABLE on as the datagram backend does, anything else is a timeout
+		const DWORD dwError{ GetLastError() };
+		SetLastError(((dwError > IP_STATUS_BASE) && (dwError <= IP_GENERAL_FAILURE) && (dwError != IP_REQ_TIMED_OUT)) ? dwError : ERROR_TIMEOUT);
+	}
 
 	return bSuccess;
 }
 
-bool CPing::PingUsingICMPv6(_In_z_ LPCTSTR pszHostName, _Inout_ CPingReplyv6& pr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_z_ LPCTSTR pszLocalBoundAddress) const
+bool CIcmpPingBackend::SendEchov6(_In_ const SOCKADDR_IN6& destAddress, _In_ const SOCKADDR_IN6& srcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv6& pr, _In_ DWORD dwTimeout)
 {
-	//Do the address lookup
-	ATL::CSocketAddr lookup;
-	int nError{ lookup.FindAddr(pszHostName, 0, 0, AF_INET6, 0, 0) };
-	if (nError != 0) //NOLINT(clang-analyzer-optin.portability.UnixAPI)
+	//Do the actual Ping
+	IP_OPTION_INFORMATION OptionInfo{ optionInfo };
+	SOCKADDR_IN6 SrcAddress{ srcAddress };
+	SOCKADDR_IN6 DestAddress{ destAddress };
+#pragma warning(suppress: 26472)
+	const DWORD dwReplySize{ static_cast<DWORD>(pr.Reply.size()) };
+	const ULONGLONG nStart{ CPingClock::NowMicroseconds() };
+#pragma warning(suppress: 26486 26492)
+	const DWORD dwRecvPackets{ Icmp6SendEcho2(m_hIP, nullptr, nullptr, nullptr, &SrcAddress, &DestAddress, const_cast<BYTE*>(pRequestData), wDataSize, &OptionInfo, pr.Reply.data(), dwReplySize, dwTimeout) };
+
+	//Check we got the packet back
+	const ULONGLONG nElapsed{ CPingClock::NowMicroseconds() - nStart };
+	const bool bSuccess{ dwRecvPackets >= 1 };
+	if (bSuccess)
 	{
-		SetLastError(nError);
+		//Ping was successful, copy over the pertinent info into the return structure
+		pr.Address = SOCKADDR_IN6{};
+		pr.Address.sin6_family = AF_INET6;
+		const ICMPV6_ECHO_REPLY* pEchoReply{ pr.GetICMPV6_ECHO_REPLY() };
+		pr.Address.sin6_port = pEchoReply->Address.sin6_port;
+		pr.Address.sin6_flowinfo = pEchoReply->Address.sin6_flowinfo;
+#pragma warning(suppress: 26485)
+		memcpy_s(&pr.Address.sin6_addr, sizeof(pr.Address.sin6_addr), pEchoReply->Address.sin6_addr, sizeof(pEchoReply->Address.sin6_addr));
+		pr.Address.sin6_scope_id = pEchoReply->Address.sin6_scope_id;
+		pr.RTT = CPingClock::ReconcileRTT(nElapsed, pEchoReply->RoundTripTime);
+		pr.EchoReplyStatus = pEchoReply->Status;
+		SetLastError(ERROR_SUCCESS);
+	}
+	else
+	{
+		//Pass an IP_STATUS such as IP_DEST_HOST_UNREACHABLE on as the datagram backend does, anything else is a timeout
+		const DWORD dwError{ GetLastError() };
+		SetLastError(((dwError > IP_STATUS_BASE) && (dwError <= IP_GENERAL_FAILURE) && (dwError != IP_REQ_TIMED_OUT)) ? dwError : ERROR_TIMEOUT);
+	}
+
+	return bSuccess;
+}
+#else
+CDatagramPingBackend::~CDatagramPingBackend()
+{
+	Close();
+}
+
+bool CDatagramPingBackend::Open(_In_ int nFamily)
+{
+	//Release any existing socket
+	Close();
+
+	//Create the unprivileged ICMP socket
+	m_nSocket = socket(nFamily, SOCK_DGRAM, (nFamily == AF_INET6) ? static_cast<int>(IPPROTO_ICMPV6) : static_cast<int>(IPPROTO_ICMP));
+	if (m_nSocket == -1)
+	{
+		SetLastError(static_cast<DWORD>(errno));
 		return false;
 	}
+	m_nFamily = nFamily;
 
-	//Note we always use the first address returned from ATL::CSocketAddr::FindAddr. If you want to use a different
-	//Address then do the lookup yourself and pass in the correct value in the "pszHostName" parameter
-	const ADDRINFOT* pAddress{ lookup.GetAddrInfoList() };
-#pragma warning(suppress: 26477)
-	ATLASSUME(pAddress != nullptr);
-#pragma warning(suppress: 26477)
-	ATLASSERT(pAddress->ai_family == AF_INET6);
-#pragma warning(suppress: 26489 26490)
-	const auto pDestAddress{ reinterpret_cast<sockaddr_in6*>(pAddress->ai_addr) };
+	//Ask for ICMP errors (TTL exceeded, destination unreachable etc) to be delivered on the error queue
+	const int nOn{ 1 };
+	const int nResult{ (nFamily == AF_INET6) ? setsockopt(m_nSocket, SOL_IPV6, IPV6_RECVERR, &nOn, sizeof(nOn)) : setsockopt(m_nSocket, SOL_IP, IP_RECVERR, &nOn, sizeof(nOn)) };
+	if (nResult == -1)
+	{
+		const DWORD dwError{ static_cast<DWORD>(errno) };
+		Close();
+		SetLastError(dwError);
+		return false;
+	}
 
-	//Create the ICMP handle
-	HANDLE hIP{ Icmp6CreateFile() };
-	if (hIP == INVALID_HANDLE_VALUE)
+	//Preallocate the receive buffer large enough for the biggest datagram
+	m_RecvBuf.resize(65536);
+	return true;
+}
+
+void CDatagramPingBackend::Close() noexcept
+{
+	if (m_nSocket != -1)
+	{
+		//Preserve the last error value across the call to close
+		const DWORD dwLastError{ GetLastError() };
+		close(m_nSocket);
+		m_nSocket = -1;
+		SetLastError(dwLastError);
+	}
+	m_nFamily = AF_UNSPEC;
+	m_nLastTTL = -1;
+	m_nLastTOS = -1;
+	m_nLastDF = -1;
+	m_bBound = false;
+}
+
+bool CDatagramPingBackend::ApplyOptions(_In_ const IP_OPTION_INFORMATION& optionInfo)
+{
+	//Note that IP_FLAG_REVERSE (record route) is not supported on datagram ICMP sockets and is ignored. Each option
+	//is only applied to the socket when it changes, so steady state probes do not incur any extra system calls
+	const int nTTL{ optionInfo.Ttl };
+	if (nTTL != m_nLastTTL)
+	{
+		const int nResult{ (m_nFamily == AF_INET6) ? setsockopt(m_nSocket, SOL_IPV6, IPV6_UNICAST_HOPS, &nTTL, sizeof(nTTL)) : setsockopt(m_nSocket, SOL_IP, IP_TTL, &nTTL, sizeof(nTTL)) };
+		if (nResult == -1)
+			return false;
+		m_nLastTTL = nTTL;
+	}
+	const int nTOS{ optionInfo.Tos };
+	if (nTOS != m_nLastTOS)
+	{
+		const int nResult{ (m_nFamily == AF_INET6) ? setsockopt(m_nSocket, SOL_IPV6, IPV6_TCLASS, &nTOS, sizeof(nTOS)) : setsockopt(m_nSocket, SOL_IP, IP_TOS, &nTOS, sizeof(nTOS)) };
+		if (nResult == -1)
+			return false;
+		m_nLastTOS = nTOS;
+	}
+	const int nDF{ (optionInfo.Flags & IP_FLAG_DF) ? 1 : 0 };
+	if (nDF != m_nLastDF)
+	{
+		const int nMode{ nDF ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT };
+		const int nResult{ (m_nFamily == AF_INET6) ? setsockopt(m_nSocket, SOL_IPV6, IPV6_MTU_DISCOVER, &nMode, sizeof(nMode)) : setsockopt(m_nSocket, SOL_IP, IP_MTU_DISCOVER, &nMode, sizeof(nMode)) };
+		if (nResult == -1)
+			return false;
+		m_nLastDF = nDF;
+	}
+	return true;
+}
+
+bool CDatagramPingBackend::Bind(_In_ const SOCKADDR* pAddress, _In_ socklen_t nAddressLen)
+{
+	//A socket can only be bound once, so just ignore subsequent requests
+	if (m_bBound)
+		return true;
+	if (bind(m_nSocket, pAddress, nAddressLen) == -1)
+		return false;
+	m_bBound = true;
+	return true;
+}
+
+bool CDatagramPingBackend::SendRequest(_In_ const SOCKADDR* pDestAddress, _In_ socklen_t nDestAddressLen, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize)
+{
+	//Form the ICMP echo request. Note the kernel fills in the identifier and the checksum for us
+	m_Packet.resize(static_cast<size_t>(8) + wDataSize);
+	BYTE* pPacket{ m_Packet.data() };
+	memset(pPacket, 0, 8);
+	pPacket[0] = (m_nFamily == AF_INET6) ? ICMP6_ECHO_REQUEST : ICMP_ECHO;
+	++m_wSequence;
+	const WORD wSequence{ htons(m_wSequence) };
+	memcpy(pPacket + 6, &wSequence, sizeof(wSequence));
+	if (wDataSize)
+		memcpy(pPacket + 8, pRequestData, wDataSize);
+	ApplyFlow(m_wSequence, pPacket + 8, wDataSize);
+
+	//Discard any stale errors which are still on the error queue
+	char control[512];
+	iovec iov{ m_RecvBuf.data(), m_RecvBuf.size() };
+	msghdr msg{};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	while (recvmsg(m_nSocket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) >= 0)
+		msg.msg_controllen = sizeof(control);
+
+	m_nSendTime = CPingClock::NowMicroseconds();
+	return sendto(m_nSocket, pPacket, m_Packet.size(), 0, pDestAddress, nDestAddressLen) != -1;
+}
+
+bool CDatagramPingBackend::IsOurReply(_In_reads_bytes_(nLength) const BYTE* pICMP, _In_ size_t nLength, _In_ bool bErrorQueue) const noexcept
+{
+	if (nLength < 8)
+		return false;
+
+	//Messages on the error queue carry our original request, otherwise we expect an echo reply
+	BYTE nExpectedType{ 0 };
+	if (m_nFamily == AF_INET6)
+		nExpectedType = bErrorQueue ? ICMP6_ECHO_REQUEST : ICMP6_ECHO_REPLY;
+	else
+		nExpectedType = bErrorQueue ? ICMP_ECHO : ICMP_ECHOREPLY;
+	if (pICMP[0] != nExpectedType)
+		return false;
+
+	//Ignore replies to earlier requests which arrived after they timed out
+	WORD wSequence{ 0 };
+	memcpy(&wSequence, pICMP + 6, sizeof(wSequence));
+	return ntohs(wSequence) == m_wSequence;
+}
+
+ULONG CDatagramPingBackend::MapIcmpError(_In_ int nFamily, _In_ BYTE nType, _In_ BYTE nCode) noexcept
+{
+	//Map the ICMP error onto the same IP_STATUS values which the Windows ICMP API reports
+	if (nFamily == AF_INET6)
+	{
+		switch (nType)
+		{
+			case ICMP6_DST_UNREACH:
+			{
+				switch (nCode)
+				{
+					case ICMP6_DST_UNREACH_NOROUTE: return IP_DEST_NO_ROUTE;
+					case ICMP6_DST_UNREACH_ADMIN: return IP_DEST_PROHIBITED;
+					case ICMP6_DST_UNREACH_NOPORT: return IP_DEST_PORT_UNREACHABLE;
+					default: return IP_DEST_ADDR_UNREACHABLE;
+				}
+			}
+			case ICMP6_PACKET_TOO_BIG: return IP_PACKET_TOO_BIG;
+			case ICMP6_TIME_EXCEEDED: return (nCode == ICMP6_TIME_EXCEED_TRANSIT) ? IP_HOP_LIMIT_EXCEEDED : IP_TTL_EXPIRED_REASSEM;
+			case ICMP6_PARAM_PROB: return IP_PARAM_PROBLEM;
+			default: return IP_GENERAL_FAILURE;
+		}
+	}
+
+	switch (nType)
+	{
+		case ICMP_DEST_UNREACH:
+		{
+			switch (nCode)
+			{
+				case ICMP_NET_UNREACH: return IP_DEST_NET_UNREACHABLE;
+				case ICMP_PROT_UNREACH: return IP_DEST_PROT_UNREACHABLE;
+				case ICMP_PORT_UNREACH: return IP_DEST_PORT_UNREACHABLE;
+				case ICMP_FRAG_NEEDED: return IP_PACKET_TOO_BIG;
+				default: return IP_DEST_HOST_UNREACHABLE;
+			}
+		}
+		case ICMP_SOURCE_QUENCH: return IP_SOURCE_QUENCH;
+		case ICMP_TIME_EXCEEDED: return (nCode == ICMP_EXC_TTL) ? IP_TTL_EXPIRED_TRANSIT : IP_TTL_EXPIRED_REASSEM;
+		case ICMP_PARAMETERPROB: return IP_PARAM_PROBLEM;
+		default: return IP_GENERAL_FAILURE;
+	}
+}
+
+bool CDatagramPingBackend::WaitForReply(_In_ DWORD dwTimeout, _Out_ SOCKADDR_STORAGE& replier, _Out_ ULONG& nStatus, _Out_ ULONGLONG& nRTT)
+{
+	replier = SOCKADDR_STORAGE{};
+	nStatus = IP_REQ_TIMED_OUT;
+	nRTT = 0;
+
+	const ULONGLONG nDeadline{ m_nSendTime + (static_cast<ULONGLONG>(dwTimeout) * 1000ULL) };
+	for (;;)
+	{
+		//Work out how long we can still wait for
+		const ULONGLONG nNow{ CPingClock::NowMicroseconds() };
+		if (nNow >= nDeadline)
+			return false;
+		pollfd pfd{ m_nSocket, POLLIN, 0 };
+		const int nWait{ static_cast<int>((nDeadline - nNow + 999) / 1000) };
+		const int nReady{ poll(&pfd, 1, nWait) };
+		if (nReady == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			nStatus = IP_GENERAL_FAILURE;
+			return false;
+		}
+		if (nReady == 0)
+			continue;
+
+		char control[512];
+		iovec iov{ m_RecvBuf.data(), m_RecvBuf.size() };
+		msghdr msg{};
+		msg.msg_name = &replier;
+		msg.msg_namelen = sizeof(replier);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if (pfd.revents & POLLERR)
+		{
+			//An ICMP error (or a local error) for one of our requests
+			const ssize_t nRead{ recvmsg(m_nSocket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) };
+			if ((nRead < 0) || !IsOurReply(m_RecvBuf.data(), static_cast<size_t>(nRead), true))
+				continue;
+			for (cmsghdr* pCmsg{ CMSG_FIRSTHDR(&msg) }; pCmsg != nullptr; pCmsg = CMSG_NXTHDR(&msg, pCmsg))
+			{
+				const bool bRecvErr{ ((pCmsg->cmsg_level == SOL_IP) && (pCmsg->cmsg_type == IP_RECVERR)) || ((pCmsg->cmsg_level == SOL_IPV6) && (pCmsg->cmsg_type == IPV6_RECVERR)) };
+				if (!bRecvErr)
+					continue;
+				const auto pError{ reinterpret_cast<const sock_extended_err*>(CMSG_DATA(pCmsg)) };
+				if ((pError->ee_origin == SO_EE_ORIGIN_ICMP) || (pError->ee_origin == SO_EE_ORIGIN_ICMP6))
+				{
+					const SOCKADDR* pOffender{ SO_EE_OFFENDER(pError) };
+					memcpy(&replier, pOffender, (pOffender->sa_family == AF_INET6) ? sizeof(SOCKADDR_IN6) : sizeof(SOCKADDR_IN));
+					nStatus = MapIcmpError(m_nFamily, pError->ee_type, pError->ee_code);
+					nRTT = CPingClock::NowMicroseconds() - m_nSendTime;
+					return true;
+				}
+				nStatus = (pError->ee_errno == EMSGSIZE) ? IP_PACKET_TOO_BIG : IP_GENERAL_FAILURE;
+				return false;
+			}
+		}
+		else if (pfd.revents & POLLIN)
+		{
+			//An echo reply, but it may be a late reply to an earlier request
+			const ssize_t nRead{ recvmsg(m_nSocket, &msg, MSG_DONTWAIT) };
+			if ((nRead < 0) || !IsOurReply(m_RecvBuf.data(), static_cast<size_t>(nRead), false))
+				continue;
+			nStatus = IP_SUCCESS;
+			nRTT = CPingClock::NowMicroseconds() - m_nSendTime;
+			return true;
+		}
+	}
+}
+
+bool CDatagramPingBackend::SendEchov4(_In_ const SOCKADDR_IN& destAddress, _In_opt_ const SOCKADDR_IN* pSrcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv4& pr, _In_ DWORD dwTimeout)
+{
+	//Set up the socket and send the request
+	if (!ApplyOptions(optionInfo) || ((pSrcAddress != nullptr) && !Bind(reinterpret_cast<const SOCKADDR*>(pSrcAddress), sizeof(SOCKADDR_IN))) ||
+		!SendRequest(reinterpret_cast<const SOCKADDR*>(&destAddress), sizeof(destAddress), pRequestData, wDataSize))
+	{
+		SetLastError(static_cast<DWORD>(errno));
+		return false;
+	}
+
+	//Wait for the response
+	SOCKADDR_STORAGE replier{};
+	ULONG nStatus{ 0 };
+	ULONGLONG nRTT{ 0 };
+	if (!WaitForReply(dwTimeout, replier, nStatus, nRTT))
+	{
+		SetLastError((nStatus == IP_REQ_TIMED_OUT) ? ERROR_TIMEOUT : nStatus);
+		return false;
+	}
+
+	//Form the same ICMP_ECHO_REPLY which the Windows ICMP API would return
+	pr.Address = SOCKADDR_IN{};
+	pr.Address.sin_family = AF_INET;
+	pr.Address.sin_addr = reinterpret_cast<const SOCKADDR_IN*>(&replier)->sin_addr;
+	pr.RTT = nRTT;
+	pr.EchoReplyStatus = nStatus;
+	ICMP_ECHO_REPLY echoReply{};
+	echoReply.Address = pr.Address.sin_addr.s_addr;
+	echoReply.Status = nStatus;
+	echoReply.RoundTripTime = static_cast<ULONG>(nRTT / 1000ULL);
+	echoReply.Options.Ttl = optionInfo.Ttl;
+	echoReply.Options.Tos = optionInfo.Tos;
+	echoReply.Options.Flags = optionInfo.Flags;
+	if ((nStatus == IP_SUCCESS) && (pr.Reply.size() >= (sizeof(ICMP_ECHO_REPLY) + wDataSize)))
+	{
+		echoReply.DataSize = wDataSize;
+		echoReply.Data = pr.Reply.data() + sizeof(ICMP_ECHO_REPLY);
+		memcpy(echoReply.Data, m_RecvBuf.data() + 8, wDataSize);
+	}
+	if (pr.Reply.size() >= sizeof(ICMP_ECHO_REPLY))
+		memcpy(pr.Reply.data(), &echoReply, sizeof(echoReply));
+	SetLastError(ERROR_SUCCESS);
+	return true;
+}
+
+bool CDatagramPingBackend::SendEchov6(_In_ const SOCKADDR_IN6& destAddress, _In_ const SOCKADDR_IN6& srcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv6& pr, _In_ DWORD dwTimeout)
+{
+	//Set up the socket and send the request
+	const bool bBind{ memcmp(&srcAddress.sin6_addr, &in6addr_any, sizeof(in6addr_any)) != 0 };
+	if (!ApplyOptions(optionInfo) || (bBind && !Bind(reinterpret_cast<const SOCKADDR*>(&srcAddress), sizeof(srcAddress))) ||
+		!SendRequest(reinterpret_cast<const SOCKADDR*>(&destAddress), sizeof(destAddress), pRequestData, wDataSize))
+	{
+		SetLastError(static_cast<DWORD>(errno));
+		return false;
+	}
+
+	//Wait for the response
+	SOCKADDR_STORAGE replier{};
+	ULONG nStatus{ 0 };
+	ULONGLONG nRTT{ 0 };
+	if (!WaitForReply(dwTimeout, replier, nStatus, nRTT))
+	{
+		SetLastError((nStatus == IP_REQ_TIMED_OUT) ? ERROR_TIMEOUT : nStatus);
 		return false;
+	}
 
-	//Set up the option info structure
+	//Form the same ICMPV6_ECHO_REPLY which the Windows ICMP API would return
+	memcpy(&pr.Address, &replier, sizeof(pr.Address));
+	pr.Address.sin6_family = AF_INET6;
+	pr.RTT = nRTT;
+	pr.EchoReplyStatus = nStatus;
+	ICMPV6_ECHO_REPLY echoReply{};
+	echoReply.Address.sin6_port = pr.Address.sin6_port;
+	echoReply.Address.sin6_flowinfo = pr.Address.sin6_flowinfo;
+	memcpy(echoReply.Address.sin6_addr, &pr.Address.sin6_addr, sizeof(echoReply.Address.sin6_addr));
+	echoReply.Address.sin6_scope_id = pr.Address.sin6_scope_id;
+	echoReply.Status = nStatus;
+	echoReply.RoundTripTime = static_cast<ULONG>(nRTT / 1000ULL);
+	if ((nStatus == IP_SUCCESS) && (pr.Reply.size() >= (sizeof(ICMPV6_ECHO_REPLY) + wDataSize)))
+		memcpy(pr.Reply.data() + sizeof(ICMPV6_ECHO_REPLY), m_RecvBuf.data() + 8, wDataSize);
+	if (pr.Reply.size() >= sizeof(ICMPV6_ECHO_REPLY))
+		memcpy(pr.Reply.data(), &echoReply, sizeof(echoReply));
+	SetLastError(ERROR_SUCCESS);
+	return true;
+}
+#endif //#ifdef _WIN32
+
+
+CPingSession::CPingSession() : CPingSession(CPingBackend::CreateDefault())
+{
+}
+
+CPingSession::CPingSession(_In_ std::unique_ptr<CPingBackend> pBackend) noexcept : m_pBackend{ std::move(pBackend) },
+m_nFamily{ AF_UNSPEC },
+m_DestAddressv4{},
+m_DestAddressv6{},
+m_SrcAddressv4{},
+m_SrcAddressv6{},
+m_bBindSourceAddress{ false },
+m_dwReplySize{ 0 }
+{
+}
+
+CPingSession::~CPingSession()
+{
+	Close();
+}
+
+//Fill up the ICMP packet with defined values
+#pragma warning(suppress: 26440)
+void CPingSession::FillIcmpData(_Out_writes_bytes_(dwRequestSize) BYTE* pRequestData, _In_ DWORD dwRequestSize) const
+{
+	memset(pRequestData, 'E', dwRequestSize);
+}
+
+IP_OPTION_INFORMATION CPingSession::MakeOptionInfo(_In_ UCHAR nTTL, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse) noexcept
+{
 	IP_OPTION_INFORMATION OptionInfo{};
 	OptionInfo.Ttl = nTTL;
 	OptionInfo.Tos = nTOS;
@@ -347,74 +932,286 @@ bool CPing::PingUsingICMPv6(_In_z_ LPCTSTR pszHostName, _Inout_ CPingReplyv6& pr
 		OptionInfo.Flags = IP_FLAG_DF;
 	if (bFlagReverse)
 		OptionInfo.Flags |= IP_FLAG_REVERSE;
+	return OptionInfo;
+}
+
+int CPingSession::ResolveAddress(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _Out_writes_bytes_(nAddressLen) SOCKADDR* pAddress, _In_ int nAddressLen)
+{
+	//Numeric addresses are converted directly, only names need a trip through the resolver
+	BYTE literalAddress[16]{};
+	int nLiteralFamily{ AF_UNSPEC };
+	if (CIpAddressText::Parse(pszHostName, _tcslen(pszHostName), nLiteralFamily, literalAddress) && ((nFamily == AF_UNSPEC) || (nFamily == nLiteralFamily)))
+	{
+		if (nLiteralFamily == AF_INET)
+		{
+			SOCKADDR_IN address{};
+			address.sin_family = AF_INET;
+			memcpy(&address.sin_addr, literalAddress, sizeof(address.sin_addr));
+			memset(pAddress, 0, nAddressLen);
+#pragma warning(suppress: 26472)
+			memcpy_s(pAddress, nAddressLen, &address, (std::min)(sizeof(address), static_cast<size_t>(nAddressLen)));
+		}
+		else
+		{
+			SOCKADDR_IN6 address{};
+			address.sin6_family = AF_INET6;
+			memcpy(&address.sin6_addr, literalAddress, sizeof(address.sin6_addr));
+			memset(pAddress, 0, nAddressLen);
+#pragma warning(suppress: 26472)
+			memcpy_s(pAddress, nAddressLen, &address, (std::min)(sizeof(address), static_cast<size_t>(nAddressLen)));
+		}
+		return 0;
+	}
+
+	//Names which were looked up recently are answered from the process wide cache
+	CHostNameCache& cache{ CHostNameCache::Instance() };
+	if (cache.Find(pszHostName, nFlags, nFamily, pAddress, nAddressLen))
+		return 0;
+
+	//Note we always use the first address returned from the lookup. If you want to use a different
+	//Address then do the lookup yourself and pass in the correct value in the "pszHostName" parameter
+#ifdef _WIN32
+	ATL::CSocketAddr lookup;
+	const int nError{ lookup.FindAddr(pszHostName, 0, nFlags, nFamily, 0, 0) };
+	if (nError != 0)
+		return nError;
+	const ADDRINFOT* pAddressInfo{ lookup.GetAddrInfoList() };
+#else
+	addrinfo hints{};
+	hints.ai_flags = nFlags;
+	hints.ai_family = nFamily;
+	addrinfo* pAddressList{ nullptr };
+	const int nError{ getaddrinfo(pszHostName, nullptr, &hints, &pAddressList) };
+	if (nError != 0)
+		return nError;
+	const addrinfo* pAddressInfo{ pAddressList };
+#endif //#ifdef _WIN32
+#pragma warning(suppress: 26477)
+	ATLASSUME(pAddressInfo != nullptr);
+#pragma warning(suppress: 26477)
+	ATLASSERT(pAddressInfo->ai_family == nFamily);
+	memset(pAddress, 0, nAddressLen);
+#pragma warning(suppress: 26472)
+	memcpy_s(pAddress, nAddressLen, pAddressInfo->ai_addr, (std::min)(static_cast<size_t>(pAddressInfo->ai_addrlen), static_cast<size_t>(nAddressLen)));
+#pragma warning(suppress: 26472)
+	cache.Add(pszHostName, nFlags, nFamily, pAddressInfo->ai_addr, static_cast<int>(pAddressInfo->ai_addrlen));
+#ifndef _WIN32
+	freeaddrinfo(pAddressList);
+#endif //#ifndef _WIN32
+	return 0;
+}
+
+int CPingSession::ResolveAllAddresses(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _Inout_ std::vector<SOCKADDR_STORAGE>& addresses)
+{
+	addresses.clear();
+
+	//A numeric address only ever has the one address
+	BYTE literalAddress[16]{};
+	int nLiteralFamily{ AF_UNSPEC };
+	if (CIpAddressText::Parse(pszHostName, _tcslen(pszHostName), nLiteralFamily, literalAddress))
+	{
+		SOCKADDR_STORAGE address{};
+#pragma warning(suppress: 26490)
+		const int nError{ ResolveAddress(pszHostName, nFlags, nFamily, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) };
+		if (nError == 0)
+			addresses.push_back(address);
+		return nError;
+	}
+
+	//Walk the whole answer, skipping the duplicates which show up once per socket type
+#ifdef _WIN32
+	ATL::CSocketAddr lookup;
+	const int nError{ lookup.FindAddr(pszHostName, 0, nFlags, nFamily, 0, 0) };
+	if (nError != 0)
+		return nError;
+	const ADDRINFOT* pAddressInfo{ lookup.GetAddrInfoList() };
+#else
+	addrinfo hints{};
+	hints.ai_flags = nFlags;
+	hints.ai_family = nFamily;
+	addrinfo* pAddressList{ nullptr };
+	const int nError{ getaddrinfo(pszHostName, nullptr, &hints, &pAddressList) };
+	if (nError != 0)
+		return nError;
+	const addrinfo* pAddressInfo{ pAddressList };
+#endif //#ifdef _WIN32
+	for (; pAddressInfo != nullptr; pAddressInfo = pAddressInfo->ai_next)
+	{
+		if ((pAddressInfo->ai_family != AF_INET) && (pAddressInfo->ai_family != AF_INET6))
+			continue;
+		SOCKADDR_STORAGE address{};
+#pragma warning(suppress: 26472)
+		memcpy(&address, pAddressInfo->ai_addr, (std::min)(static_cast<size_t>(pAddressInfo->ai_addrlen), sizeof(address)));
+		const bool bDuplicate{ std::any_of(addresses.begin(), addresses.end(), [&](const SOCKADDR_STORAGE& other) noexcept
+		{
+			return memcmp(&address, &other, sizeof(address)) == 0;
+		}) };
+		if (!bDuplicate)
+			addresses.push_back(address);
+	}
+#ifndef _WIN32
+	freeaddrinfo(pAddressList);
+#endif //#ifndef _WIN32
+	if (addresses.empty())
+		return EAI_NONAME;
+
+	//Keep the first one around for the next single address lookup of the same name
+#pragma warning(suppress: 26490)
+	CHostNameCache::Instance().Add(pszHostName, nFlags, nFamily, reinterpret_cast<const SOCKADDR*>(&addresses.front()), (addresses.front().ss_family == AF_INET6) ? sizeof(SOCKADDR_IN6) : sizeof(SOCKADDR_IN));
+	return 0;
+}
+
+void CPingSession::Close() noexcept
+{
+	if (m_pBackend != nullptr)
+		m_pBackend->Close();
+	m_nFamily = AF_UNSPEC;
+}
+
+bool CPingSession::OpenBackend(_In_ int nFamily, _In_ WORD wDataSize)
+{
+	if (m_pBackend == nullptr)
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return false;
+	}
+
+	//Create the ICMP handle / socket
+	if (!m_pBackend->Open(nFamily))
+		return false;
+	m_nFamily = nFamily;
 
 	//Set up the data which will be sent
-	std::vector<BYTE> sendBuf{ wDataSize, std::allocator<BYTE>{} };
+	m_SendBuf.resize(wDataSize);
 #pragma warning(suppress: 26486)
-	FillIcmpData(sendBuf.data(), wDataSize);
+	FillIcmpData(m_SendBuf.data(), wDataSize);
+	m_dwReplySize = m_pBackend->GetReplySize(nFamily, wDataSize);
 
-	//Do the actual Ping
-#pragma warning(suppress: 26472)
-	const DWORD dwReplySize{ static_cast<DWORD>(sizeof(ICMPV6_ECHO_REPLY) + wDataSize + 8) };
-	pr.Reply.resize(dwReplySize);
+	return true;
+}
+
+bool CPingSession::Openv4(_In_z_ LPCTSTR pszHostName, _In_ WORD wDataSize, _In_opt_z_ LPCTSTR pszLocalBoundAddress)
+{
+	//Release any existing resources
+	Close();
+
+	//Do the address lookup
+	SOCKADDR_IN destAddress{};
+#pragma warning(suppress: 26490)
+	int nError{ ResolveAddress(pszHostName, 0, AF_INET, reinterpret_cast<SOCKADDR*>(&destAddress), sizeof(destAddress)) };
+	if (nError != 0)
+	{
+		SetLastError(nError);
+		return false;
+	}
 
-	//Bind to the local address if need be
-	sockaddr_in6 srcAddress{};
-	srcAddress.sin6_family = AF_INET6;
-	if (pszLocalBoundAddress && _tcslen(pszLocalBoundAddress))
+	//Lookup the local address if need be
+	SOCKADDR_IN localAddress{};
+	const bool bBindSourceAddress{ (pszLocalBoundAddress != nullptr) && _tcslen(pszLocalBoundAddress) };
+	if (bBindSourceAddress)
 	{
-		nError = lookup.FindAddr(pszLocalBoundAddress, 0, AI_PASSIVE, AF_INET6, 0, 0);
+#pragma warning(suppress: 26490)
+		nError = ResolveAddress(pszLocalBoundAddress, AI_PASSIVE, AF_INET, reinterpret_cast<SOCKADDR*>(&localAddress), sizeof(localAddress));
 		if (nError != 0)
 		{
-			IcmpCloseHandle(hIP);
 			SetLastError(nError);
 			return false;
 		}
+	}
 
-		pAddress = lookup.GetAddrInfoList();
-#pragma warning(suppress: 26477)
-		ATLASSUME(pAddress != nullptr);
-#pragma warning(suppress: 26477)
-		ATLASSERT(pAddress->ai_family == AF_INET6);
-#pragma warning(suppress: 26489 26490)
-		auto pLookupAddress{ reinterpret_cast<const sockaddr_in6*>(pAddress->ai_addr) };
-#pragma warning(suppress: 26489)
-		srcAddress.sin6_port = pLookupAddress->sin6_port;
-#pragma warning(suppress: 26489)
-		srcAddress.sin6_flowinfo = pLookupAddress->sin6_flowinfo;
-#pragma warning(suppress: 26489)
-		memcpy_s(&srcAddress.sin6_addr, sizeof(srcAddress.sin6_addr), &pLookupAddress->sin6_addr, sizeof(pLookupAddress->sin6_addr));
-#pragma warning(suppress: 26489)
-		srcAddress.sin6_scope_id = pLookupAddress->sin6_scope_id;
+	return Openv4(destAddress, wDataSize, bBindSourceAddress ? &localAddress : nullptr);
+}
+
+bool CPingSession::Openv4(_In_ const SOCKADDR_IN& destAddress, _In_ WORD wDataSize, _In_opt_ const SOCKADDR_IN* pLocalAddress)
+{
+	//Release any existing resources
+	Close();
+
+	m_DestAddressv4 = destAddress;
+	m_SrcAddressv4 = (pLocalAddress != nullptr) ? *pLocalAddress : SOCKADDR_IN{};
+	m_bBindSourceAddress = (pLocalAddress != nullptr);
+
+	return OpenBackend(AF_INET, wDataSize);
+}
+
+bool CPingSession::Openv6(_In_z_ LPCTSTR pszHostName, _In_ WORD wDataSize, _In_opt_z_ LPCTSTR pszLocalBoundAddress)
+{
+	//Release any existing resources
+	Close();
+
+	//Do the address lookup
+	SOCKADDR_IN6 destAddress{};
+#pragma warning(suppress: 26490)
+	int nError{ ResolveAddress(pszHostName, 0, AF_INET6, reinterpret_cast<SOCKADDR*>(&destAddress), sizeof(destAddress)) };
+	if (nError != 0) //NOLINT(clang-analyzer-optin.portability.UnixAPI)
+	{
+		SetLastError(nError);
+		return false;
+	}
+
+	//Lookup the local address if need be
+	SOCKADDR_IN6 localAddress{};
+	const bool bBindSourceAddress{ pszLocalBoundAddress && _tcslen(pszLocalBoundAddress) };
+	if (bBindSourceAddress)
+	{
+#pragma warning(suppress: 26490)
+		nError = ResolveAddress(pszLocalBoundAddress, AI_PASSIVE, AF_INET6, reinterpret_cast<SOCKADDR*>(&localAddress), sizeof(localAddress));
+		if (nError != 0)
+		{
+			SetLastError(nError);
+			return false;
+		}
 	}
+
+	return Openv6(destAddress, wDataSize, bBindSourceAddress ? &localAddress : nullptr);
+}
+
+bool CPingSession::Openv6(_In_ const SOCKADDR_IN6& destAddress, _In_ WORD wDataSize, _In_opt_ const SOCKADDR_IN6* pLocalAddress)
+{
+	//Release any existing resources
+	Close();
+
+	m_DestAddressv6 = destAddress;
+	if (pLocalAddress != nullptr)
+		m_SrcAddressv6 = *pLocalAddress;
 	else
-		srcAddress.sin6_addr = in6addr_any;
+	{
+		m_SrcAddressv6 = SOCKADDR_IN6{};
+		m_SrcAddressv6.sin6_addr = in6addr_any;
+	}
+	m_SrcAddressv6.sin6_family = AF_INET6;
 
-#pragma warning(suppress: 26486)
-	const DWORD dwRecvPackets{ Icmp6SendEcho2(hIP, nullptr, nullptr, nullptr, &srcAddress, pDestAddress, sendBuf.data(), wDataSize, &OptionInfo, pr.Reply.data(), dwReplySize, dwTimeout) };
+	return OpenBackend(AF_INET6, wDataSize);
+}
+
+bool CPingSession::Pingv4(_Inout_ CPingReplyv4& pr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse)
+{
+	//Validate our state
+	if ((m_nFamily != AF_INET) || !IsOpen())
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return false;
+	}
 
-	//Close the ICMP handle
-	IcmpCloseHandle(hIP);
+	//Do the actual Ping. Note that the resize is a no-op when the caller reuses "pr" across calls
+	pr.Reply.resize(m_dwReplySize);
+	const IP_OPTION_INFORMATION OptionInfo{ MakeOptionInfo(nTTL, nTOS, bDontFragment, bFlagReverse) };
+#pragma warning(suppress: 26472)
+	return m_pBackend->SendEchov4(m_DestAddressv4, m_bBindSourceAddress ? &m_SrcAddressv4 : nullptr, OptionInfo, m_SendBuf.data(), static_cast<WORD>(m_SendBuf.size()), pr, dwTimeout);
+}
 
-	//Check we got the packet back
-	const bool bSuccess{ dwRecvPackets >= 1 };
-	if (bSuccess)
+bool CPingSession::Pingv6(_Inout_ CPingReplyv6& pr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse)
+{
+	//Validate our state
+	if ((m_nFamily != AF_INET6) || !IsOpen())
 	{
-		//Ping was successful, copy over the pertinent info into the return structure
-		pr.Address = SOCKADDR_IN6{};
-		pr.Address.sin6_family = AF_INET6;
-		const ICMPV6_ECHO_REPLY* pEchoReply{ pr.GetICMPV6_ECHO_REPLY() };
-		pr.Address.sin6_port = pEchoReply->Address.sin6_port;
-		pr.Address.sin6_flowinfo = pEchoReply->Address.sin6_flowinfo;
-#pragma warning(suppress: 26485)
-		memcpy_s(&pr.Address.sin6_addr, sizeof(pr.Address.sin6_addr), pEchoReply->Address.sin6_addr, sizeof(pEchoReply->Address.sin6_addr));
-		pr.Address.sin6_scope_id = pEchoReply->Address.sin6_scope_id;
-		pr.RTT = pEchoReply->RoundTripTime;
-		pr.EchoReplyStatus = pEchoReply->Status;
-		SetLastError(ERROR_SUCCESS);
+		SetLastError(ERROR_INVALID_HANDLE);
+		return false;
 	}
-	else
-		SetLastError(ERROR_TIMEOUT);
 
-	return bSuccess;
+	//Do the actual Ping. Note that the resize is a no-op when the caller reuses "pr" across calls
+	pr.Reply.resize(m_dwReplySize);
+	const IP_OPTION_INFORMATION OptionInfo{ MakeOptionInfo(nTTL, nTOS, bDontFragment, bFlagReverse) };
+#pragma warning(suppress: 26472)
+	return m_pBackend->SendEchov6(m_DestAddressv6, m_SrcAddressv6, OptionInfo, m_SendBuf.data(), static_cast<WORD>(m_SendBuf.size()), pr, dwTimeout);
 }
@@ -25,6 +25,7 @@ to maintain a single distribution point for the source code.
 #ifndef __PING_H__
 #define __PING_H__
 
+#ifdef _WIN32
 #ifndef __ATL_SOCKET__
 #pragma message("To avoid this message please put atlsocket.h in your pre compiled header (normally stdafx.h)")
 #include <atlsocket.h>
@@ -34,12 +35,33 @@ to maintain a single distribution point for the source code.
 #pragma message("To avoid this message please put icmpapi.h in your pre compiled header (normally stdafx.h)")
 #include <icmpapi.h>
 #endif //#ifndef _ICMP_INCLUDED_
+#endif //#ifdef _WIN32
 
 #ifndef _VECTOR_
 #pragma message("To avoid this message please put vector in your pre compiled header (normally stdafx.h)")
 #include <vector>
 #endif //#ifndef _VECTOR_
 
+#ifndef _MEMORY_
+#pragma message("To avoid this message please put memory in your pre compiled header (normally stdafx.h)")
+#include <memory>
+#endif //#ifndef _MEMORY_
+
+#ifndef _MAP_
+#pragma message("To avoid this message please put map in your pre compiled header (normally stdafx.h)")
+#include <map>
+#endif //#ifndef _MAP_
+
+#ifndef _MUTEX_
+#pragma message("To avoid this message please put mutex in your pre compiled header (normally stdafx.h)")
+#include <mutex>
+#endif //#ifndef _MUTEX_
+
+#ifndef _STRING_
+#pragma message("To avoid this message please put string in your pre compiled header (normally stdafx.h)")
+#include <string>
+#endif //#ifndef _STRING_
+
 #ifndef CPING_EXT_CLASS
 #define CPING_EXT_CLASS
 #endif //#ifndef CPING_EXT_CLASS
@@ -66,7 +88,7 @@ struct CPING_EXT_CLASS CPingReplyv4
 
 	//Member variables
 	SOCKADDR_IN Address; //The IP address of the replier
-	unsigned long RTT; //Round Trip time in Milliseconds
+	ULONGLONG RTT; //Round Trip time in Microseconds
 	unsigned long EchoReplyStatus; //here will be status of the last ping if successful
 	std::vector<BYTE> Reply; //The buffer for the ICMP_ECHO_REPLY / ICMPV6_ECHO_REPLY
 };
@@ -87,12 +109,141 @@ struct CPING_EXT_CLASS CPingReplyv6
 
 	//Member variables
 	SOCKADDR_IN6 Address; //The IP address of the replier
-	unsigned long RTT; //Round Trip time in Milliseconds
+	ULONGLONG RTT; //Round Trip time in Microseconds
 	unsigned long EchoReplyStatus; //here will be status of the last ping if successful
 	std::vector<BYTE> Reply; //The buffer for the ICMP_ECHO_REPLY / ICMPV6_ECHO_REPLY
 };
 
 
+//Access to a monotonic high resolution clock (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere)
+class CPING_EXT_CLASS CPingClock
+{
+public:
+	_NODISCARD static ULONGLONG NowMicroseconds() noexcept;
+	_NODISCARD static ULONGLONG ReconcileRTT(_In_ ULONGLONG nElapsedMicroseconds, _In_ ULONG nReportedMilliseconds) noexcept;
+};
+
+
+//The interface which actually sends an ICMP echo request and waits for the reply. CPingSession talks to the
+//network only through this class which allows the probe engine to run on platforms other than Windows
+class CPING_EXT_CLASS CPingBackend
+{
+public:
+	//Constructors / Destructors
+	CPingBackend() = default;
+	CPingBackend(const CPingBackend&) = delete;
+	CPingBackend(CPingBackend&&) = delete;
+	virtual ~CPingBackend() = default;
+
+	//Methods
+	CPingBackend& operator=(const CPingBackend&) = delete;
+	CPingBackend& operator=(CPingBackend&&) = delete;
+	virtual bool Open(_In_ int nFamily) = 0;
+	virtual void Close() noexcept = 0;
+	_NODISCARD virtual bool IsOpen() const noexcept = 0;
+	_NODISCARD virtual DWORD GetReplySize(_In_ int nFamily, _In_ WORD wDataSize) const noexcept;
+	virtual bool SendEchov4(_In_ const SOCKADDR_IN& destAddress, _In_opt_ const SOCKADDR_IN* pSrcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv4& pr, _In_ DWORD dwTimeout) = 0;
+	virtual bool SendEchov6(_In_ const SOCKADDR_IN6& destAddress, _In_ const SOCKADDR_IN6& srcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv6& pr, _In_ DWORD dwTimeout) = 0;
+
+	//Creates the native backend for the platform we are compiled for
+	_NODISCARD static std::unique_ptr<CPingBackend> CreateDefault();
+
+	//Flow stable (Paris traceroute) probing. Per flow load balancers choose the next hop of an ICMP echo request from
+	//its addresses and the first words of its ICMP header i.e. the type, code, checksum and identifier. With a flow set,
+	//a backend which knows the identifier and sequence number of its requests puts a word into the start of the request
+	//data which makes up for the sequence number, so the checksum of every request is the same for the same flow and
+	//data and all of them take the same path. A different flow gives a different checksum and so possibly a different
+	//path. SetFlow fails if the backend cannot do this, and needs at least 2 bytes of request data to have any effect
+	bool SetFlow(_In_ WORD wFlow) noexcept;
+	void ClearFlow() noexcept { m_bFlow = false; }
+	_NODISCARD bool HasFlow() const noexcept { return m_bFlow; }
+	_NODISCARD WORD GetFlow() const noexcept { return m_wFlow; }
+	_NODISCARD virtual bool SupportsFlow() const noexcept { return false; }
+
+protected:
+	//Methods
+	void ApplyFlow(_In_ WORD wSequence, _Inout_updates_bytes_(wDataSize) BYTE* pRequestData, _In_ WORD wDataSize) const noexcept;
+
+	//Member variables
+	bool m_bFlow{ false }; //Should the checksum of the requests be kept at the one of m_wFlow
+	WORD m_wFlow{ 0 }; //The flow of the requests
+};
+
+
+#ifdef _WIN32
+//The backend which uses IcmpSendEcho / IcmpSendEcho2Ex / Icmp6SendEcho2 from Iphlpapi. Note that the ICMP API picks
+//the identifier and sequence number of the requests itself, so this backend does not support flows
+class CPING_EXT_CLASS CIcmpPingBackend : public CPingBackend
+{
+public:
+	//Constructors / Destructors
+	CIcmpPingBackend() = default;
+	CIcmpPingBackend(const CIcmpPingBackend&) = delete;
+	CIcmpPingBackend(CIcmpPingBackend&&) = delete;
+	~CIcmpPingBackend() override;
+
+	//Methods
+	CIcmpPingBackend& operator=(const CIcmpPingBackend&) = delete;
+	CIcmpPingBackend& operator=(CIcmpPingBackend&&) = delete;
+	bool Open(_In_ int nFamily) override;
+	void Close() noexcept override;
+	_NODISCARD bool IsOpen() const noexcept override { return m_hIP != INVALID_HANDLE_VALUE; }
+	bool SendEchov4(_In_ const SOCKADDR_IN& destAddress, _In_opt_ const SOCKADDR_IN* pSrcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv4& pr, _In_ DWORD dwTimeout) override;
+	bool SendEchov6(_In_ const SOCKADDR_IN6& destAddress, _In_ const SOCKADDR_IN6& srcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv6& pr, _In_ DWORD dwTimeout) override;
+
+protected:
+	//Member variables
+	HANDLE m_hIP{ INVALID_HANDLE_VALUE }; //The ICMP handle which is kept open until Close is called
+};
+#else
+//The backend which uses unprivileged datagram ICMP sockets i.e. socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP). Note
+//that on Linux the calling group must be allowed by the "net.ipv4.ping_group_range" sysctl. The kernel sets the
+//identifier of the requests to the local port of the socket, which stays the same until the socket is closed
+class CPING_EXT_CLASS CDatagramPingBackend : public CPingBackend
+{
+public:
+	//Constructors / Destructors
+	CDatagramPingBackend() = default;
+	CDatagramPingBackend(const CDatagramPingBackend&) = delete;
+	CDatagramPingBackend(CDatagramPingBackend&&) = delete;
+	~CDatagramPingBackend() override;
+
+	//Methods
+	CDatagramPingBackend& operator=(const CDatagramPingBackend&) = delete;
+	CDatagramPingBackend& operator=(CDatagramPingBackend&&) = delete;
+	bool Open(_In_ int nFamily) override;
+	void Close() noexcept override;
+	_NODISCARD bool IsOpen() const noexcept override { return m_nSocket != -1; }
+	_NODISCARD bool SupportsFlow() const noexcept override { return true; }
+	bool SendEchov4(_In_ const SOCKADDR_IN& destAddress, _In_opt_ const SOCKADDR_IN* pSrcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv4& pr, _In_ DWORD dwTimeout) override;
+	bool SendEchov6(_In_ const SOCKADDR_IN6& destAddress, _In_ const SOCKADDR_IN6& srcAddress, _In_ const IP_OPTION_INFORMATION& optionInfo, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize, _Inout_ CPingReplyv6& pr, _In_ DWORD dwTimeout) override;
+
+	//Maps an ICMP / ICMPv6 error type and code onto the same IP_STATUS values which the Windows ICMP API reports
+	_NODISCARD static ULONG MapIcmpError(_In_ int nFamily, _In_ BYTE nType, _In_ BYTE nCode) noexcept;
+
+protected:
+	//Methods
+	bool ApplyOptions(_In_ const IP_OPTION_INFORMATION& optionInfo);
+	bool Bind(_In_ const SOCKADDR* pAddress, _In_ socklen_t nAddressLen);
+	bool SendRequest(_In_ const SOCKADDR* pDestAddress, _In_ socklen_t nDestAddressLen, _In_reads_bytes_(wDataSize) const BYTE* pRequestData, _In_ WORD wDataSize);
+	bool WaitForReply(_In_ DWORD dwTimeout, _Out_ SOCKADDR_STORAGE& replier, _Out_ ULONG& nStatus, _Out_ ULONGLONG& nRTT);
+	_NODISCARD bool IsOurReply(_In_reads_bytes_(nLength) const BYTE* pICMP, _In_ size_t nLength, _In_ bool bErrorQueue) const noexcept;
+
+	//Member variables
+	int m_nSocket{ -1 }; //The ICMP datagram socket which is kept open until Close is called
+	int m_nFamily{ AF_UNSPEC }; //The address family of m_nSocket
+	std::vector<BYTE> m_Packet; //Preallocated buffer for the outgoing ICMP header + data
+	std::vector<BYTE> m_RecvBuf; //Preallocated buffer for incoming datagrams
+	WORD m_wSequence{ 0 }; //The sequence number of the outstanding request
+	int m_nLastTTL{ -1 }; //The TTL / hop limit last applied to the socket
+	int m_nLastTOS{ -1 }; //The TOS / traffic class last applied to the socket
+	int m_nLastDF{ -1 }; //The don't fragment setting last applied to the socket
+	bool m_bBound{ false }; //Has the socket been bound to a local address
+	ULONGLONG m_nSendTime{ 0 }; //The monotonic time in microseconds when the request was sent
+};
+#endif //#ifdef _WIN32
+
+
 class CPING_EXT_CLASS CPing
 {
 public:
@@ -107,10 +258,108 @@ public:
 	CPing& operator=(CPing&&) = delete;
 	bool PingUsingICMPv4(_In_z_ LPCTSTR pszHostName, _Inout_ CPingReplyv4& pr, _In_ UCHAR nTTL = 10, _In_ DWORD dwTimeout = 5000, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_z_ LPCTSTR pszLocalBoundAddress = nullptr) const;
 	bool PingUsingICMPv6(_In_z_ LPCTSTR pszHostName, _Inout_ CPingReplyv6& pr, _In_ UCHAR nTTL = 10, _In_ DWORD dwTimeout = 5000, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_z_ LPCTSTR pszLocalBoundAddress = nullptr) const;
+	bool PingUsingICMPv4(_In_ const SOCKADDR_IN& destAddress, _Inout_ CPingReplyv4& pr, _In_ UCHAR nTTL = 10, _In_ DWORD dwTimeout = 5000, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_ const SOCKADDR_IN* pLocalAddress = nullptr) const;
+	bool PingUsingICMPv6(_In_ const SOCKADDR_IN6& destAddress, _Inout_ CPingReplyv6& pr, _In_ UCHAR nTTL = 10, _In_ DWORD dwTimeout = 5000, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_ const SOCKADDR_IN6* pLocalAddress = nullptr) const;
 
 protected:
 	//Methods
 	virtual void FillIcmpData(_Out_writes_bytes_(dwRequestSize) BYTE* pRequestData, _In_ DWORD dwRequestSize) const;
 };
 
+
+//A process wide cache of the forward lookups done by CPingSession::ResolveAddress, so that pings, traces and bulk
+//runs of the same host do not go back to the resolver. getaddrinfo does not report the TTL of the records behind
+//its answers, so entries live for a fixed time to live which caps how stale an answer can be (0 disables caching)
+class CPING_EXT_CLASS CHostNameCache
+{
+public:
+	//Constructors / Destructors
+	CHostNameCache() noexcept;
+	CHostNameCache(const CHostNameCache&) = delete;
+	CHostNameCache(CHostNameCache&&) = delete;
+	~CHostNameCache() = default;
+
+	//Methods
+	CHostNameCache& operator=(const CHostNameCache&) = delete;
+	CHostNameCache& operator=(CHostNameCache&&) = delete;
+	_NODISCARD static CHostNameCache& Instance();
+	_NODISCARD bool Find(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _Out_writes_bytes_(nAddressLen) SOCKADDR* pAddress, _In_ int nAddressLen);
+	void Add(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _In_reads_bytes_(nAddressLen) const SOCKADDR* pAddress, _In_ int nAddressLen);
+	void SetTimeToLive(_In_ ULONGLONG nTimeToLive) noexcept; //In microseconds
+	_NODISCARD ULONGLONG GetTimeToLive() const noexcept;
+	void Clear();
+
+protected:
+	//The cached answer for a host name, flags and family
+	struct CEntry
+	{
+		SOCKADDR_STORAGE Address{}; //The first address of the answer
+		int nAddressLen{ 0 }; //The size of the address
+		ULONGLONG nExpires{ 0 }; //CPingClock time the entry goes stale
+	};
+	using Key = std::pair<std::basic_string<TCHAR>, std::pair<int, int>>;
+
+	//Member variables
+	mutable std::mutex m_Mutex; //Protects the member variables below
+	std::map<Key, CEntry> m_Entries; //The cached answers
+	ULONGLONG m_nTimeToLive; //How long an answer is kept, in microseconds
+	size_t m_nMaxEntries; //The cache size at which stale entries are purged
+};
+
+
+//A persistent ping session which does the address lookup, backend (ICMP handle or socket) creation and buffer
+//allocation once in Openv4 / Openv6 so that each subsequent call to Pingv4 / Pingv6 does no DNS work and no heap
+//allocations
+class CPING_EXT_CLASS CPingSession
+{
+public:
+	//Constructors / Destructors
+	CPingSession();
+	explicit CPingSession(_In_ std::unique_ptr<CPingBackend> pBackend) noexcept;
+	CPingSession(const CPingSession&) = delete;
+	CPingSession(CPingSession&&) = delete;
+	virtual ~CPingSession();
+
+	//Methods
+	CPingSession& operator=(const CPingSession&) = delete;
+	CPingSession& operator=(CPingSession&&) = delete;
+	bool Openv4(_In_z_ LPCTSTR pszHostName, _In_ WORD wDataSize = 32, _In_opt_z_ LPCTSTR pszLocalBoundAddress = nullptr);
+	bool Openv6(_In_z_ LPCTSTR pszHostName, _In_ WORD wDataSize = 32, _In_opt_z_ LPCTSTR pszLocalBoundAddress = nullptr);
+	bool Openv4(_In_ const SOCKADDR_IN& destAddress, _In_ WORD wDataSize = 32, _In_opt_ const SOCKADDR_IN* pLocalAddress = nullptr);
+	bool Openv6(_In_ const SOCKADDR_IN6& destAddress, _In_ WORD wDataSize = 32, _In_opt_ const SOCKADDR_IN6* pLocalAddress = nullptr);
+	void Close() noexcept;
+	_NODISCARD bool IsOpen() const noexcept { return (m_pBackend != nullptr) && m_pBackend->IsOpen(); }
+	_NODISCARD int GetFamily() const noexcept { return m_nFamily; }
+	_NODISCARD const SOCKADDR_IN& GetDestAddressv4() const noexcept { return m_DestAddressv4; }
+	_NODISCARD const SOCKADDR_IN6& GetDestAddressv6() const noexcept { return m_DestAddressv6; }
+	_NODISCARD std::vector<BYTE>& GetRequestData() noexcept { return m_SendBuf; }
+	_NODISCARD CPingBackend* GetBackend() const noexcept { return m_pBackend.get(); }
+	bool Pingv4(_Inout_ CPingReplyv4& pr, _In_ UCHAR nTTL = 10, _In_ DWORD dwTimeout = 5000, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false);
+	bool Pingv6(_Inout_ CPingReplyv6& pr, _In_ UCHAR nTTL = 10, _In_ DWORD dwTimeout = 5000, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false);
+
+	//Resolves a host name to the first address of the specified family, the equivalent of ATL::CSocketAddr::FindAddr.
+	//Numeric addresses are converted directly and names are answered from CHostNameCache while they are fresh
+	static int ResolveAddress(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _Out_writes_bytes_(nAddressLen) SOCKADDR* pAddress, _In_ int nAddressLen);
+
+	//Resolves a host name to every distinct address of the specified family, in the order the resolver returned them
+	static int ResolveAllAddresses(_In_z_ LPCTSTR pszHostName, _In_ int nFlags, _In_ int nFamily, _Inout_ std::vector<SOCKADDR_STORAGE>& addresses);
+
+protected:
+	//Methods
+	virtual void FillIcmpData(_Out_writes_bytes_(dwRequestSize) BYTE* pRequestData, _In_ DWORD dwRequestSize) const;
+	_NODISCARD static IP_OPTION_INFORMATION MakeOptionInfo(_In_ UCHAR nTTL, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse) noexcept;
+	bool OpenBackend(_In_ int nFamily, _In_ WORD wDataSize);
+
+	//Member variables
+	std::unique_ptr<CPingBackend> m_pBackend; //The backend which is kept open for the lifetime of the session
+	int m_nFamily; //AF_INET or AF_INET6 depending on which Open method was called
+	SOCKADDR_IN m_DestAddressv4; //The resolved IPv4 destination address
+	SOCKADDR_IN6 m_DestAddressv6; //The resolved IPv6 destination address
+	SOCKADDR_IN m_SrcAddressv4; //The IPv4 address to bind to if m_bBindSourceAddress is true
+	SOCKADDR_IN6 m_SrcAddressv6; //The IPv6 address to bind to (in6addr_any if none was specified)
+	bool m_bBindSourceAddress; //Should we bind to m_SrcAddressv4 for IPv4 requests
+	std::vector<BYTE> m_SendBuf; //The preallocated request data
+	DWORD m_dwReplySize; //The size of the reply buffer required by Pingv4 / Pingv6
+};
+
 #endif //#ifndef __PING_H__
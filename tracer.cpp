@@ -70,33 +70,104 @@ to maintain a single distribution point for the source code.
 
 #include "pch.h"
 #include "tracer.h"
+#include "IpAddressText.h"
 #include "ping.h" //If you get a compilation error about this missing header file, then you need to download my CPing class from http://www.naughter.com/ping.html
 #ifndef _INC_LIMITS
 #pragma message("To avoid this message please put limits.h in your pre compiled header (usually stdafx.h)")
 #include <limits.h>
 #endif //#ifndef _INC_LIMITS
+#ifndef _FUTURE_
+#pragma message("To avoid this message please put future in your pre compiled header (usually stdafx.h)")
+#include <future>
+#endif //#ifndef _FUTURE_
 
 
 ///////////////////////////////// Implementation //////////////////////////////
 
+CTraceRoute::CTraceRoute() noexcept : m_bConcurrent{ false },
+m_nMaxConcurrentHops{ 0 },
+m_bCancelled{ false },
+m_nGapLimit{ 0 },
+m_bStopOnUnreachable{ false },
+m_StopReason{ StopReason::HopCount },
+m_bAdaptiveTimeout{ false },
+m_dwTimeoutFloor{ 200 },
+m_nProbesSent{ 0 }
+{
+}
+
+void CTraceRoute::ResetHopTimeouts(_In_ UCHAR nHopCount, _In_ DWORD dwTimeout)
+{
+	//Every hop starts without an estimate, so its first probe waits for the full timeout
+	m_arrHopTimeouts.assign(nHopCount, CAdaptiveTimeout{});
+	for (auto& hopTimeout : m_arrHopTimeouts)
+		hopTimeout.SetBounds(m_dwTimeoutFloor, dwTimeout);
+}
+
+bool CTraceRoute::IsUnreachableStatus(_In_ ULONG nStatus) noexcept
+{
+	//Covers net / host / protocol / port unreachable and their IPv6 aliases no route / address unreachable / administratively prohibited
+	return (nStatus >= IP_DEST_NET_UNREACHABLE) && (nStatus <= IP_DEST_PORT_UNREACHABLE);
+}
+
+bool CTraceRoute::CheckStopPolicies(_In_ bool bFromDestination, _In_ ULONG nStatus, _In_ DWORD dwError, _Inout_ UCHAR& nSilentHops) noexcept
+{
+	//Any reply from the destination itself, or an echo reply from wherever it came, means we have arrived
+	if (bFromDestination || (nStatus == IP_SUCCESS))
+	{
+		m_StopReason = StopReason::DestinationReached;
+		return true;
+	}
+
+	//A router which cannot forward towards the destination will say the same for every higher TTL
+	if (m_bStopOnUnreachable && (IsUnreachableStatus(nStatus) || IsUnreachableStatus(dwError)))
+	{
+		m_StopReason = StopReason::Unreachable;
+		return true;
+	}
+
+	//Count the consecutive hops which did not answer at all
+	if (nStatus != IP_REQ_TIMED_OUT)
+	{
+		nSilentHops = 0;
+		return false;
+	}
+	++nSilentHops;
+	if ((m_nGapLimit != 0) && (nSilentHops >= m_nGapLimit))
+	{
+		m_StopReason = StopReason::GapLimit;
+		return true;
+	}
+	return false;
+}
+
 CTraceRoute::String CTraceRoute::AddressToString(const SOCKADDR* pSockAddr, int nSockAddrLen, int nFlags, UINT* pnSocketPort)
 {
 	//What will be the return value from this function
 	String sSocketAddress;
 
-	int nResult{ 0 };
+	//Numeric addresses are formatted directly rather than via the resolver library
+	if ((nFlags & NI_NUMERICHOST) != 0)
+	{
+		TCHAR szAddress[CIpAddressText::MAX_LENGTH]{};
+		if (CIpAddressText::Format(pSockAddr, nSockAddrLen, szAddress, CIpAddressText::MAX_LENGTH) != 0)
+		{
+			sSocketAddress = szAddress;
+			if (pnSocketPort != nullptr)
+				*pnSocketPort = ntohs(SS_PORT(pSockAddr));
+			return sSocketAddress;
+		}
+	}
+
+	TCHAR szName[NI_MAXHOST]{};
 #ifdef _UNICODE
-	CStringW sName;
-	nResult = GetNameInfoW(pSockAddr, nSockAddrLen, sName.GetBuffer(NI_MAXHOST), NI_MAXHOST, nullptr, 0, nFlags);
-	sName.ReleaseBuffer();
+	const int nResult{ GetNameInfoW(pSockAddr, nSockAddrLen, szName, NI_MAXHOST, nullptr, 0, nFlags) };
 #else
-	CStringA sName;
-	nResult = getnameinfo(pSockAddr, nSockAddrLen, sName.GetBuffer(NI_MAXHOST), NI_MAXHOST, nullptr, 0, nFlags);
-	sName.ReleaseBuffer();
+	const int nResult{ getnameinfo(pSockAddr, nSockAddrLen, szName, NI_MAXHOST, nullptr, 0, nFlags) };
 #endif
 	if (nResult == 0)
 	{
-		sSocketAddress = sName;
+		sSocketAddress = szName;
 		if (pnSocketPort != nullptr)
 			*pnSocketPort = ntohs(SS_PORT(&pSockAddr));
 	}
@@ -121,80 +192,137 @@ bool CTraceRoute::Tracev4(_In_z_ LPCTSTR pszHostName, _Inout_ CReplyv4& trr, _In
 		return false;
 	}
 
-	//Do the address lookup
-	ATL::CSocketAddr lookup;
-	const int nError{ lookup.FindAddr(pszHostName, 0, 0, AF_INET, 0, 0) };
+	//Do the address lookups once, so the probes themselves never go near the resolver
+	SOCKADDR_IN destAddress{};
+#pragma warning(suppress: 26490)
+	int nError{ CPingSession::ResolveAddress(pszHostName, 0, AF_INET, reinterpret_cast<SOCKADDR*>(&destAddress), sizeof(destAddress)) };
 	if (nError != 0)
 	{
 		SetLastError(nError);
 		return false;
 	}
+	SOCKADDR_IN localAddress{};
+	const bool bBindSourceAddress{ (pszLocalBoundAddress != nullptr) && _tcslen(pszLocalBoundAddress) };
+	if (bBindSourceAddress)
+	{
+#pragma warning(suppress: 26490)
+		nError = CPingSession::ResolveAddress(pszLocalBoundAddress, AI_PASSIVE, AF_INET, reinterpret_cast<SOCKADDR*>(&localAddress), sizeof(localAddress));
+		if (nError != 0)
+		{
+			SetLastError(nError);
+			return false;
+		}
+	}
 
-	//Note we always use the first address returned from ATL::CSocketAddr::FindAddr. If you want to use a different
-	//Address then do the lookup yourself and pass in the correct value in the "pszHostName" parameter
-	const ADDRINFOT* pAddress{ lookup.GetAddrInfoList() };
-#pragma warning(suppress: 26477)
-	ATLASSUME(pAddress != nullptr);
+	return Tracev4(destAddress, trr, nHopCount, dwTimeout, dwPingsPerHost, wDataSize, nTOS, bDontFragment, bFlagReverse, bBindSourceAddress ? &localAddress : nullptr);
+}
+
+bool CTraceRoute::Tracev4(_In_ const SOCKADDR_IN& destAddress, _Inout_ CReplyv4& trr, _In_ UCHAR nHopCount, _In_ DWORD dwTimeout, _In_ DWORD dwPingsPerHost, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN* pLocalAddress)
+{
+	//Validate our parameters
 #pragma warning(suppress: 26477)
-	ATLASSERT(pAddress->ai_family == AF_INET);
-#pragma warning(suppress: 26489 26490)
-	auto pDestAddress{ reinterpret_cast<const sockaddr_in*>(pAddress->ai_addr) };
-#pragma warning(suppress: 26472)
-	String sDestAddress{ AddressToString(pAddress->ai_addr, static_cast<int>(pAddress->ai_addrlen), NI_NUMERICHOST, nullptr) };
+	ATLASSERT(nHopCount > 0);
 
-	//Iterate through all the hop count values
-	bool bReachedHost{ false };
-	for (UCHAR i{ 1 }; i <= nHopCount && !bReachedHost; i++)
+	//Set the output parameter to a sane default
+	trr.clear();
+
+	if (dwPingsPerHost == 0)
 	{
-		CHostTraceMultiReplyv4 htrr;
-		htrr.dwError = ERROR_SUCCESS;
-		htrr.minRTT = ULONG_MAX;
-		htrr.avgRTT = 0;
-		htrr.maxRTT = 0;
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return false;
+	}
+	const SOCKADDR_IN* pDestAddress{ &destAddress };
 
-		//Iterate through all the pings for each host
-		DWORD totalRTT{ 0 };
-		CHostTraceSingleReplyv4 htsr{};
-		bool bPingError{ false };
-		for (DWORD j{ 0 }; j < dwPingsPerHost && !bPingError; j++)
+	//Iterate through all the hop count values
+	m_bCancelled = false;
+	m_StopReason = StopReason::HopCount;
+	UCHAR nSilentHops{ 0 };
+	ResetHopTimeouts(nHopCount, dwTimeout);
+	m_nProbesSent = 0;
+	if (m_bConcurrent)
+	{
+		//Launch the probes for the first window of hops. Note "futures" is declared after "hops" so that on an early
+		//return it is destroyed first and waits for any outstanding hops which still reference them
+		struct CHopResult
+		{
+			CHostTraceMultiReplyv4 htrr{};
+			std::vector<CHostTraceSingleReplyv4> replies;
+		};
+		std::vector<CHopResult> hops(nHopCount);
+		std::vector<std::future<void>> futures(nHopCount);
+		const UCHAR nWindow{ (m_nMaxConcurrentHops == 0) ? nHopCount : m_nMaxConcurrentHops };
+		UCHAR nLaunched{ 0 };
+		auto LaunchUpTo{ [&](UCHAR nLastHop)
 		{
-			if (Pingv4(sDestAddress.c_str(), htsr, i, dwTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pszLocalBoundAddress))
+			for (; (nLaunched < nLastHop) && (nLaunched < nHopCount); nLaunched++)
 			{
-				//Accumulate the total RTT
-				totalRTT += htsr.RTT;
-
-				//Store away the RTT's
-				if (htsr.RTT < htrr.minRTT)
-					htrr.minRTT = htsr.RTT;
-				if (htsr.RTT > htrr.maxRTT)
-					htrr.maxRTT = htsr.RTT;
+				CHopResult& hop{ hops[nLaunched] };
+				const UCHAR nTTL{ static_cast<UCHAR>(nLaunched + 1) };
+				futures[nLaunched] = std::async(std::launch::async, [&, nTTL]()
+				{
+					ProbeHopv4(destAddress, nTTL, hop.htrr, hop.replies, false, dwTimeout, dwPingsPerHost, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress);
+				});
+			}
+		} };
 
-				//Call the virtual function
-				if (!OnPingResult(j + 1, htsr))
+		//Consume the hops in order, firing the callbacks just like the sequential code path would
+		for (UCHAR i{ 1 }; i <= nHopCount; i++)
+		{
+			LaunchUpTo(static_cast<UCHAR>(std::min<int>(nHopCount, i - 1 + nWindow)));
+			futures[i - 1].wait();
+			const CHopResult& hop{ hops[i - 1] };
+			for (size_t j{ 0 }; j < hop.replies.size(); j++)
+			{
+#pragma warning(suppress: 26472)
+				if (!OnPingResult(static_cast<int>(j + 1), hop.replies[j]))
 				{
+					m_bCancelled = true;
+					m_StopReason = StopReason::Cancelled;
 					SetLastError(ERROR_CANCELLED);
 					return false;
 				}
 			}
-			else
+			if (!OnSingleHostResult(i, hop.htrr))
+			{
+				m_bCancelled = true;
+				m_StopReason = StopReason::Cancelled;
+				SetLastError(ERROR_CANCELLED);
+				return false;
+			}
+			trr.push_back(hop.htrr);
+
+			//Have we reached the final host, or does another termination policy end the trace here? If so any probes
+			//still in flight for later hops are abandoned
+#pragma warning(suppress: 26489)
+			const bool bFromDestination{ (hop.htrr.nStatus != IP_REQ_TIMED_OUT) && (memcmp(&pDestAddress->sin_addr, &hop.htrr.Address.sin_addr, sizeof(hop.htrr.Address.sin_addr)) == 0) };
+			if (CheckStopPolicies(bFromDestination, hop.htrr.nStatus, hop.htrr.dwError, nSilentHops))
 			{
-				htrr.dwError = GetLastError();
-				bPingError = true;
+				m_bCancelled = true;
+				break;
 			}
 		}
-		memcpy_s(&htrr.Address, sizeof(htrr.Address), &htsr.Address, sizeof(htsr.Address));
-		if (htrr.dwError == 0)
-			htrr.avgRTT = totalRTT / dwPingsPerHost;
-		else
+
+		return true;
+	}
+
+	bool bStop{ false };
+	std::vector<CHostTraceSingleReplyv4> replies;
+	for (UCHAR i{ 1 }; i <= nHopCount && !bStop; i++)
+	{
+		//Probe the hop, calling OnPingResult as each reply arrives. Until the hop has answered, its probes are given
+		//the full timeout: the round trip time of the hop before it says nothing about a slow link to this one
+		CHostTraceMultiReplyv4 htrr{};
+		if (!ProbeHopv4(destAddress, i, htrr, replies, true, dwTimeout, dwPingsPerHost, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress))
 		{
-			htrr.minRTT = 0;
-			htrr.avgRTT = 0;
-			htrr.maxRTT = 0;
+			m_StopReason = StopReason::Cancelled;
+			SetLastError(ERROR_CANCELLED);
+			return false;
 		}
 
 		//Call the virtual function
 		if (!OnSingleHostResult(i, htrr))
 		{
+			m_StopReason = StopReason::Cancelled;
 			SetLastError(ERROR_CANCELLED);
 			return false;
 		}
@@ -203,10 +331,10 @@ bool CTraceRoute::Tracev4(_In_z_ LPCTSTR pszHostName, _Inout_ CReplyv4& trr, _In
 #pragma warning(suppress: 26489)
 		trr.push_back(htrr);
 
-		//Have we reached the final host?
+		//Have we reached the final host, or does another termination policy end the trace here?
 #pragma warning(suppress: 26489)
-		if (memcmp(&pDestAddress->sin_addr, &htrr.Address.sin_addr, sizeof(htrr.Address.sin_addr)) == 0)
-			bReachedHost = true;
+		const bool bFromDestination{ (htrr.nStatus != IP_REQ_TIMED_OUT) && (memcmp(&pDestAddress->sin_addr, &htrr.Address.sin_addr, sizeof(htrr.Address.sin_addr)) == 0) };
+		bStop = CheckStopPolicies(bFromDestination, htrr.nStatus, htrr.dwError, nSilentHops);
 	}
 
 	return true;
@@ -229,80 +357,137 @@ bool CTraceRoute::Tracev6(_In_z_ LPCTSTR pszHostName, _Inout_ CReplyv6& trr, _In
 		return false;
 	}
 
-	//Do the address lookup
-	ATL::CSocketAddr lookup;
-	const int nError{ lookup.FindAddr(pszHostName, 0, 0, AF_INET6, 0, 0) };
+	//Do the address lookups once, so the probes themselves never go near the resolver
+	SOCKADDR_IN6 destAddress{};
+#pragma warning(suppress: 26490)
+	int nError{ CPingSession::ResolveAddress(pszHostName, 0, AF_INET6, reinterpret_cast<SOCKADDR*>(&destAddress), sizeof(destAddress)) };
 	if (nError != 0)
 	{
 		SetLastError(nError);
 		return false;
 	}
+	SOCKADDR_IN6 localAddress{};
+	const bool bBindSourceAddress{ (pszLocalBoundAddress != nullptr) && _tcslen(pszLocalBoundAddress) };
+	if (bBindSourceAddress)
+	{
+#pragma warning(suppress: 26490)
+		nError = CPingSession::ResolveAddress(pszLocalBoundAddress, AI_PASSIVE, AF_INET6, reinterpret_cast<SOCKADDR*>(&localAddress), sizeof(localAddress));
+		if (nError != 0)
+		{
+			SetLastError(nError);
+			return false;
+		}
+	}
 
-	//Note we always use the first address returned from ATL::CSocketAddr::FindAddr. If you want to use a different
-	//Address then do the lookup yourself and pass in the correct value in the "pszHostName" parameter
-	const ADDRINFOT* pAddress{ lookup.GetAddrInfoList() };
-#pragma warning(suppress: 26477)
-	ATLASSUME(pAddress != nullptr);
+	return Tracev6(destAddress, trr, nHopCount, dwTimeout, dwPingsPerHost, wDataSize, nTOS, bDontFragment, bFlagReverse, bBindSourceAddress ? &localAddress : nullptr);
+}
+
+bool CTraceRoute::Tracev6(_In_ const SOCKADDR_IN6& destAddress, _Inout_ CReplyv6& trr, _In_ UCHAR nHopCount, _In_ DWORD dwTimeout, _In_ DWORD dwPingsPerHost, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN6* pLocalAddress)
+{
+	//Validate our parameters
 #pragma warning(suppress: 26477)
-	ATLASSERT(pAddress->ai_family == AF_INET6);
-#pragma warning(suppress: 26489 26490)
-	auto pDestAddress{ reinterpret_cast<const sockaddr_in6*>(pAddress->ai_addr) };
-#pragma warning(suppress: 26472)
-	String sDestAddress{ AddressToString(pAddress->ai_addr, static_cast<int>(pAddress->ai_addrlen), NI_NUMERICHOST, nullptr) };
+	ATLASSERT(nHopCount > 0);
 
-	//Iterate through all the hop count values
-	bool bReachedHost{ false };
-	for (UCHAR i{ 1 }; i <= nHopCount && !bReachedHost; i++)
+	//Set the output parameter to a sane default
+	trr.clear();
+
+	if (dwPingsPerHost == 0)
 	{
-		CHostTraceMultiReplyv6 htrr;
-		htrr.dwError = ERROR_SUCCESS;
-		htrr.minRTT = ULONG_MAX;
-		htrr.avgRTT = 0;
-		htrr.maxRTT = 0;
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return false;
+	}
+	const SOCKADDR_IN6* pDestAddress{ &destAddress };
 
-		//Iterate through all the pings for each host
-		DWORD totalRTT{ 0 };
-		CHostTraceSingleReplyv6 htsr{};
-		bool bPingError{ false };
-		for (DWORD j{ 0 }; j < dwPingsPerHost && !bPingError; j++)
+	//Iterate through all the hop count values
+	m_bCancelled = false;
+	m_StopReason = StopReason::HopCount;
+	UCHAR nSilentHops{ 0 };
+	ResetHopTimeouts(nHopCount, dwTimeout);
+	m_nProbesSent = 0;
+	if (m_bConcurrent)
+	{
+		//Launch the probes for the first window of hops. Note "futures" is declared after "hops" so that on an early
+		//return it is destroyed first and waits for any outstanding hops which still reference them
+		struct CHopResult
+		{
+			CHostTraceMultiReplyv6 htrr{};
+			std::vector<CHostTraceSingleReplyv6> replies;
+		};
+		std::vector<CHopResult> hops(nHopCount);
+		std::vector<std::future<void>> futures(nHopCount);
+		const UCHAR nWindow{ (m_nMaxConcurrentHops == 0) ? nHopCount : m_nMaxConcurrentHops };
+		UCHAR nLaunched{ 0 };
+		auto LaunchUpTo{ [&](UCHAR nLastHop)
 		{
-			if (Pingv6(sDestAddress.c_str(), htsr, i, dwTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pszLocalBoundAddress))
+			for (; (nLaunched < nLastHop) && (nLaunched < nHopCount); nLaunched++)
 			{
-				//Accumulate the total RTT
-				totalRTT += htsr.RTT;
-
-				//Store away the RTT's
-				if (htsr.RTT < htrr.minRTT)
-					htrr.minRTT = htsr.RTT;
-				if (htsr.RTT > htrr.maxRTT)
-					htrr.maxRTT = htsr.RTT;
+				CHopResult& hop{ hops[nLaunched] };
+				const UCHAR nTTL{ static_cast<UCHAR>(nLaunched + 1) };
+				futures[nLaunched] = std::async(std::launch::async, [&, nTTL]()
+				{
+					ProbeHopv6(destAddress, nTTL, hop.htrr, hop.replies, false, dwTimeout, dwPingsPerHost, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress);
+				});
+			}
+		} };
 
-				//Call the virtual function
-				if (!OnPingResult(j + 1, htsr))
+		//Consume the hops in order, firing the callbacks just like the sequential code path would
+		for (UCHAR i{ 1 }; i <= nHopCount; i++)
+		{
+			LaunchUpTo(static_cast<UCHAR>(std::min<int>(nHopCount, i - 1 + nWindow)));
+			futures[i - 1].wait();
+			const CHopResult& hop{ hops[i - 1] };
+			for (size_t j{ 0 }; j < hop.replies.size(); j++)
+			{
+#pragma warning(suppress: 26472)
+				if (!OnPingResult(static_cast<int>(j + 1), hop.replies[j]))
 				{
+					m_bCancelled = true;
+					m_StopReason = StopReason::Cancelled;
 					SetLastError(ERROR_CANCELLED);
 					return false;
 				}
 			}
-			else
+			if (!OnSingleHostResult(i, hop.htrr))
+			{
+				m_bCancelled = true;
+				m_StopReason = StopReason::Cancelled;
+				SetLastError(ERROR_CANCELLED);
+				return false;
+			}
+			trr.push_back(hop.htrr);
+
+			//Have we reached the final host, or does another termination policy end the trace here? If so any probes
+			//still in flight for later hops are abandoned
+#pragma warning(suppress: 26489)
+			const bool bFromDestination{ (hop.htrr.nStatus != IP_REQ_TIMED_OUT) && (memcmp(&pDestAddress->sin6_addr, &hop.htrr.Address.sin6_addr, sizeof(hop.htrr.Address.sin6_addr)) == 0) };
+			if (CheckStopPolicies(bFromDestination, hop.htrr.nStatus, hop.htrr.dwError, nSilentHops))
 			{
-				htrr.dwError = GetLastError();
-				bPingError = true;
+				m_bCancelled = true;
+				break;
 			}
 		}
-		memcpy_s(&htrr.Address, sizeof(htrr.Address), &htsr.Address, sizeof(htsr.Address));
-		if (htrr.dwError == 0)
-			htrr.avgRTT = totalRTT / dwPingsPerHost;
-		else
+
+		return true;
+	}
+
+	bool bStop{ false };
+	std::vector<CHostTraceSingleReplyv6> replies;
+	for (UCHAR i{ 1 }; i <= nHopCount && !bStop; i++)
+	{
+		//Probe the hop, calling OnPingResult as each reply arrives. Until the hop has answered, its probes are given
+		//the full timeout: the round trip time of the hop before it says nothing about a slow link to this one
+		CHostTraceMultiReplyv6 htrr{};
+		if (!ProbeHopv6(destAddress, i, htrr, replies, true, dwTimeout, dwPingsPerHost, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress))
 		{
-			htrr.minRTT = 0;
-			htrr.avgRTT = 0;
-			htrr.maxRTT = 0;
+			m_StopReason = StopReason::Cancelled;
+			SetLastError(ERROR_CANCELLED);
+			return false;
 		}
 
 		//Call the virtual function
 		if (!OnSingleHostResult(i, htrr))
 		{
+			m_StopReason = StopReason::Cancelled;
 			SetLastError(ERROR_CANCELLED);
 			return false;
 		}
@@ -311,44 +496,258 @@ bool CTraceRoute::Tracev6(_In_z_ LPCTSTR pszHostName, _Inout_ CReplyv6& trr, _In
 #pragma warning(suppress: 26489)
 		trr.push_back(htrr);
 
-		//Have we reached the final host ?
+		//Have we reached the final host, or does another termination policy end the trace here?
 #pragma warning(suppress: 26489)
-		if (memcmp(&pDestAddress->sin6_addr, &htrr.Address.sin6_addr, sizeof(htrr.Address.sin6_addr)) == 0)
-			bReachedHost = true;
+		const bool bFromDestination{ (htrr.nStatus != IP_REQ_TIMED_OUT) && (memcmp(&pDestAddress->sin6_addr, &htrr.Address.sin6_addr, sizeof(htrr.Address.sin6_addr)) == 0) };
+		bStop = CheckStopPolicies(bFromDestination, htrr.nStatus, htrr.dwError, nSilentHops);
+	}
+
+	return true;
+}
+
+bool CTraceRoute::ProbeHopv4(_In_ const SOCKADDR_IN& destAddress, _In_ UCHAR nTTL, _Inout_ CHostTraceMultiReplyv4& htrr, _Inout_ std::vector<CHostTraceSingleReplyv4>& replies, _In_ bool bNotify, _In_ DWORD dwTimeout, _In_ DWORD dwPingsPerHost, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN* pLocalAddress)
+{
+	htrr.dwError = ERROR_SUCCESS;
+	htrr.minRTT = ULLONG_MAX;
+	htrr.avgRTT = 0;
+	htrr.maxRTT = 0;
+	htrr.nStatus = IP_REQ_TIMED_OUT;
+	replies.clear();
+
+	//Iterate through all the pings for each host
+	ULONGLONG totalRTT{ 0 };
+	CHostTraceSingleReplyv4 htsr{};
+	htsr.nStatus = IP_REQ_TIMED_OUT;
+	CHostTraceSingleReplyv4 htsrDestination{};
+	bool bDestinationReplied{ false };
+	bool bPingError{ false };
+	CAdaptiveTimeout& hopTimeout{ m_arrHopTimeouts.at(nTTL - 1) };
+	for (DWORD j{ 0 }; j < dwPingsPerHost && !bPingError && !m_bCancelled; j++)
+	{
+		const DWORD dwProbeTimeout{ m_bAdaptiveTimeout ? hopTimeout.GetTimeout() : dwTimeout };
+		++m_nProbesSent;
+		if (Pingv4(destAddress, htsr, nTTL, dwProbeTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress))
+		{
+			//Accumulate the total RTT
+			totalRTT += htsr.RTT;
+			hopTimeout.AddSample(htsr.RTT);
+
+			//Remember if the destination itself answered any of the probes, whatever the kind of its reply
+			if (!bDestinationReplied && (memcmp(&htsr.Address.sin_addr, &destAddress.sin_addr, sizeof(destAddress.sin_addr)) == 0))
+			{
+				htsrDestination = htsr;
+				bDestinationReplied = true;
+			}
+
+			//Store away the RTT's
+			if (htsr.RTT < htrr.minRTT)
+				htrr.minRTT = htsr.RTT;
+			if (htsr.RTT > htrr.maxRTT)
+				htrr.maxRTT = htsr.RTT;
+
+			//Call the virtual function now or leave it to the caller
+			if (bNotify)
+			{
+				if (!OnPingResult(j + 1, htsr))
+					return false;
+			}
+			else
+				replies.push_back(htsr);
+		}
+		else
+		{
+			htrr.dwError = GetLastError();
+			if (htrr.dwError == ERROR_TIMEOUT)
+				hopTimeout.AddLoss(dwProbeTimeout);
+			bPingError = true;
+		}
+	}
+	const auto& htsrHop{ bDestinationReplied ? htsrDestination : htsr };
+	memcpy_s(&htrr.Address, sizeof(htrr.Address), &htsrHop.Address, sizeof(htsrHop.Address));
+	htrr.nStatus = htsrHop.nStatus;
+	if (htrr.dwError == 0)
+		htrr.avgRTT = totalRTT / dwPingsPerHost;
+	else
+	{
+		htrr.minRTT = 0;
+		htrr.avgRTT = 0;
+		htrr.maxRTT = 0;
 	}
 
 	return true;
 }
 
-bool CTraceRoute::Pingv4(_In_z_ LPCTSTR pszHostName, _Inout_ CHostTraceSingleReplyv4& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_z_ LPCTSTR pszLocalBoundAddress)
+bool CTraceRoute::ProbeHopv6(_In_ const SOCKADDR_IN6& destAddress, _In_ UCHAR nTTL, _Inout_ CHostTraceMultiReplyv6& htrr, _Inout_ std::vector<CHostTraceSingleReplyv6>& replies, _In_ bool bNotify, _In_ DWORD dwTimeout, _In_ DWORD dwPingsPerHost, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN6* pLocalAddress)
+{
+	htrr.dwError = ERROR_SUCCESS;
+	htrr.minRTT = ULLONG_MAX;
+	htrr.avgRTT = 0;
+	htrr.maxRTT = 0;
+	htrr.nStatus = IP_REQ_TIMED_OUT;
+	replies.clear();
+
+	//Iterate through all the pings for each host
+	ULONGLONG totalRTT{ 0 };
+	CHostTraceSingleReplyv6 htsr{};
+	htsr.nStatus = IP_REQ_TIMED_OUT;
+	CHostTraceSingleReplyv6 htsrDestination{};
+	bool bDestinationReplied{ false };
+	bool bPingError{ false };
+	CAdaptiveTimeout& hopTimeout{ m_arrHopTimeouts.at(nTTL - 1) };
+	for (DWORD j{ 0 }; j < dwPingsPerHost && !bPingError && !m_bCancelled; j++)
+	{
+		const DWORD dwProbeTimeout{ m_bAdaptiveTimeout ? hopTimeout.GetTimeout() : dwTimeout };
+		++m_nProbesSent;
+		if (Pingv6(destAddress, htsr, nTTL, dwProbeTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pLocalAddress))
+		{
+			//Accumulate the total RTT
+			totalRTT += htsr.RTT;
+			hopTimeout.AddSample(htsr.RTT);
+
+			//Remember if the destination itself answered any of the probes, whatever the kind of its reply
+			if (!bDestinationReplied && (memcmp(&htsr.Address.sin6_addr, &destAddress.sin6_addr, sizeof(destAddress.sin6_addr)) == 0))
+			{
+				htsrDestination = htsr;
+				bDestinationReplied = true;
+			}
+
+			//Store away the RTT's
+			if (htsr.RTT < htrr.minRTT)
+				htrr.minRTT = htsr.RTT;
+			if (htsr.RTT > htrr.maxRTT)
+				htrr.maxRTT = htsr.RTT;
+
+			//Call the virtual function now or leave it to the caller
+			if (bNotify)
+			{
+				if (!OnPingResult(j + 1, htsr))
+					return false;
+			}
+			else
+				replies.push_back(htsr);
+		}
+		else
+		{
+			htrr.dwError = GetLastError();
+			if (htrr.dwError == ERROR_TIMEOUT)
+				hopTimeout.AddLoss(dwProbeTimeout);
+			bPingError = true;
+		}
+	}
+	const auto& htsrHop{ bDestinationReplied ? htsrDestination : htsr };
+	memcpy_s(&htrr.Address, sizeof(htrr.Address), &htsrHop.Address, sizeof(htsrHop.Address));
+	htrr.nStatus = htsrHop.nStatus;
+	if (htrr.dwError == 0)
+		htrr.avgRTT = totalRTT / dwPingsPerHost;
+	else
+	{
+		htrr.minRTT = 0;
+		htrr.avgRTT = 0;
+		htrr.maxRTT = 0;
+	}
+
+	return true;
+}
+
+std::unique_ptr<CPingBackend> CTraceRoute::CreateBackend()
+{
+	return CPingBackend::CreateDefault();
+}
+
+std::unique_ptr<CTraceRoute::CProbeSession> CTraceRoute::AcquireSession(_In_ const SOCKADDR_STORAGE& destAddress, _In_ const SOCKADDR_STORAGE& localAddress, _In_ WORD wDataSize)
+{
+	std::unique_ptr<CProbeSession> pProbeSession;
+	{
+		std::lock_guard<std::mutex> lock{ m_SessionsMutex };
+
+		//Prefer an idle session which is already open for this probe, otherwise take any idle one
+		auto iter{ std::find_if(m_IdleSessions.begin(), m_IdleSessions.end(), [&](const std::unique_ptr<CProbeSession>& pIdle) noexcept
+		{
+			return pIdle->pSession->IsOpen() && (pIdle->wDataSize == wDataSize) && (memcmp(&pIdle->DestAddress, &destAddress, sizeof(destAddress)) == 0) &&
+				   (memcmp(&pIdle->LocalAddress, &localAddress, sizeof(localAddress)) == 0);
+		}) };
+		if (iter != m_IdleSessions.end())
+		{
+			pProbeSession = std::move(*iter);
+			m_IdleSessions.erase(iter);
+			return pProbeSession;
+		}
+		if (!m_IdleSessions.empty())
+		{
+			pProbeSession = std::move(m_IdleSessions.back());
+			m_IdleSessions.pop_back();
+		}
+	}
+
+	//The session has to be (re)opened by the caller
+	if (pProbeSession == nullptr)
+	{
+		pProbeSession = std::make_unique<CProbeSession>();
+		pProbeSession->pSession = std::make_unique<CPingSession>(CreateBackend());
+	}
+	pProbeSession->pSession->Close();
+	pProbeSession->DestAddress = destAddress;
+	pProbeSession->LocalAddress = localAddress;
+	pProbeSession->wDataSize = wDataSize;
+	return pProbeSession;
+}
+
+void CTraceRoute::ReleaseSession(_In_ std::unique_ptr<CProbeSession> pProbeSession)
+{
+	//Preserve the error of the probe across the lock
+	const DWORD dwError{ GetLastError() };
+	{
+		std::lock_guard<std::mutex> lock{ m_SessionsMutex };
+		m_IdleSessions.push_back(std::move(pProbeSession));
+	}
+	SetLastError(dwError);
+}
+
+bool CTraceRoute::Pingv4(_In_ const SOCKADDR_IN& destAddress, _Inout_ CHostTraceSingleReplyv4& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN* pLocalAddress)
 {
-	CPingReplyv4 pr;
-	CPing ping;
-#pragma warning(suppress: 26486)
-	const bool bSuccess{ ping.PingUsingICMPv4(pszHostName, pr, nTTL, dwTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pszLocalBoundAddress) };
+	//Send the probe over an idle session rather than a new ICMP handle / socket
+	SOCKADDR_STORAGE destKey{};
+	memcpy_s(&destKey, sizeof(destKey), &destAddress, sizeof(destAddress));
+	SOCKADDR_STORAGE localKey{};
+	if (pLocalAddress != nullptr)
+		memcpy_s(&localKey, sizeof(localKey), pLocalAddress, sizeof(*pLocalAddress));
+	std::unique_ptr<CProbeSession> pProbeSession{ AcquireSession(destKey, localKey, wDataSize) };
+	CPingSession& session{ *pProbeSession->pSession };
+	CPingReplyv4& pr{ pProbeSession->Replyv4 };
+	const bool bSuccess{ (session.IsOpen() || session.Openv4(destAddress, wDataSize, pLocalAddress)) && session.Pingv4(pr, nTTL, dwTimeout, nTOS, bDontFragment, bFlagReverse) };
 	if (bSuccess)
 	{
 		//Ping was successful, copy over the pertinent info into the return structure
 		memcpy_s(&htsr.Address, sizeof(htsr.Address), &pr.Address, sizeof(pr.Address));
 		htsr.RTT = pr.RTT;
+		htsr.nStatus = static_cast<ULONG>(pr.EchoReplyStatus);
 	}
+	ReleaseSession(std::move(pProbeSession));
 
 	//return the status
 	return bSuccess;
 }
 
-bool CTraceRoute::Pingv6(_In_z_ LPCTSTR pszHostName, _Inout_ CHostTraceSingleReplyv6& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_z_ LPCTSTR pszLocalBoundAddress)
+bool CTraceRoute::Pingv6(_In_ const SOCKADDR_IN6& destAddress, _Inout_ CHostTraceSingleReplyv6& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN6* pLocalAddress)
 {
-	CPingReplyv6 pr;
-	CPing ping;
-#pragma warning(suppress: 26486)
-	const bool bSuccess{ ping.PingUsingICMPv6(pszHostName, pr, nTTL, dwTimeout, wDataSize, nTOS, bDontFragment, bFlagReverse, pszLocalBoundAddress) };
+	//Send the probe over an idle session rather than a new ICMP handle / socket
+	SOCKADDR_STORAGE destKey{};
+	memcpy_s(&destKey, sizeof(destKey), &destAddress, sizeof(destAddress));
+	SOCKADDR_STORAGE localKey{};
+	if (pLocalAddress != nullptr)
+		memcpy_s(&localKey, sizeof(localKey), pLocalAddress, sizeof(*pLocalAddress));
+	std::unique_ptr<CProbeSession> pProbeSession{ AcquireSession(destKey, localKey, wDataSize) };
+	CPingSession& session{ *pProbeSession->pSession };
+	CPingReplyv6& pr{ pProbeSession->Replyv6 };
+	const bool bSuccess{ (session.IsOpen() || session.Openv6(destAddress, wDataSize, pLocalAddress)) && session.Pingv6(pr, nTTL, dwTimeout, nTOS, bDontFragment, bFlagReverse) };
 	if (bSuccess)
 	{
 		//Ping was successful, copy over the pertinent info into the return structure
 		memcpy_s(&htsr.Address, sizeof(htsr.Address), &pr.Address, sizeof(pr.Address));
 		htsr.RTT = pr.RTT;
+		htsr.nStatus = static_cast<ULONG>(pr.EchoReplyStatus);
 	}
+	ReleaseSession(std::move(pProbeSession));
 
 	//return the status
 	return bSuccess;
@@ -40,6 +40,12 @@ to maintain a single distribution point for the source code.
 #pragma message("To avoid this message, you should put string in your pre compiled header (normally stdafx.h)")
 #include <string>
 #endif //#ifndef _STRING_
+#ifndef _ATOMIC_
+#pragma message("To avoid this message, you should put atomic in your pre compiled header (normally stdafx.h)")
+#include <atomic>
+#endif //#ifndef _ATOMIC_
+#include "AdaptiveTimeout.h"
+#include "ping.h"
 
 
 /////////////////////////// Classes ///////////////////////////////////////////
@@ -48,32 +54,36 @@ struct CTRACEROUTE_EXT_CLASS CHostTraceSingleReplyv4
 {
 	DWORD dwError; //GetLastError for this replier
 	SOCKADDR_IN Address; //The IP address of the replier
-	unsigned long RTT; //Round Trip time in milliseconds for this replier
+	ULONGLONG RTT; //Round Trip time in microseconds for this replier
+	ULONG nStatus; //The IP_STATUS of the reply e.g. IP_TTL_EXPIRED_TRANSIT, IP_SUCCESS or IP_DEST_HOST_UNREACHABLE
 };
 
 struct CTRACEROUTE_EXT_CLASS CHostTraceMultiReplyv4
 {
 	DWORD dwError; //GetLastError for this host
 	SOCKADDR_IN Address; //The IP address of the replier
-	DWORD minRTT; //Minimum round trip time in milliseconds
-	DWORD avgRTT; //Average round trip time in milliseconds
-	DWORD maxRTT; //Maximum round trip time in milliseconds
+	ULONGLONG minRTT; //Minimum round trip time in microseconds
+	ULONGLONG avgRTT; //Average round trip time in microseconds
+	ULONGLONG maxRTT; //Maximum round trip time in microseconds
+	ULONG nStatus; //The IP_STATUS of the reply from the destination if it answered, otherwise of the last reply. IP_REQ_TIMED_OUT if no probe was answered
 };
 
 struct CTRACEROUTE_EXT_CLASS CHostTraceSingleReplyv6
 {
 	DWORD dwError; //GetLastError for this replier
 	SOCKADDR_IN6 Address; //The IP address of the replier
-	unsigned long RTT; //Round Trip time in milliseconds for this replier
+	ULONGLONG RTT; //Round Trip time in microseconds for this replier
+	ULONG nStatus; //The IP_STATUS of the reply e.g. IP_HOP_LIMIT_EXCEEDED, IP_SUCCESS or IP_DEST_ADDR_UNREACHABLE
 };
 
 struct CTRACEROUTE_EXT_CLASS CHostTraceMultiReplyv6
 {
 	DWORD dwError; //GetLastError for this host
 	SOCKADDR_IN6 Address; //The IP address of the replier
-	DWORD minRTT; //Minimum round trip time in milliseconds
-	DWORD avgRTT; //Average round trip time in milliseconds
-	DWORD maxRTT; //Maximum round trip time in milliseconds
+	ULONGLONG minRTT; //Minimum round trip time in microseconds
+	ULONGLONG avgRTT; //Average round trip time in microseconds
+	ULONGLONG maxRTT; //Maximum round trip time in microseconds
+	ULONG nStatus; //The IP_STATUS of the reply from the destination if it answered, otherwise of the last reply. IP_REQ_TIMED_OUT if no probe was answered
 };
 
 //The actual class which does the Trace Route
@@ -89,8 +99,18 @@ public:
 	using String = std::string;
 #endif //#ifdef _UNICODE
 
+	//Enums
+	enum class StopReason
+	{
+		HopCount, //All nHopCount hops were probed without the destination answering
+		DestinationReached, //The destination answered a probe, whatever the kind of its reply
+		Unreachable, //A hop reported the destination as unreachable or administratively prohibited
+		GapLimit, //The gap limit of consecutive hops which answered no probe was reached
+		Cancelled //A callback cancelled the trace
+	};
+
 	//Constructors / Destructors
-	CTraceRoute() = default;
+	CTraceRoute() noexcept;
 	CTraceRoute(const CTraceRoute&) = delete;
 	CTraceRoute(CTraceRoute&&) = delete;
 	virtual ~CTraceRoute() = default;
@@ -100,16 +120,83 @@ public:
 	CTraceRoute& operator=(CTraceRoute&&) = delete;
 	bool Tracev4(_In_z_ LPCTSTR pszHostName, _Inout_ CReplyv4& trr, _In_ UCHAR nHopCount = 30, _In_ DWORD dwTimeout = 5000, _In_ DWORD dwPingsPerHost = 3, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_z_ LPCTSTR pszLocalBoundAddress = nullptr);
 	bool Tracev6(_In_z_ LPCTSTR pszHostName, _Inout_ CReplyv6& trr, _In_ UCHAR nHopCount = 30, _In_ DWORD dwTimeout = 5000, _In_ DWORD dwPingsPerHost = 3, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_z_ LPCTSTR pszLocalBoundAddress = nullptr);
+	bool Tracev4(_In_ const SOCKADDR_IN& destAddress, _Inout_ CReplyv4& trr, _In_ UCHAR nHopCount = 30, _In_ DWORD dwTimeout = 5000, _In_ DWORD dwPingsPerHost = 3, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_ const SOCKADDR_IN* pLocalAddress = nullptr);
+	bool Tracev6(_In_ const SOCKADDR_IN6& destAddress, _Inout_ CReplyv6& trr, _In_ UCHAR nHopCount = 30, _In_ DWORD dwTimeout = 5000, _In_ DWORD dwPingsPerHost = 3, _In_ WORD wDataSize = 32, _In_ UCHAR nTOS = 0, _In_ bool bDontFragment = false, _In_ bool bFlagReverse = false, _In_opt_ const SOCKADDR_IN6* pLocalAddress = nullptr);
 	virtual bool OnPingResult(_In_ int nPingNum, _In_ const CHostTraceSingleReplyv4& htsr);
 	virtual bool OnSingleHostResult(_In_ int nHostNum, _In_ const CHostTraceMultiReplyv4& htmr);
 	virtual bool OnPingResult(_In_ int nPingNum, _In_ const CHostTraceSingleReplyv6& htsr);
 	virtual bool OnSingleHostResult(_In_ int nHostNum, _In_ const CHostTraceMultiReplyv6& htmr);
 
+	//In concurrent mode the probes for up to "nMaxConcurrentHops" TTL values (0 means all of them) are in flight at
+	//the same time, so the wall clock time of a trace is roughly one timeout rather than the sum of the per hop
+	//timeouts. The OnPingResult / OnSingleHostResult callbacks are still called in hop order on the calling thread
+	void SetConcurrentProbing(_In_ bool bConcurrent, _In_ UCHAR nMaxConcurrentHops = 0) noexcept { m_bConcurrent = bConcurrent; m_nMaxConcurrentHops = nMaxConcurrentHops; }
+	_NODISCARD bool GetConcurrentProbing() const noexcept { return m_bConcurrent; }
+
+	//Termination policies. The trace always stops once the destination answers. With a gap limit of K it also stops
+	//after K consecutive hops which answered none of their probes (0 means no limit), and with "bStopOnUnreachable"
+	//at the first hop which reports the destination as unreachable or administratively prohibited. GetStopReason
+	//tells which of them ended the last trace, and the last hop in the reply is the hop at which it happened
+	void SetGapLimit(_In_ UCHAR nGapLimit) noexcept { m_nGapLimit = nGapLimit; }
+	_NODISCARD UCHAR GetGapLimit() const noexcept { return m_nGapLimit; }
+	void SetStopOnUnreachable(_In_ bool bStopOnUnreachable) noexcept { m_bStopOnUnreachable = bStopOnUnreachable; }
+	_NODISCARD bool GetStopOnUnreachable() const noexcept { return m_bStopOnUnreachable; }
+	_NODISCARD StopReason GetStopReason() const noexcept { return m_StopReason; }
+	_NODISCARD static bool IsUnreachableStatus(_In_ ULONG nStatus) noexcept;
+
+	//With adaptive timeouts every hop keeps an RFC 6298 style estimate of its round trip time, and a probe is given
+	//up after a few round trip times (but never less than "dwFloor" ms) rather than after the full "dwTimeout" passed
+	//to Tracev4 / Tracev6, which becomes the ceiling. A hop is given the full timeout until it has answered itself,
+	//as the round trip times of the hops before it say nothing about a slow link to it. GetHopTimeouts gives the estimators of the last trace, which
+	//also account for how long was spent waiting for lost probes
+	void SetAdaptiveTimeout(_In_ bool bAdaptive, _In_ DWORD dwFloor = 200) noexcept { m_bAdaptiveTimeout = bAdaptive; m_dwTimeoutFloor = dwFloor; }
+	_NODISCARD bool GetAdaptiveTimeout() const noexcept { return m_bAdaptiveTimeout; }
+	_NODISCARD const std::vector<CAdaptiveTimeout>& GetHopTimeouts() const noexcept { return m_arrHopTimeouts; }
+
+	//The number of echo requests sent by the last trace
+	_NODISCARD ULONGLONG GetProbesSent() const noexcept { return m_nProbesSent; }
+
 protected:
+	//A ping session of the probes and what it was last opened for
+	struct CProbeSession
+	{
+		std::unique_ptr<CPingSession> pSession; //The session, created with CreateBackend
+		SOCKADDR_STORAGE DestAddress{}; //The destination it was opened for
+		SOCKADDR_STORAGE LocalAddress{}; //The local address it was opened for, family AF_UNSPEC for none
+		WORD wDataSize{ 0 }; //The data size it was opened for
+		CPingReplyv4 Replyv4; //The reply of every IPv4 probe sent over the session, so that its buffer is only allocated once
+		CPingReplyv6 Replyv6; //Likewise for IPv6 probes
+	};
+
 	//Methods
+	bool ProbeHopv4(_In_ const SOCKADDR_IN& destAddress, _In_ UCHAR nTTL, _Inout_ CHostTraceMultiReplyv4& htrr, _Inout_ std::vector<CHostTraceSingleReplyv4>& replies, _In_ bool bNotify, _In_ DWORD dwTimeout, _In_ DWORD dwPingsPerHost, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN* pLocalAddress);
+	bool ProbeHopv6(_In_ const SOCKADDR_IN6& destAddress, _In_ UCHAR nTTL, _Inout_ CHostTraceMultiReplyv6& htrr, _Inout_ std::vector<CHostTraceSingleReplyv6>& replies, _In_ bool bNotify, _In_ DWORD dwTimeout, _In_ DWORD dwPingsPerHost, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN6* pLocalAddress);
+	void ResetHopTimeouts(_In_ UCHAR nHopCount, _In_ DWORD dwTimeout);
+	_NODISCARD bool CheckStopPolicies(_In_ bool bFromDestination, _In_ ULONG nStatus, _In_ DWORD dwError, _Inout_ UCHAR& nSilentHops) noexcept;
 	static String AddressToString(const SOCKADDR* pSockAddr, int nSockAddrLen, int nFlags, UINT* pnSocketPort);
-	virtual bool Pingv4(_In_z_ LPCTSTR pszHostName, _Inout_ CHostTraceSingleReplyv4& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_z_ LPCTSTR pszLocalBoundAddress);
-	virtual bool Pingv6(_In_z_ LPCTSTR pszHostName, _Inout_ CHostTraceSingleReplyv6& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_z_ LPCTSTR pszLocalBoundAddress);
+	virtual bool Pingv4(_In_ const SOCKADDR_IN& destAddress, _Inout_ CHostTraceSingleReplyv4& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN* pLocalAddress);
+	virtual bool Pingv6(_In_ const SOCKADDR_IN6& destAddress, _Inout_ CHostTraceSingleReplyv6& htsr, _In_ UCHAR nTTL, _In_ DWORD dwTimeout, _In_ WORD wDataSize, _In_ UCHAR nTOS, _In_ bool bDontFragment, _In_ bool bFlagReverse, _In_opt_ const SOCKADDR_IN6* pLocalAddress);
+	virtual std::unique_ptr<CPingBackend> CreateBackend(); //Creates the backend of a ping session; override to trace a simulated network
+
+	//Pingv4 / Pingv6 send every probe over an idle session of m_IdleSessions rather than over a new ICMP handle / socket.
+	//A session is only reopened when it was opened for another destination, local address or data size, so a trace
+	//opens one of them, or one per hop probed at the same time in concurrent mode, and later traces reuse them
+	_NODISCARD std::unique_ptr<CProbeSession> AcquireSession(_In_ const SOCKADDR_STORAGE& destAddress, _In_ const SOCKADDR_STORAGE& localAddress, _In_ WORD wDataSize);
+	void ReleaseSession(_In_ std::unique_ptr<CProbeSession> pProbeSession);
+
+	//Member variables
+	bool m_bConcurrent; //Should the hops be probed concurrently
+	UCHAR m_nMaxConcurrentHops; //The maximum number of hops probed at the same time in concurrent mode (0 means no limit)
+	std::atomic<bool> m_bCancelled; //Set when a callback cancels a concurrent trace so that outstanding hops stop early
+	UCHAR m_nGapLimit; //Stop after this many consecutive silent hops (0 means no limit)
+	bool m_bStopOnUnreachable; //Stop at a hop which reports the destination as unreachable
+	StopReason m_StopReason; //Why the last trace stopped
+	bool m_bAdaptiveTimeout; //Should the probe timeouts follow the round trip times of the hops
+	DWORD m_dwTimeoutFloor; //The smallest adaptive timeout in milliseconds
+	std::vector<CAdaptiveTimeout> m_arrHopTimeouts; //The timeout estimator of every hop, indexed by TTL - 1
+	std::atomic<ULONGLONG> m_nProbesSent; //Echo requests sent, counted by ProbeHopv4 / ProbeHopv6
+	std::mutex m_SessionsMutex; //Protects m_IdleSessions
+	std::vector<std::unique_ptr<CProbeSession>> m_IdleSessions; //The ping sessions which no probe is using
 };
 
 #endif //#ifndef __TRACER_H__